@@ -0,0 +1,215 @@
+#ifndef ASSEMBLY_HPP
+#define ASSEMBLY_HPP
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+#include "matrix.hpp"
+#include "threadpool.hpp"
+
+namespace abramov
+{
+  template< Integral T, class P >
+  struct BlockAssembly
+  {
+    using Block = std::reference_wrapper< const Matrix< T, P > >;
+
+    BlockAssembly(size_t grid_rows, size_t grid_cols, T fill = 0);
+    static BlockAssembly< T, P > horizontal(const std::vector< Block > &blocks, T fill = 0);
+    static BlockAssembly< T, P > vertical(const std::vector< Block > &blocks, T fill = 0);
+    static BlockAssembly< T, P > diagonal(const std::vector< Block > &blocks, T fill = 0);
+    BlockAssembly< T, P > &set(size_t row, size_t col, const Matrix< T, P > &block);
+    BlockAssembly< T, P > &reset(size_t row, size_t col);
+    size_t getRows() const noexcept;
+    size_t getCols() const noexcept;
+    T operator()(size_t row, size_t col) const;
+    void copyRow(size_t row, T *out) const;
+    Matrix< T, P > materialize(size_t threads = 0) const;
+  private:
+    size_t grid_rows;
+    size_t grid_cols;
+    T fill;
+    std::vector< const Matrix< T, P > * > blocks;
+    std::vector< size_t > heights;
+    std::vector< size_t > widths;
+    std::vector< size_t > row_offsets;
+    std::vector< size_t > col_offsets;
+
+    void layout(size_t row, size_t col);
+    size_t gridRow(size_t row) const noexcept;
+  };
+}
+
+template< abramov::Integral T, class P >
+abramov::BlockAssembly< T, P >::BlockAssembly(size_t rows, size_t cols, T value):
+  grid_rows(rows),
+  grid_cols(cols),
+  fill(value),
+  blocks(rows * cols, nullptr),
+  heights(rows, 0),
+  widths(cols, 0),
+  row_offsets(rows + 1, 0),
+  col_offsets(cols + 1, 0)
+{}
+
+template< abramov::Integral T, class P >
+abramov::BlockAssembly< T, P > abramov::BlockAssembly< T, P >::horizontal(const std::vector< Block > &blocks, T fill)
+{
+  BlockAssembly< T, P > res(1, blocks.size(), fill);
+  for (size_t j = 0; j < blocks.size(); ++j)
+  {
+    res.set(0, j, blocks[j].get());
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::BlockAssembly< T, P > abramov::BlockAssembly< T, P >::vertical(const std::vector< Block > &blocks, T fill)
+{
+  BlockAssembly< T, P > res(blocks.size(), 1, fill);
+  for (size_t i = 0; i < blocks.size(); ++i)
+  {
+    res.set(i, 0, blocks[i].get());
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::BlockAssembly< T, P > abramov::BlockAssembly< T, P >::diagonal(const std::vector< Block > &blocks, T fill)
+{
+  BlockAssembly< T, P > res(blocks.size(), blocks.size(), fill);
+  for (size_t i = 0; i < blocks.size(); ++i)
+  {
+    res.set(i, i, blocks[i].get());
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::BlockAssembly< T, P > &abramov::BlockAssembly< T, P >::set(size_t row, size_t col, const Matrix< T, P > &block)
+{
+  if (row >= grid_rows || col >= grid_cols)
+  {
+    throw std::out_of_range("Index out of range\n");
+  }
+  blocks[row * grid_cols + col] = &block;
+  layout(row, col);
+  return *this;
+}
+
+template< abramov::Integral T, class P >
+abramov::BlockAssembly< T, P > &abramov::BlockAssembly< T, P >::reset(size_t row, size_t col)
+{
+  if (row >= grid_rows || col >= grid_cols)
+  {
+    throw std::out_of_range("Index out of range\n");
+  }
+  blocks[row * grid_cols + col] = nullptr;
+  layout(row, col);
+  return *this;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::BlockAssembly< T, P >::getRows() const noexcept
+{
+  return row_offsets.back();
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::BlockAssembly< T, P >::getCols() const noexcept
+{
+  return col_offsets.back();
+}
+
+template< abramov::Integral T, class P >
+T abramov::BlockAssembly< T, P >::operator()(size_t row, size_t col) const
+{
+  if (row >= getRows() || col >= getCols())
+  {
+    throw std::out_of_range("Index out of range\n");
+  }
+  size_t r = gridRow(row);
+  size_t c = std::upper_bound(col_offsets.begin(), col_offsets.end(), col) - col_offsets.begin() - 1;
+  const Matrix< T, P > *block = blocks[r * grid_cols + c];
+  size_t i = row - row_offsets[r];
+  size_t j = col - col_offsets[c];
+  if (!block || i >= block->rows || j >= block->cols)
+  {
+    return fill;
+  }
+  return block->data[i][j];
+}
+
+template< abramov::Integral T, class P >
+void abramov::BlockAssembly< T, P >::copyRow(size_t row, T *out) const
+{
+  size_t r = gridRow(row);
+  size_t i = row - row_offsets[r];
+  for (size_t c = 0; c < grid_cols; ++c)
+  {
+    const Matrix< T, P > *block = blocks[r * grid_cols + c];
+    T *dst = out + col_offsets[c];
+    T *end = out + col_offsets[c + 1];
+    if (block && i < block->rows)
+    {
+      dst = std::copy(block->data[i], block->data[i] + block->cols, dst);
+    }
+    std::fill(dst, end, fill);
+  }
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::BlockAssembly< T, P >::materialize(size_t threads) const
+{
+  ABRAMOV_PROFILE_SCOPE("BlockAssembly::materialize", getRows(), getCols());
+  Matrix< T, P > res;
+  res.data = Matrix< T, P >::initMatrix(getRows(), getCols());
+  res.rows = getRows();
+  res.cols = getCols();
+  constexpr size_t min_elements = 1 << 16;
+  size_t limit = res.rows * res.cols / min_elements;
+  threads = std::max< size_t >(1, std::min(threads ? threads : defaultThreads(), limit));
+  placedParallelFor(res.rows ? res.data[0] : nullptr, 0, res.rows, [this, &res](size_t lo, size_t hi)
+  {
+    for (size_t row = lo; row < hi; ++row)
+    {
+      copyRow(row, res.data[row]);
+    }
+  }, threads);
+  return res;
+}
+
+template< abramov::Integral T, class P >
+void abramov::BlockAssembly< T, P >::layout(size_t row, size_t col)
+{
+  size_t height = 0;
+  for (size_t c = 0; c < grid_cols; ++c)
+  {
+    const Matrix< T, P > *block = blocks[row * grid_cols + c];
+    height = std::max(height, block ? block->rows : 0);
+  }
+  size_t width = 0;
+  for (size_t r = 0; r < grid_rows; ++r)
+  {
+    const Matrix< T, P > *block = blocks[r * grid_cols + col];
+    width = std::max(width, block ? block->cols : 0);
+  }
+  heights[row] = height;
+  widths[col] = width;
+  for (size_t r = 0; r < grid_rows; ++r)
+  {
+    row_offsets[r + 1] = row_offsets[r] + heights[r];
+  }
+  for (size_t c = 0; c < grid_cols; ++c)
+  {
+    col_offsets[c + 1] = col_offsets[c] + widths[c];
+  }
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::BlockAssembly< T, P >::gridRow(size_t row) const noexcept
+{
+  return std::upper_bound(row_offsets.begin(), row_offsets.end(), row) - row_offsets.begin() - 1;
+}
+#endif
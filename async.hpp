@@ -0,0 +1,419 @@
+#ifndef ASYNC_HPP
+#define ASYNC_HPP
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "matrix.hpp"
+#include "textio.hpp"
+#include "threadpool.hpp"
+
+namespace abramov
+{
+  template< Integral T, class P = Wrapping >
+  struct TaskGraph
+  {
+    struct Inputs
+    {
+      size_t size() const noexcept;
+      const Matrix< T, P > &get(size_t i) const;
+      Matrix< T, P > take(size_t i);
+    private:
+      friend struct TaskGraph< T, P >;
+      std::vector< Matrix< T, P > * > values;
+      std::vector< bool > owned;
+    };
+    using Operation = std::function< Matrix< T, P >(Inputs &) >;
+
+    TaskGraph();
+    TaskGraph(const TaskGraph< T, P > &) = delete;
+    TaskGraph< T, P > &operator=(const TaskGraph< T, P > &) = delete;
+    size_t input(Matrix< T, P > matrix);
+    size_t read(const std::string &path);
+    size_t apply(const std::vector< size_t > &deps, Operation op);
+    size_t add(size_t lhs, size_t rhs);
+    size_t subtract(size_t lhs, size_t rhs);
+    size_t multiply(size_t lhs, size_t rhs);
+    size_t scale(size_t node, T scalar);
+    size_t power(size_t node, size_t k);
+    size_t transpose(size_t node);
+    size_t adjugate(size_t node);
+    TaskGraph< T, P > &keep(size_t node);
+    void run(size_t threads = 0);
+    size_t size() const noexcept;
+    const Matrix< T, P > &result(size_t node) const;
+    Matrix< T, P > take(size_t node);
+  private:
+    struct Node
+    {
+      std::vector< size_t > deps;
+      std::vector< size_t > dependents;
+      Operation op;
+      Matrix< T, P > value;
+      bool keep = false;
+      bool ready = false;
+      bool failed = false;
+    };
+    struct State
+    {
+      std::mutex mutex;
+      std::condition_variable cv;
+      std::deque< size_t > ready;
+      std::vector< size_t > waiting;
+      std::vector< size_t > consumers;
+      size_t finished = 0;
+      size_t helpers = 0;
+      size_t running = 0;
+      std::exception_ptr error;
+    };
+
+    std::vector< Node > nodes;
+
+    void check(size_t node) const;
+    static bool step(TaskGraph< T, P > *graph, const std::shared_ptr< State > &state);
+    static void spawn(TaskGraph< T, P > *graph, const std::shared_ptr< State > &state);
+    void execute(size_t node, const std::shared_ptr< State > &state);
+  };
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TaskGraph< T, P >::Inputs::size() const noexcept
+{
+  return values.size();
+}
+
+template< abramov::Integral T, class P >
+const abramov::Matrix< T, P > &abramov::TaskGraph< T, P >::Inputs::get(size_t i) const
+{
+  return *values.at(i);
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::TaskGraph< T, P >::Inputs::take(size_t i)
+{
+  if (owned.at(i))
+  {
+    owned[i] = false;
+    return std::move(*values[i]);
+  }
+  return *values[i];
+}
+
+template< abramov::Integral T, class P >
+abramov::TaskGraph< T, P >::TaskGraph():
+  nodes()
+{}
+
+template< abramov::Integral T, class P >
+size_t abramov::TaskGraph< T, P >::input(Matrix< T, P > matrix)
+{
+  auto value = std::make_shared< const Matrix< T, P > >(std::move(matrix));
+  return apply({}, [value](Inputs &)
+  {
+    // Copied rather than moved out: run() may execute the graph again
+    return Matrix< T, P >(*value);
+  });
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TaskGraph< T, P >::read(const std::string &path)
+{
+  return apply({}, [path](Inputs &)
+  {
+    MappedFile file(path);
+    Matrix< T, P > res;
+    if (!res.parse(file.begin(), file.end()))
+    {
+      throw std::runtime_error("Invalid matrix in " + path + "\n");
+    }
+    return res;
+  });
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TaskGraph< T, P >::apply(const std::vector< size_t > &deps, Operation op)
+{
+  for (size_t dep : deps)
+  {
+    check(dep);
+  }
+  size_t id = nodes.size();
+  nodes.emplace_back();
+  nodes.back().deps = deps;
+  nodes.back().op = std::move(op);
+  for (size_t dep : deps)
+  {
+    nodes[dep].dependents.push_back(id);
+  }
+  return id;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TaskGraph< T, P >::add(size_t lhs, size_t rhs)
+{
+  return apply({ lhs, rhs }, [](Inputs &in)
+  {
+    Matrix< T, P > res = in.take(0);
+    res += in.get(1);
+    return res;
+  });
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TaskGraph< T, P >::subtract(size_t lhs, size_t rhs)
+{
+  return apply({ lhs, rhs }, [](Inputs &in)
+  {
+    Matrix< T, P > res = in.take(0);
+    res -= in.get(1);
+    return res;
+  });
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TaskGraph< T, P >::multiply(size_t lhs, size_t rhs)
+{
+  return apply({ lhs, rhs }, [](Inputs &in)
+  {
+    Matrix< T, P > res = in.take(0);
+    res *= in.get(1);
+    return res;
+  });
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TaskGraph< T, P >::scale(size_t node, T scalar)
+{
+  return apply({ node }, [scalar](Inputs &in)
+  {
+    Matrix< T, P > res = in.take(0);
+    res *= scalar;
+    return res;
+  });
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TaskGraph< T, P >::power(size_t node, size_t k)
+{
+  return apply({ node }, [k](Inputs &in)
+  {
+    return in.get(0).power(k);
+  });
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TaskGraph< T, P >::transpose(size_t node)
+{
+  return apply({ node }, [](Inputs &in)
+  {
+    return in.get(0).transpose();
+  });
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TaskGraph< T, P >::adjugate(size_t node)
+{
+  return apply({ node }, [](Inputs &in)
+  {
+    return in.get(0).inverse().second;
+  });
+}
+
+template< abramov::Integral T, class P >
+abramov::TaskGraph< T, P > &abramov::TaskGraph< T, P >::keep(size_t node)
+{
+  check(node);
+  nodes[node].keep = true;
+  return *this;
+}
+
+template< abramov::Integral T, class P >
+void abramov::TaskGraph< T, P >::run(size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("TaskGraph::run", nodes.size(), 1);
+  auto state = std::make_shared< State >();
+  state->waiting.resize(nodes.size());
+  state->consumers.resize(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    nodes[i].ready = false;
+    nodes[i].failed = false;
+    state->waiting[i] = nodes[i].deps.size();
+    state->consumers[i] = nodes[i].dependents.size();
+    if (nodes[i].deps.empty())
+    {
+      state->ready.push_back(i);
+    }
+  }
+  state->helpers = std::min(threads ? threads - 1 : defaultPool().size(), defaultPool().size());
+  spawn(this, state);
+  std::unique_lock< std::mutex > lock(state->mutex);
+  for (;;)
+  {
+    state->cv.wait(lock, [this, &state]()
+    {
+      return state->finished == nodes.size() || !state->ready.empty();
+    });
+    if (state->finished == nodes.size())
+    {
+      break;
+    }
+    lock.unlock();
+    step(this, state);
+    lock.lock();
+  }
+  if (state->error)
+  {
+    std::rethrow_exception(state->error);
+  }
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TaskGraph< T, P >::size() const noexcept
+{
+  return nodes.size();
+}
+
+template< abramov::Integral T, class P >
+const abramov::Matrix< T, P > &abramov::TaskGraph< T, P >::result(size_t node) const
+{
+  check(node);
+  if (!nodes[node].ready)
+  {
+    throw std::logic_error("Result is not available\n");
+  }
+  return nodes[node].value;
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::TaskGraph< T, P >::take(size_t node)
+{
+  check(node);
+  if (!nodes[node].ready)
+  {
+    throw std::logic_error("Result is not available\n");
+  }
+  nodes[node].ready = false;
+  return std::move(nodes[node].value);
+}
+
+template< abramov::Integral T, class P >
+void abramov::TaskGraph< T, P >::check(size_t node) const
+{
+  if (node >= nodes.size())
+  {
+    throw std::out_of_range("Invalid task\n");
+  }
+}
+
+template< abramov::Integral T, class P >
+bool abramov::TaskGraph< T, P >::step(TaskGraph< T, P > *graph, const std::shared_ptr< State > &state)
+{
+  size_t node = 0;
+  {
+    std::lock_guard< std::mutex > lock(state->mutex);
+    if (state->ready.empty())
+    {
+      return false;
+    }
+    node = state->ready.front();
+    state->ready.pop_front();
+  }
+  graph->execute(node, state);
+  return true;
+}
+
+template< abramov::Integral T, class P >
+void abramov::TaskGraph< T, P >::spawn(TaskGraph< T, P > *graph, const std::shared_ptr< State > &state)
+{
+  std::lock_guard< std::mutex > lock(state->mutex);
+  while (state->running < state->helpers && state->running < state->ready.size())
+  {
+    ++state->running;
+    defaultPool().submit([graph, state]()
+    {
+      for (;;)
+      {
+        while (step(graph, state))
+        {}
+        std::lock_guard< std::mutex > guard(state->mutex);
+        if (state->ready.empty())
+        {
+          --state->running;
+          return;
+        }
+      }
+    });
+  }
+}
+
+template< abramov::Integral T, class P >
+void abramov::TaskGraph< T, P >::execute(size_t id, const std::shared_ptr< State > &state)
+{
+  Node &node = nodes[id];
+  bool skip = false;
+  Inputs in;
+  for (size_t dep : node.deps)
+  {
+    skip = skip || nodes[dep].failed;
+    in.values.push_back(&nodes[dep].value);
+    in.owned.push_back(nodes[dep].dependents.size() == 1 && !nodes[dep].keep);
+  }
+  if (skip)
+  {
+    node.failed = true;
+  }
+  else
+  {
+    try
+    {
+      node.value = node.op(in);
+    }
+    catch (...)
+    {
+      node.failed = true;
+      std::lock_guard< std::mutex > lock(state->mutex);
+      if (!state->error)
+      {
+        state->error = std::current_exception();
+      }
+    }
+  }
+  std::vector< size_t > released;
+  {
+    std::lock_guard< std::mutex > lock(state->mutex);
+    node.ready = !node.failed && (node.keep || node.dependents.empty());
+    for (size_t dep : node.deps)
+    {
+      if (!--state->consumers[dep] && !nodes[dep].keep)
+      {
+        released.push_back(dep);
+      }
+    }
+  }
+  for (size_t dep : released)
+  {
+    nodes[dep].value = Matrix< T, P >();
+  }
+  {
+    std::lock_guard< std::mutex > lock(state->mutex);
+    for (size_t next : node.dependents)
+    {
+      if (!--state->waiting[next])
+      {
+        state->ready.push_back(next);
+      }
+    }
+    ++state->finished;
+  }
+  spawn(this, state);
+  std::lock_guard< std::mutex > lock(state->mutex);
+  state->cv.notify_all();
+}
+#endif
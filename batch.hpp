@@ -0,0 +1,539 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "matrix.hpp"
+#include "profile.hpp"
+#include "textio.hpp"
+#include "threadpool.hpp"
+
+namespace abramov
+{
+  struct BatchJob
+  {
+    std::string op;
+    std::string output;
+    std::vector< std::string > inputs;
+    long long arg = 0;
+    size_t line = 0;
+  };
+
+  struct BatchStatus
+  {
+    bool ok = false;
+    std::string error;
+    double seconds = 0.0;
+    size_t memory = 0;
+  };
+
+  struct MemoryBudget
+  {
+    explicit MemoryBudget(size_t limit = 0);
+    MemoryBudget(const MemoryBudget &) = delete;
+    MemoryBudget &operator=(const MemoryBudget &) = delete;
+    void acquire(size_t bytes);
+    void release(size_t bytes) noexcept;
+    size_t limit() const noexcept;
+    size_t peak() const noexcept;
+  private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t max;
+    size_t used;
+    size_t top;
+  };
+
+  std::vector< BatchJob > parseManifest(std::istream &in);
+  template< Integral T >
+  void writeReport(const Matrix< T > &m1, const Matrix< T > &m2, const Matrix< T > *cramer, std::ostream &out);
+  template< Integral T >
+  size_t runJob(const BatchJob &job, MemoryBudget &budget);
+  template< Integral T >
+  std::vector< BatchStatus > runBatch(const std::vector< BatchJob > &jobs, size_t threads = 0, size_t memory = 0,
+    std::ostream *report = nullptr);
+}
+
+inline abramov::MemoryBudget::MemoryBudget(size_t limit):
+  mutex(),
+  cv(),
+  max(limit),
+  used(0),
+  top(0)
+{}
+
+inline void abramov::MemoryBudget::acquire(size_t bytes)
+{
+  std::unique_lock< std::mutex > lock(mutex);
+  cv.wait(lock, [this, bytes]()
+  {
+    return !max || !used || used + bytes <= max;
+  });
+  used += bytes;
+  top = std::max(top, used);
+}
+
+inline void abramov::MemoryBudget::release(size_t bytes) noexcept
+{
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    used -= bytes;
+  }
+  cv.notify_all();
+}
+
+inline size_t abramov::MemoryBudget::limit() const noexcept
+{
+  return max;
+}
+
+inline size_t abramov::MemoryBudget::peak() const noexcept
+{
+  return top;
+}
+
+inline std::vector< abramov::BatchJob > abramov::parseManifest(std::istream &in)
+{
+  struct Signature
+  {
+    const char *op;
+    size_t min_inputs;
+    size_t max_inputs;
+    bool arg;
+  };
+  static const Signature signatures[] = {
+    { "add", 2, 2, false }, { "subtract", 2, 2, false }, { "multiply", 2, 2, false },
+    { "kronecker", 2, 2, false }, { "hconcat", 2, 2, false }, { "vconcat", 2, 2, false },
+    { "dconcat", 2, 2, false }, { "scale", 1, 1, true }, { "power", 1, 1, true },
+    { "negate", 1, 1, false }, { "transpose", 1, 1, false }, { "determinant", 1, 1, false },
+    { "trace", 1, 1, false }, { "perm", 1, 1, false }, { "rank", 1, 1, false },
+    { "firstNorm", 1, 1, false }, { "infinityNorm", 1, 1, false }, { "inverse", 1, 1, false },
+    { "cramer", 1, 1, false }, { "report", 2, 3, false }
+  };
+  std::vector< BatchJob > jobs;
+  std::string text;
+  for (size_t line = 1; std::getline(in, text); ++line)
+  {
+    text.erase(std::find(text.begin(), text.end(), '#'), text.end());
+    std::istringstream fields(text);
+    BatchJob job;
+    job.line = line;
+    if (!(fields >> job.op))
+    {
+      continue;
+    }
+    const Signature *sig = std::find_if(std::begin(signatures), std::end(signatures), [&job](const Signature &s)
+    {
+      return job.op == s.op;
+    });
+    if (sig == std::end(signatures))
+    {
+      throw std::invalid_argument("Unknown operation " + job.op + " in manifest line " + std::to_string(line) + "\n");
+    }
+    std::vector< std::string > words;
+    for (std::string word; fields >> word;)
+    {
+      words.push_back(word);
+    }
+    if (sig->arg && !words.empty())
+    {
+      size_t used = 0;
+      try
+      {
+        job.arg = std::stoll(words.back(), &used);
+      }
+      catch (const std::exception &)
+      {}
+      if (used != words.back().size() || (job.op == "power" && job.arg < 0))
+      {
+        throw std::invalid_argument("Invalid argument in manifest line " + std::to_string(line) + "\n");
+      }
+      words.pop_back();
+    }
+    if (words.size() < sig->min_inputs + 1 || words.size() > sig->max_inputs + 1)
+    {
+      throw std::invalid_argument("Invalid number of files in manifest line " + std::to_string(line) + "\n");
+    }
+    job.output = words.front();
+    job.inputs.assign(words.begin() + 1, words.end());
+    jobs.push_back(std::move(job));
+  }
+  return jobs;
+}
+
+template< abramov::Integral T >
+void abramov::writeReport(const Matrix< T > &m1, const Matrix< T > &m2, const Matrix< T > *cramer, std::ostream &out)
+{
+  Matrix< T > copy = m1;
+  copy += m2;
+  out << "operator+=\n";
+  copy.print(out);
+  out << '\n';
+  copy = m1 + m2;
+  out << "operator_binary_plus\n";
+  copy.print(out);
+  out << '\n';
+  copy = +m1;
+  out << "operator_unary_plus\n";
+  copy.print(out);
+  out << '\n';
+
+  copy = m1;
+  copy -= m2;
+  out << "operator-=\n";
+  copy.print(out);
+  out << '\n';
+  copy = m1 - m2;
+  out << "operator_binary_minus\n";
+  copy.print(out);
+  out << '\n';
+  copy = -m1;
+  out << "operator_unary_minus\n";
+  copy.print(out);
+  out << '\n';
+
+  copy = m1;
+  copy *= m2;
+  out << "operator*=\n";
+  copy.print(out);
+  out << '\n';
+  copy = m1 * m2;
+  out << "operator_multiple_matrix_matrix\n";
+  copy.print(out);
+  out << '\n';
+
+  copy = m1;
+  copy = m1.power(2);
+  out << "power with k = 2\n";
+  copy.print(out);
+  copy = m1.power(3);
+  out << "power with k = 3\n";
+  copy.print(out);
+  out << '\n';
+
+  copy = m1.transpose();
+  out << "transpose\n";
+  copy.print(out);
+  out << '\n';
+
+  out << "determinant of the first matrix: " << m1.determinant() << '\n';
+  out << "determinant of the second matrix: " << m2.determinant() << '\n';
+  out << '\n';
+
+  out << "trace of the first matrix: " << m1.trace() << '\n';
+  out << "trace of the second matrix: " << m2.trace() << '\n';
+  out << '\n';
+
+  out << "permanent of the first matrix: " << m1.perm() << '\n';
+  out << "permanent of the second matrix: " << m2.perm() << '\n';
+  out << '\n';
+
+  out << "rank of the first matrix: " << m1.rank() << '\n';
+  out << "rank of the second matrix: " << m2.rank() << '\n';
+  out << '\n';
+
+  out << "first norm of the first matrix: " << m1.firstNorm() << '\n';
+  out << "first norm of the second matrix: " << m2.firstNorm() << '\n';
+  out << '\n';
+
+  out << "infinity norm of the first matrix: " << m1.infinityNorm() << '\n';
+  out << "infinity norm of the second matrix: " << m2.infinityNorm() << '\n';
+  out << '\n';
+
+  auto p1 = m1.inverse();
+  out << "first inverse matrix\n";
+  out << "factor " << std::setprecision(2) << p1.first << '\n';
+  out << "integer matrix\n";
+  p1.second.print(out);
+  auto p2 = m2.inverse();
+  out << "second inverse matrix\n";
+  out << "factor " << p2.first << '\n';
+  out << "integer matrix\n";
+  p2.second.print(out);
+  out << '\n';
+
+  if (cramer)
+  {
+    auto v1 = cramer->solveCramer();
+    out << "solutions of the matrix as system of linear equations\n";
+    out << *(v1.begin());
+    for (auto it = ++v1.begin(); it != v1.end(); ++it)
+    {
+      out << ' ' << *it;
+    }
+    out << '\n' << '\n';
+  }
+
+  copy = m1 * 2;
+  out << "operator_multiple_matrix_scalar\n";
+  copy.print(out);
+  out << '\n';
+  copy = 2 * m1;
+  out << "operator_multiple_scalar_matrix\n";
+  copy.print(out);
+  out << '\n';
+
+  copy = Matrix< T >::horizontalConcat(m1, m2);
+  out << "horizontal_concatenation\n";
+  copy.print(out);
+  out << '\n';
+  copy = Matrix< T >::verticalConcat(m1, m2);
+  out << "vertical_concatenation\n";
+  copy.print(out);
+  out << '\n';
+  copy = Matrix< T >::diagonalConcat(m1, m2);
+  out << "diagonal_concatenation\n";
+  copy.print(out);
+  out << '\n';
+
+  copy = Matrix< T >::kroneckerProduct(m1, m2);
+  out << "Kronecker product\n";
+  copy.print(out);
+}
+
+template< abramov::Integral T >
+size_t abramov::runJob(const BatchJob &job, MemoryBudget &budget)
+{
+  constexpr size_t digits = std::numeric_limits< T >::digits10 + 3;
+  if (job.inputs.empty())
+  {
+    throw std::invalid_argument("Job has no input files\n");
+  }
+  std::vector< std::unique_ptr< MappedFile > > files;
+  std::vector< size_t > rows;
+  std::vector< size_t > cols;
+  size_t bytes = 0;
+  for (const std::string &path : job.inputs)
+  {
+    files.push_back(std::make_unique< MappedFile >(path));
+    size_t m = 0;
+    size_t n = 0;
+    const char *first = parseInteger(files.back()->begin(), files.back()->end(), m);
+    if (!first || !parseInteger(first, files.back()->end(), n))
+    {
+      throw std::runtime_error("Invalid matrix in " + path + "\n");
+    }
+    rows.push_back(m);
+    cols.push_back(n);
+    bytes += m * n * sizeof(T) + m * sizeof(T *);
+  }
+  size_t elements = rows[0] * cols[0];
+  if (job.op == "multiply")
+  {
+    elements = rows[0] * cols[1];
+  }
+  else if (job.op == "kronecker" || job.op == "report")
+  {
+    elements = rows[0] * cols[0] * rows[1] * cols[1] + 4 * (rows[0] + rows[1]) * (cols[0] + cols[1]);
+  }
+  else if (job.op == "hconcat")
+  {
+    elements = std::max(rows[0], rows[1]) * (cols[0] + cols[1]);
+  }
+  else if (job.op == "vconcat")
+  {
+    elements = (rows[0] + rows[1]) * std::max(cols[0], cols[1]);
+  }
+  else if (job.op == "dconcat")
+  {
+    elements = (rows[0] + rows[1]) * (cols[0] + cols[1]);
+  }
+  else if (job.op == "power")
+  {
+    elements *= 3;
+  }
+  bytes += elements * (sizeof(T) + digits);
+  budget.acquire(bytes);
+  try
+  {
+    std::vector< Matrix< T > > in(files.size());
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+      if (!in[i].parse(files[i]->begin(), files[i]->end()))
+      {
+        throw std::runtime_error("Invalid matrix in " + job.inputs[i] + "\n");
+      }
+    }
+    files.clear();
+    std::string text;
+    Matrix< T > res;
+    if (job.op == "add")
+    {
+      res = in[0] + in[1];
+    }
+    else if (job.op == "subtract")
+    {
+      res = in[0] - in[1];
+    }
+    else if (job.op == "multiply")
+    {
+      res = in[0] * in[1];
+    }
+    else if (job.op == "kronecker")
+    {
+      res = Matrix< T >::kroneckerProduct(in[0], in[1]);
+    }
+    else if (job.op == "hconcat")
+    {
+      res = Matrix< T >::horizontalConcat(in[0], in[1]);
+    }
+    else if (job.op == "vconcat")
+    {
+      res = Matrix< T >::verticalConcat(in[0], in[1]);
+    }
+    else if (job.op == "dconcat")
+    {
+      res = Matrix< T >::diagonalConcat(in[0], in[1]);
+    }
+    else if (job.op == "scale")
+    {
+      res = in[0] * static_cast< T >(job.arg);
+    }
+    else if (job.op == "power")
+    {
+      res = in[0].power(job.arg);
+    }
+    else if (job.op == "negate")
+    {
+      res = -in[0];
+    }
+    else if (job.op == "transpose")
+    {
+      res = in[0].transpose();
+    }
+    else if (job.op == "determinant" || job.op == "trace" || job.op == "perm" || job.op == "rank"
+      || job.op == "firstNorm" || job.op == "infinityNorm")
+    {
+      if (job.op == "rank")
+      {
+        formatInteger(text, in[0].rank());
+      }
+      else
+      {
+        const Matrix< T > &m = in[0];
+        T value = job.op == "determinant" ? m.determinant() : job.op == "trace" ? m.trace() : job.op == "perm" ? m.perm()
+          : job.op == "firstNorm" ? m.firstNorm() : m.infinityNorm();
+        formatInteger(text, value);
+      }
+      text.push_back('\n');
+    }
+    else
+    {
+      std::ostringstream out;
+      if (job.op == "inverse")
+      {
+        auto p = in[0].inverse();
+        out << "factor " << p.first << '\n';
+        p.second.print(out);
+      }
+      else if (job.op == "cramer")
+      {
+        std::vector< double > solution = in[0].solveCramer();
+        for (size_t i = 0; i < solution.size(); ++i)
+        {
+          out << (i ? " " : "") << solution[i];
+        }
+        out << '\n';
+      }
+      else
+      {
+        writeReport(in[0], in[1], in.size() > 2 ? &in[2] : nullptr, out);
+      }
+      text = out.str();
+    }
+    if (text.empty())
+    {
+      text.reserve(res.getRows() * res.getCols() * digits);
+      res.format(text);
+    }
+    in.clear();
+    res = Matrix< T >();
+    std::ofstream file(job.output, std::ios::binary);
+    if (!file.write(text.data(), text.size()) || !file.flush())
+    {
+      throw std::runtime_error("Can not write file " + job.output + "\n");
+    }
+  }
+  catch (...)
+  {
+    budget.release(bytes);
+    throw;
+  }
+  budget.release(bytes);
+  return bytes;
+}
+
+template< abramov::Integral T >
+std::vector< abramov::BatchStatus > abramov::runBatch(const std::vector< BatchJob > &jobs, size_t threads, size_t memory,
+  std::ostream *report)
+{
+  ABRAMOV_PROFILE_SCOPE("runBatch", jobs.size(), 1);
+  using clock = std::chrono::steady_clock;
+  std::vector< BatchStatus > status(jobs.size());
+  MemoryBudget budget(memory);
+  std::mutex mutex;
+  std::atomic< size_t > next{ 0 };
+  auto start = clock::now();
+  size_t workers = std::max< size_t >(1, std::min(threads ? threads : defaultThreads(), jobs.size()));
+  parallelFor(0, workers, [&](size_t lo, size_t hi)
+  {
+    for (size_t w = lo; w < hi; ++w)
+    {
+      for (size_t i = next++; i < jobs.size(); i = next++)
+      {
+        auto begin = clock::now();
+        try
+        {
+          status[i].memory = runJob< T >(jobs[i], budget);
+          status[i].ok = true;
+        }
+        catch (const std::exception &e)
+        {
+          status[i].error = e.what();
+        }
+        status[i].seconds = std::chrono::duration< double >(clock::now() - begin).count();
+        if (report)
+        {
+          std::ostringstream line;
+          line << "job " << jobs[i].line << ' ' << jobs[i].op << ' ' << jobs[i].output << ": ";
+          line << std::fixed << std::setprecision(3) << status[i].seconds * 1e3 << " ms";
+          if (status[i].ok)
+          {
+            line << ", " << status[i].memory << " bytes\n";
+          }
+          else
+          {
+            line << ", failed: " << status[i].error;
+          }
+          std::lock_guard< std::mutex > lock(mutex);
+          *report << line.str();
+        }
+      }
+    }
+  }, workers);
+  if (report)
+  {
+    size_t failed = std::count_if(status.begin(), status.end(), [](const BatchStatus &s)
+    {
+      return !s.ok;
+    });
+    double total = std::chrono::duration< double >(clock::now() - start).count();
+    *report << "jobs " << jobs.size() << ", failed " << failed << ", threads " << workers << ", ";
+    *report << std::fixed << std::setprecision(3) << total * 1e3 << " ms, peak " << budget.peak() << " bytes\n";
+  }
+  return status;
+}
+#endif
@@ -0,0 +1,1545 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "assembly.hpp"
+#include "async.hpp"
+#include "distributed.hpp"
+#include "eigen.hpp"
+#include "gf2.hpp"
+#include "knn.hpp"
+#include "kronecker.hpp"
+#include "matrix.hpp"
+#include "normalform.hpp"
+#include "ntt.hpp"
+#include "numa.hpp"
+#include "semiring.hpp"
+#include "structured.hpp"
+#include "qgemm.hpp"
+#include "random.hpp"
+#include "vector.hpp"
+
+namespace
+{
+  std::atomic< size_t > alloc_count{ 0 };
+  std::atomic< size_t > alloc_bytes{ 0 };
+
+  struct Options
+  {
+    std::vector< size_t > sizes{ 4, 16, 64, 256, 1024, 4096, 8192 };
+    size_t max_size = 1024;
+    double min_time = 0.1;
+    double threshold = 0.25;
+    std::string filter;
+    std::string json;
+    std::string baseline;
+  };
+
+  struct Result
+  {
+    std::string op;
+    std::string type;
+    size_t size;
+    size_t iterations;
+    double ns_per_op;
+    double items_per_second;
+    double allocs_per_op;
+    double bytes_per_op;
+  };
+
+  struct Bench
+  {
+    const Options &options;
+    std::vector< Result > results;
+
+    template< class Setup, class F >
+    void run(const std::string &op, const std::string &type, size_t size, double items, Setup setup, F f)
+    {
+      if (!options.filter.empty() && op.find(options.filter) == std::string::npos)
+      {
+        return;
+      }
+      auto state = setup();
+      using State = decltype(state);
+      // Operations taking their state by non-const reference mutate it: each
+      // iteration gets its own copy, made outside the timed region, so no run
+      // sees moved-from objects or values grown by the previous iterations
+      constexpr bool fresh = !std::is_invocable_v< F &, const State & > && std::is_copy_constructible_v< State >;
+      size_t batch = 1;
+      if constexpr (fresh)
+      {
+        size_t bytes = alloc_bytes;
+        State probe(state);
+        f(probe);
+        size_t footprint = sizeof(State) + alloc_bytes - bytes;
+        batch = std::max< size_t >(1, (size_t(64) << 20) / footprint);
+      }
+      else
+      {
+        f(state);
+      }
+      size_t iterations = 1;
+      for (;;)
+      {
+        double seconds = 0;
+        size_t count = 0;
+        size_t bytes = 0;
+        for (size_t done = 0; done < iterations;)
+        {
+          size_t step = fresh ? std::min(batch, iterations - done) : iterations;
+          std::vector< State > copies;
+          if constexpr (fresh)
+          {
+            copies.assign(step, state);
+          }
+          size_t count0 = alloc_count;
+          size_t bytes0 = alloc_bytes;
+          auto start = std::chrono::steady_clock::now();
+          for (size_t i = 0; i < step; ++i)
+          {
+            if constexpr (fresh)
+            {
+              f(copies[i]);
+            }
+            else
+            {
+              f(state);
+            }
+          }
+          auto stop = std::chrono::steady_clock::now();
+          seconds += std::chrono::duration< double >(stop - start).count();
+          count += alloc_count - count0;
+          bytes += alloc_bytes - bytes0;
+          done += step;
+        }
+        if (seconds >= options.min_time || iterations >= (size_t(1) << 24))
+        {
+          double ns = seconds * 1e9 / iterations;
+          Result r{ op, type, size, iterations, ns, items * 1e9 / ns, static_cast< double >(count) / iterations,
+            static_cast< double >(bytes) / iterations };
+          report(r);
+          results.push_back(r);
+          return;
+        }
+        size_t grow = seconds > 0 ? static_cast< size_t >(options.min_time / seconds * 1.2) + 1 : 16;
+        iterations *= std::clamp< size_t >(grow, 2, 16);
+      }
+    }
+
+    void report(const Result &r) const
+    {
+      std::cout << std::left << std::setw(28) << r.op << std::setw(8) << r.type << std::right << std::setw(6) << r.size
+        << std::setw(16) << std::fixed << std::setprecision(1) << r.ns_per_op << " ns/op"
+        << std::setw(14) << std::scientific << std::setprecision(3) << r.items_per_second << " items/s"
+        << std::setw(10) << std::fixed << std::setprecision(1) << r.allocs_per_op << " allocs/op"
+        << std::setw(14) << r.bytes_per_op << " B/op\n";
+    }
+  };
+
+  template< class T >
+  void sink(const T &value)
+  {
+    asm volatile("" : : "g"(&value) : "memory");
+  }
+
+  template< class T >
+  abramov::Matrix< T > sample(size_t m, size_t n, int seed)
+  {
+    abramov::Matrix< T > res(m, n, 0);
+    for (size_t i = 0; i < m; ++i)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        res[i][j] = static_cast< T >((i * 131 + j * 71 + seed) % 7) - 3;
+      }
+    }
+    return res;
+  }
+
+  template< class T >
+  abramov::Matrix< T > diagonalHeavy(size_t n)
+  {
+    abramov::Matrix< T > res = sample< T >(n, n, 1);
+    for (size_t i = 0; i < n; ++i)
+    {
+      res[i][i] += 10;
+    }
+    return res;
+  }
+
+  template< class T >
+  void benchMatrix(Bench &b, const std::string &type)
+  {
+    using M = abramov::Matrix< T >;
+    const Options &o = b.options;
+    for (size_t n : o.sizes)
+    {
+      if (n > o.max_size)
+      {
+        continue;
+      }
+      double n2 = static_cast< double >(n) * n;
+      auto one = [n]()
+      {
+        return sample< T >(n, n, 1);
+      };
+      auto two = [n]()
+      {
+        return std::make_pair(sample< T >(n, n, 1), sample< T >(n, n, 2));
+      };
+      auto none = []()
+      {
+        return 0;
+      };
+      b.run("Matrix()", type, n, 1, none, [](int)
+      {
+        M m;
+        sink(m);
+      });
+      b.run("Matrix(m,n,value)", type, n, n2, none, [n](int)
+      {
+        M m(n, n, 1);
+        sink(m);
+      });
+      b.run("Matrix(m,n,values)", type, n, n2, [n]()
+      {
+        return std::vector< int >(n * n, 3);
+      }, [n](const std::vector< int > &v)
+      {
+        M m(n, n, v.data());
+        sink(m);
+      });
+      b.run("Matrix(const Matrix&)", type, n, n2, one, [](const M &a)
+      {
+        M m(a);
+        sink(m);
+      });
+      b.run("Matrix(Matrix&&)", type, n, 1, one, [](M &a)
+      {
+        M m(std::move(a));
+        sink(m);
+      });
+      b.run("operator=(const&)", type, n, n2, two, [](std::pair< M, M > &p)
+      {
+        p.first = p.second;
+        sink(p.first);
+      });
+      b.run("operator=(&&)", type, n, n2, two, [](std::pair< M, M > &p)
+      {
+        p.first = std::move(p.second);
+        sink(p.first);
+      });
+      b.run("operator+=", type, n, n2, two, [](std::pair< M, M > &p)
+      {
+        p.first += p.second;
+        sink(p.first);
+      });
+      b.run("operator+", type, n, n2, two, [](const std::pair< M, M > &p)
+      {
+        M m = p.first + p.second;
+        sink(m);
+      });
+      b.run("operator+()", type, n, n2, one, [](const M &a)
+      {
+        M m = +a;
+        sink(m);
+      });
+      b.run("operator-=", type, n, n2, two, [](std::pair< M, M > &p)
+      {
+        p.first -= p.second;
+        sink(p.first);
+      });
+      b.run("operator-", type, n, n2, two, [](const std::pair< M, M > &p)
+      {
+        M m = p.first - p.second;
+        sink(m);
+      });
+      b.run("operator-()", type, n, n2, one, [](const M &a)
+      {
+        M m = -a;
+        sink(m);
+      });
+      b.run("operator*=(T)", type, n, n2, one, [](M &a)
+      {
+        a *= T(3);
+        sink(a);
+      });
+      b.run("operator*(M,T)", type, n, n2, one, [](const M &a)
+      {
+        M m = a * T(3);
+        sink(m);
+      });
+      b.run("operator*(T,M)", type, n, n2, one, [](const M &a)
+      {
+        M m = T(3) * a;
+        sink(m);
+      });
+      b.run("operator==", type, n, n2, two, [](const std::pair< M, M > &p)
+      {
+        bool eq = p.first == p.first;
+        sink(eq);
+      });
+      b.run("transpose", type, n, n2, one, [](const M &a)
+      {
+        M m = a.transpose();
+        sink(m);
+      });
+      b.run("trace", type, n, n, one, [](const M &a)
+      {
+        int t = a.trace();
+        sink(t);
+      });
+      b.run("firstNorm", type, n, n2, one, [](const M &a)
+      {
+        int t = a.firstNorm();
+        sink(t);
+      });
+      b.run("infinityNorm", type, n, n2, one, [](const M &a)
+      {
+        int t = a.infinityNorm();
+        sink(t);
+      });
+      b.run("horizontalConcat", type, n, 2 * n2, two, [](const std::pair< M, M > &p)
+      {
+        M m = M::horizontalConcat(p.first, p.second);
+        sink(m);
+      });
+      b.run("verticalConcat", type, n, 2 * n2, two, [](const std::pair< M, M > &p)
+      {
+        M m = M::verticalConcat(p.first, p.second);
+        sink(m);
+      });
+      b.run("diagonalConcat", type, n, 4 * n2, two, [](const std::pair< M, M > &p)
+      {
+        M m = M::diagonalConcat(p.first, p.second);
+        sink(m);
+      });
+      b.run("BlockAssembly::materialize", type, n, n2, [n]()
+      {
+        std::vector< M > pieces;
+        for (int k = 0; k < 16; ++k)
+        {
+          pieces.push_back(sample< T >((n + 3) / 4, (n + 3) / 4, k));
+        }
+        return pieces;
+      }, [](const std::vector< M > &pieces)
+      {
+        abramov::BlockAssembly< T > grid(4, 4);
+        for (size_t k = 0; k < pieces.size(); ++k)
+        {
+          grid.set(k / 4, k % 4, pieces[k]);
+        }
+        M m = grid.materialize();
+        sink(m);
+      });
+      b.run("format", type, n, n2, one, [](const M &a)
+      {
+        std::string s;
+        a.format(s);
+        sink(s);
+      });
+      b.run("print", type, n, n2, one, [](const M &a)
+      {
+        std::ostringstream out;
+        a.print(out);
+        sink(out);
+      });
+      auto text = [n]()
+      {
+        std::string s = std::to_string(n) + " " + std::to_string(n) + "\n";
+        sample< T >(n, n, 1).format(s);
+        return std::make_pair(s, M());
+      };
+      b.run("parse", type, n, n2, text, [](std::pair< std::string, M > &p)
+      {
+        const char *end = p.second.parse(p.first.data(), p.first.data() + p.first.size());
+        sink(end);
+      });
+      b.run("read", type, n, n2, text, [](std::pair< std::string, M > &p)
+      {
+        std::istringstream in(p.first);
+        p.second.read(in);
+        sink(p.second);
+      });
+      if (n <= 1024)
+      {
+        double n3 = n2 * n;
+        b.run("operator*=(M)", type, n, n3, two, [](std::pair< M, M > &p)
+        {
+          p.first *= p.second;
+          sink(p.first);
+        });
+        b.run("operator*(M,M)", type, n, n3, two, [](const std::pair< M, M > &p)
+        {
+          M m = p.first * p.second;
+          sink(m);
+        });
+        b.run("power(4)", type, n, 2 * n3, one, [](const M &a)
+        {
+          M m = a.power(4);
+          sink(m);
+        });
+        b.run("rank", type, n, n3, one, [](const M &a)
+        {
+          int r = a.rank();
+          sink(r);
+        });
+        b.run("TaskGraph::run", type, n, 8 * 3 * n3, two, [](const std::pair< M, M > &p)
+        {
+          abramov::TaskGraph< T > graph;
+          for (int k = 0; k < 8; ++k)
+          {
+            graph.power(graph.multiply(graph.input(p.first), graph.input(p.second)), 2);
+          }
+          graph.run();
+          sink(graph);
+        });
+      }
+      if (n <= 64)
+      {
+        b.run("kroneckerProduct", type, n, n2 * n2, two, [](const std::pair< M, M > &p)
+        {
+          M m = M::kroneckerProduct(p.first, p.second);
+          sink(m);
+        });
+        b.run("KroneckerOperator::multiply", type, n, 2 * n2 * n, [n]()
+        {
+          return std::make_pair(abramov::KroneckerOperator< T >(sample< T >(n, n, 1), sample< T >(n, n, 2)),
+            std::vector< T >(n * n, 1));
+        }, [](const std::pair< abramov::KroneckerOperator< T >, std::vector< T > > &p)
+        {
+          std::vector< T > y = p.first.multiply(p.second);
+          sink(y);
+        });
+      }
+    }
+    for (size_t n = 4; n <= std::min< size_t >(8, o.max_size); n += 2)
+    {
+      auto square = [n]()
+      {
+        return diagonalHeavy< T >(n);
+      };
+      b.run("determinant", type, n, n, square, [](const M &a)
+      {
+        int d = a.determinant();
+        sink(d);
+      });
+      b.run("perm", type, n, n, square, [](const M &a)
+      {
+        int p = a.perm();
+        sink(p);
+      });
+      b.run("inverse", type, n, n * n, square, [](const M &a)
+      {
+        auto inv = a.inverse();
+        sink(inv);
+      });
+      b.run("solveCramer", type, n, n, [n]()
+      {
+        return M::horizontalConcat(diagonalHeavy< T >(n), sample< T >(n, 1, 3));
+      }, [](const M &a)
+      {
+        auto x = a.solveCramer();
+        sink(x);
+      });
+    }
+  }
+
+  template< class T, size_t N >
+  abramov::Vector< T, N > sampleVector(int seed)
+  {
+    std::array< T, N > arr;
+    for (size_t i = 0; i < N; ++i)
+    {
+      arr[i] = static_cast< T >((i * 37 + seed) % 11) - T(5);
+    }
+    arr[0] = T(7);
+    return abramov::Vector< T, N >(arr);
+  }
+
+  template< class T, size_t N >
+  void benchVector(Bench &b, const std::string &type)
+  {
+    using V = abramov::Vector< T, N >;
+    if (N > b.options.max_size)
+    {
+      return;
+    }
+    double n = N;
+    auto one = []()
+    {
+      return sampleVector< T, N >(1);
+    };
+    auto two = []()
+    {
+      return std::make_pair(sampleVector< T, N >(1), sampleVector< T, N >(2));
+    };
+    b.run("Vector()", type, N, n, []()
+    {
+      return 0;
+    }, [](int)
+    {
+      V v;
+      sink(v);
+    });
+    b.run("Vector(array)", type, N, n, []()
+    {
+      return std::array< T, N >{};
+    }, [](const std::array< T, N > &a)
+    {
+      V v(a);
+      sink(v);
+    });
+    b.run("Vector(const Vector&)", type, N, n, one, [](const V &a)
+    {
+      V v(a);
+      sink(v);
+    });
+    b.run("Vector(Vector&&)", type, N, n, one, [](V &a)
+    {
+      V v(std::move(a));
+      sink(v);
+    });
+    b.run("Vector::operator=(const&)", type, N, n, two, [](std::pair< V, V > &p)
+    {
+      p.first = p.second;
+      sink(p.first);
+    });
+    b.run("Vector::operator=(&&)", type, N, n, two, [](std::pair< V, V > &p)
+    {
+      p.first = std::move(p.second);
+      sink(p.first);
+    });
+    b.run("Vector::operator+=", type, N, n, two, [](std::pair< V, V > &p)
+    {
+      p.first += p.second;
+      sink(p.first);
+    });
+    b.run("Vector::operator+", type, N, n, two, [](const std::pair< V, V > &p)
+    {
+      V v = p.first + p.second;
+      sink(v);
+    });
+    b.run("Vector::operator+()", type, N, n, one, [](const V &a)
+    {
+      V v = +a;
+      sink(v);
+    });
+    b.run("Vector::operator-=", type, N, n, two, [](std::pair< V, V > &p)
+    {
+      p.first -= p.second;
+      sink(p.first);
+    });
+    b.run("Vector::operator-", type, N, n, two, [](const std::pair< V, V > &p)
+    {
+      V v = p.first - p.second;
+      sink(v);
+    });
+    b.run("Vector::operator-()", type, N, n, one, [](const V &a)
+    {
+      V v = -a;
+      sink(v);
+    });
+    b.run("Vector::operator*=", type, N, n, one, [](V &a)
+    {
+      a *= T(2);
+      sink(a);
+    });
+    b.run("Vector::operator*(V,T)", type, N, n, one, [](const V &a)
+    {
+      V v = a * T(2);
+      sink(v);
+    });
+    b.run("Vector::operator*(T,V)", type, N, n, one, [](const V &a)
+    {
+      V v = T(2) * a;
+      sink(v);
+    });
+    b.run("Vector::operator==", type, N, n, two, [](const std::pair< V, V > &p)
+    {
+      bool eq = p.first == p.first;
+      sink(eq);
+    });
+    b.run("Vector::operator!=", type, N, n, two, [](const std::pair< V, V > &p)
+    {
+      bool ne = p.first != p.second;
+      sink(ne);
+    });
+    b.run("Vector::dot", type, N, n, two, [](const std::pair< V, V > &p)
+    {
+      T d = p.first.dot(p.second);
+      sink(d);
+    });
+    b.run("Vector::norm", type, N, n, one, [](const V &a)
+    {
+      double d = a.norm();
+      sink(d);
+    });
+    b.run("Vector::normalized", type, N, n, one, [](const V &a)
+    {
+      auto v = a.normalized();
+      sink(v);
+    });
+    b.run("Vector::distance", type, N, n, two, [](const std::pair< V, V > &p)
+    {
+      double d = p.first.distance(p.second);
+      sink(d);
+    });
+    b.run("Vector::angle", type, N, n, two, [](const std::pair< V, V > &p)
+    {
+      double d = p.first.angle(p.second);
+      sink(d);
+    });
+    b.run("Vector::dot(Kahan)", type, N, n, two, [](const std::pair< V, V > &p)
+    {
+      T d = p.first.dot(p.second, abramov::Summation::Kahan);
+      sink(d);
+    });
+    b.run("Vector::dot(Pairwise)", type, N, n, two, [](const std::pair< V, V > &p)
+    {
+      T d = p.first.dot(p.second, abramov::Summation::Pairwise);
+      sink(d);
+    });
+    b.run("dots", type, N, n * 64, []()
+    {
+      std::vector< V > items;
+      for (int k = 0; k < 64; ++k)
+      {
+        items.push_back(sampleVector< T, N >(k));
+      }
+      return std::make_pair(sampleVector< T, N >(1), std::move(items));
+    }, [](const std::pair< V, std::vector< V > > &p)
+    {
+      auto d = abramov::dots(p.first, p.second);
+      sink(d);
+    });
+    b.run("distances", type, N, n * 64, []()
+    {
+      std::vector< V > items;
+      for (int k = 0; k < 64; ++k)
+      {
+        items.push_back(sampleVector< T, N >(k));
+      }
+      return std::make_pair(sampleVector< T, N >(1), std::move(items));
+    }, [](const std::pair< V, std::vector< V > > &p)
+    {
+      auto d = abramov::distances(p.first, p.second);
+      sink(d);
+    });
+    if constexpr (N == 3)
+    {
+      b.run("Vector::cross", type, N, n, two, [](const std::pair< V, V > &p)
+      {
+        V v = p.first.cross(p.second);
+        sink(v);
+      });
+      b.run("Vector::triple", type, N, n, two, [](const std::pair< V, V > &p)
+      {
+        T t = p.first.triple(p.second, p.first + p.second);
+        sink(t);
+      });
+    }
+    if constexpr (N == 2)
+    {
+      b.run("Vector::cross2D", type, N, n, two, [](const std::pair< V, V > &p)
+      {
+        T t = p.first.cross2D(p.second);
+        sink(t);
+      });
+    }
+    auto text = []()
+    {
+      std::ostringstream out;
+      out << N;
+      for (size_t i = 0; i < N; ++i)
+      {
+        out << ' ' << (i % 7);
+      }
+      return std::make_pair(out.str(), V());
+    };
+    b.run("Vector::read", type, N, n, text, [](std::pair< std::string, V > &p)
+    {
+      std::istringstream in(p.first);
+      p.second.read(in);
+      sink(p.second);
+    });
+    b.run("Vector::print", type, N, n, one, [](const V &a)
+    {
+      std::ostringstream out;
+      a.print(out);
+      sink(out);
+    });
+  }
+
+  template< class T >
+  void benchVectors(Bench &b, const std::string &type)
+  {
+    benchVector< T, 2 >(b, type);
+    benchVector< T, 3 >(b, type);
+    benchVector< T, 16 >(b, type);
+    benchVector< T, 256 >(b, type);
+    benchVector< T, 4096 >(b, type);
+  }
+
+  template< class A, class B, class Acc >
+  void benchQgemm(Bench &b, const std::string &type, abramov::GemmKernel kernel)
+  {
+    const Options &o = b.options;
+    for (size_t n : o.sizes)
+    {
+      if (n > std::min< size_t >(o.max_size, 1024) || !abramov::gemmSupported(kernel))
+      {
+        continue;
+      }
+      double n3 = static_cast< double >(n) * n * n;
+      b.run("qgemm", type, n, n3, [n]()
+      {
+        return std::make_pair(sample< A >(n, n, 1), sample< B >(n, n, 2));
+      }, [kernel](const std::pair< abramov::Matrix< A >, abramov::Matrix< B > > &p)
+      {
+        auto m = abramov::qgemm< Acc >(p.first, p.second, kernel);
+        sink(m);
+      });
+      b.run("qgemm(packed)", type, n, n3, [n]()
+      {
+        return std::make_pair(abramov::PackedLhs(sample< A >(n, n, 1)), abramov::PackedRhs(sample< B >(n, n, 2)));
+      }, [kernel](const std::pair< abramov::PackedLhs, abramov::PackedRhs > &p)
+      {
+        auto m = abramov::qgemm< Acc >(p.first, p.second, kernel);
+        sink(m);
+      });
+    }
+  }
+
+  void benchNuma(Bench &b)
+  {
+    using M = abramov::Matrix< int >;
+    const Options &o = b.options;
+    const std::pair< abramov::Placement, std::string > policies[] = {
+      { abramov::Placement::Local, "local" },
+      { abramov::Placement::Interleave, "interleave" },
+      { abramov::Placement::RowBlocks, "rowblocks" }
+    };
+    for (size_t n : o.sizes)
+    {
+      if (n < 1024 || n > o.max_size)
+      {
+        continue;
+      }
+      double n2 = static_cast< double >(n) * n;
+      for (const auto &[policy, name] : policies)
+      {
+        abramov::setPlacement(policy);
+        b.run("Matrix(m,n,value)[" + name + "]", "int", n, n2, []()
+        {
+          return 0;
+        }, [n](int)
+        {
+          M m(n, n, 1);
+          sink(m);
+        });
+        auto one = [n]()
+        {
+          return sample< int >(n, n, 1);
+        };
+        b.run("rowSums(parallelFor)[" + name + "]", "int", n, n2, one, [](const M &a)
+        {
+          std::vector< long long > sums(a.getRows());
+          abramov::parallelFor(0, a.getRows(), [&](size_t lo, size_t hi)
+          {
+            for (size_t i = lo; i < hi; ++i)
+            {
+              long long s = 0;
+              for (size_t j = 0; j < a.getCols(); ++j)
+              {
+                s += a[i][j];
+              }
+              sums[i] = s;
+            }
+          });
+          sink(sums);
+        });
+        b.run("rowSums(numaParallelFor)[" + name + "]", "int", n, n2, one, [](const M &a)
+        {
+          std::vector< long long > sums(a.getRows());
+          abramov::numaParallelFor(0, a.getRows(), [&](size_t lo, size_t hi)
+          {
+            for (size_t i = lo; i < hi; ++i)
+            {
+              long long s = 0;
+              for (size_t j = 0; j < a.getCols(); ++j)
+              {
+                s += a[i][j];
+              }
+              sums[i] = s;
+            }
+          });
+          sink(sums);
+        });
+      }
+      abramov::setPlacement(abramov::Placement::Local);
+    }
+  }
+
+  void benchHugePages(Bench &b)
+  {
+    using M = abramov::Matrix< int >;
+    const Options &o = b.options;
+    const std::pair< abramov::HugePages, std::string > modes[] = {
+      { abramov::HugePages::Off, "4k" },
+      { abramov::HugePages::Transparent, "thp" }
+    };
+    for (size_t n : o.sizes)
+    {
+      if (n < 1024 || n > o.max_size)
+      {
+        continue;
+      }
+      double n2 = static_cast< double >(n) * n;
+      for (const auto &[mode, name] : modes)
+      {
+        abramov::setHugePages(mode);
+        auto one = [n]()
+        {
+          return sample< int >(n, n, 1);
+        };
+        auto two = [n]()
+        {
+          return std::make_pair(sample< int >(n, n, 1), sample< int >(n, n, 2));
+        };
+        b.run("transpose[" + name + "]", "int", n, n2, one, [](const M &a)
+        {
+          M m = a.transpose();
+          sink(m);
+        });
+        if (n <= 1024)
+        {
+          b.run("operator*=(M)[" + name + "]", "int", n, n2 * n, two, [](std::pair< M, M > &p)
+          {
+            p.first *= p.second;
+            sink(p.first);
+          });
+        }
+      }
+      abramov::setHugePages(abramov::HugePages::Off);
+    }
+  }
+
+  void benchDistributed(Bench &b)
+  {
+    using M = abramov::Matrix< int >;
+    const Options &o = b.options;
+    for (size_t n : o.sizes)
+    {
+      if (n < 256 || n > std::min< size_t >(o.max_size, 1024))
+      {
+        continue;
+      }
+      double n2 = static_cast< double >(n) * n;
+      auto two = [n]()
+      {
+        return std::make_pair(sample< int >(n, n, 1), sample< int >(n, n, 2));
+      };
+      for (size_t processes : { 1, 2, 4 })
+      {
+        std::string suffix = "(P=" + std::to_string(processes) + ")";
+        b.run("distributedMultiply" + suffix, "int", n, n2 * n, two, [processes](const std::pair< M, M > &p)
+        {
+          abramov::runProcesses(processes, [&p](abramov::Transport &transport)
+          {
+            M res = abramov::distributedMultiply(p.first, p.second, transport);
+            sink(res);
+          });
+        });
+        b.run("distributedTranspose" + suffix, "int", n, n2, two, [processes](const std::pair< M, M > &p)
+        {
+          abramov::runProcesses(processes, [&p](abramov::Transport &transport)
+          {
+            M res = abramov::distributedTranspose(p.first, transport);
+            sink(res);
+          });
+        });
+      }
+    }
+  }
+
+  void benchEigen(Bench &b)
+  {
+    using M = abramov::Matrix< int >;
+    const Options &o = b.options;
+    for (size_t n : o.sizes)
+    {
+      if (n > std::min< size_t >(o.max_size, 512))
+      {
+        continue;
+      }
+      double n3 = static_cast< double >(n) * n * n;
+      auto one = [n]()
+      {
+        return sample< int >(n, n, 1);
+      };
+      if (n <= 128)
+      {
+        b.run("characteristicPolynomial", "int", n, n3, one, [](const M &a)
+        {
+          auto poly = abramov::characteristicPolynomial(a, abramov::Charpoly::Hessenberg, 1);
+          sink(poly.coefficients);
+        });
+      }
+      if (n <= 64)
+      {
+        b.run("characteristicPolynomial(Berkowitz)", "int", n, n3 * n, one, [](const M &a)
+        {
+          auto poly = abramov::characteristicPolynomial(a, abramov::Charpoly::Berkowitz, 1);
+          sink(poly.coefficients);
+        });
+      }
+      b.run("eigenvalues", "int", n, n3, one, [](const M &a)
+      {
+        auto values = abramov::eigenvalues(a);
+        sink(values);
+      });
+    }
+  }
+
+  void benchNormalForms(Bench &b)
+  {
+    using M = abramov::Matrix< int >;
+    const Options &o = b.options;
+    for (size_t n : o.sizes)
+    {
+      if (n > std::min< size_t >(o.max_size, 256))
+      {
+        continue;
+      }
+      double n3 = static_cast< double >(n) * n * n;
+      auto one = [n]()
+      {
+        return sample< int >(n, n, 1);
+      };
+      b.run("hermiteForm", "int", n, n3, one, [](const M &a)
+      {
+        auto form = abramov::hermiteForm(a, false);
+        sink(form.h);
+      });
+      b.run("smithForm", "int", n, n3, one, [](const M &a)
+      {
+        auto form = abramov::smithForm(a, false);
+        sink(form.diagonal);
+      });
+      if (n <= 128)
+      {
+        b.run("hermiteForm(transform)", "int", n, n3, one, [](const M &a)
+        {
+          auto form = abramov::hermiteForm(a);
+          sink(form.u);
+        });
+      }
+    }
+  }
+
+  void benchGf2(Bench &b)
+  {
+    using M = abramov::Matrix< int >;
+    const Options &o = b.options;
+    for (size_t n : o.sizes)
+    {
+      if (n > std::min< size_t >(o.max_size, 4096))
+      {
+        continue;
+      }
+      double n3 = static_cast< double >(n) * n * n;
+      auto bits = [n]()
+      {
+        M res(n, n, 0);
+        uint64_t state = 88172645463325252ULL;
+        for (size_t i = 0; i < n; ++i)
+        {
+          for (size_t j = 0; j < n; ++j)
+          {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            res[i][j] = static_cast< int >(state & 1);
+          }
+        }
+        return res;
+      };
+      b.run("Gf2Matrix::operator*", "bit", n, n3, bits, [](const M &a)
+      {
+        abramov::Gf2Matrix g(a);
+        sink(g * g);
+      });
+      b.run("Gf2Matrix::rank", "bit", n, n3, bits, [](const M &a)
+      {
+        sink(abramov::Gf2Matrix(a).rank());
+      });
+      b.run("Gf2Matrix::inverse", "bit", n, n3, bits, [](const M &a)
+      {
+        abramov::Gf2Matrix g(a);
+        g.set(0, 0, !g.get(0, 0));
+        try
+        {
+          sink(g.inverse());
+        }
+        catch (const std::logic_error &)
+        {
+          sink(g.rank());
+        }
+      });
+    }
+  }
+
+  void benchStructured(Bench &b)
+  {
+    using M = abramov::Matrix< int >;
+    using Band = abramov::BandedMatrix< int >;
+    const Options &o = b.options;
+    const size_t width = 8;
+    for (size_t n : o.sizes)
+    {
+      if (n > o.max_size)
+      {
+        continue;
+      }
+      double band = static_cast< double >(n) * (2 * width + 1);
+      auto dense = [n, width]()
+      {
+        M res = sample< int >(n, n, 11);
+        for (size_t i = 0; i < n; ++i)
+        {
+          for (size_t j = 0; j < n; ++j)
+          {
+            res[i][j] = j + width < i || i + width < j ? 0 : res[i][j] + (i == j ? 8 : 0);
+          }
+        }
+        return res;
+      };
+      auto banded = [dense, width]()
+      {
+        return Band(dense(), width, width);
+      };
+      auto unit = [dense, width]()
+      {
+        M res = dense();
+        for (size_t i = 0; i < res.getRows(); ++i)
+        {
+          std::fill(res[i], res[i] + i, 0);
+          res[i][i] = 1;
+        }
+        return Band(res, width, width);
+      };
+      b.run("BandedMatrix::operator*", "int", n, band * (2 * width + 1), banded, [](const Band &x)
+      {
+        sink(x * x);
+      });
+      b.run("BandedMatrix::determinant", "int", n, band * width, unit, [](const Band &x)
+      {
+        sink(x.determinant());
+      });
+      b.run("BandedMatrix::solve", "int", n, band * width, banded, [n](const Band &x)
+      {
+        sink(x.solve(std::vector< int >(n, 1)));
+      });
+      auto toeplitz = [dense, n]()
+      {
+        M a = dense();
+        std::vector< int > column(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+          column[i] = a[i][0];
+        }
+        return abramov::ToeplitzMatrix< int >(column, std::vector< int >(a[0], a[0] + n));
+      };
+      b.run("ToeplitzMatrix::solve", "int", n, static_cast< double >(n) * n, toeplitz,
+        [n](const abramov::ToeplitzMatrix< int > &t)
+      {
+        sink(t.solve(std::vector< int >(n, 1)));
+      });
+      auto triangular = [dense, n]()
+      {
+        M a = dense();
+        for (size_t i = 0; i < n; ++i)
+        {
+          std::fill(a[i] + i + 1, a[i] + n, 0);
+        }
+        return abramov::TriangularMatrix< int >(a, abramov::Triangle::Lower);
+      };
+      b.run("TriangularMatrix::solve", "int", n, static_cast< double >(n) * n / 2, triangular,
+        [n](const abramov::TriangularMatrix< int > &t)
+      {
+        sink(t.solve(std::vector< int >(n, 1)));
+      });
+    }
+  }
+
+  void benchNtt(Bench &b)
+  {
+    using M = abramov::Matrix< int >;
+    using Toeplitz = abramov::ToeplitzMatrix< int >;
+    const Options &o = b.options;
+    for (size_t n : o.sizes)
+    {
+      if (n > o.max_size)
+      {
+        continue;
+      }
+      double nlogn = static_cast< double >(n) * std::max(1.0, std::log2(static_cast< double >(n)));
+      auto signals = [n]()
+      {
+        M a = sample< int >(2, n, 5);
+        return std::make_pair(std::vector< int >(a[0], a[0] + n), std::vector< int >(a[1], a[1] + n));
+      };
+      b.run("convolve", "int", n, nlogn, signals, [](const std::pair< std::vector< int >, std::vector< int > > &s)
+      {
+        sink(abramov::convolve(s.first, s.second));
+      });
+      b.run("directConvolve", "int", n, static_cast< double >(n) * n, signals,
+        [n](const std::pair< std::vector< int >, std::vector< int > > &s)
+      {
+        std::vector< int > res(2 * n - 1);
+        abramov::directConvolve< abramov::Wrapping >(s.first.data(), n, s.second.data(), n, res.data());
+        sink(res);
+      });
+      auto toeplitz = [signals]()
+      {
+        auto s = signals();
+        s.second[0] = s.first[0];
+        return std::make_pair(Toeplitz(s.first, s.second), sample< int >(signals().first.size(), 16, 9));
+      };
+      b.run("ToeplitzMatrix::operator*(Matrix)", "int", n, nlogn * 16, toeplitz, [](const std::pair< Toeplitz, M > &s)
+      {
+        sink(s.first * s.second);
+      });
+      b.run("circulantMultiply", "int", n, nlogn, signals, [](const std::pair< std::vector< int >, std::vector< int > > &s)
+      {
+        sink(abramov::circulantMultiply(Toeplitz::circulant(s.first), Toeplitz::circulant(s.second)));
+      });
+      b.run("linearRecurrence", "int", n, nlogn * 64, signals, [](const std::pair< std::vector< int >, std::vector< int > > &s)
+      {
+        sink(abramov::linearRecurrence(s.first, s.second, 1ULL << 62));
+      });
+      auto polynomials = [n]()
+      {
+        abramov::PolynomialMatrix< int > a(8, 8, n);
+        M values = sample< int >(64, n, 3);
+        for (size_t e = 0; e < 64; ++e)
+        {
+          std::copy_n(values[e], n, a.entry(e / 8, e % 8));
+        }
+        return a;
+      };
+      b.run("polynomialMultiply", "int", n, 512 * nlogn, polynomials, [](const abramov::PolynomialMatrix< int > &a)
+      {
+        sink(a * a);
+      });
+    }
+  }
+
+  void benchRandom(Bench &b)
+  {
+    const Options &o = b.options;
+    for (size_t n : o.sizes)
+    {
+      if (n > o.max_size)
+      {
+        continue;
+      }
+      double n2 = static_cast< double >(n) * n;
+      auto none = []()
+      {
+        return 0;
+      };
+      b.run("randomMatrix", "int", n, n2, none, [n](int)
+      {
+        sink(abramov::randomMatrix(n, n, 1, -1000, 1000));
+      });
+      b.run("randomMatrix(serial)", "int", n, n2, none, [n](int)
+      {
+        sink(abramov::randomMatrix(n, n, 1, -1000, 1000, 1));
+      });
+      b.run("randomSparse", "int", n, n2, none, [n](int)
+      {
+        sink(abramov::randomSparse(n, n, 0.05, 2, -1000, 1000));
+      });
+      b.run("randomBanded", "int", n, n2, none, [n](int)
+      {
+        sink(abramov::randomBanded(n, 3, 3, 3, -1000, 1000));
+      });
+      if (n > 1024)
+      {
+        continue;
+      }
+      b.run("randomWithDeterminant", "int", n, n2 * n, none, [n](int)
+      {
+        sink(abramov::randomWithDeterminant(std::vector< int >(n, 1), 4, -3, 3));
+      });
+      b.run("checkProperty", "int", n, 64 * n2, none, [n](int)
+      {
+        sink(abramov::checkProperty("square", 64, 5, [n](abramov::RandomStream &s)
+        {
+          abramov::Matrix< int > a = abramov::randomMatrix(n, n, s.next(), -9, 9, 1);
+          return a.trace() == abramov::Matrix< int >(a).trace();
+        }).failures);
+      });
+    }
+  }
+
+  abramov::Matrix< int > graph(size_t n, int seed, int missing)
+  {
+    abramov::Matrix< int > res(n, n, 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        size_t h = (i * 2654435761u + j * 40503u + static_cast< size_t >(seed)) % 97;
+        res[i][j] = h < 5 ? static_cast< int >(1 + h * 7) : missing;
+      }
+    }
+    return res;
+  }
+
+  void benchSemirings(Bench &b)
+  {
+    using M = abramov::Matrix< int >;
+    const Options &o = b.options;
+    for (size_t n : o.sizes)
+    {
+      if (n > std::min< size_t >(o.max_size, 1024))
+      {
+        continue;
+      }
+      double n3 = static_cast< double >(n) * n * n;
+      auto sparse = [n]()
+      {
+        return graph(n, 1, 0);
+      };
+      auto weights = [n]()
+      {
+        return graph(n, 1, abramov::MinPlus< int >::zero());
+      };
+      b.run("semiringMultiply(or-and)", "int", n, n3, sparse, [](const M &a)
+      {
+        sink(abramov::semiringMultiply< abramov::OrAnd< int > >(a, a));
+      });
+      b.run("semiringMultiply(min-plus)", "int", n, n3, weights, [](const M &a)
+      {
+        sink(abramov::semiringMultiply< abramov::MinPlus< int > >(a, a));
+      });
+      b.run("booleanMultiply", "bit", n, n3, sparse, [](const M &a)
+      {
+        abramov::BitMatrix bits(a);
+        sink(abramov::booleanMultiply(bits, bits).count());
+      });
+      b.run("countingMultiply", "bit", n, n3, sparse, [](const M &a)
+      {
+        abramov::BitMatrix bits(a);
+        sink(abramov::countingMultiply< int >(bits, bits));
+      });
+      b.run("transitiveClosure", "bit", n, n3, sparse, [](const M &a)
+      {
+        sink(abramov::transitiveClosure(abramov::BitMatrix(a)).count());
+      });
+      if (n <= 512)
+      {
+        b.run("shortestPaths", "int", n, n3, weights, [](const M &a)
+        {
+          sink(abramov::shortestPaths(a));
+        });
+      }
+    }
+  }
+
+  template< class T, size_t N >
+  void benchKnn(Bench &b, const std::string &type, size_t n)
+  {
+    if (n > b.options.max_size)
+    {
+      return;
+    }
+    auto points = [n]()
+    {
+      std::vector< abramov::Vector< T, N > > res;
+      for (size_t k = 0; k < n; ++k)
+      {
+        res.push_back(sampleVector< T, N >(static_cast< int >(k * 7)));
+        res.back()[k % N] += T(k % 5);
+      }
+      return res;
+    };
+    using Points = std::vector< abramov::Vector< T, N > >;
+    std::string dim = "[" + std::to_string(N) + "]";
+    if constexpr (N <= 8)
+    {
+      b.run("KdTree::KdTree" + dim, type, n, n, points, [](const Points &p)
+      {
+        abramov::KdTree< T, N > tree(p);
+        sink(tree);
+      });
+      b.run("KdTree::query" + dim, type, n, n, [&points]()
+      {
+        return abramov::KdTree< T, N >(points());
+      }, [](const abramov::KdTree< T, N > &tree)
+      {
+        auto res = tree.query(sampleVector< T, N >(3), 10);
+        sink(res);
+      });
+    }
+    b.run("FlatIndex::query" + dim, type, n, n, [&points]()
+    {
+      return abramov::FlatIndex< T, N >(points());
+    }, [](const abramov::FlatIndex< T, N > &index)
+    {
+      auto res = index.query(sampleVector< T, N >(3), 10);
+      sink(res);
+    });
+    b.run("IvfIndex::IvfIndex" + dim, type, n, n, points, [](const Points &p)
+    {
+      abramov::IvfIndex< T, N > index(p);
+      sink(index);
+    });
+    b.run("IvfIndex::query" + dim, type, n, n, [&points]()
+    {
+      return abramov::IvfIndex< T, N >(points());
+    }, [](const abramov::IvfIndex< T, N > &index)
+    {
+      auto res = index.query(sampleVector< T, N >(3), 10);
+      sink(res);
+    });
+  }
+
+  std::string quoted(const std::string &s)
+  {
+    std::string res = "\"";
+    for (char c : s)
+    {
+      if (c == '"' || c == '\\')
+      {
+        res += '\\';
+      }
+      res += c;
+    }
+    return res + "\"";
+  }
+
+  void writeJson(std::ostream &out, const std::vector< Result > &results)
+  {
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+      const Result &r = results[i];
+      out << "  { \"op\": " << quoted(r.op) << ", \"type\": " << quoted(r.type) << ", \"size\": " << r.size
+        << ", \"iterations\": " << r.iterations << std::setprecision(6) << std::defaultfloat
+        << ", \"ns_per_op\": " << r.ns_per_op << ", \"items_per_second\": " << r.items_per_second
+        << ", \"allocs_per_op\": " << r.allocs_per_op << ", \"bytes_per_op\": " << r.bytes_per_op << " }"
+        << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+  }
+
+  std::string field(const std::string &line, const std::string &name)
+  {
+    std::string key = "\"" + name + "\": ";
+    size_t pos = line.find(key);
+    if (pos == std::string::npos)
+    {
+      return "";
+    }
+    pos += key.size();
+    if (line[pos] == '"')
+    {
+      std::string res;
+      for (++pos; pos < line.size() && line[pos] != '"'; ++pos)
+      {
+        if (line[pos] == '\\')
+        {
+          ++pos;
+        }
+        res += line[pos];
+      }
+      return res;
+    }
+    size_t end = line.find_first_of(",}", pos);
+    return line.substr(pos, end - pos);
+  }
+
+  size_t compare(const std::string &path, const std::vector< Result > &results, double threshold)
+  {
+    std::ifstream in(path);
+    if (!in)
+    {
+      std::cerr << "Can not open baseline " << path << "\n";
+      return 0;
+    }
+    std::map< std::tuple< std::string, std::string, size_t >, double > base;
+    std::string line;
+    while (std::getline(in, line))
+    {
+      std::string ns = field(line, "ns_per_op");
+      if (!ns.empty())
+      {
+        base[{ field(line, "op"), field(line, "type"), std::stoul(field(line, "size")) }] = std::stod(ns);
+      }
+    }
+    size_t regressions = 0;
+    for (const Result &r : results)
+    {
+      auto it = base.find({ r.op, r.type, r.size });
+      if (it == base.end())
+      {
+        continue;
+      }
+      double ratio = r.ns_per_op / it->second;
+      if (ratio > 1 + threshold && r.ns_per_op - it->second > 5)
+      {
+        ++regressions;
+        std::cout << "REGRESSION " << r.op << ' ' << r.type << ' ' << r.size << ": " << std::fixed
+          << std::setprecision(1) << it->second << " -> " << r.ns_per_op << " ns/op (x" << std::setprecision(2) << ratio << ")\n";
+      }
+    }
+    std::cout << regressions << " regression(s) against " << path << "\n";
+    return regressions;
+  }
+
+  std::vector< size_t > parseSizes(const std::string &s)
+  {
+    std::vector< size_t > res;
+    std::istringstream in(s);
+    std::string item;
+    while (std::getline(in, item, ','))
+    {
+      res.push_back(std::stoul(item));
+    }
+    return res;
+  }
+}
+
+__attribute__((noinline)) void *operator new(size_t size)
+{
+  ++alloc_count;
+  alloc_bytes += size;
+  if (void *p = std::malloc(size ? size : 1))
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void *operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void *p) noexcept
+{
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (i + 1 >= argc)
+    {
+      std::cerr << "Missing value for " << arg << "\n";
+      return 2;
+    }
+    std::string value = argv[++i];
+    if (arg == "--sizes")
+    {
+      options.sizes = parseSizes(value);
+    }
+    else if (arg == "--max-size")
+    {
+      options.max_size = std::stoul(value);
+    }
+    else if (arg == "--min-time")
+    {
+      options.min_time = std::stod(value);
+    }
+    else if (arg == "--threshold")
+    {
+      options.threshold = std::stod(value);
+    }
+    else if (arg == "--filter")
+    {
+      options.filter = value;
+    }
+    else if (arg == "--json")
+    {
+      options.json = value;
+    }
+    else if (arg == "--baseline")
+    {
+      options.baseline = value;
+    }
+    else
+    {
+      std::cerr << "Unknown option " << arg << "\n";
+      return 2;
+    }
+  }
+  Bench bench{ options, {} };
+  benchMatrix< int >(bench, "int");
+  benchVectors< int >(bench, "int");
+  benchVectors< float >(bench, "float");
+  benchVectors< double >(bench, "double");
+  benchNuma(bench);
+  benchHugePages(bench);
+  benchDistributed(bench);
+  benchEigen(bench);
+  benchNormalForms(bench);
+  benchSemirings(bench);
+  benchGf2(bench);
+  benchStructured(bench);
+  benchNtt(bench);
+  benchRandom(bench);
+  benchQgemm< int8_t, int8_t, int32_t >(bench, "int8", abramov::GemmKernel::Auto);
+  benchQgemm< uint8_t, int8_t, int32_t >(bench, "uint8*int8", abramov::GemmKernel::Auto);
+  benchQgemm< int16_t, int16_t, int32_t >(bench, "int16", abramov::GemmKernel::Auto);
+  benchQgemm< int16_t, int16_t, int64_t >(bench, "int16->int64", abramov::GemmKernel::Auto);
+  benchQgemm< int8_t, int8_t, int32_t >(bench, "int8/portable", abramov::GemmKernel::Portable);
+  benchQgemm< int8_t, int8_t, int32_t >(bench, "int8/avx2", abramov::GemmKernel::Avx2);
+  benchKnn< float, 3 >(bench, "float", 4096);
+  benchKnn< float, 256 >(bench, "float", 2048);
+  if (!options.json.empty())
+  {
+    std::ofstream out(options.json);
+    writeJson(out, bench.results);
+  }
+  if (!options.baseline.empty() && compare(options.baseline, bench.results, options.threshold))
+  {
+    return 1;
+  }
+}
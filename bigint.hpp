@@ -0,0 +1,553 @@
+#ifndef BIGINT_HPP
+#define BIGINT_HPP
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace abramov
+{
+  struct BigInt;
+
+  BigInt operator+(BigInt lhs, const BigInt &rhs);
+  BigInt operator-(BigInt lhs, const BigInt &rhs);
+  BigInt operator*(const BigInt &lhs, const BigInt &rhs);
+  BigInt operator/(BigInt lhs, const BigInt &rhs);
+  BigInt operator%(BigInt lhs, const BigInt &rhs);
+
+  struct BigInt
+  {
+    friend BigInt operator*(const BigInt &lhs, const BigInt &rhs);
+
+    BigInt();
+    template< std::integral V >
+    BigInt(V value);
+    BigInt(__int128 value);
+    explicit BigInt(const std::string &text);
+    BigInt &operator+=(const BigInt &other);
+    BigInt &operator-=(const BigInt &other);
+    BigInt &operator*=(const BigInt &other);
+    BigInt &operator/=(const BigInt &other);
+    BigInt &operator%=(const BigInt &other);
+    BigInt operator-() const;
+    bool operator==(const BigInt &other) const noexcept;
+    std::strong_ordering operator<=>(const BigInt &other) const noexcept;
+    explicit operator double() const noexcept;
+
+    bool isZero() const noexcept;
+    bool isNegative() const noexcept;
+    size_t bits() const noexcept;
+    BigInt &mulAdd(uint32_t factor, uint32_t addend);
+    uint32_t divSmall(uint32_t divisor);
+    uint32_t modSmall(uint32_t divisor) const noexcept;
+    static std::pair< BigInt, BigInt > divMod(const BigInt &lhs, const BigInt &rhs);
+    std::string toString() const;
+
+    std::ostream &print(std::ostream &out = std::cout) const;
+    std::istream &read(std::istream &in = std::cin);
+  private:
+    bool negative;
+    std::vector< uint32_t > limbs;
+
+    void assign(bool neg, unsigned __int128 magnitude);
+    void trim() noexcept;
+    static int compareMagnitude(const std::vector< uint32_t > &lhs, const std::vector< uint32_t > &rhs) noexcept;
+    static void addMagnitude(std::vector< uint32_t > &lhs, const std::vector< uint32_t > &rhs);
+    static void subMagnitude(std::vector< uint32_t > &lhs, const std::vector< uint32_t > &rhs) noexcept;
+    static void divMagnitude(const std::vector< uint32_t > &lhs, const std::vector< uint32_t > &rhs,
+      std::vector< uint32_t > &quotient, std::vector< uint32_t > &remainder);
+  };
+}
+
+inline abramov::BigInt::BigInt():
+  negative(false),
+  limbs()
+{}
+
+template< std::integral V >
+abramov::BigInt::BigInt(V value):
+  negative(false),
+  limbs()
+{
+  if constexpr (std::is_signed_v< V >)
+  {
+    assign(value < 0, value < 0 ? -static_cast< unsigned __int128 >(value) : value);
+  }
+  else
+  {
+    assign(false, value);
+  }
+}
+
+inline abramov::BigInt::BigInt(__int128 value):
+  negative(false),
+  limbs()
+{
+  assign(value < 0, value < 0 ? -static_cast< unsigned __int128 >(value) : value);
+}
+
+inline abramov::BigInt::BigInt(const std::string &text):
+  negative(false),
+  limbs()
+{
+  size_t i = 0;
+  bool neg = false;
+  if (i < text.size() && (text[i] == '-' || text[i] == '+'))
+  {
+    neg = text[i] == '-';
+    ++i;
+  }
+  if (i == text.size())
+  {
+    throw std::invalid_argument("Invalid number\n");
+  }
+  while (i < text.size())
+  {
+    uint32_t chunk = 0;
+    uint32_t scale = 1;
+    for (size_t d = 0; d < 9 && i < text.size(); ++d, ++i)
+    {
+      if (text[i] < '0' || text[i] > '9')
+      {
+        throw std::invalid_argument("Invalid number\n");
+      }
+      chunk = chunk * 10 + (text[i] - '0');
+      scale *= 10;
+    }
+    mulAdd(scale, chunk);
+  }
+  negative = neg && !limbs.empty();
+}
+
+inline abramov::BigInt &abramov::BigInt::operator+=(const BigInt &other)
+{
+  if (negative == other.negative)
+  {
+    addMagnitude(limbs, other.limbs);
+  }
+  else if (compareMagnitude(limbs, other.limbs) >= 0)
+  {
+    subMagnitude(limbs, other.limbs);
+  }
+  else
+  {
+    std::vector< uint32_t > res = other.limbs;
+    subMagnitude(res, limbs);
+    limbs.swap(res);
+    negative = other.negative;
+  }
+  trim();
+  return *this;
+}
+
+inline abramov::BigInt &abramov::BigInt::operator-=(const BigInt &other)
+{
+  if (this == &other)
+  {
+    limbs.clear();
+    negative = false;
+    return *this;
+  }
+  negative = !negative;
+  *this += other;
+  negative = !negative && !limbs.empty();
+  return *this;
+}
+
+inline abramov::BigInt &abramov::BigInt::operator*=(const BigInt &other)
+{
+  *this = *this * other;
+  return *this;
+}
+
+inline abramov::BigInt abramov::BigInt::operator-() const
+{
+  BigInt res(*this);
+  res.negative = !negative && !limbs.empty();
+  return res;
+}
+
+inline bool abramov::BigInt::operator==(const BigInt &other) const noexcept
+{
+  return negative == other.negative && limbs == other.limbs;
+}
+
+inline std::strong_ordering abramov::BigInt::operator<=>(const BigInt &other) const noexcept
+{
+  if (negative != other.negative)
+  {
+    return negative ? std::strong_ordering::less : std::strong_ordering::greater;
+  }
+  int cmp = compareMagnitude(limbs, other.limbs);
+  if (negative)
+  {
+    cmp = -cmp;
+  }
+  return cmp < 0 ? std::strong_ordering::less : cmp > 0 ? std::strong_ordering::greater : std::strong_ordering::equal;
+}
+
+inline abramov::BigInt::operator double() const noexcept
+{
+  double res = 0.0;
+  for (size_t i = limbs.size(); i > 0; --i)
+  {
+    res = res * 4294967296.0 + limbs[i - 1];
+  }
+  return negative ? -res : res;
+}
+
+inline bool abramov::BigInt::isZero() const noexcept
+{
+  return limbs.empty();
+}
+
+inline bool abramov::BigInt::isNegative() const noexcept
+{
+  return negative;
+}
+
+inline size_t abramov::BigInt::bits() const noexcept
+{
+  if (limbs.empty())
+  {
+    return 0;
+  }
+  size_t top = 32 - __builtin_clz(limbs.back());
+  return (limbs.size() - 1) * 32 + top;
+}
+
+inline abramov::BigInt &abramov::BigInt::mulAdd(uint32_t factor, uint32_t addend)
+{
+  uint64_t carry = addend;
+  for (uint32_t &limb : limbs)
+  {
+    uint64_t cur = static_cast< uint64_t >(limb) * factor + carry;
+    limb = static_cast< uint32_t >(cur);
+    carry = cur >> 32;
+  }
+  if (carry)
+  {
+    limbs.push_back(static_cast< uint32_t >(carry));
+  }
+  trim();
+  return *this;
+}
+
+inline uint32_t abramov::BigInt::divSmall(uint32_t divisor)
+{
+  if (!divisor)
+  {
+    throw std::invalid_argument("Division by zero\n");
+  }
+  uint64_t rem = 0;
+  for (size_t i = limbs.size(); i > 0; --i)
+  {
+    uint64_t cur = (rem << 32) | limbs[i - 1];
+    limbs[i - 1] = static_cast< uint32_t >(cur / divisor);
+    rem = cur % divisor;
+  }
+  trim();
+  return static_cast< uint32_t >(rem);
+}
+
+inline uint32_t abramov::BigInt::modSmall(uint32_t divisor) const noexcept
+{
+  uint64_t rem = 0;
+  for (size_t i = limbs.size(); i > 0; --i)
+  {
+    rem = ((rem << 32) | limbs[i - 1]) % divisor;
+  }
+  return negative && rem ? static_cast< uint32_t >(divisor - rem) : static_cast< uint32_t >(rem);
+}
+
+inline std::string abramov::BigInt::toString() const
+{
+  if (limbs.empty())
+  {
+    return "0";
+  }
+  BigInt tmp(*this);
+  std::vector< uint32_t > chunks;
+  while (!tmp.limbs.empty())
+  {
+    chunks.push_back(tmp.divSmall(1000000000));
+  }
+  std::string res = negative ? "-" : "";
+  res += std::to_string(chunks.back());
+  for (size_t i = chunks.size() - 1; i > 0; --i)
+  {
+    std::string part = std::to_string(chunks[i - 1]);
+    res.append(9 - part.size(), '0');
+    res += part;
+  }
+  return res;
+}
+
+inline std::ostream &abramov::BigInt::print(std::ostream &out) const
+{
+  return out << toString();
+}
+
+inline std::istream &abramov::BigInt::read(std::istream &in)
+{
+  std::string text;
+  if (in >> text)
+  {
+    try
+    {
+      *this = BigInt(text);
+    }
+    catch (const std::invalid_argument &)
+    {
+      in.setstate(std::ios_base::failbit);
+    }
+  }
+  return in;
+}
+
+inline std::pair< abramov::BigInt, abramov::BigInt > abramov::BigInt::divMod(const BigInt &lhs, const BigInt &rhs)
+{
+  if (rhs.isZero())
+  {
+    throw std::invalid_argument("Division by zero\n");
+  }
+  std::pair< BigInt, BigInt > res;
+  if (compareMagnitude(lhs.limbs, rhs.limbs) < 0)
+  {
+    res.second = lhs;
+    return res;
+  }
+  divMagnitude(lhs.limbs, rhs.limbs, res.first.limbs, res.second.limbs);
+  res.first.negative = lhs.negative != rhs.negative;
+  res.second.negative = lhs.negative;
+  res.first.trim();
+  res.second.trim();
+  return res;
+}
+
+inline abramov::BigInt &abramov::BigInt::operator/=(const BigInt &other)
+{
+  *this = divMod(*this, other).first;
+  return *this;
+}
+
+inline abramov::BigInt &abramov::BigInt::operator%=(const BigInt &other)
+{
+  *this = divMod(*this, other).second;
+  return *this;
+}
+
+inline void abramov::BigInt::assign(bool neg, unsigned __int128 magnitude)
+{
+  limbs.clear();
+  while (magnitude)
+  {
+    limbs.push_back(static_cast< uint32_t >(magnitude));
+    magnitude >>= 32;
+  }
+  negative = neg && !limbs.empty();
+}
+
+inline void abramov::BigInt::trim() noexcept
+{
+  while (!limbs.empty() && !limbs.back())
+  {
+    limbs.pop_back();
+  }
+  if (limbs.empty())
+  {
+    negative = false;
+  }
+}
+
+inline int abramov::BigInt::compareMagnitude(const std::vector< uint32_t > &lhs, const std::vector< uint32_t > &rhs) noexcept
+{
+  if (lhs.size() != rhs.size())
+  {
+    return lhs.size() < rhs.size() ? -1 : 1;
+  }
+  for (size_t i = lhs.size(); i > 0; --i)
+  {
+    if (lhs[i - 1] != rhs[i - 1])
+    {
+      return lhs[i - 1] < rhs[i - 1] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+inline void abramov::BigInt::addMagnitude(std::vector< uint32_t > &lhs, const std::vector< uint32_t > &rhs)
+{
+  if (lhs.size() < rhs.size())
+  {
+    lhs.resize(rhs.size(), 0);
+  }
+  uint64_t carry = 0;
+  for (size_t i = 0; i < lhs.size(); ++i)
+  {
+    uint64_t cur = carry + lhs[i] + (i < rhs.size() ? rhs[i] : 0);
+    lhs[i] = static_cast< uint32_t >(cur);
+    carry = cur >> 32;
+    if (!carry && i >= rhs.size())
+    {
+      break;
+    }
+  }
+  if (carry)
+  {
+    lhs.push_back(static_cast< uint32_t >(carry));
+  }
+}
+
+inline void abramov::BigInt::subMagnitude(std::vector< uint32_t > &lhs, const std::vector< uint32_t > &rhs) noexcept
+{
+  int64_t borrow = 0;
+  for (size_t i = 0; i < lhs.size(); ++i)
+  {
+    int64_t cur = static_cast< int64_t >(lhs[i]) - borrow - (i < rhs.size() ? rhs[i] : 0);
+    borrow = cur < 0 ? 1 : 0;
+    lhs[i] = static_cast< uint32_t >(cur + (borrow << 32));
+    if (!borrow && i >= rhs.size())
+    {
+      break;
+    }
+  }
+}
+
+inline void abramov::BigInt::divMagnitude(const std::vector< uint32_t > &lhs, const std::vector< uint32_t > &rhs,
+  std::vector< uint32_t > &quotient, std::vector< uint32_t > &remainder)
+{
+  constexpr uint64_t base = uint64_t(1) << 32;
+  size_t m = lhs.size();
+  size_t n = rhs.size();
+  quotient.assign(m - n + 1, 0);
+  if (n == 1)
+  {
+    uint64_t rem = 0;
+    for (size_t j = m; j > 0; --j)
+    {
+      uint64_t cur = (rem << 32) | lhs[j - 1];
+      quotient[j - 1] = static_cast< uint32_t >(cur / rhs[0]);
+      rem = cur % rhs[0];
+    }
+    remainder.assign(1, static_cast< uint32_t >(rem));
+    return;
+  }
+  int shift = __builtin_clz(rhs.back());
+  std::vector< uint32_t > v(n);
+  std::vector< uint32_t > u(m + 1);
+  for (size_t i = n - 1; i > 0; --i)
+  {
+    v[i] = static_cast< uint32_t >((static_cast< uint64_t >(rhs[i]) << shift) | (static_cast< uint64_t >(rhs[i - 1]) >> (32 - shift)));
+  }
+  v[0] = rhs[0] << shift;
+  u[m] = static_cast< uint32_t >(static_cast< uint64_t >(lhs[m - 1]) >> (32 - shift));
+  for (size_t i = m - 1; i > 0; --i)
+  {
+    u[i] = static_cast< uint32_t >((static_cast< uint64_t >(lhs[i]) << shift) | (static_cast< uint64_t >(lhs[i - 1]) >> (32 - shift)));
+  }
+  u[0] = lhs[0] << shift;
+  for (size_t j = m - n + 1; j-- > 0;)
+  {
+    uint64_t top = (static_cast< uint64_t >(u[j + n]) << 32) | u[j + n - 1];
+    uint64_t qhat = top / v[n - 1];
+    uint64_t rhat = top % v[n - 1];
+    while (qhat >= base || qhat * v[n - 2] > ((rhat << 32) | u[j + n - 2]))
+    {
+      --qhat;
+      rhat += v[n - 1];
+      if (rhat >= base)
+      {
+        break;
+      }
+    }
+    int64_t borrow = 0;
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      uint64_t p = qhat * v[i] + carry;
+      carry = p >> 32;
+      int64_t t = static_cast< int64_t >(u[i + j]) - borrow - static_cast< int64_t >(p & 0xffffffffu);
+      u[i + j] = static_cast< uint32_t >(t);
+      borrow = t < 0;
+    }
+    int64_t t = static_cast< int64_t >(u[j + n]) - borrow - static_cast< int64_t >(carry);
+    u[j + n] = static_cast< uint32_t >(t);
+    quotient[j] = static_cast< uint32_t >(qhat);
+    if (t < 0)
+    {
+      --quotient[j];
+      uint64_t sum = 0;
+      for (size_t i = 0; i < n; ++i)
+      {
+        sum += static_cast< uint64_t >(u[i + j]) + v[i];
+        u[i + j] = static_cast< uint32_t >(sum);
+        sum >>= 32;
+      }
+      u[j + n] = static_cast< uint32_t >(u[j + n] + sum);
+    }
+  }
+  remainder.assign(n, 0);
+  for (size_t i = 0; i + 1 < n; ++i)
+  {
+    remainder[i] = static_cast< uint32_t >((u[i] >> shift) | (static_cast< uint64_t >(u[i + 1]) << (32 - shift)));
+  }
+  remainder[n - 1] = u[n - 1] >> shift;
+}
+
+inline abramov::BigInt abramov::operator+(BigInt lhs, const BigInt &rhs)
+{
+  lhs += rhs;
+  return lhs;
+}
+
+inline abramov::BigInt abramov::operator-(BigInt lhs, const BigInt &rhs)
+{
+  lhs -= rhs;
+  return lhs;
+}
+
+inline abramov::BigInt abramov::operator*(const BigInt &lhs, const BigInt &rhs)
+{
+  if (lhs.isZero() || rhs.isZero())
+  {
+    return BigInt();
+  }
+  std::vector< uint32_t > res(lhs.limbs.size() + rhs.limbs.size(), 0);
+  for (size_t i = 0; i < lhs.limbs.size(); ++i)
+  {
+    uint64_t carry = 0;
+    uint64_t a = lhs.limbs[i];
+    for (size_t j = 0; j < rhs.limbs.size(); ++j)
+    {
+      uint64_t cur = a * rhs.limbs[j] + res[i + j] + carry;
+      res[i + j] = static_cast< uint32_t >(cur);
+      carry = cur >> 32;
+    }
+    res[i + rhs.limbs.size()] = static_cast< uint32_t >(carry);
+  }
+  BigInt product;
+  product.limbs.swap(res);
+  product.negative = lhs.negative != rhs.negative;
+  product.trim();
+  return product;
+}
+
+inline abramov::BigInt abramov::operator/(BigInt lhs, const BigInt &rhs)
+{
+  lhs /= rhs;
+  return lhs;
+}
+
+inline abramov::BigInt abramov::operator%(BigInt lhs, const BigInt &rhs)
+{
+  lhs %= rhs;
+  return lhs;
+}
+#endif
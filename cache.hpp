@@ -0,0 +1,399 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <unistd.h>
+#include "matrix.hpp"
+
+namespace abramov
+{
+  enum class CacheOp: uint32_t
+  {
+    determinant = 1,
+    trace = 2,
+    rank = 3,
+    inverse = 4
+  };
+
+  struct CacheKey
+  {
+    uint64_t lo;
+    uint64_t hi;
+    uint64_t rows;
+    uint64_t cols;
+    uint32_t type;
+    CacheOp op;
+
+    bool operator==(const CacheKey &other) const noexcept = default;
+    std::string toString() const;
+  };
+
+  template< class P >
+  constexpr uint32_t policyTag = 0;
+  template<>
+  inline constexpr uint32_t policyTag< Wrapping > = 1;
+  template<>
+  inline constexpr uint32_t policyTag< Checked > = 2;
+  template<>
+  inline constexpr uint32_t policyTag< Saturating > = 3;
+  template<>
+  inline constexpr uint32_t policyTag< Widening > = 4;
+
+  template< Integral T, class P >
+  CacheKey cacheKey(const Matrix< T, P > &matrix, CacheOp op);
+
+  struct ResultCache
+  {
+    explicit ResultCache(size_t budget = size_t(64) << 20, std::string directory = "");
+    ResultCache(const ResultCache &) = delete;
+    ResultCache &operator=(const ResultCache &) = delete;
+    bool find(const CacheKey &key, std::string &value);
+    void insert(const CacheKey &key, std::string value);
+    void clear();
+    void setBudget(size_t budget);
+    void setDirectory(std::string directory);
+    size_t size() const;
+    size_t bytes() const;
+    size_t hits() const;
+    size_t misses() const;
+  private:
+    struct KeyHash
+    {
+      size_t operator()(const CacheKey &key) const noexcept;
+    };
+    using Entry = std::pair< CacheKey, std::string >;
+
+    mutable std::mutex mutex;
+    std::list< Entry > order;
+    std::unordered_map< CacheKey, std::list< Entry >::iterator, KeyHash > index;
+    size_t budget;
+    size_t used;
+    size_t hit;
+    size_t miss;
+    std::string directory;
+
+    void store(const CacheKey &key, std::string value);
+    void evict();
+    static size_t cost(const Entry &entry) noexcept;
+  };
+
+  ResultCache &resultCache();
+  template< Integral T, class P >
+  typename Matrix< T, P >::result_type cachedDeterminant(const Matrix< T, P > &matrix, ResultCache &cache = resultCache());
+  template< Integral T, class P >
+  typename Matrix< T, P >::result_type cachedTrace(const Matrix< T, P > &matrix, ResultCache &cache = resultCache());
+  template< Integral T, class P >
+  int cachedRank(const Matrix< T, P > &matrix, ResultCache &cache = resultCache());
+  template< Integral T, class P >
+  std::pair< double, Matrix< T, P > > cachedInverse(const Matrix< T, P > &matrix, ResultCache &cache = resultCache());
+}
+
+inline std::string abramov::CacheKey::toString() const
+{
+  static const char digits[] = "0123456789abcdef";
+  std::string res;
+  for (uint64_t word : { lo, hi, rows, cols, (uint64_t(type) << 32) | uint64_t(op) })
+  {
+    for (int shift = 60; shift >= 0; shift -= 4)
+    {
+      res.push_back(digits[(word >> shift) & 15]);
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::CacheKey abramov::cacheKey(const Matrix< T, P > &matrix, CacheOp op)
+{
+  ABRAMOV_PROFILE_SCOPE("cacheKey", matrix.getRows(), matrix.getCols());
+  constexpr uint64_t k0 = 0x9e3779b97f4a7c15ULL;
+  constexpr uint64_t k1 = 0xc2b2ae3d27d4eb4fULL;
+  auto mix = [](uint64_t x)
+  {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    return x ^ (x >> 33);
+  };
+  uint64_t a = k0 ^ matrix.getRows();
+  uint64_t b = k1 ^ matrix.getCols();
+  size_t row_bytes = matrix.getCols() * sizeof(T);
+  for (size_t i = 0; i < matrix.getRows(); ++i)
+  {
+    const unsigned char *bytes = reinterpret_cast< const unsigned char * >(matrix[i]);
+    size_t j = 0;
+    for (; j + 8 <= row_bytes; j += 8)
+    {
+      uint64_t word = 0;
+      std::memcpy(&word, bytes + j, 8);
+      a = (a ^ word) * k1;
+      a = (a << 31) | (a >> 33);
+      b = (b + word) * k0;
+      b ^= b >> 29;
+    }
+    if (j < row_bytes)
+    {
+      uint64_t word = 0;
+      std::memcpy(&word, bytes + j, row_bytes - j);
+      a = ((a ^ word) * k1) + i;
+      b = ((b + word) * k0) ^ i;
+    }
+  }
+  uint32_t type = (policyTag< P > << 16) | (std::is_signed_v< T > ? 0x100 : 0) | sizeof(T);
+  return { mix(a ^ mix(b)), mix(b + k0 * a), matrix.getRows(), matrix.getCols(), type, op };
+}
+
+inline abramov::ResultCache::ResultCache(size_t bytes, std::string path):
+  mutex(),
+  order(),
+  index(),
+  budget(bytes),
+  used(0),
+  hit(0),
+  miss(0),
+  directory(std::move(path))
+{}
+
+inline bool abramov::ResultCache::find(const CacheKey &key, std::string &value)
+{
+  std::string path;
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    auto it = index.find(key);
+    if (it != index.end())
+    {
+      order.splice(order.begin(), order, it->second);
+      value = it->second->second;
+      ++hit;
+      return true;
+    }
+    if (directory.empty())
+    {
+      ++miss;
+      return false;
+    }
+    path = directory + "/" + key.toString();
+  }
+  std::ifstream in(path, std::ios::binary);
+  std::string text((std::istreambuf_iterator< char >(in)), std::istreambuf_iterator< char >());
+  std::lock_guard< std::mutex > lock(mutex);
+  if (!in.good() && !in.eof())
+  {
+    ++miss;
+    return false;
+  }
+  if (text.size() < sizeof(CacheKey) || std::memcmp(text.data(), &key, sizeof(CacheKey)))
+  {
+    ++miss;
+    return false;
+  }
+  value = text.substr(sizeof(CacheKey));
+  ++hit;
+  store(key, value);
+  return true;
+}
+
+inline void abramov::ResultCache::insert(const CacheKey &key, std::string value)
+{
+  std::string path;
+  std::string text;
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    if (!directory.empty())
+    {
+      path = directory + "/" + key.toString();
+      text.assign(reinterpret_cast< const char * >(&key), sizeof(CacheKey));
+      text += value;
+    }
+    store(key, std::move(value));
+  }
+  if (!path.empty())
+  {
+    std::string tmp = path + "." + std::to_string(::getpid()) + "." + std::to_string(reinterpret_cast< uintptr_t >(&text));
+    {
+      std::ofstream out(tmp, std::ios::binary);
+      out.write(text.data(), text.size());
+    }
+    if (std::rename(tmp.c_str(), path.c_str()))
+    {
+      std::remove(tmp.c_str());
+    }
+  }
+}
+
+inline void abramov::ResultCache::clear()
+{
+  std::lock_guard< std::mutex > lock(mutex);
+  order.clear();
+  index.clear();
+  used = 0;
+  hit = 0;
+  miss = 0;
+}
+
+inline void abramov::ResultCache::setBudget(size_t bytes)
+{
+  std::lock_guard< std::mutex > lock(mutex);
+  budget = bytes;
+  evict();
+}
+
+inline void abramov::ResultCache::setDirectory(std::string path)
+{
+  std::lock_guard< std::mutex > lock(mutex);
+  directory = std::move(path);
+}
+
+inline size_t abramov::ResultCache::size() const
+{
+  std::lock_guard< std::mutex > lock(mutex);
+  return index.size();
+}
+
+inline size_t abramov::ResultCache::bytes() const
+{
+  std::lock_guard< std::mutex > lock(mutex);
+  return used;
+}
+
+inline size_t abramov::ResultCache::hits() const
+{
+  std::lock_guard< std::mutex > lock(mutex);
+  return hit;
+}
+
+inline size_t abramov::ResultCache::misses() const
+{
+  std::lock_guard< std::mutex > lock(mutex);
+  return miss;
+}
+
+inline size_t abramov::ResultCache::KeyHash::operator()(const CacheKey &key) const noexcept
+{
+  return key.lo ^ (static_cast< size_t >(key.op) * 0x9e3779b97f4a7c15ULL);
+}
+
+inline void abramov::ResultCache::store(const CacheKey &key, std::string value)
+{
+  auto it = index.find(key);
+  if (it != index.end())
+  {
+    used -= cost(*it->second);
+    order.erase(it->second);
+    index.erase(it);
+  }
+  order.emplace_front(key, std::move(value));
+  index.emplace(key, order.begin());
+  used += cost(order.front());
+  evict();
+}
+
+inline void abramov::ResultCache::evict()
+{
+  while (used > budget && !order.empty())
+  {
+    used -= cost(order.back());
+    index.erase(order.back().first);
+    order.pop_back();
+  }
+}
+
+inline size_t abramov::ResultCache::cost(const Entry &entry) noexcept
+{
+  return sizeof(Entry) + entry.second.size() + 4 * sizeof(void *);
+}
+
+inline abramov::ResultCache &abramov::resultCache()
+{
+  static ResultCache cache;
+  return cache;
+}
+
+template< abramov::Integral T, class P >
+typename abramov::Matrix< T, P >::result_type abramov::cachedDeterminant(const Matrix< T, P > &matrix, ResultCache &cache)
+{
+  using R = typename Matrix< T, P >::result_type;
+  CacheKey key = cacheKey(matrix, CacheOp::determinant);
+  std::string value;
+  R res = 0;
+  if (cache.find(key, value) && value.size() == sizeof(R))
+  {
+    std::memcpy(&res, value.data(), sizeof(R));
+    return res;
+  }
+  res = matrix.determinant();
+  cache.insert(key, std::string(reinterpret_cast< const char * >(&res), sizeof(R)));
+  return res;
+}
+
+template< abramov::Integral T, class P >
+typename abramov::Matrix< T, P >::result_type abramov::cachedTrace(const Matrix< T, P > &matrix, ResultCache &cache)
+{
+  using R = typename Matrix< T, P >::result_type;
+  CacheKey key = cacheKey(matrix, CacheOp::trace);
+  std::string value;
+  R res = 0;
+  if (cache.find(key, value) && value.size() == sizeof(R))
+  {
+    std::memcpy(&res, value.data(), sizeof(R));
+    return res;
+  }
+  res = matrix.trace();
+  cache.insert(key, std::string(reinterpret_cast< const char * >(&res), sizeof(R)));
+  return res;
+}
+
+template< abramov::Integral T, class P >
+int abramov::cachedRank(const Matrix< T, P > &matrix, ResultCache &cache)
+{
+  CacheKey key = cacheKey(matrix, CacheOp::rank);
+  std::string value;
+  int res = 0;
+  if (cache.find(key, value) && value.size() == sizeof(int))
+  {
+    std::memcpy(&res, value.data(), sizeof(int));
+    return res;
+  }
+  res = matrix.rank();
+  cache.insert(key, std::string(reinterpret_cast< const char * >(&res), sizeof(int)));
+  return res;
+}
+
+template< abramov::Integral T, class P >
+std::pair< double, abramov::Matrix< T, P > > abramov::cachedInverse(const Matrix< T, P > &matrix, ResultCache &cache)
+{
+  CacheKey key = cacheKey(matrix, CacheOp::inverse);
+  size_t n = matrix.getRows();
+  size_t row_bytes = matrix.getCols() * sizeof(T);
+  std::string value;
+  if (cache.find(key, value) && value.size() == sizeof(double) + n * row_bytes)
+  {
+    std::pair< double, Matrix< T, P > > res(0.0, Matrix< T, P >(n, matrix.getCols(), 0));
+    std::memcpy(&res.first, value.data(), sizeof(double));
+    for (size_t i = 0; i < n; ++i)
+    {
+      std::memcpy(res.second[i], value.data() + sizeof(double) + i * row_bytes, row_bytes);
+    }
+    return res;
+  }
+  std::pair< double, Matrix< T, P > > res = matrix.inverse();
+  value.assign(reinterpret_cast< const char * >(&res.first), sizeof(double));
+  for (size_t i = 0; i < n; ++i)
+  {
+    value.append(reinterpret_cast< const char * >(static_cast< const Matrix< T, P > & >(res.second)[i]), row_bytes);
+  }
+  cache.insert(key, std::move(value));
+  return res;
+}
+#endif
@@ -0,0 +1,723 @@
+#ifndef DISTRIBUTED_HPP
+#define DISTRIBUTED_HPP
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "matrix.hpp"
+#include "overflow.hpp"
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace abramov
+{
+  struct Transport
+  {
+    virtual ~Transport() = default;
+    virtual size_t rank() const noexcept = 0;
+    virtual size_t size() const noexcept = 0;
+    virtual void send(size_t to, const void *data, size_t bytes) = 0;
+    virtual void receive(size_t from, void *data, size_t bytes) = 0;
+  };
+
+  struct SocketTransport: Transport
+  {
+    SocketTransport(size_t rank, std::vector< int > sockets);
+    SocketTransport(const SocketTransport &) = delete;
+    SocketTransport &operator=(const SocketTransport &) = delete;
+    ~SocketTransport() override;
+    size_t rank() const noexcept override;
+    size_t size() const noexcept override;
+    void send(size_t to, const void *data, size_t bytes) override;
+    void receive(size_t from, void *data, size_t bytes) override;
+  private:
+    size_t self;
+    std::vector< int > peers;
+
+    int socket(size_t peer) const;
+  };
+
+  struct ProcessGrid
+  {
+    size_t rows;
+    size_t cols;
+
+    size_t row(size_t rank) const noexcept;
+    size_t col(size_t rank) const noexcept;
+    size_t rank(size_t row, size_t col) const noexcept;
+  };
+
+  struct BlockCyclic
+  {
+    size_t rows;
+    size_t cols;
+    size_t rowBlock;
+    size_t colBlock;
+    ProcessGrid grid;
+
+    size_t localRows(size_t row) const noexcept;
+    size_t localCols(size_t col) const noexcept;
+    size_t globalRow(size_t local, size_t row) const noexcept;
+    size_t globalCol(size_t local, size_t col) const noexcept;
+  };
+
+  template< class F >
+  void runProcesses(size_t processes, F f);
+  ProcessGrid processGrid(size_t processes) noexcept;
+  size_t cyclicExtent(size_t n, size_t block, size_t index, size_t count) noexcept;
+  size_t cyclicGlobal(size_t local, size_t block, size_t index, size_t count) noexcept;
+
+  template< Integral T, class P >
+  Matrix< T, P > distributedMultiply(const Matrix< T, P > &a, const Matrix< T, P > &b, Transport &transport,
+    size_t block = 64);
+  template< Integral T, class P >
+  Matrix< T, P > distributedTranspose(const Matrix< T, P > &a, Transport &transport, size_t block = 64);
+  template< Integral T, class P >
+  Matrix< T, P > distributedKronecker(const Matrix< T, P > &a, const Matrix< T, P > &b, Transport &transport);
+
+  void broadcastHeader(size_t *header, size_t count, Transport &transport);
+  template< Integral T, class P >
+  std::vector< T > scatterMatrix(const Matrix< T, P > &matrix, const BlockCyclic &layout, Transport &transport);
+  template< Integral T, class P >
+  Matrix< T, P > gatherMatrix(const std::vector< T > &local, const BlockCyclic &layout, bool failed,
+    Transport &transport);
+  template< Integral T, class P >
+  void multiplyPanel(std::vector< std::conditional_t< P::wraps, std::make_unsigned_t< T >, __int128 > > &acc,
+    const std::vector< T > &lhs, const std::vector< T > &rhs, size_t rows, size_t inner, size_t cols);
+}
+
+inline abramov::SocketTransport::SocketTransport(size_t rank, std::vector< int > sockets):
+  self(rank),
+  peers(std::move(sockets))
+{}
+
+inline abramov::SocketTransport::~SocketTransport()
+{
+  for (int fd : peers)
+  {
+    if (fd >= 0)
+    {
+      ::close(fd);
+    }
+  }
+}
+
+inline size_t abramov::SocketTransport::rank() const noexcept
+{
+  return self;
+}
+
+inline size_t abramov::SocketTransport::size() const noexcept
+{
+  return peers.size();
+}
+
+inline int abramov::SocketTransport::socket(size_t peer) const
+{
+  if (peer >= peers.size() || peer == self)
+  {
+    throw std::out_of_range("Invalid peer rank\n");
+  }
+  return peers[peer];
+}
+
+inline void abramov::SocketTransport::send(size_t to, const void *data, size_t bytes)
+{
+  int fd = socket(to);
+  const char *p = static_cast< const char * >(data);
+  while (bytes)
+  {
+    ssize_t sent = ::send(fd, p, bytes, MSG_NOSIGNAL);
+    if (sent < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      throw std::runtime_error("Transport send failed\n");
+    }
+    p += sent;
+    bytes -= static_cast< size_t >(sent);
+  }
+}
+
+inline void abramov::SocketTransport::receive(size_t from, void *data, size_t bytes)
+{
+  int fd = socket(from);
+  char *p = static_cast< char * >(data);
+  while (bytes)
+  {
+    ssize_t got = ::recv(fd, p, bytes, 0);
+    if (got < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (got <= 0)
+    {
+      throw std::runtime_error("Transport closed\n");
+    }
+    p += got;
+    bytes -= static_cast< size_t >(got);
+  }
+}
+
+inline size_t abramov::ProcessGrid::row(size_t rank) const noexcept
+{
+  return rank / cols;
+}
+
+inline size_t abramov::ProcessGrid::col(size_t rank) const noexcept
+{
+  return rank % cols;
+}
+
+inline size_t abramov::ProcessGrid::rank(size_t row, size_t col) const noexcept
+{
+  return row * cols + col;
+}
+
+inline size_t abramov::BlockCyclic::localRows(size_t row) const noexcept
+{
+  return cyclicExtent(rows, rowBlock, row, grid.rows);
+}
+
+inline size_t abramov::BlockCyclic::localCols(size_t col) const noexcept
+{
+  return cyclicExtent(cols, colBlock, col, grid.cols);
+}
+
+inline size_t abramov::BlockCyclic::globalRow(size_t local, size_t row) const noexcept
+{
+  return cyclicGlobal(local, rowBlock, row, grid.rows);
+}
+
+inline size_t abramov::BlockCyclic::globalCol(size_t local, size_t col) const noexcept
+{
+  return cyclicGlobal(local, colBlock, col, grid.cols);
+}
+
+inline abramov::ProcessGrid abramov::processGrid(size_t processes) noexcept
+{
+  processes = std::max< size_t >(processes, 1);
+  size_t rows = static_cast< size_t >(std::sqrt(static_cast< double >(processes)));
+  while (rows > 1 && processes % rows)
+  {
+    --rows;
+  }
+  rows = std::max< size_t >(rows, 1);
+  return ProcessGrid{ rows, processes / rows };
+}
+
+inline size_t abramov::cyclicExtent(size_t n, size_t block, size_t index, size_t count) noexcept
+{
+  size_t blocks = n / block;
+  size_t res = blocks / count * block;
+  size_t rest = blocks % count;
+  if (index < rest)
+  {
+    res += block;
+  }
+  else if (index == rest)
+  {
+    res += n % block;
+  }
+  return res;
+}
+
+inline size_t abramov::cyclicGlobal(size_t local, size_t block, size_t index, size_t count) noexcept
+{
+  return (local / block * count + index) * block + local % block;
+}
+
+template< class F >
+void abramov::runProcesses(size_t processes, F f)
+{
+  if (!processes)
+  {
+    throw std::invalid_argument("At least one process is required\n");
+  }
+  std::vector< std::vector< int > > sockets(processes, std::vector< int >(processes, -1));
+  auto closeAll = [&sockets]()
+  {
+    for (auto &row : sockets)
+    {
+      for (int &fd : row)
+      {
+        if (fd >= 0)
+        {
+          ::close(fd);
+          fd = -1;
+        }
+      }
+    }
+  };
+  for (size_t i = 0; i < processes; ++i)
+  {
+    for (size_t j = i + 1; j < processes; ++j)
+    {
+      int pair[2];
+      if (::socketpair(AF_UNIX, SOCK_STREAM, 0, pair))
+      {
+        closeAll();
+        throw std::runtime_error("Cannot create socket pair\n");
+      }
+      sockets[i][j] = pair[0];
+      sockets[j][i] = pair[1];
+      int buffer = 1 << 20;
+      ::setsockopt(pair[0], SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+      ::setsockopt(pair[1], SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+    }
+  }
+  std::vector< pid_t > children;
+  for (size_t rank = 1; rank < processes; ++rank)
+  {
+    pid_t pid = ::fork();
+    if (pid < 0)
+    {
+      break;
+    }
+    if (!pid)
+    {
+      for (size_t i = 0; i < processes; ++i)
+      {
+        if (i == rank)
+        {
+          continue;
+        }
+        for (int fd : sockets[i])
+        {
+          if (fd >= 0)
+          {
+            ::close(fd);
+          }
+        }
+      }
+      int status = 0;
+      try
+      {
+        SocketTransport transport(rank, std::move(sockets[rank]));
+        f(static_cast< Transport & >(transport));
+      }
+      catch (...)
+      {
+        status = 1;
+      }
+      ::_exit(status);
+    }
+    children.push_back(pid);
+  }
+  std::vector< int > own = std::move(sockets[0]);
+  closeAll();
+  std::exception_ptr error;
+  if (children.size() + 1 != processes)
+  {
+    for (int fd : own)
+    {
+      if (fd >= 0)
+      {
+        ::close(fd);
+      }
+    }
+    error = std::make_exception_ptr(std::runtime_error("Cannot start process\n"));
+  }
+  else
+  {
+    try
+    {
+      SocketTransport transport(0, std::move(own));
+      f(static_cast< Transport & >(transport));
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+  }
+  bool failed = false;
+  for (pid_t pid : children)
+  {
+    int status = 0;
+    while (::waitpid(pid, &status, 0) < 0 && errno == EINTR)
+    {}
+    failed |= !WIFEXITED(status) || WEXITSTATUS(status);
+  }
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+  if (failed)
+  {
+    throw std::runtime_error("Process failed\n");
+  }
+}
+
+inline void abramov::broadcastHeader(size_t *header, size_t count, Transport &transport)
+{
+  if (transport.rank())
+  {
+    transport.receive(0, header, count * sizeof(size_t));
+    return;
+  }
+  for (size_t r = 1; r < transport.size(); ++r)
+  {
+    transport.send(r, header, count * sizeof(size_t));
+  }
+}
+
+template< abramov::Integral T, class P >
+std::vector< T > abramov::scatterMatrix(const Matrix< T, P > &matrix, const BlockCyclic &layout, Transport &transport)
+{
+  const ProcessGrid &grid = layout.grid;
+  size_t self = transport.rank();
+  if (self)
+  {
+    std::vector< T > res(layout.localRows(grid.row(self)) * layout.localCols(grid.col(self)));
+    transport.receive(0, res.data(), res.size() * sizeof(T));
+    return res;
+  }
+  std::vector< T > res;
+  for (size_t r = transport.size(); r-- > 0;)
+  {
+    size_t pr = grid.row(r);
+    size_t pc = grid.col(r);
+    size_t lr = layout.localRows(pr);
+    size_t lc = layout.localCols(pc);
+    std::vector< T > piece(lr * lc);
+    for (size_t i = 0; i < lr; ++i)
+    {
+      const T *row = matrix[layout.globalRow(i, pr)];
+      T *dst = piece.data() + i * lc;
+      for (size_t j = 0; j < lc; j += layout.colBlock)
+      {
+        size_t g = layout.globalCol(j, pc);
+        std::copy(row + g, row + g + std::min(layout.colBlock, lc - j), dst + j);
+      }
+    }
+    if (r)
+    {
+      transport.send(r, piece.data(), piece.size() * sizeof(T));
+    }
+    else
+    {
+      res = std::move(piece);
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::gatherMatrix(const std::vector< T > &local, const BlockCyclic &layout, bool failed,
+  Transport &transport)
+{
+  const ProcessGrid &grid = layout.grid;
+  size_t self = transport.rank();
+  if (self)
+  {
+    char status = failed;
+    transport.send(0, &status, 1);
+    if (!failed)
+    {
+      transport.send(0, local.data(), local.size() * sizeof(T));
+    }
+    return Matrix< T, P >();
+  }
+  Matrix< T, P > res(layout.rows, layout.cols, 0);
+  std::vector< T > piece;
+  for (size_t r = 0; r < transport.size(); ++r)
+  {
+    size_t pr = grid.row(r);
+    size_t pc = grid.col(r);
+    size_t lr = layout.localRows(pr);
+    size_t lc = layout.localCols(pc);
+    const T *src = local.data();
+    if (r)
+    {
+      char status = 0;
+      transport.receive(r, &status, 1);
+      failed |= status != 0;
+      if (failed)
+      {
+        break;
+      }
+      piece.resize(lr * lc);
+      transport.receive(r, piece.data(), piece.size() * sizeof(T));
+      src = piece.data();
+    }
+    else if (failed)
+    {
+      break;
+    }
+    for (size_t i = 0; i < lr; ++i)
+    {
+      T *row = res[layout.globalRow(i, pr)];
+      for (size_t j = 0; j < lc; j += layout.colBlock)
+      {
+        size_t width = std::min(layout.colBlock, lc - j);
+        std::copy(src + i * lc + j, src + i * lc + j + width, row + layout.globalCol(j, pc));
+      }
+    }
+  }
+  if (failed)
+  {
+    throw std::overflow_error("Integer overflow\n");
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+void abramov::multiplyPanel(std::vector< std::conditional_t< P::wraps, std::make_unsigned_t< T >, __int128 > > &acc,
+  const std::vector< T > &lhs, const std::vector< T > &rhs, size_t rows, size_t inner, size_t cols)
+{
+  using A = std::conditional_t< P::wraps, std::make_unsigned_t< T >, __int128 >;
+  using M = std::conditional_t< P::wraps, promoted_unsigned_t< T >, A >;
+  bool overflow = false;
+  for (size_t i = 0; i < rows; ++i)
+  {
+    A *dst = acc.data() + i * cols;
+    for (size_t k = 0; k < inner; ++k)
+    {
+      A a = static_cast< A >(lhs[i * inner + k]);
+      const T *b = rhs.data() + k * cols;
+      if constexpr (P::wraps || sizeof(T) < sizeof(long long))
+      {
+        for (size_t j = 0; j < cols; ++j)
+        {
+          dst[j] = static_cast< A >(dst[j] + static_cast< M >(a) * static_cast< M >(b[j]));
+        }
+      }
+      else
+      {
+        for (size_t j = 0; j < cols; ++j)
+        {
+          overflow |= __builtin_add_overflow(dst[j], a * static_cast< A >(b[j]), &dst[j]);
+        }
+      }
+    }
+  }
+  if (overflow)
+  {
+    throw std::overflow_error("Integer overflow\n");
+  }
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::distributedMultiply(const Matrix< T, P > &a, const Matrix< T, P > &b,
+  Transport &transport, size_t block)
+{
+  using A = std::conditional_t< P::wraps, std::make_unsigned_t< T >, __int128 >;
+  size_t header[4] = { a.getCols() != b.getRows(), a.getRows(), a.getCols(), b.getCols() };
+  broadcastHeader(header, 4, transport);
+  if (header[0])
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  block = std::max< size_t >(block, 1);
+  ProcessGrid grid = processGrid(transport.size());
+  BlockCyclic left{ header[1], header[2], block, block, grid };
+  BlockCyclic right{ header[2], header[3], block, block, grid };
+  BlockCyclic out{ header[1], header[3], block, block, grid };
+  std::vector< T > lhs = scatterMatrix(a, left, transport);
+  std::vector< T > rhs = scatterMatrix(b, right, transport);
+  size_t self = transport.rank();
+  size_t pr = grid.row(self);
+  size_t pc = grid.col(self);
+  size_t rows = out.localRows(pr);
+  size_t cols = out.localCols(pc);
+  size_t lhsCols = left.localCols(pc);
+  std::vector< A > acc(rows * cols, A(0));
+  bool failed = false;
+  std::vector< T > lhsPanel;
+  std::vector< T > rhsPanel;
+  for (size_t k = 0; k < header[2]; k += block)
+  {
+    size_t width = std::min(block, header[2] - k);
+    size_t kb = k / block;
+    size_t owner = kb % grid.cols;
+    lhsPanel.resize(rows * width);
+    if (pc == owner)
+    {
+      size_t offset = kb / grid.cols * block;
+      for (size_t i = 0; i < rows; ++i)
+      {
+        std::copy_n(lhs.data() + i * lhsCols + offset, width, lhsPanel.data() + i * width);
+      }
+      for (size_t c = 0; c < grid.cols; ++c)
+      {
+        if (c != pc)
+        {
+          transport.send(grid.rank(pr, c), lhsPanel.data(), lhsPanel.size() * sizeof(T));
+        }
+      }
+    }
+    else
+    {
+      transport.receive(grid.rank(pr, owner), lhsPanel.data(), lhsPanel.size() * sizeof(T));
+    }
+    owner = kb % grid.rows;
+    rhsPanel.resize(width * cols);
+    if (pr == owner)
+    {
+      size_t offset = kb / grid.rows * block;
+      std::copy_n(rhs.data() + offset * cols, width * cols, rhsPanel.data());
+      for (size_t r = 0; r < grid.rows; ++r)
+      {
+        if (r != pr)
+        {
+          transport.send(grid.rank(r, pc), rhsPanel.data(), rhsPanel.size() * sizeof(T));
+        }
+      }
+    }
+    else
+    {
+      transport.receive(grid.rank(owner, pc), rhsPanel.data(), rhsPanel.size() * sizeof(T));
+    }
+    try
+    {
+      if (!failed)
+      {
+        multiplyPanel< T, P >(acc, lhsPanel, rhsPanel, rows, width, cols);
+      }
+    }
+    catch (const std::overflow_error &)
+    {
+      failed = true;
+    }
+  }
+  std::vector< T > res(rows * cols);
+  try
+  {
+    for (size_t i = 0; i < res.size() && !failed; ++i)
+    {
+      res[i] = P::template narrow< T >(acc[i]);
+    }
+  }
+  catch (const std::overflow_error &)
+  {
+    failed = true;
+  }
+  return gatherMatrix< T, P >(res, out, failed, transport);
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::distributedTranspose(const Matrix< T, P > &a, Transport &transport, size_t block)
+{
+  size_t header[2] = { a.getRows(), a.getCols() };
+  broadcastHeader(header, 2, transport);
+  block = std::max< size_t >(block, 1);
+  ProcessGrid grid = processGrid(transport.size());
+  BlockCyclic layout{ header[0], header[1], block, block, grid };
+  std::vector< T > local = scatterMatrix(a, layout, transport);
+  size_t self = transport.rank();
+  size_t rows = layout.localRows(grid.row(self));
+  size_t cols = layout.localCols(grid.col(self));
+  std::vector< T > flipped(local.size());
+  for (size_t i = 0; i < rows; ++i)
+  {
+    for (size_t j = 0; j < cols; ++j)
+    {
+      flipped[j * rows + i] = local[i * cols + j];
+    }
+  }
+  ProcessGrid swapped{ grid.cols, grid.rows };
+  BlockCyclic out{ header[1], header[0], block, block, swapped };
+  if (self)
+  {
+    return gatherMatrix< T, P >(flipped, out, false, transport);
+  }
+  Matrix< T, P > res(header[1], header[0], 0);
+  std::vector< T > piece;
+  for (size_t r = 0; r < transport.size(); ++r)
+  {
+    size_t pr = grid.col(r);
+    size_t pc = grid.row(r);
+    size_t lr = out.localRows(pr);
+    size_t lc = out.localCols(pc);
+    const T *src = flipped.data();
+    if (r)
+    {
+      char status = 0;
+      transport.receive(r, &status, 1);
+      piece.resize(lr * lc);
+      transport.receive(r, piece.data(), piece.size() * sizeof(T));
+      src = piece.data();
+    }
+    for (size_t i = 0; i < lr; ++i)
+    {
+      T *row = res[out.globalRow(i, pr)];
+      for (size_t j = 0; j < lc; j += block)
+      {
+        size_t width = std::min(block, lc - j);
+        std::copy(src + i * lc + j, src + i * lc + j + width, row + out.globalCol(j, pc));
+      }
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::distributedKronecker(const Matrix< T, P > &a, const Matrix< T, P > &b,
+  Transport &transport)
+{
+  size_t header[4] = { a.getRows(), a.getCols(), b.getRows(), b.getCols() };
+  broadcastHeader(header, 4, transport);
+  std::vector< T > right(header[2] * header[3]);
+  if (transport.rank())
+  {
+    transport.receive(0, right.data(), right.size() * sizeof(T));
+  }
+  else
+  {
+    for (size_t i = 0; i < header[2]; ++i)
+    {
+      std::copy_n(b[i], header[3], right.data() + i * header[3]);
+    }
+    for (size_t r = 1; r < transport.size(); ++r)
+    {
+      transport.send(r, right.data(), right.size() * sizeof(T));
+    }
+  }
+  ProcessGrid grid = processGrid(transport.size());
+  BlockCyclic layout{ header[0], header[1], 1, 1, grid };
+  std::vector< T > local = scatterMatrix(a, layout, transport);
+  size_t self = transport.rank();
+  size_t rows = layout.localRows(grid.row(self));
+  size_t cols = layout.localCols(grid.col(self));
+  Matrix< T, P > lhs(rows, cols, 0);
+  for (size_t i = 0; i < rows; ++i)
+  {
+    std::copy_n(local.data() + i * cols, cols, lhs[i]);
+  }
+  Matrix< T, P > rhs(header[2], header[3], 0);
+  for (size_t i = 0; i < header[2]; ++i)
+  {
+    std::copy_n(right.data() + i * header[3], header[3], rhs[i]);
+  }
+  BlockCyclic out{ header[0] * header[2], header[1] * header[3], header[2], header[3], grid };
+  if (!out.rowBlock || !out.colBlock)
+  {
+    return transport.rank() ? Matrix< T, P >() : Matrix< T, P >(out.rows, out.cols, 0);
+  }
+  std::vector< T > res;
+  bool failed = false;
+  try
+  {
+    Matrix< T, P > product = Matrix< T, P >::kroneckerProduct(lhs, rhs);
+    res.resize(product.getRows() * product.getCols());
+    for (size_t i = 0; i < product.getRows(); ++i)
+    {
+      std::copy_n(product[i], product.getCols(), res.data() + i * product.getCols());
+    }
+  }
+  catch (const std::overflow_error &)
+  {
+    failed = true;
+  }
+  return gatherMatrix< T, P >(res, out, failed, transport);
+}
+#endif
@@ -0,0 +1,531 @@
+#ifndef EIGEN_HPP
+#define EIGEN_HPP
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "bigint.hpp"
+#include "matrix.hpp"
+#include "modular.hpp"
+#include "threadpool.hpp"
+
+namespace abramov
+{
+  enum class Charpoly
+  {
+    Hessenberg,
+    Berkowitz
+  };
+
+  struct CharacteristicPolynomial
+  {
+    std::vector< BigInt > coefficients;
+
+    size_t degree() const noexcept;
+    BigInt trace() const;
+    BigInt determinant() const;
+    BigInt operator()(const BigInt &x) const;
+  };
+
+  template< Integral T, class P >
+  CharacteristicPolynomial characteristicPolynomial(const Matrix< T, P > &matrix,
+    Charpoly method = Charpoly::Hessenberg, size_t threads = 0);
+  template< Integral T, class P >
+  std::vector< std::complex< double > > eigenvalues(const Matrix< T, P > &matrix, size_t threads = 1);
+
+  void hessenbergCharpolyMod(std::vector< uint32_t > &a, size_t n, uint32_t p, uint32_t *out);
+  void berkowitzCharpolyMod(const std::vector< uint32_t > &a, size_t n, uint32_t p, uint32_t *out);
+  void balanceMatrix(std::vector< double > &a, size_t n);
+  void reduceHessenberg(std::vector< double > &a, size_t n, size_t threads);
+  std::vector< std::complex< double > > hessenbergEigenvalues(std::vector< double > &a, size_t n);
+}
+
+inline size_t abramov::CharacteristicPolynomial::degree() const noexcept
+{
+  return coefficients.empty() ? 0 : coefficients.size() - 1;
+}
+
+inline abramov::BigInt abramov::CharacteristicPolynomial::trace() const
+{
+  return degree() ? -coefficients[degree() - 1] : BigInt();
+}
+
+inline abramov::BigInt abramov::CharacteristicPolynomial::determinant() const
+{
+  if (coefficients.empty())
+  {
+    return BigInt(1);
+  }
+  return degree() % 2 ? -coefficients[0] : coefficients[0];
+}
+
+inline abramov::BigInt abramov::CharacteristicPolynomial::operator()(const BigInt &x) const
+{
+  BigInt res;
+  for (size_t k = coefficients.size(); k > 0; --k)
+  {
+    res *= x;
+    res += coefficients[k - 1];
+  }
+  return res;
+}
+
+inline void abramov::hessenbergCharpolyMod(std::vector< uint32_t > &a, size_t n, uint32_t p, uint32_t *out)
+{
+  for (size_t c = 0; c + 2 < n; ++c)
+  {
+    size_t pivot = c + 1;
+    while (pivot < n && !a[pivot * n + c])
+    {
+      ++pivot;
+    }
+    if (pivot == n)
+    {
+      continue;
+    }
+    if (pivot != c + 1)
+    {
+      std::swap_ranges(a.begin() + pivot * n, a.begin() + (pivot + 1) * n, a.begin() + (c + 1) * n);
+      for (size_t i = 0; i < n; ++i)
+      {
+        std::swap(a[i * n + pivot], a[i * n + c + 1]);
+      }
+    }
+    uint32_t inv = invMod(a[(c + 1) * n + c], p);
+    const uint32_t *prow = a.data() + (c + 1) * n;
+    for (size_t i = c + 2; i < n; ++i)
+    {
+      uint32_t *row = a.data() + i * n;
+      uint32_t f = mulMod(row[c], inv, p);
+      if (!f)
+      {
+        continue;
+      }
+      uint64_t neg = p - f;
+      for (size_t j = c; j < n; ++j)
+      {
+        row[j] = static_cast< uint32_t >((row[j] + neg * prow[j]) % p);
+      }
+      for (size_t r = 0; r < n; ++r)
+      {
+        uint32_t &dst = a[r * n + c + 1];
+        dst = static_cast< uint32_t >((dst + static_cast< uint64_t >(f) * a[r * n + i]) % p);
+      }
+    }
+  }
+  std::vector< std::vector< uint32_t > > polys(n + 1);
+  polys[0] = { 1 };
+  for (size_t m = 1; m <= n; ++m)
+  {
+    std::vector< uint32_t > &cur = polys[m];
+    const std::vector< uint32_t > &prev = polys[m - 1];
+    cur.assign(m + 1, 0);
+    uint32_t diag = p - a[(m - 1) * n + m - 1] % p;
+    for (size_t k = 0; k < m; ++k)
+    {
+      cur[k + 1] = (cur[k + 1] + prev[k]) % p;
+      cur[k] = static_cast< uint32_t >((cur[k] + static_cast< uint64_t >(diag) * prev[k]) % p);
+    }
+    uint32_t t = 1;
+    for (size_t i = 1; i < m; ++i)
+    {
+      t = mulMod(t, a[(m - i) * n + m - i - 1], p);
+      if (!t)
+      {
+        break;
+      }
+      uint64_t f = p - mulMod(t, a[(m - i - 1) * n + m - 1], p);
+      const std::vector< uint32_t > &older = polys[m - i - 1];
+      for (size_t k = 0; k < older.size(); ++k)
+      {
+        cur[k] = static_cast< uint32_t >((cur[k] + f * older[k]) % p);
+      }
+    }
+  }
+  std::copy(polys[n].begin(), polys[n].end(), out);
+}
+
+inline void abramov::berkowitzCharpolyMod(const std::vector< uint32_t > &a, size_t n, uint32_t p, uint32_t *out)
+{
+  std::vector< uint32_t > poly{ 1 };
+  std::vector< uint32_t > next;
+  std::vector< uint32_t > toeplitz;
+  std::vector< uint32_t > v;
+  std::vector< uint32_t > w;
+  for (size_t k = 1; k <= n; ++k)
+  {
+    size_t r = k - 1;
+    toeplitz.assign(k + 1, 0);
+    toeplitz[0] = 1;
+    toeplitz[1] = (p - a[r * n + r] % p) % p;
+    v.assign(r, 0);
+    for (size_t i = 0; i < r; ++i)
+    {
+      v[i] = a[i * n + r];
+    }
+    for (size_t j = 2; j <= k; ++j)
+    {
+      unsigned __int128 dot = 0;
+      for (size_t i = 0; i < r; ++i)
+      {
+        dot += static_cast< uint64_t >(a[r * n + i]) * v[i];
+      }
+      toeplitz[j] = static_cast< uint32_t >((p - static_cast< uint64_t >(dot % p)) % p);
+      if (j == k)
+      {
+        break;
+      }
+      w.assign(r, 0);
+      for (size_t i = 0; i < r; ++i)
+      {
+        unsigned __int128 sum = 0;
+        const uint32_t *row = a.data() + i * n;
+        for (size_t c = 0; c < r; ++c)
+        {
+          sum += static_cast< uint64_t >(row[c]) * v[c];
+        }
+        w[i] = static_cast< uint32_t >(sum % p);
+      }
+      v.swap(w);
+    }
+    next.assign(k + 1, 0);
+    for (size_t i = 0; i <= k; ++i)
+    {
+      unsigned __int128 sum = 0;
+      for (size_t j = i >= poly.size() ? i - poly.size() + 1 : 0; j <= i; ++j)
+      {
+        sum += static_cast< uint64_t >(toeplitz[j]) * poly[i - j];
+      }
+      next[i] = static_cast< uint32_t >(sum % p);
+    }
+    poly.swap(next);
+  }
+  std::reverse_copy(poly.begin(), poly.end(), out);
+}
+
+template< abramov::Integral T, class P >
+abramov::CharacteristicPolynomial abramov::characteristicPolynomial(const Matrix< T, P > &matrix, Charpoly method,
+  size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("characteristicPolynomial", matrix.getRows(), matrix.getCols());
+  size_t n = matrix.getRows();
+  if (n != matrix.getCols())
+  {
+    throw std::logic_error("Matrix must be square\n");
+  }
+  CharacteristicPolynomial res;
+  res.coefficients.assign(n + 1, BigInt());
+  res.coefficients[n] = BigInt(1);
+  if (!n)
+  {
+    return res;
+  }
+  std::vector< uint32_t > primes = modularPrimes(0, primesFor(static_cast< double >(n) + hadamardBits(matrix, n, false)));
+  std::vector< uint32_t > residues(primes.size() * (n + 1));
+  parallelFor(0, primes.size(), [&](size_t lo, size_t hi)
+  {
+    std::vector< uint32_t > a;
+    for (size_t k = lo; k < hi; ++k)
+    {
+      reduceMatrix(matrix, n, primes[k], a, n);
+      if (method == Charpoly::Berkowitz)
+      {
+        berkowitzCharpolyMod(a, n, primes[k], residues.data() + k * (n + 1));
+      }
+      else
+      {
+        hessenbergCharpolyMod(a, n, primes[k], residues.data() + k * (n + 1));
+      }
+    }
+  }, threads);
+  CrtBasis basis(primes);
+  res.coefficients = reconstructAll(basis, n + 1, [&](size_t i, size_t k)
+  {
+    return residues[i * (n + 1) + k];
+  }, threads);
+  return res;
+}
+
+inline void abramov::balanceMatrix(std::vector< double > &a, size_t n)
+{
+  // Scale row i by 1 / f and column i by f until the off-diagonal norms of each
+  // pair are within a factor of two; powers of two keep the scaling exact
+  constexpr size_t max_sweeps = 64;
+  bool changed = true;
+  for (size_t sweep = 0; changed && sweep < max_sweeps; ++sweep)
+  {
+    changed = false;
+    for (size_t i = 0; i < n; ++i)
+    {
+      double column = 0.0;
+      double row = 0.0;
+      for (size_t j = 0; j < n; ++j)
+      {
+        if (j != i)
+        {
+          column += std::fabs(a[j * n + i]);
+          row += std::fabs(a[i * n + j]);
+        }
+      }
+      if (column == 0.0 || row == 0.0)
+      {
+        continue;
+      }
+      int exponent = static_cast< int >(std::lround(0.5 * std::log2(row / column)));
+      double factor = std::ldexp(1.0, exponent);
+      if (!exponent || column * factor + row / factor >= 0.95 * (column + row))
+      {
+        continue;
+      }
+      changed = true;
+      for (size_t j = 0; j < n; ++j)
+      {
+        a[i * n + j] /= factor;
+        a[j * n + i] *= factor;
+      }
+    }
+  }
+}
+
+inline void abramov::reduceHessenberg(std::vector< double > &a, size_t n, size_t threads)
+{
+  std::vector< double > v(n);
+  std::vector< double > w(n);
+  for (size_t k = 0; k + 2 < n; ++k)
+  {
+    double scale = 0.0;
+    for (size_t i = k + 1; i < n; ++i)
+    {
+      scale += std::fabs(a[i * n + k]);
+    }
+    if (scale == 0.0)
+    {
+      continue;
+    }
+    double sigma = 0.0;
+    for (size_t i = k + 1; i < n; ++i)
+    {
+      v[i] = a[i * n + k] / scale;
+      sigma += v[i] * v[i];
+    }
+    double alpha = std::copysign(std::sqrt(sigma), v[k + 1]);
+    v[k + 1] += alpha;
+    double beta = 1.0 / (alpha * v[k + 1]);
+    std::fill(w.begin() + k, w.end(), 0.0);
+    for (size_t i = k + 1; i < n; ++i)
+    {
+      const double *row = a.data() + i * n;
+      for (size_t j = k; j < n; ++j)
+      {
+        w[j] += v[i] * row[j];
+      }
+    }
+    for (size_t i = k + 1; i < n; ++i)
+    {
+      double *row = a.data() + i * n;
+      double f = beta * v[i];
+      for (size_t j = k; j < n; ++j)
+      {
+        row[j] -= f * w[j];
+      }
+    }
+    parallelFor(0, n, [&](size_t lo, size_t hi)
+    {
+      for (size_t i = lo; i < hi; ++i)
+      {
+        double *row = a.data() + i * n;
+        double s = 0.0;
+        for (size_t j = k + 1; j < n; ++j)
+        {
+          s += row[j] * v[j];
+        }
+        s *= beta;
+        for (size_t j = k + 1; j < n; ++j)
+        {
+          row[j] -= s * v[j];
+        }
+      }
+    }, n >= 256 ? threads : 1);
+    a[(k + 1) * n + k] = -alpha * scale;
+    for (size_t i = k + 2; i < n; ++i)
+    {
+      a[i * n + k] = 0.0;
+    }
+  }
+}
+
+inline std::vector< std::complex< double > > abramov::hessenbergEigenvalues(std::vector< double > &h, size_t size)
+{
+  auto at = [&h, size](size_t i, size_t j) -> double &
+  {
+    return h[i * size + j];
+  };
+  constexpr double eps = std::numeric_limits< double >::epsilon();
+  constexpr size_t max_iterations = 60;
+  double norm = 0.0;
+  for (size_t i = 0; i < size; ++i)
+  {
+    for (size_t j = i ? i - 1 : 0; j < size; ++j)
+    {
+      norm += std::fabs(at(i, j));
+    }
+  }
+  std::vector< std::complex< double > > res(size);
+  // Francis double-shift QR on the active window [lo, hi): deflate from the
+  // bottom whenever a subdiagonal entry drops below rounding of its neighbours
+  size_t hi = size;
+  size_t iterations = 0;
+  while (hi > 0)
+  {
+    size_t lo = hi - 1;
+    for (; lo > 0; --lo)
+    {
+      double scale = std::fabs(at(lo - 1, lo - 1)) + std::fabs(at(lo, lo));
+      if (std::fabs(at(lo, lo - 1)) <= eps * (scale == 0.0 ? norm : scale))
+      {
+        at(lo, lo - 1) = 0.0;
+        break;
+      }
+    }
+    if (lo + 1 == hi)
+    {
+      --hi;
+      res[hi] = at(hi, hi);
+      iterations = 0;
+      continue;
+    }
+    size_t last = hi - 1;
+    if (lo + 2 == hi)
+    {
+      double a = at(lo, lo);
+      double b = at(lo, last);
+      double c = at(last, lo);
+      double d = at(last, last);
+      double half = 0.5 * (a - d);
+      double discriminant = half * half + b * c;
+      double root = std::sqrt(std::fabs(discriminant));
+      if (discriminant >= 0.0)
+      {
+        double offset = half + std::copysign(root, half);
+        res[lo] = d + offset;
+        res[last] = offset != 0.0 ? d - b * c / offset : d;
+      }
+      else
+      {
+        res[lo] = std::complex< double >(d + half, root);
+        res[last] = std::complex< double >(d + half, -root);
+      }
+      hi = lo;
+      iterations = 0;
+      continue;
+    }
+    if (iterations == max_iterations)
+    {
+      throw std::runtime_error("Eigenvalue iteration did not converge\n");
+    }
+    ++iterations;
+    // The shifts are the eigenvalues of the trailing 2 x 2 block, entering only
+    // through its trace and determinant; every tenth step uses an ad hoc pair
+    // to break cycles
+    double trace = at(last - 1, last - 1) + at(last, last);
+    double det = at(last - 1, last - 1) * at(last, last) - at(last - 1, last) * at(last, last - 1);
+    if (iterations % 10 == 0)
+    {
+      double s = std::fabs(at(last, last - 1)) + std::fabs(at(last - 1, last - 2));
+      trace = 1.5 * s;
+      det = s * s;
+    }
+    // First column of (H - s1 I)(H - s2 I): three nonzeros on a Hessenberg H
+    double first[3] = {
+      at(lo, lo) * at(lo, lo) + at(lo, lo + 1) * at(lo + 1, lo) - trace * at(lo, lo) + det,
+      at(lo + 1, lo) * (at(lo, lo) + at(lo + 1, lo + 1) - trace),
+      at(lo + 1, lo) * at(lo + 2, lo + 1)
+    };
+    for (size_t k = lo; k + 1 < hi; ++k)
+    {
+      size_t span = std::min< size_t >(3, hi - k);
+      double v[3] = { first[0], first[1], span == 3 ? first[2] : 0.0 };
+      double length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+      if (length != 0.0)
+      {
+        // Householder reflector I - beta v v^T mapping the column onto e1
+        double alpha = -std::copysign(length, v[0]);
+        v[0] -= alpha;
+        double beta = 2.0 / (v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        for (size_t j = k > lo ? k - 1 : lo; j < hi; ++j)
+        {
+          double dot = 0.0;
+          for (size_t r = 0; r < span; ++r)
+          {
+            dot += v[r] * at(k + r, j);
+          }
+          dot *= beta;
+          for (size_t r = 0; r < span; ++r)
+          {
+            at(k + r, j) -= dot * v[r];
+          }
+        }
+        if (k > lo)
+        {
+          for (size_t r = 1; r < span; ++r)
+          {
+            at(k + r, k - 1) = 0.0;
+          }
+        }
+        for (size_t i = lo; i <= std::min(k + 3, last); ++i)
+        {
+          double dot = 0.0;
+          for (size_t c = 0; c < span; ++c)
+          {
+            dot += at(i, k + c) * v[c];
+          }
+          dot *= beta;
+          for (size_t c = 0; c < span; ++c)
+          {
+            at(i, k + c) -= dot * v[c];
+          }
+        }
+      }
+      // The bulge now sits below the subdiagonal of column k: chase it down
+      if (k + 2 < hi)
+      {
+        first[0] = at(k + 1, k);
+        first[1] = at(k + 2, k);
+        first[2] = k + 3 < hi ? at(k + 3, k) : 0.0;
+      }
+    }
+  }
+  std::sort(res.begin(), res.end(), [](const std::complex< double > &lhs, const std::complex< double > &rhs)
+  {
+    return lhs.real() != rhs.real() ? lhs.real() < rhs.real() : lhs.imag() < rhs.imag();
+  });
+  return res;
+}
+
+template< abramov::Integral T, class P >
+std::vector< std::complex< double > > abramov::eigenvalues(const Matrix< T, P > &matrix, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("eigenvalues", matrix.getRows(), matrix.getCols());
+  size_t n = matrix.getRows();
+  if (n != matrix.getCols())
+  {
+    throw std::logic_error("Matrix must be square\n");
+  }
+  std::vector< double > a(n * n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      a[i * n + j] = static_cast< double >(matrix[i][j]);
+    }
+  }
+  balanceMatrix(a, n);
+  reduceHessenberg(a, n, threads);
+  return hessenbergEigenvalues(a, n);
+}
+#endif
@@ -0,0 +1,475 @@
+#ifndef GF2_HPP
+#define GF2_HPP
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "matrix.hpp"
+#include "threadpool.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ABRAMOV_GF2_X86 1
+#endif
+
+namespace abramov
+{
+  using XorRows = void (*)(uint64_t *dst, const uint64_t *src, size_t words);
+
+  struct Gf2Matrix
+  {
+    Gf2Matrix();
+    Gf2Matrix(size_t m, size_t n);
+    template< Integral T, class P >
+    explicit Gf2Matrix(const Matrix< T, P > &matrix);
+    static Gf2Matrix identity(size_t n);
+    size_t getRows() const noexcept;
+    size_t getCols() const noexcept;
+    size_t words() const noexcept;
+    bool get(size_t i, size_t j) const noexcept;
+    void set(size_t i, size_t j, bool value = true) noexcept;
+    uint64_t *row(size_t i) noexcept;
+    const uint64_t *row(size_t i) const noexcept;
+    template< Integral T >
+    Matrix< T > toMatrix() const;
+    Gf2Matrix transpose() const;
+    Gf2Matrix &operator+=(const Gf2Matrix &other);
+    Gf2Matrix operator+(const Gf2Matrix &other) const;
+    Gf2Matrix operator*(const Gf2Matrix &other) const;
+    bool operator==(const Gf2Matrix &other) const noexcept;
+    size_t echelonize(bool reduced = true, size_t threads = 0);
+    size_t rank(size_t threads = 0) const;
+    int determinant(size_t threads = 0) const;
+    Gf2Matrix inverse(size_t threads = 0) const;
+    Gf2Matrix solve(const Gf2Matrix &rhs, size_t threads = 0) const;
+  private:
+    size_t rows;
+    size_t cols;
+    size_t stride;
+    std::vector< uint64_t > bits;
+
+    Gf2Matrix augment(const Gf2Matrix &other) const;
+    Gf2Matrix columns(size_t first, size_t count) const;
+  };
+
+  Gf2Matrix gf2Multiply(const Gf2Matrix &lhs, const Gf2Matrix &rhs, size_t threads = 0);
+
+  void xorRowsPortable(uint64_t *dst, const uint64_t *src, size_t words);
+#ifdef ABRAMOV_GF2_X86
+  __attribute__((target("avx2"))) void xorRowsAvx2(uint64_t *dst, const uint64_t *src, size_t words);
+#endif
+  XorRows xorKernel() noexcept;
+}
+
+inline void abramov::xorRowsPortable(uint64_t *dst, const uint64_t *src, size_t words)
+{
+  for (size_t w = 0; w < words; ++w)
+  {
+    dst[w] ^= src[w];
+  }
+}
+
+#ifdef ABRAMOV_GF2_X86
+__attribute__((target("avx2"))) inline void abramov::xorRowsAvx2(uint64_t *dst, const uint64_t *src, size_t words)
+{
+  size_t w = 0;
+  for (; w + 4 <= words; w += 4)
+  {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(dst + w));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(src + w));
+    _mm256_storeu_si256(reinterpret_cast< __m256i * >(dst + w), _mm256_xor_si256(a, b));
+  }
+  for (; w < words; ++w)
+  {
+    dst[w] ^= src[w];
+  }
+}
+#endif
+
+inline abramov::XorRows abramov::xorKernel() noexcept
+{
+#ifdef ABRAMOV_GF2_X86
+  if (__builtin_cpu_supports("avx2"))
+  {
+    return xorRowsAvx2;
+  }
+#endif
+  return xorRowsPortable;
+}
+
+inline abramov::Gf2Matrix::Gf2Matrix():
+  Gf2Matrix(0, 0)
+{}
+
+inline abramov::Gf2Matrix::Gf2Matrix(size_t m, size_t n):
+  rows(m),
+  cols(n),
+  stride((n + 63) / 64),
+  bits(m * stride, 0)
+{}
+
+template< abramov::Integral T, class P >
+abramov::Gf2Matrix::Gf2Matrix(const Matrix< T, P > &matrix):
+  Gf2Matrix(matrix.getRows(), matrix.getCols())
+{
+  for (size_t i = 0; i < rows; ++i)
+  {
+    uint64_t *dst = row(i);
+    for (size_t j = 0; j < cols; ++j)
+    {
+      dst[j / 64] |= static_cast< uint64_t >(matrix[i][j] % 2 != 0) << (j % 64);
+    }
+  }
+}
+
+inline abramov::Gf2Matrix abramov::Gf2Matrix::identity(size_t n)
+{
+  Gf2Matrix res(n, n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    res.set(i, i);
+  }
+  return res;
+}
+
+inline size_t abramov::Gf2Matrix::getRows() const noexcept
+{
+  return rows;
+}
+
+inline size_t abramov::Gf2Matrix::getCols() const noexcept
+{
+  return cols;
+}
+
+inline size_t abramov::Gf2Matrix::words() const noexcept
+{
+  return stride;
+}
+
+inline bool abramov::Gf2Matrix::get(size_t i, size_t j) const noexcept
+{
+  return (row(i)[j / 64] >> (j % 64)) & 1;
+}
+
+inline void abramov::Gf2Matrix::set(size_t i, size_t j, bool value) noexcept
+{
+  uint64_t mask = uint64_t(1) << (j % 64);
+  uint64_t &word = row(i)[j / 64];
+  word = value ? word | mask : word & ~mask;
+}
+
+inline uint64_t *abramov::Gf2Matrix::row(size_t i) noexcept
+{
+  return bits.data() + i * stride;
+}
+
+inline const uint64_t *abramov::Gf2Matrix::row(size_t i) const noexcept
+{
+  return bits.data() + i * stride;
+}
+
+template< abramov::Integral T >
+abramov::Matrix< T > abramov::Gf2Matrix::toMatrix() const
+{
+  Matrix< T > res(rows, cols, 0);
+  for (size_t i = 0; i < rows; ++i)
+  {
+    for (size_t j = 0; j < cols; ++j)
+    {
+      res[i][j] = static_cast< T >(get(i, j));
+    }
+  }
+  return res;
+}
+
+inline abramov::Gf2Matrix abramov::Gf2Matrix::transpose() const
+{
+  Gf2Matrix res(cols, rows);
+  for (size_t i = 0; i < rows; ++i)
+  {
+    const uint64_t *src = row(i);
+    for (size_t w = 0; w < stride; ++w)
+    {
+      for (uint64_t word = src[w]; word; word &= word - 1)
+      {
+        res.set(w * 64 + std::countr_zero(word), i);
+      }
+    }
+  }
+  return res;
+}
+
+inline abramov::Gf2Matrix &abramov::Gf2Matrix::operator+=(const Gf2Matrix &other)
+{
+  if (rows != other.rows || cols != other.cols)
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  xorKernel()(bits.data(), other.bits.data(), bits.size());
+  return *this;
+}
+
+inline abramov::Gf2Matrix abramov::Gf2Matrix::operator+(const Gf2Matrix &other) const
+{
+  Gf2Matrix res = *this;
+  res += other;
+  return res;
+}
+
+inline abramov::Gf2Matrix abramov::Gf2Matrix::operator*(const Gf2Matrix &other) const
+{
+  return gf2Multiply(*this, other);
+}
+
+inline bool abramov::Gf2Matrix::operator==(const Gf2Matrix &other) const noexcept
+{
+  return rows == other.rows && cols == other.cols && bits == other.bits;
+}
+
+inline size_t abramov::Gf2Matrix::echelonize(bool reduced, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("Gf2Matrix::echelonize", rows, cols);
+  constexpr size_t group = 8;
+  XorRows kernel = xorKernel();
+  std::vector< uint64_t > table;
+  size_t r = 0;
+  size_t c = 0;
+  while (r < rows && c < cols)
+  {
+    size_t pivots[group];
+    size_t p = 0;
+    size_t first = c / 64;
+    size_t span = stride - first;
+    for (; c < cols && p < group && r + p < rows; ++c)
+    {
+      size_t found = rows;
+      for (size_t i = r + p; i < rows && found == rows; ++i)
+      {
+        for (size_t l = 0; l < p; ++l)
+        {
+          if (get(i, pivots[l]))
+          {
+            kernel(row(i) + first, row(r + l) + first, span);
+          }
+        }
+        found = get(i, c) ? i : rows;
+      }
+      if (found == rows)
+      {
+        continue;
+      }
+      if (found != r + p)
+      {
+        std::swap_ranges(row(found), row(found) + stride, row(r + p));
+      }
+      for (size_t l = 0; l < p; ++l)
+      {
+        if (get(r + l, c))
+        {
+          kernel(row(r + l) + first, row(r + p) + first, span);
+        }
+      }
+      pivots[p++] = c;
+    }
+    if (!p)
+    {
+      break;
+    }
+    table.assign(span << p, 0);
+    for (size_t mask = 1; mask < (size_t(1) << p); ++mask)
+    {
+      uint64_t *dst = table.data() + mask * span;
+      std::copy_n(table.data() + (mask & (mask - 1)) * span, span, dst);
+      kernel(dst, row(r + std::countr_zero(mask)) + first, span);
+    }
+    parallelFor(reduced ? 0 : r + p, rows, [&](size_t lo, size_t hi)
+    {
+      for (size_t i = lo; i < hi; ++i)
+      {
+        if (i >= r && i < r + p)
+        {
+          continue;
+        }
+        size_t index = 0;
+        for (size_t l = 0; l < p; ++l)
+        {
+          index |= static_cast< size_t >(get(i, pivots[l])) << l;
+        }
+        if (index)
+        {
+          kernel(row(i) + first, table.data() + index * span, span);
+        }
+      }
+    }, threads);
+    r += p;
+  }
+  return r;
+}
+
+inline size_t abramov::Gf2Matrix::rank(size_t threads) const
+{
+  ABRAMOV_PROFILE_SCOPE("Gf2Matrix::rank", rows, cols);
+  Gf2Matrix tmp = *this;
+  return tmp.echelonize(false, threads);
+}
+
+inline int abramov::Gf2Matrix::determinant(size_t threads) const
+{
+  ABRAMOV_PROFILE_SCOPE("Gf2Matrix::determinant", rows, cols);
+  if (rows != cols)
+  {
+    throw std::logic_error("Matrix must be square to get determinant\n");
+  }
+  return rank(threads) == rows;
+}
+
+inline abramov::Gf2Matrix abramov::Gf2Matrix::inverse(size_t threads) const
+{
+  ABRAMOV_PROFILE_SCOPE("Gf2Matrix::inverse", rows, cols);
+  if (rows != cols)
+  {
+    throw std::logic_error("Matrix must be square\n");
+  }
+  Gf2Matrix tmp = augment(identity(rows));
+  tmp.echelonize(true, threads);
+  for (size_t i = 0; i < rows; ++i)
+  {
+    if (!tmp.get(i, i))
+    {
+      throw std::logic_error("Matrix does not have inverse\n");
+    }
+  }
+  return tmp.columns(cols, cols);
+}
+
+inline abramov::Gf2Matrix abramov::Gf2Matrix::solve(const Gf2Matrix &rhs, size_t threads) const
+{
+  ABRAMOV_PROFILE_SCOPE("Gf2Matrix::solve", rows, cols);
+  if (rhs.rows != rows)
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  Gf2Matrix tmp = augment(rhs);
+  size_t rank = tmp.echelonize(true, threads);
+  Gf2Matrix values = tmp.columns(cols, rhs.cols);
+  Gf2Matrix res(cols, rhs.cols);
+  for (size_t i = 0; i < rank; ++i)
+  {
+    const uint64_t *line = tmp.row(i);
+    size_t w = 0;
+    while (!line[w])
+    {
+      ++w;
+    }
+    size_t pivot = w * 64 + std::countr_zero(line[w]);
+    if (pivot >= cols)
+    {
+      throw std::logic_error("System has no solution\n");
+    }
+    std::copy_n(values.row(i), values.stride, res.row(pivot));
+  }
+  return res;
+}
+
+inline abramov::Gf2Matrix abramov::Gf2Matrix::augment(const Gf2Matrix &other) const
+{
+  Gf2Matrix res(rows, cols + other.cols);
+  size_t shift = cols % 64;
+  for (size_t i = 0; i < rows; ++i)
+  {
+    uint64_t *dst = res.row(i);
+    std::copy_n(row(i), stride, dst);
+    const uint64_t *src = other.row(i);
+    for (size_t w = 0; w < other.stride; ++w)
+    {
+      size_t at = cols / 64 + w;
+      dst[at] |= src[w] << shift;
+      if (shift && at + 1 < res.stride)
+      {
+        dst[at + 1] |= src[w] >> (64 - shift);
+      }
+    }
+  }
+  return res;
+}
+
+inline abramov::Gf2Matrix abramov::Gf2Matrix::columns(size_t first, size_t count) const
+{
+  Gf2Matrix res(rows, count);
+  size_t shift = first % 64;
+  uint64_t tail = count % 64 ? (uint64_t(1) << (count % 64)) - 1 : ~uint64_t(0);
+  for (size_t i = 0; i < rows; ++i)
+  {
+    const uint64_t *src = row(i);
+    uint64_t *dst = res.row(i);
+    for (size_t w = 0; w < res.stride; ++w)
+    {
+      size_t at = first / 64 + w;
+      uint64_t word = src[at] >> shift;
+      if (shift && at + 1 < stride)
+      {
+        word |= src[at + 1] << (64 - shift);
+      }
+      dst[w] = w + 1 == res.stride ? word & tail : word;
+    }
+  }
+  return res;
+}
+
+inline abramov::Gf2Matrix abramov::gf2Multiply(const Gf2Matrix &lhs, const Gf2Matrix &rhs, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("gf2Multiply", lhs.getRows(), rhs.getCols());
+  if (lhs.getCols() != rhs.getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  size_t m = lhs.getRows();
+  size_t inner = lhs.getCols();
+  size_t w = rhs.words();
+  Gf2Matrix res(m, rhs.getCols());
+  if (!m || !inner || !w)
+  {
+    return res;
+  }
+  XorRows kernel = xorKernel();
+  std::vector< uint64_t > tables(8 * 256 * w, 0);
+  for (size_t word = 0; word < lhs.words(); ++word)
+  {
+    size_t groups = std::min< size_t >(8, (inner - word * 64 + 7) / 8);
+    parallelFor(0, groups, [&](size_t lo, size_t hi)
+    {
+      for (size_t g = lo; g < hi; ++g)
+      {
+        size_t k0 = word * 64 + g * 8;
+        size_t span = std::min< size_t >(8, inner - k0);
+        uint64_t *table = tables.data() + g * 256 * w;
+        for (size_t mask = 1; mask < (size_t(1) << span); ++mask)
+        {
+          uint64_t *dst = table + mask * w;
+          std::copy_n(table + (mask & (mask - 1)) * w, w, dst);
+          kernel(dst, rhs.row(k0 + std::countr_zero(mask)), w);
+        }
+      }
+    }, threads);
+    parallelFor(0, m, [&](size_t lo, size_t hi)
+    {
+      for (size_t i = lo; i < hi; ++i)
+      {
+        uint64_t bitsRow = lhs.row(i)[word];
+        uint64_t *dst = res.row(i);
+        for (size_t g = 0; bitsRow; ++g, bitsRow >>= 8)
+        {
+          size_t mask = bitsRow & 0xff;
+          if (mask)
+          {
+            kernel(dst, tables.data() + (g * 256 + mask) * w, w);
+          }
+        }
+      }
+    }, threads);
+  }
+  return res;
+}
+#endif
@@ -0,0 +1,642 @@
+#ifndef KNN_HPP
+#define KNN_HPP
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "threadpool.hpp"
+#include "vector.hpp"
+
+namespace abramov
+{
+  enum class Metric
+  {
+    Euclidean,
+    Cosine
+  };
+
+  struct Neighbour
+  {
+    size_t index;
+    double distance;
+  };
+
+  template< Numeric T, size_t N >
+  struct FlatIndex
+  {
+    explicit FlatIndex(std::vector< Vector< T, N > > points, Metric metric = Metric::Euclidean, size_t threads = 0);
+    size_t size() const noexcept;
+    Metric metric() const noexcept;
+    const Vector< T, N > &operator[](size_t i) const;
+    std::vector< Neighbour > query(const Vector< T, N > &q, size_t k) const;
+    std::vector< std::vector< Neighbour > > query(const std::vector< Vector< T, N > > &queries, size_t k,
+      size_t threads = 0) const;
+  private:
+    std::vector< Vector< T, N > > points;
+    std::vector< double > norms;
+    Metric kind;
+  };
+
+  template< Numeric T, size_t N >
+  struct KdTree
+  {
+    explicit KdTree(std::vector< Vector< T, N > > points, Metric metric = Metric::Euclidean, size_t threads = 0);
+    size_t size() const noexcept;
+    Metric metric() const noexcept;
+    const Vector< T, N > &operator[](size_t i) const;
+    std::vector< Neighbour > query(const Vector< T, N > &q, size_t k) const;
+    std::vector< std::vector< Neighbour > > query(const std::vector< Vector< T, N > > &queries, size_t k,
+      size_t threads = 0) const;
+  private:
+    static constexpr size_t leaf = 16;
+
+    std::vector< Vector< T, N > > points;
+    std::vector< Vector< double, N > > nodes;
+    std::vector< size_t > order;
+    std::vector< size_t > dims;
+    Metric kind;
+
+    Vector< double, N > prepare(const Vector< T, N > &p) const;
+    size_t split(size_t lo, size_t hi);
+    void build(size_t lo, size_t hi);
+    void search(size_t lo, size_t hi, const Vector< double, N > &q, std::vector< Neighbour > &heap, size_t k) const;
+  };
+
+  template< Numeric T, size_t N >
+  struct IvfIndex
+  {
+    IvfIndex(std::vector< Vector< T, N > > points, Metric metric = Metric::Euclidean, size_t lists = 0,
+      size_t threads = 0);
+    size_t size() const noexcept;
+    Metric metric() const noexcept;
+    size_t lists() const noexcept;
+    size_t probes() const noexcept;
+    IvfIndex< T, N > &setProbes(size_t count);
+    const Vector< T, N > &operator[](size_t i) const;
+    std::vector< Neighbour > query(const Vector< T, N > &q, size_t k) const;
+    std::vector< std::vector< Neighbour > > query(const std::vector< Vector< T, N > > &queries, size_t k,
+      size_t threads = 0) const;
+  private:
+    static constexpr size_t iterations = 10;
+
+    std::vector< Vector< T, N > > points;
+    std::vector< double > norms;
+    std::vector< Vector< double, N > > centroids;
+    std::vector< std::vector< size_t > > members;
+    Metric kind;
+    size_t probe;
+
+    double centroidDistance(const Vector< T, N > &p, double norm, size_t c) const;
+    size_t nearestCentroid(const Vector< T, N > &p, double norm) const;
+  };
+
+  template< Numeric T, size_t N >
+  std::vector< double > pointNorms(const std::vector< Vector< T, N > > &points, Metric metric, size_t threads);
+  template< Numeric T, size_t N >
+  double queryNorm(const Vector< T, N > &q, Metric metric);
+  template< Numeric T, size_t N >
+  double pointDistance(const Vector< T, N > &q, double qnorm, const Vector< T, N > &p, double pnorm, Metric metric);
+  void pushNeighbour(std::vector< Neighbour > &heap, size_t k, Neighbour n);
+  std::vector< Neighbour > sortedNeighbours(std::vector< Neighbour > heap);
+}
+
+template< abramov::Numeric T, size_t N >
+std::vector< double > abramov::pointNorms(const std::vector< Vector< T, N > > &points, Metric metric, size_t threads)
+{
+  if (metric != Metric::Cosine)
+  {
+    return {};
+  }
+  std::vector< double > res(points.size());
+  parallelFor(0, points.size(), [&](size_t lo, size_t hi)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      res[i] = queryNorm(points[i], metric);
+    }
+  }, threads);
+  return res;
+}
+
+template< abramov::Numeric T, size_t N >
+double abramov::queryNorm(const Vector< T, N > &q, Metric metric)
+{
+  if (metric != Metric::Cosine)
+  {
+    return 0;
+  }
+  double res = q.norm();
+  if (res == 0)
+  {
+    throw std::logic_error("Can not compute angle with zero vector\n");
+  }
+  return res;
+}
+
+template< abramov::Numeric T, size_t N >
+double abramov::pointDistance(const Vector< T, N > &q, double qnorm, const Vector< T, N > &p, double pnorm,
+  Metric metric)
+{
+  if (metric == Metric::Cosine)
+  {
+    return 1.0 - static_cast< double >(q.dot(p)) / (qnorm * pnorm);
+  }
+  return q.distance(p);
+}
+
+inline void abramov::pushNeighbour(std::vector< Neighbour > &heap, size_t k, Neighbour n)
+{
+  auto cmp = [](const Neighbour &a, const Neighbour &b)
+  {
+    return a.distance < b.distance || (a.distance == b.distance && a.index < b.index);
+  };
+  if (heap.size() < k)
+  {
+    heap.push_back(n);
+    std::push_heap(heap.begin(), heap.end(), cmp);
+  }
+  else if (k && cmp(n, heap.front()))
+  {
+    std::pop_heap(heap.begin(), heap.end(), cmp);
+    heap.back() = n;
+    std::push_heap(heap.begin(), heap.end(), cmp);
+  }
+}
+
+inline std::vector< abramov::Neighbour > abramov::sortedNeighbours(std::vector< Neighbour > heap)
+{
+  std::sort(heap.begin(), heap.end(), [](const Neighbour &a, const Neighbour &b)
+  {
+    return a.distance < b.distance || (a.distance == b.distance && a.index < b.index);
+  });
+  return heap;
+}
+
+template< abramov::Numeric T, size_t N >
+abramov::FlatIndex< T, N >::FlatIndex(std::vector< Vector< T, N > > data, Metric metric, size_t threads):
+  points(std::move(data)),
+  norms(pointNorms(points, metric, threads)),
+  kind(metric)
+{}
+
+template< abramov::Numeric T, size_t N >
+size_t abramov::FlatIndex< T, N >::size() const noexcept
+{
+  return points.size();
+}
+
+template< abramov::Numeric T, size_t N >
+abramov::Metric abramov::FlatIndex< T, N >::metric() const noexcept
+{
+  return kind;
+}
+
+template< abramov::Numeric T, size_t N >
+const abramov::Vector< T, N > &abramov::FlatIndex< T, N >::operator[](size_t i) const
+{
+  return points.at(i);
+}
+
+template< abramov::Numeric T, size_t N >
+std::vector< abramov::Neighbour > abramov::FlatIndex< T, N >::query(const Vector< T, N > &q, size_t k) const
+{
+  ABRAMOV_PROFILE_SCOPE("FlatIndex::query", points.size(), N);
+  std::vector< Neighbour > heap;
+  heap.reserve(std::min(k, points.size()));
+  if (kind == Metric::Cosine)
+  {
+    double qnorm = queryNorm(q, kind);
+    std::vector< T > d = dots(q, points);
+    for (size_t i = 0; i < d.size(); ++i)
+    {
+      pushNeighbour(heap, k, { i, 1.0 - static_cast< double >(d[i]) / (qnorm * norms[i]) });
+    }
+  }
+  else
+  {
+    std::vector< double > d = distances(q, points);
+    for (size_t i = 0; i < d.size(); ++i)
+    {
+      pushNeighbour(heap, k, { i, d[i] });
+    }
+  }
+  return sortedNeighbours(std::move(heap));
+}
+
+template< abramov::Numeric T, size_t N >
+std::vector< std::vector< abramov::Neighbour > > abramov::FlatIndex< T, N >::query(
+  const std::vector< Vector< T, N > > &queries, size_t k, size_t threads) const
+{
+  std::vector< std::vector< Neighbour > > res(queries.size());
+  parallelFor(0, queries.size(), [&](size_t lo, size_t hi)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      res[i] = query(queries[i], k);
+    }
+  }, threads);
+  return res;
+}
+
+template< abramov::Numeric T, size_t N >
+abramov::KdTree< T, N >::KdTree(std::vector< Vector< T, N > > data, Metric metric, size_t threads):
+  points(std::move(data)),
+  nodes(points.size()),
+  order(points.size()),
+  dims(points.size()),
+  kind(metric)
+{
+  ABRAMOV_PROFILE_SCOPE("KdTree::KdTree", points.size(), N);
+  parallelFor(0, points.size(), [&](size_t lo, size_t hi)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      nodes[i] = prepare(points[i]);
+      order[i] = i;
+    }
+  }, threads);
+  if (!threads)
+  {
+    threads = defaultThreads();
+  }
+  std::vector< std::pair< size_t, size_t > > ranges{ { 0, points.size() } };
+  while (ranges.size() < 4 * threads)
+  {
+    std::vector< std::pair< size_t, size_t > > next;
+    for (auto [lo, hi] : ranges)
+    {
+      if (hi - lo <= leaf)
+      {
+        next.emplace_back(lo, hi);
+        continue;
+      }
+      size_t mid = split(lo, hi);
+      next.emplace_back(lo, mid);
+      next.emplace_back(mid + 1, hi);
+    }
+    if (next.size() == ranges.size())
+    {
+      break;
+    }
+    ranges = std::move(next);
+  }
+  parallelFor(0, ranges.size(), [&](size_t lo, size_t hi)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      build(ranges[i].first, ranges[i].second);
+    }
+  }, threads);
+  std::vector< Vector< double, N > > sorted(points.size());
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    sorted[i] = std::move(nodes[order[i]]);
+  }
+  nodes = std::move(sorted);
+}
+
+template< abramov::Numeric T, size_t N >
+size_t abramov::KdTree< T, N >::size() const noexcept
+{
+  return points.size();
+}
+
+template< abramov::Numeric T, size_t N >
+abramov::Metric abramov::KdTree< T, N >::metric() const noexcept
+{
+  return kind;
+}
+
+template< abramov::Numeric T, size_t N >
+const abramov::Vector< T, N > &abramov::KdTree< T, N >::operator[](size_t i) const
+{
+  return points.at(i);
+}
+
+template< abramov::Numeric T, size_t N >
+std::vector< abramov::Neighbour > abramov::KdTree< T, N >::query(const Vector< T, N > &q, size_t k) const
+{
+  ABRAMOV_PROFILE_SCOPE("KdTree::query", points.size(), N);
+  std::vector< Neighbour > heap;
+  heap.reserve(std::min(k, points.size()));
+  if (k)
+  {
+    search(0, points.size(), prepare(q), heap, k);
+  }
+  if (kind == Metric::Cosine)
+  {
+    for (Neighbour &n : heap)
+    {
+      n.distance = n.distance * n.distance / 2;
+    }
+  }
+  return sortedNeighbours(std::move(heap));
+}
+
+template< abramov::Numeric T, size_t N >
+std::vector< std::vector< abramov::Neighbour > > abramov::KdTree< T, N >::query(
+  const std::vector< Vector< T, N > > &queries, size_t k, size_t threads) const
+{
+  std::vector< std::vector< Neighbour > > res(queries.size());
+  parallelFor(0, queries.size(), [&](size_t lo, size_t hi)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      res[i] = query(queries[i], k);
+    }
+  }, threads);
+  return res;
+}
+
+template< abramov::Numeric T, size_t N >
+abramov::Vector< double, N > abramov::KdTree< T, N >::prepare(const Vector< T, N > &p) const
+{
+  if (kind == Metric::Cosine)
+  {
+    return p.normalized();
+  }
+  Vector< double, N > res;
+  for (size_t i = 0; i < N; ++i)
+  {
+    res[i] = static_cast< double >(p[i]);
+  }
+  return res;
+}
+
+template< abramov::Numeric T, size_t N >
+size_t abramov::KdTree< T, N >::split(size_t lo, size_t hi)
+{
+  size_t dim = 0;
+  double spread = -1;
+  for (size_t d = 0; d < N; ++d)
+  {
+    double low = std::numeric_limits< double >::infinity();
+    double high = -low;
+    for (size_t i = lo; i < hi; ++i)
+    {
+      low = std::min(low, nodes[order[i]][d]);
+      high = std::max(high, nodes[order[i]][d]);
+    }
+    if (high - low > spread)
+    {
+      spread = high - low;
+      dim = d;
+    }
+  }
+  size_t mid = lo + (hi - lo) / 2;
+  std::nth_element(order.begin() + lo, order.begin() + mid, order.begin() + hi, [this, dim](size_t a, size_t b)
+  {
+    return nodes[a][dim] < nodes[b][dim];
+  });
+  dims[mid] = dim;
+  return mid;
+}
+
+template< abramov::Numeric T, size_t N >
+void abramov::KdTree< T, N >::build(size_t lo, size_t hi)
+{
+  if (hi - lo <= leaf)
+  {
+    return;
+  }
+  size_t mid = split(lo, hi);
+  build(lo, mid);
+  build(mid + 1, hi);
+}
+
+template< abramov::Numeric T, size_t N >
+void abramov::KdTree< T, N >::search(size_t lo, size_t hi, const Vector< double, N > &q, std::vector< Neighbour > &heap,
+  size_t k) const
+{
+  if (hi - lo <= leaf)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      pushNeighbour(heap, k, { order[i], q.distance(nodes[i]) });
+    }
+    return;
+  }
+  size_t mid = lo + (hi - lo) / 2;
+  size_t dim = dims[mid];
+  double diff = q[dim] - nodes[mid][dim];
+  pushNeighbour(heap, k, { order[mid], q.distance(nodes[mid]) });
+  if (diff < 0)
+  {
+    search(lo, mid, q, heap, k);
+  }
+  else
+  {
+    search(mid + 1, hi, q, heap, k);
+  }
+  if (heap.size() < k || std::abs(diff) <= heap.front().distance)
+  {
+    if (diff < 0)
+    {
+      search(mid + 1, hi, q, heap, k);
+    }
+    else
+    {
+      search(lo, mid, q, heap, k);
+    }
+  }
+}
+
+template< abramov::Numeric T, size_t N >
+abramov::IvfIndex< T, N >::IvfIndex(std::vector< Vector< T, N > > data, Metric metric, size_t count, size_t threads):
+  points(std::move(data)),
+  norms(pointNorms(points, metric, threads)),
+  centroids(),
+  members(),
+  kind(metric),
+  probe(1)
+{
+  ABRAMOV_PROFILE_SCOPE("IvfIndex::IvfIndex", points.size(), N);
+  if (!count)
+  {
+    count = static_cast< size_t >(std::sqrt(static_cast< double >(points.size())));
+  }
+  count = std::max< size_t >(1, std::min(count, points.size()));
+  probe = std::max< size_t >(1, count / 8);
+  for (size_t c = 0; c < count; ++c)
+  {
+    Vector< double, N > centroid;
+    if (!points.empty())
+    {
+      const Vector< T, N > &p = points[c * points.size() / count];
+      double scale = kind == Metric::Cosine ? norms[c * points.size() / count] : 1.0;
+      for (size_t i = 0; i < N; ++i)
+      {
+        centroid[i] = static_cast< double >(p[i]) / scale;
+      }
+    }
+    centroids.push_back(centroid);
+  }
+  std::vector< size_t > assignment(points.size(), count);
+  for (size_t step = 0; step < iterations; ++step)
+  {
+    std::atomic< size_t > changed{ 0 };
+    parallelFor(0, points.size(), [&](size_t lo, size_t hi)
+    {
+      size_t local = 0;
+      for (size_t i = lo; i < hi; ++i)
+      {
+        size_t c = nearestCentroid(points[i], kind == Metric::Cosine ? norms[i] : 0);
+        local += c != assignment[i];
+        assignment[i] = c;
+      }
+      changed += local;
+    }, threads);
+    if (!changed)
+    {
+      break;
+    }
+    std::vector< Vector< double, N > > sums(count);
+    std::vector< size_t > counts(count, 0);
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      double scale = kind == Metric::Cosine ? norms[i] : 1.0;
+      for (size_t d = 0; d < N; ++d)
+      {
+        sums[assignment[i]][d] += static_cast< double >(points[i][d]) / scale;
+      }
+      ++counts[assignment[i]];
+    }
+    for (size_t c = 0; c < count; ++c)
+    {
+      if (!counts[c])
+      {
+        continue;
+      }
+      double len = kind == Metric::Cosine ? sums[c].norm() : static_cast< double >(counts[c]);
+      if (len == 0)
+      {
+        continue;
+      }
+      centroids[c] = sums[c] * (1.0 / len);
+    }
+  }
+  members.resize(count);
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    members[assignment[i]].push_back(i);
+  }
+}
+
+template< abramov::Numeric T, size_t N >
+size_t abramov::IvfIndex< T, N >::size() const noexcept
+{
+  return points.size();
+}
+
+template< abramov::Numeric T, size_t N >
+abramov::Metric abramov::IvfIndex< T, N >::metric() const noexcept
+{
+  return kind;
+}
+
+template< abramov::Numeric T, size_t N >
+size_t abramov::IvfIndex< T, N >::lists() const noexcept
+{
+  return centroids.size();
+}
+
+template< abramov::Numeric T, size_t N >
+size_t abramov::IvfIndex< T, N >::probes() const noexcept
+{
+  return probe;
+}
+
+template< abramov::Numeric T, size_t N >
+abramov::IvfIndex< T, N > &abramov::IvfIndex< T, N >::setProbes(size_t count)
+{
+  if (!count)
+  {
+    throw std::invalid_argument("Number of probes must be positive\n");
+  }
+  probe = std::min(count, centroids.size());
+  return *this;
+}
+
+template< abramov::Numeric T, size_t N >
+const abramov::Vector< T, N > &abramov::IvfIndex< T, N >::operator[](size_t i) const
+{
+  return points.at(i);
+}
+
+template< abramov::Numeric T, size_t N >
+std::vector< abramov::Neighbour > abramov::IvfIndex< T, N >::query(const Vector< T, N > &q, size_t k) const
+{
+  ABRAMOV_PROFILE_SCOPE("IvfIndex::query", points.size(), N);
+  double qnorm = queryNorm(q, kind);
+  std::vector< Neighbour > nearest;
+  for (size_t c = 0; c < centroids.size(); ++c)
+  {
+    pushNeighbour(nearest, probe, { c, centroidDistance(q, qnorm, c) });
+  }
+  std::vector< Neighbour > heap;
+  heap.reserve(std::min(k, points.size()));
+  for (const Neighbour &list : nearest)
+  {
+    for (size_t i : members[list.index])
+    {
+      double pnorm = kind == Metric::Cosine ? norms[i] : 0;
+      pushNeighbour(heap, k, { i, pointDistance(q, qnorm, points[i], pnorm, kind) });
+    }
+  }
+  return sortedNeighbours(std::move(heap));
+}
+
+template< abramov::Numeric T, size_t N >
+std::vector< std::vector< abramov::Neighbour > > abramov::IvfIndex< T, N >::query(
+  const std::vector< Vector< T, N > > &queries, size_t k, size_t threads) const
+{
+  std::vector< std::vector< Neighbour > > res(queries.size());
+  parallelFor(0, queries.size(), [&](size_t lo, size_t hi)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      res[i] = query(queries[i], k);
+    }
+  }, threads);
+  return res;
+}
+
+template< abramov::Numeric T, size_t N >
+double abramov::IvfIndex< T, N >::centroidDistance(const Vector< T, N > &p, double norm, size_t c) const
+{
+  const Vector< double, N > &centroid = centroids[c];
+  if (kind == Metric::Cosine)
+  {
+    return 1.0 - productSum< double >(N, [&p, &centroid](size_t i)
+    {
+      return std::pair< double, double >(static_cast< double >(p[i]), centroid[i]);
+    }) / norm;
+  }
+  return std::sqrt(productSum< double >(N, [&p, &centroid](size_t i)
+  {
+    double d = static_cast< double >(p[i]) - centroid[i];
+    return std::pair< double, double >(d, d);
+  }));
+}
+
+template< abramov::Numeric T, size_t N >
+size_t abramov::IvfIndex< T, N >::nearestCentroid(const Vector< T, N > &p, double norm) const
+{
+  size_t best = 0;
+  double dist = std::numeric_limits< double >::infinity();
+  for (size_t c = 0; c < centroids.size(); ++c)
+  {
+    double d = centroidDistance(p, norm, c);
+    if (d < dist)
+    {
+      dist = d;
+      best = c;
+    }
+  }
+  return best;
+}
+#endif
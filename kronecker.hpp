@@ -0,0 +1,174 @@
+#ifndef KRONECKER_HPP
+#define KRONECKER_HPP
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include "matrix.hpp"
+#include "overflow.hpp"
+#include "threadpool.hpp"
+
+namespace abramov
+{
+  template< Integral T, class P = Wrapping >
+  struct KroneckerOperator
+  {
+    KroneckerOperator(const Matrix< T, P > &a, const Matrix< T, P > &b);
+    KroneckerOperator(Matrix< T, P > &&a, Matrix< T, P > &&b);
+    size_t getRows() const noexcept;
+    size_t getCols() const noexcept;
+    const Matrix< T, P > &left() const noexcept;
+    const Matrix< T, P > &right() const noexcept;
+    T operator()(size_t row, size_t col) const;
+    KroneckerOperator< T, P > transpose() const;
+    std::vector< T > multiply(const std::vector< T > &x, size_t threads = 1) const;
+    Matrix< T, P > multiply(const Matrix< T, P > &x, size_t threads = 1) const;
+    Matrix< T, P > materialize(size_t threads = 0) const;
+  private:
+    Matrix< T, P > a;
+    Matrix< T, P > b;
+
+    void apply(const T *const *in, size_t k, T *const *out, size_t threads) const;
+  };
+}
+
+template< abramov::Integral T, class P >
+abramov::KroneckerOperator< T, P >::KroneckerOperator(const Matrix< T, P > &lhs, const Matrix< T, P > &rhs):
+  a(lhs),
+  b(rhs)
+{}
+
+template< abramov::Integral T, class P >
+abramov::KroneckerOperator< T, P >::KroneckerOperator(Matrix< T, P > &&lhs, Matrix< T, P > &&rhs):
+  a(std::move(lhs)),
+  b(std::move(rhs))
+{}
+
+template< abramov::Integral T, class P >
+size_t abramov::KroneckerOperator< T, P >::getRows() const noexcept
+{
+  return a.getRows() * b.getRows();
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::KroneckerOperator< T, P >::getCols() const noexcept
+{
+  return a.getCols() * b.getCols();
+}
+
+template< abramov::Integral T, class P >
+const abramov::Matrix< T, P > &abramov::KroneckerOperator< T, P >::left() const noexcept
+{
+  return a;
+}
+
+template< abramov::Integral T, class P >
+const abramov::Matrix< T, P > &abramov::KroneckerOperator< T, P >::right() const noexcept
+{
+  return b;
+}
+
+template< abramov::Integral T, class P >
+T abramov::KroneckerOperator< T, P >::operator()(size_t row, size_t col) const
+{
+  if (row >= getRows() || col >= getCols())
+  {
+    throw std::out_of_range("Index out of range\n");
+  }
+  T res = a[row / b.getRows()][col / b.getCols()];
+  scaleRow< P >(&res, 1, b[row % b.getRows()][col % b.getCols()]);
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::KroneckerOperator< T, P > abramov::KroneckerOperator< T, P >::transpose() const
+{
+  return KroneckerOperator< T, P >(a.transpose(), b.transpose());
+}
+
+template< abramov::Integral T, class P >
+std::vector< T > abramov::KroneckerOperator< T, P >::multiply(const std::vector< T > &x, size_t threads) const
+{
+  ABRAMOV_PROFILE_SCOPE("KroneckerOperator::multiply(vector)", getRows(), getCols());
+  if (x.size() != getCols())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  std::vector< const T * > in(x.size());
+  for (size_t i = 0; i < x.size(); ++i)
+  {
+    in[i] = x.data() + i;
+  }
+  std::vector< T > y(getRows(), 0);
+  std::vector< T * > out(y.size());
+  for (size_t i = 0; i < y.size(); ++i)
+  {
+    out[i] = y.data() + i;
+  }
+  apply(in.data(), 1, out.data(), threads);
+  return y;
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::KroneckerOperator< T, P >::multiply(const Matrix< T, P > &x, size_t threads) const
+{
+  ABRAMOV_PROFILE_SCOPE("KroneckerOperator::multiply(Matrix)", getRows(), x.getCols());
+  if (x.getRows() != getCols())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  std::vector< const T * > in(x.getRows());
+  for (size_t i = 0; i < in.size(); ++i)
+  {
+    in[i] = x[i];
+  }
+  Matrix< T, P > y(getRows(), x.getCols(), 0);
+  std::vector< T * > out(y.getRows());
+  for (size_t i = 0; i < out.size(); ++i)
+  {
+    out[i] = y[i];
+  }
+  apply(in.data(), x.getCols(), out.data(), threads);
+  return y;
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::KroneckerOperator< T, P >::materialize(size_t threads) const
+{
+  return Matrix< T, P >::kroneckerProduct(a, b, threads);
+}
+
+template< abramov::Integral T, class P >
+void abramov::KroneckerOperator< T, P >::apply(const T *const *in, size_t k, T *const *out, size_t threads) const
+{
+  size_t ar = a.getRows();
+  size_t ac = a.getCols();
+  size_t br = b.getRows();
+  size_t bc = b.getCols();
+  if (!k || !ar || !br)
+  {
+    return;
+  }
+  std::vector< T > partial(ac * br * k);
+  parallelFor(0, ac * br, [&](size_t lo, size_t hi)
+  {
+    for (size_t row = lo; row < hi; ++row)
+    {
+      size_t j = row / br;
+      multiplyRow< P >(partial.data() + row * k, b[row % br], in + j * bc, bc, k);
+    }
+  }, threads);
+  parallelFor(0, ar * br, [&](size_t lo, size_t hi)
+  {
+    std::vector< const T * > blocks(ac);
+    for (size_t row = lo; row < hi; ++row)
+    {
+      size_t r = row % br;
+      for (size_t j = 0; j < ac; ++j)
+      {
+        blocks[j] = partial.data() + (j * br + r) * k;
+      }
+      multiplyRow< P >(out[row], a[row / br], blocks.data(), ac, k);
+    }
+  }, threads);
+}
+#endif
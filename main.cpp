@@ -1,14 +1,92 @@
+#include <cstdlib>
 #include <fstream>
-#include <iomanip>
 #include <iostream>
+#include <string>
+#include "batch.hpp"
 #include "matrix.hpp"
 #include "vector.hpp"
 
+namespace
+{
+  int runManifest(int argc, char **argv)
+  {
+    size_t threads = 0;
+    size_t memory = 0;
+    std::string report;
+    for (int i = 3; i < argc; i += 2)
+    {
+      std::string key = argv[i];
+      if (i + 1 >= argc)
+      {
+        std::cerr << "Missing value for " << key << '\n';
+        return 1;
+      }
+      char *end = nullptr;
+      unsigned long long value = std::strtoull(argv[i + 1], &end, 10);
+      if (key == "--jobs" && *end == '\0')
+      {
+        threads = value;
+      }
+      else if (key == "--memory" && *end == '\0')
+      {
+        memory = value << 20;
+      }
+      else if (key == "--report")
+      {
+        report = argv[i + 1];
+      }
+      else
+      {
+        std::cerr << "Incorrect option " << key << '\n';
+        return 1;
+      }
+    }
+    std::ifstream manifest(argv[2]);
+    if (!manifest)
+    {
+      std::cerr << "Incorrect filename\n";
+      return 1;
+    }
+    std::ofstream log;
+    if (!report.empty())
+    {
+      log.open(report);
+      if (!log)
+      {
+        std::cerr << "Incorrect filename\n";
+        return 1;
+      }
+    }
+    try
+    {
+      auto jobs = abramov::parseManifest(manifest);
+      auto status = abramov::runBatch< int >(jobs, threads, memory, report.empty() ? &std::cerr : &log);
+      for (const auto &s : status)
+      {
+        if (!s.ok)
+        {
+          return 2;
+        }
+      }
+    }
+    catch (const std::exception &e)
+    {
+      std::cerr << e.what();
+      return 1;
+    }
+    return 0;
+  }
+}
+
 int main(int argc, char **argv)
 {
   using namespace abramov;
 
-  if (argc != 3)
+  if (argc >= 3 && std::string(argv[1]) == "--batch")
+  {
+    return runManifest(argc, argv);
+  }
+  if (argc != 3 && argc != 4)
   {
     std::cerr << "Incorrect num of args\n";
     return 1;
@@ -35,131 +113,10 @@ int main(int argc, char **argv)
 
   try
   {
-    abramov::Matrix< int > copy = m1;
-    copy += m2;
-    std::cout << "operator+=\n";
-    copy.print();
-    std::cout << '\n';
-    copy = m1 + m2;
-    std::cout << "operator_binary_plus\n";
-    copy.print();
-    std::cout << '\n';
-    copy = +m1;
-    std::cout << "operator_unary_plus\n";
-    copy.print();
-    std::cout << '\n';
-
-    copy = m1;
-    copy -= m2;
-    std::cout << "operator-=\n";
-    copy.print();
-    std::cout << '\n';
-    copy = m1 - m2;
-    std::cout << "operator_binary_minus\n";
-    copy.print();
-    std::cout << '\n';
-    copy = -m1;
-    std::cout << "operator_unary_minus\n";
-    copy.print();
-    std::cout << '\n';
-
-    copy = m1;
-    copy *= m2;
-    std::cout << "operator*=\n";
-    copy.print();
-    std::cout << '\n';
-    copy = m1 * m2;
-    std::cout << "operator_multiple_matrix_matrix\n";
-    copy.print();
-    std::cout << '\n';
-
-    copy = m1;
-    copy = m1.power(2);
-    std::cout << "power with k = 2\n";
-    copy.print();
-    copy = m1.power(3);
-    std::cout << "power with k = 3\n";
-    copy.print();
-    std::cout << '\n';
-
-    copy = m1.transpose();
-    std::cout << "transpose\n";
-    copy.print();
-    std::cout << '\n';
-
-    std::cout << "determinant of the first matrix: " << m1.determinant() << '\n';
-    std::cout << "determinant of the second matrix: " << m2.determinant() << '\n';
-    std::cout << '\n';
-
-    std::cout << "trace of the first matrix: " << m1.trace() << '\n';
-    std::cout << "trace of the second matrix: " << m2.trace() << '\n';
-    std::cout << '\n';
-
-    std::cout << "permanent of the first matrix: " << m1.perm() << '\n';
-    std::cout << "permanent of the second matrix: " << m2.perm() << '\n';
-    std::cout << '\n';
-
-    std::cout << "rank of the first matrix: " << m1.rank() << '\n';
-    std::cout << "rank of the second matrix: " << m2.rank() << '\n';
-    std::cout << '\n';
-
-    std::cout << "first norm of the first matrix: " << m1.firstNorm() << '\n';
-    std::cout << "first norm of the second matrix: " << m2.firstNorm() << '\n';
-    std::cout << '\n';
-
-    std::cout << "infinity norm of the first matrix: " << m1.infinityNorm() << '\n';
-    std::cout << "infinity norm of the second matrix: " << m2.infinityNorm() << '\n';
-    std::cout << '\n';
-
-    auto p1 = m1.inverse();
-    std::cout << "first inverse matrix\n";
-    std::cout << "factor " << std::setprecision(2) << p1.first << '\n';
-    std::cout << "integer matrix\n";
-    p1.second.print();
-    auto p2 = m2.inverse();
-    std::cout << "second inverse matrix\n";
-    std::cout << "factor " << p2.first << '\n';
-    std::cout << "integer matrix\n";
-    p2.second.print();
-    std::cout << '\n';
-
-    std::ifstream input3("cramer.txt");
+    std::ifstream input3(argc == 4 ? argv[3] : "cramer.txt");
     abramov::Matrix< int > cr;
     cr.read(input3);
-    auto v1 = cr.solveCramer();
-    std::cout << "solutions of the matrix as system of linear equations\n";
-    std::cout << *(v1.begin());
-    for (auto it = ++v1.begin(); it != v1.end(); ++it)
-    {
-      std::cout << ' ' << *it;
-    }
-    std::cout << '\n' << '\n';
-
-    copy = m1 * 2;
-    std::cout << "operator_multiple_matrix_scalar\n";
-    copy.print();
-    std::cout << '\n';
-    copy = 2 * m1;
-    std::cout << "operator_multiple_scalar_matrix\n";
-    copy.print();
-    std::cout << '\n';
-
-    copy = Matrix< int >::horizontalConcat(m1, m2);
-    std::cout << "horizontal_concatenation\n";
-    copy.print();
-    std::cout << '\n';
-    copy = Matrix< int >::verticalConcat(m1, m2);
-    std::cout << "vertical_concatenation\n";
-    copy.print();
-    std::cout << '\n';
-    copy = Matrix< int >::diagonalConcat(m1,m2);
-    std::cout << "diagonal_concatenation\n";
-    copy.print();
-    std::cout << '\n';
-
-    copy = Matrix< int >::kroneckerProduct(m1, m2);
-    std::cout << "Kronecker product\n";
-    copy.print();
+    writeReport(m1, m2, &cr, std::cout);
   }
   catch (const std::exception &e)
   {
@@ -5,92 +5,145 @@
 #include <concepts>
 #include <iostream>
 #include <initializer_list>
+#include <locale>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include "overflow.hpp"
+#include "profile.hpp"
+#include "storage.hpp"
+#include "textio.hpp"
 
 namespace abramov
 {
   template< class T >
   concept Integral = std::is_integral_v< T >;
-  template< Integral T >
+  template< Integral T, class P = Wrapping >
   struct Matrix;
+  template< Integral T, class P = Wrapping >
+  struct BlockAssembly;
 
-  template< Integral T >
-  Matrix< T > operator+(Matrix< T > lhs, const Matrix< T > &rhs);
-  template< Integral T >
-  Matrix< T > operator-(Matrix< T > lhs, const Matrix< T > &rhs);
-  template< Integral T >
-  Matrix< T > operator*(Matrix< T > lhs, const Matrix< T > &rhs);
-  template< Integral T >
-  Matrix< T > operator*(Matrix< T > lhs, T scalar);
-  template< Integral T  >
-  Matrix< T > operator*(T scalar, const Matrix< T > &rhs);
-
-  template< Integral T >
+  template< Integral T, class P >
+  Matrix< T, P > operator+(Matrix< T, P > lhs, const Matrix< T, P > &rhs);
+  template< Integral T, class P >
+  Matrix< T, P > operator-(Matrix< T, P > lhs, const Matrix< T, P > &rhs);
+  template< Integral T, class P >
+  Matrix< T, P > operator*(Matrix< T, P > lhs, const Matrix< T, P > &rhs);
+  template< Integral T, class P >
+  Matrix< T, P > operator*(Matrix< T, P > lhs, T scalar);
+  template< Integral T, class P >
+  Matrix< T, P > operator*(T scalar, const Matrix< T, P > &rhs);
+
+  template< Integral T, class P >
   struct Matrix
   {
-    friend Matrix< T > operator+<>(Matrix< T > lhs, const Matrix< T > &rhs);
-    friend Matrix< T > operator-<>(Matrix< T > lhs, const Matrix< T > &rhs);
-    friend Matrix< T > operator*<>(Matrix< T > lhs, const Matrix< T > &rhs);
+    friend Matrix< T, P > operator+<>(Matrix< T, P > lhs, const Matrix< T, P > &rhs);
+    friend Matrix< T, P > operator-<>(Matrix< T, P > lhs, const Matrix< T, P > &rhs);
+    friend Matrix< T, P > operator*<>(Matrix< T, P > lhs, const Matrix< T, P > &rhs);
+    friend struct BlockAssembly< T, P >;
+
+    using result_type = typename P::template result_type< T >;
 
     Matrix();
-    Matrix(const Matrix< T > &matrix);
-    Matrix(Matrix< T > &&matrix) noexcept;
+    Matrix(const Matrix< T, P > &matrix);
+    Matrix(Matrix< T, P > &&matrix) noexcept;
     Matrix(size_t m, size_t n, int value);
     Matrix(size_t m, size_t n, const int *values);
     Matrix(std::initializer_list< std::initializer_list< T > > init);
     ~Matrix();
-    Matrix< T > &operator=(const Matrix< T > &matrix);
-    Matrix< T > &operator=(Matrix< T > &&matrix) noexcept;
-    Matrix< T > &operator+=(const Matrix< T > &other);
-    Matrix< T > operator+() const;
-    Matrix< T > &operator-=(const Matrix< T > &other);
-    Matrix< T > operator-() const;
-    Matrix< T > &operator*=(const Matrix< T > &other);
-    Matrix< T > &operator*=(T scalar);
-    bool operator==(const Matrix< T > &other) const;
-    Matrix< T > power(size_t k) const;
-    Matrix< T > transpose() const;
-    int determinant() const;
-    int trace() const;
-    int perm() const;
+    Matrix< T, P > &operator=(const Matrix< T, P > &matrix);
+    Matrix< T, P > &operator=(Matrix< T, P > &&matrix) noexcept;
+    Matrix< T, P > &operator+=(const Matrix< T, P > &other);
+    Matrix< T, P > operator+() const;
+    Matrix< T, P > &operator-=(const Matrix< T, P > &other);
+    Matrix< T, P > operator-() const;
+    Matrix< T, P > &operator*=(const Matrix< T, P > &other);
+    Matrix< T, P > &operator*=(T scalar);
+    bool operator==(const Matrix< T, P > &other) const;
+    Matrix< T, P > power(size_t k) const;
+    Matrix< T, P > transpose() const;
+    result_type determinant() const;
+    result_type trace() const;
+    result_type perm() const;
     int rank() const;
-    int firstNorm() const;
-    int infinityNorm() const;
-    std::pair< double, Matrix< T > > inverse() const;
+    result_type firstNorm() const;
+    result_type infinityNorm() const;
+    std::pair< double, Matrix< T, P > > inverse() const;
     std::vector< double > solveCramer() const;
 
-    static Matrix< T > horizontalConcat(const Matrix< T > &lhs, const Matrix< T > &rhs, T fill = 0);
-    static Matrix< T > verticalConcat(const Matrix< T > &top, const Matrix< T > &bottom, T fill = 0);
-    static Matrix< T > diagonalConcat(const Matrix< T > &a, const Matrix< T > &b, T fill = 0);
-    static Matrix< T > kroneckerProduct(const Matrix< T > &a, const Matrix< T > &b);
+    static Matrix< T, P > horizontalConcat(const Matrix< T, P > &lhs, const Matrix< T, P > &rhs, T fill = 0);
+    static Matrix< T, P > verticalConcat(const Matrix< T, P > &top, const Matrix< T, P > &bottom, T fill = 0);
+    static Matrix< T, P > diagonalConcat(const Matrix< T, P > &a, const Matrix< T, P > &b, T fill = 0);
+    static Matrix< T, P > kroneckerProduct(const Matrix< T, P > &a, const Matrix< T, P > &b, size_t threads = 1);
+
+    size_t getRows() const noexcept;
+    size_t getCols() const noexcept;
+    T *operator[](size_t row) noexcept;
+    const T *operator[](size_t row) const noexcept;
 
     std::ostream &print(std::ostream &out = std::cout) const;
     std::istream &read(std::istream &in = std::cin);
+    std::string &format(std::string &out) const;
+    const char *parse(const char *first, const char *last, size_t threads = 1);
+
+    void enableCache(bool enable = true);
+    bool isCached() const noexcept;
   private:
+    struct Memo;
+
     T **data;
     size_t rows;
     size_t cols;
+    std::unique_ptr< Memo > memo;
 
     static T **initMatrix(size_t m, size_t n);
     static void destroyMatrix(T **data, size_t m) noexcept;
-    Matrix< T > createMinor(size_t row, size_t col) const;
-    Matrix< T > replaceColumn(size_t col, const std::vector< T > &newCol) const;
-    void swap(Matrix< T > &matrix) noexcept;
+    Matrix< T, P > createMinor(size_t row, size_t col) const;
+    template< class A >
+    A determinantAs() const;
+    template< class A >
+    A permAs() const;
+    Matrix< T, P > replaceColumn(size_t col, const std::vector< T > &newCol) const;
+    void swap(Matrix< T, P > &matrix) noexcept;
+    void invalidate() noexcept;
+    template< class V, class F >
+    V remember(std::optional< V > Memo::*slot, F compute) const;
+    static bool isPlainStream(const std::ios_base &stream);
+    template< class V >
+    static bool readValue(std::istream &in, V &value, bool plain);
   };
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T >::Matrix():
+// Cleared by every mutator and by the non-const operator[]: a row pointer kept
+// across a cached query has to be fetched again before writing through it
+template< abramov::Integral T, class P >
+struct abramov::Matrix< T, P >::Memo
+{
+  std::mutex mutex;
+  std::optional< result_type > determinant;
+  std::optional< result_type > trace;
+  std::optional< int > rank;
+  std::optional< std::pair< double, Matrix< T, P > > > inverse;
+};
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P >::Matrix():
   data(nullptr),
   rows(0),
-  cols(0)
+  cols(0),
+  memo()
 {}
 
-template< abramov::Integral T >
-abramov::Matrix< T >::Matrix(const Matrix< T > &matrix):
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P >::Matrix(const Matrix< T, P > &matrix):
   data(initMatrix(matrix.rows, matrix.cols)),
   rows(matrix.rows),
-  cols(matrix.cols)
+  cols(matrix.cols),
+  memo()
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::Matrix(const Matrix &)", matrix.rows, matrix.cols);
   for (size_t m = 0; m < matrix.rows; ++m)
   {
     for (size_t n = 0; n < matrix.cols; ++n)
@@ -98,24 +151,35 @@ abramov::Matrix< T >::Matrix(const Matrix< T > &matrix):
       data[m][n] = matrix.data[m][n];
     }
   }
+  if (matrix.memo)
+  {
+    enableCache();
+    std::lock_guard< std::mutex > lock(matrix.memo->mutex);
+    memo->determinant = matrix.memo->determinant;
+    memo->trace = matrix.memo->trace;
+    memo->rank = matrix.memo->rank;
+    memo->inverse = matrix.memo->inverse;
+  }
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T >::Matrix(Matrix< T > &&matrix) noexcept:
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P >::Matrix(Matrix< T, P > &&matrix) noexcept:
   data(matrix.data),
   rows(matrix.rows),
-  cols(matrix.cols)
+  cols(matrix.cols),
+  memo(std::move(matrix.memo))
 {
   matrix.data = nullptr;
   matrix.rows = 0;
   matrix.cols = 0;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T >::Matrix(size_t m, size_t n, int value):
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P >::Matrix(size_t m, size_t n, int value):
   data(initMatrix(m, n)),
   rows(m),
-  cols(n)
+  cols(n),
+  memo()
 {
   for (size_t i = 0; i < m; ++i)
   {
@@ -126,11 +190,12 @@ abramov::Matrix< T >::Matrix(size_t m, size_t n, int value):
   }
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T >::Matrix(size_t m, size_t n, const int *values):
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P >::Matrix(size_t m, size_t n, const int *values):
   data(initMatrix(m, n)),
   rows(m),
-  cols(n)
+  cols(n),
+  memo()
 {
   size_t count = 0;
   for (size_t i = 0; i < m; ++i)
@@ -142,8 +207,9 @@ abramov::Matrix< T >::Matrix(size_t m, size_t n, const int *values):
   }
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T >::Matrix(std::initializer_list< std::initializer_list< T > > init)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P >::Matrix(std::initializer_list< std::initializer_list< T > > init):
+  memo()
 {
   rows = init.size();
   if (!rows)
@@ -165,7 +231,7 @@ abramov::Matrix< T >::Matrix(std::initializer_list< std::initializer_list< T > >
   for (const auto &row : init)
   {
     size_t j = 0;
-    for (int val : row)
+    for (T val : row)
     {
       data[i][j] = val;
       ++j;
@@ -174,31 +240,33 @@ abramov::Matrix< T >::Matrix(std::initializer_list< std::initializer_list< T > >
   }
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T >::~Matrix()
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P >::~Matrix()
 {
   destroyMatrix(data, rows);
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > &abramov::Matrix< T >::operator=(const Matrix< T > &matrix)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > &abramov::Matrix< T, P >::operator=(const Matrix< T, P > &matrix)
 {
-  Matrix< T > tmp(matrix);
+  Matrix< T, P > tmp(matrix);
   swap(tmp);
   return *this;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > &abramov::Matrix< T >::operator=(Matrix< T > &&matrix) noexcept
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > &abramov::Matrix< T, P >::operator=(Matrix< T, P > &&matrix) noexcept
 {
-  Matrix< T > tmp(matrix);
+  Matrix< T, P > tmp(std::move(matrix));
   swap(tmp);
   return *this;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > &abramov::Matrix< T >::operator+=(const Matrix &matrix)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > &abramov::Matrix< T, P >::operator+=(const Matrix &matrix)
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::operator+=", rows, cols);
+  invalidate();
   if (rows != matrix.rows || cols != matrix.cols)
   {
     throw std::invalid_argument("Matrix dimensions do not agree\n");
@@ -209,30 +277,30 @@ abramov::Matrix< T > &abramov::Matrix< T >::operator+=(const Matrix &matrix)
   }
   for (size_t i = 0; i < matrix.rows; ++i)
   {
-    for (size_t j = 0; j < matrix.cols; ++j)
-    {
-      data[i][j] += matrix.data[i][j];
-    }
+    addRow< P >(data[i], matrix.data[i], cols);
   }
   return *this;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::operator+(Matrix< T > lhs, const Matrix< T > &rhs)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::operator+(Matrix< T, P > lhs, const Matrix< T, P > &rhs)
 {
   lhs += rhs;
   return lhs;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::Matrix< T >::operator+() const
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::Matrix< T, P >::operator+() const
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::operator+()", rows, cols);
   return *this;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > &abramov::Matrix< T >::operator-=(const Matrix< T > &matrix)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > &abramov::Matrix< T, P >::operator-=(const Matrix< T, P > &matrix)
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::operator-=", rows, cols);
+  invalidate();
   if (rows != matrix.rows || cols != matrix.cols)
   {
     throw std::invalid_argument("Matrix dimensions do not agree\n");
@@ -243,80 +311,71 @@ abramov::Matrix< T > &abramov::Matrix< T >::operator-=(const Matrix< T > &matrix
   }
   for (size_t i = 0; i < matrix.rows; ++i)
   {
-    for (size_t j = 0; j < matrix.cols; ++j)
-    {
-      data[i][j] -= matrix.data[i][j];
-    }
+    subRow< P >(data[i], matrix.data[i], cols);
   }
   return *this;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::operator-(Matrix< T > lhs, const Matrix< T > &rhs)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::operator-(Matrix< T, P > lhs, const Matrix< T, P > &rhs)
 {
   lhs -= rhs;
   return lhs;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::Matrix< T >::operator-() const
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::Matrix< T, P >::operator-() const
 {
-  Matrix< T > res(*this);
+  ABRAMOV_PROFILE_SCOPE("Matrix::operator-()", rows, cols);
+  Matrix< T, P > res(*this);
   for (size_t i = 0; i < res.rows; ++i)
   {
-    for (size_t j = 0; j < res.cols; ++j)
-    {
-      res.data[i][j] *= -1;
-    }
+    negateRow< P >(res.data[i], res.cols);
   }
   return res;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > &abramov::Matrix< T >::operator*=(const Matrix< T > &other)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > &abramov::Matrix< T, P >::operator*=(const Matrix< T, P > &other)
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::operator*=(Matrix)", rows, cols);
+  invalidate();
   if (cols != other.rows)
   {
     throw std::invalid_argument("Matrix dimensions do not agree\n");
   }
-  Matrix< T > res(rows,other.cols, 0);
+  Matrix< T, P > res(rows, other.cols, 0);
   for (size_t i = 0; i < rows; ++i)
   {
-    for (size_t j = 0; j < other.cols; ++ j)
-    {
-      for (size_t k = 0; k < cols; ++k)
-      {
-        res.data[i][j] += data[i][k] * other.data[k][j];
-      }
-    }
+    multiplyRow< P >(res.data[i], data[i], other.data, cols, other.cols);
   }
   swap(res);
   return *this;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > &abramov::Matrix< T >::operator*=(T scalar)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > &abramov::Matrix< T, P >::operator*=(T scalar)
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::operator*=(T)", rows, cols);
+  invalidate();
   for (size_t i = 0; i < rows; ++i)
   {
-    for (size_t j = 0; j < cols; ++j)
-    {
-      data[i][j] *= scalar;
-    }
+    scaleRow< P >(data[i], cols, scalar);
   }
   return *this;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::operator*(Matrix< T > lhs, const Matrix< T > &rhs)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::operator*(Matrix< T, P > lhs, const Matrix< T, P > &rhs)
 {
   lhs *= rhs;
   return lhs;
 }
 
-template< abramov::Integral T >
-bool abramov::Matrix< T >::operator==(const Matrix< T > &other) const
+template< abramov::Integral T, class P >
+bool abramov::Matrix< T, P >::operator==(const Matrix< T, P > &other) const
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::operator==", rows, cols);
   if (rows != other.rows || cols != other.cols)
   {
     return false;
@@ -334,16 +393,17 @@ bool abramov::Matrix< T >::operator==(const Matrix< T > &other) const
   return true;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::Matrix< T >::power(size_t k) const
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::Matrix< T, P >::power(size_t k) const
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::power", rows, cols);
   if (rows != cols)
   {
     throw std::logic_error("Matrix must be square\n");
   }
   if (k == 0)
   {
-    Matrix< T > res(3, 3, 0);
+    Matrix< T, P > res(3, 3, 0);
     for (size_t i = 0; i < 3; ++i)
     {
       res.data[i][i] = 1;
@@ -354,8 +414,8 @@ abramov::Matrix< T > abramov::Matrix< T >::power(size_t k) const
   {
     return Matrix(*this);
   }
-  Matrix< T > res(*this);
-  Matrix< T > temp(*this);
+  Matrix< T, P > res(*this);
+  Matrix< T, P > temp(*this);
   size_t p = k - 1;
   while (p > 0)
   {
@@ -369,10 +429,11 @@ abramov::Matrix< T > abramov::Matrix< T >::power(size_t k) const
   return res;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::Matrix< T >::transpose() const
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::Matrix< T, P >::transpose() const
 {
-  Matrix< T > res;
+  ABRAMOV_PROFILE_SCOPE("Matrix::transpose", rows, cols);
+  Matrix< T, P > res;
   res.rows = cols;
   res.cols = rows;
   res.data = initMatrix(res.rows, res.cols);
@@ -386,225 +447,281 @@ abramov::Matrix< T > abramov::Matrix< T >::transpose() const
   return res;
 }
 
-template< abramov::Integral T >
-int abramov::Matrix< T >::determinant() const
+template< abramov::Integral T, class P >
+typename abramov::Matrix< T, P >::result_type abramov::Matrix< T, P >::determinant() const
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::determinant", rows, cols);
   if (rows != cols)
   {
     throw std::logic_error("Matrix must be square to get determinant\n");
   }
+  return remember(&Memo::determinant, [this]()
+  {
+    return escalate< P, T >([this]< class A >()
+    {
+      return determinantAs< A >();
+    });
+  });
+}
+
+template< abramov::Integral T, class P >
+template< class A >
+A abramov::Matrix< T, P >::determinantAs() const
+{
   if (rows == 1)
   {
     return data[0][0];
   }
   if (rows == 2)
   {
-    return data[0][0] * data[1][1] - data[0][1] * data[1][0];
+    return sub< P >(mul< P, A >(data[0][0], data[1][1]), mul< P, A >(data[0][1], data[1][0]));
   }
   if (rows == 3)
   {
-    int det = 0;
-    det += data[0][0] * data[1][1] * data[2][2];
-    det += data[0][1] * data[1][2] * data[2][0];
-    det += data[0][2] * data[1][0] * data[2][1];
-    det -= data[0][2] * data[1][1] * data[2][0];
-    det -= data[0][1] * data[1][0] * data[2][2];
-    det -= data[0][0] * data[1][2] * data[2][1];
+    auto term = [this](size_t a, size_t b, size_t c)
+    {
+      return mul< P >(mul< P, A >(data[0][a], data[1][b]), A(data[2][c]));
+    };
+    A det = 0;
+    det = add< P >(det, term(0, 1, 2));
+    det = add< P >(det, term(1, 2, 0));
+    det = add< P >(det, term(2, 0, 1));
+    det = sub< P >(det, term(2, 1, 0));
+    det = sub< P >(det, term(1, 0, 2));
+    det = sub< P >(det, term(0, 2, 1));
     return det;
   }
-  int det = 0;
+  A det = 0;
   for (size_t j = 0; j < cols; ++j)
   {
-    Matrix< T > minor = createMinor(0, j);
-    int minor_det = minor.determinant();
+    Matrix< T, P > minor = createMinor(0, j);
+    A minor_det = mul< P, A >(data[0][j], minor.template determinantAs< A >());
     if (j % 2 == 0)
     {
-      det += data[0][j] * minor_det;
+      det = add< P >(det, minor_det);
     }
     else
     {
-      det -= data[0][j] * minor_det;
+      det = sub< P >(det, minor_det);
     }
   }
   return det;
 }
 
-template< abramov::Integral T >
-int abramov::Matrix< T >::trace() const
+template< abramov::Integral T, class P >
+typename abramov::Matrix< T, P >::result_type abramov::Matrix< T, P >::trace() const
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::trace", rows, cols);
   if (rows != cols)
   {
     throw std::logic_error("Matrix is not square\n");
   }
-  int tr = 0;
-  for (size_t i = 0; i < rows; ++i)
+  return remember(&Memo::trace, [this]()
   {
-    tr += data[i][i];
-  }
-  return tr;
+    return escalate< P, T >([this]< class A >()
+    {
+      A tr = 0;
+      for (size_t i = 0; i < rows; ++i)
+      {
+        tr = add< P, A >(tr, data[i][i]);
+      }
+      return tr;
+    });
+  });
 }
 
-template< abramov::Integral T >
-int abramov::Matrix< T >::perm() const
+template< abramov::Integral T, class P >
+typename abramov::Matrix< T, P >::result_type abramov::Matrix< T, P >::perm() const
 {
-  int **vals = data;
-  int r = rows;
-  int c = cols;
+  ABRAMOV_PROFILE_SCOPE("Matrix::perm", rows, cols);
   if (rows < cols)
   {
-    Matrix< T > m = transpose();
-    vals = m.data;
-    r = m.rows;
-    c = m.cols;
+    Matrix< T, P > m = transpose();
+    return escalate< P, T >([&m]< class A >()
+    {
+      return m.template permAs< A >();
+    });
   }
-  if (c == 1)
+  return escalate< P, T >([this]< class A >()
   {
-    int p = 0;
-    for (size_t i = 0; i < r; ++i)
+    return permAs< A >();
+  });
+}
+
+template< abramov::Integral T, class P >
+template< class A >
+A abramov::Matrix< T, P >::permAs() const
+{
+  if (cols == 1)
+  {
+    A p = 0;
+    for (size_t i = 0; i < rows; ++i)
     {
-      p += vals[i][0];
+      p = add< P, A >(p, data[i][0]);
     }
     return p;
   }
-  if (c == 2)
+  if (cols == 2)
   {
-    int p = 0;
-    for (size_t i = 0; i < r; ++i)
+    A p = 0;
+    for (size_t i = 0; i < rows; ++i)
     {
-      for (size_t j = i + 1; j < r; ++j)
+      for (size_t j = i + 1; j < rows; ++j)
       {
-        p += vals[i][0] * vals[j][1] + vals[i][1] * vals[j][0];
+        p = add< P >(p, mul< P, A >(data[i][0], data[j][1]));
+        p = add< P >(p, mul< P, A >(data[i][1], data[j][0]));
       }
     }
     return p;
   }
-  int p = 0;
-  for (size_t i = 0; i < r; ++i)
+  A p = 0;
+  for (size_t i = 0; i < rows; ++i)
   {
-    Matrix< T > minor = createMinor(i, 0);
-    p += vals[i][0] * minor.perm();
+    Matrix< T, P > minor = createMinor(i, 0);
+    p = add< P >(p, mul< P, A >(data[i][0], minor.template permAs< A >()));
   }
   return p;
 }
 
-template< abramov::Integral T >
-int abramov::Matrix< T >::rank() const
+template< abramov::Integral T, class P >
+int abramov::Matrix< T, P >::rank() const
 {
-  abramov::Matrix copy(*this);
-  int r = 0;
-  for (size_t col = 0; col < cols && r < rows; ++col)
+  ABRAMOV_PROFILE_SCOPE("Matrix::rank", rows, cols);
+  return remember(&Memo::rank, [this]()
   {
-    int pivot = r;
-    while (pivot < rows && copy.data[pivot][col] == 0)
-    {
-      ++pivot;
-    }
-    if (pivot == rows)
+    return escalate< P, T, int >([this]< class A >()
     {
-      continue;
-    }
-    if (pivot != r)
-    {
-      std::swap(copy.data[r], copy.data[pivot]);
-    }
-    for (size_t i = r + 1; i < rows; ++i)
-    {
-      if (copy.data[i][col] != 0)
+      std::vector< A > copy(rows * cols);
+      for (size_t i = 0; i < rows; ++i)
+      {
+        std::copy(data[i], data[i] + cols, copy.begin() + i * cols);
+      }
+      auto at = [&copy, this](size_t i, size_t j) -> A &
+      {
+        return copy[i * cols + j];
+      };
+      size_t r = 0;
+      for (size_t col = 0; col < cols && r < rows; ++col)
       {
-        int a = copy.data[r][col];
-        int b = copy.data[i][col];
-        while (b != 0)
+        size_t pivot = r;
+        while (pivot < rows && at(pivot, col) == 0)
         {
-          int temp = b;
-          b = a % b;
-          a = temp;
+          ++pivot;
         }
-        int gcd_val = a;
-        int f1 = copy.data[r][col] / gcd_val;
-        int f2 = copy.data[i][col] / gcd_val;
-        for (size_t j = col; j < cols; ++j)
+        if (pivot == rows)
         {
-          copy.data[i][j] = copy.data[i][j] * f1 - copy.data[r][j] * f2;
+          continue;
         }
+        if (pivot != r)
+        {
+          std::swap_ranges(copy.begin() + r * cols, copy.begin() + (r + 1) * cols, copy.begin() + pivot * cols);
+        }
+        for (size_t i = r + 1; i < rows; ++i)
+        {
+          if (at(i, col) != 0)
+          {
+            A a = at(r, col);
+            A b = at(i, col);
+            while (b != 0)
+            {
+              A temp = b;
+              b = a % b;
+              a = temp;
+            }
+            A gcd_val = a;
+            A f1 = at(r, col) / gcd_val;
+            A f2 = at(i, col) / gcd_val;
+            for (size_t j = col; j < cols; ++j)
+            {
+              at(i, j) = sub< P >(mul< P >(at(i, j), f1), mul< P >(at(r, j), f2));
+            }
+          }
+        }
+        ++r;
       }
-    }
-    ++r;
-  }
-  return r;
+      return A(r);
+    });
+  });
 }
 
-template< abramov::Integral T >
-int abramov::Matrix< T >::firstNorm() const
+template< abramov::Integral T, class P >
+typename abramov::Matrix< T, P >::result_type abramov::Matrix< T, P >::firstNorm() const
 {
-  int norm = 0;
-  for (size_t j = 0; j < cols; ++j)
+  ABRAMOV_PROFILE_SCOPE("Matrix::firstNorm", rows, cols);
+  return escalate< P, T >([this]< class A >()
   {
-    int curr = 0;
-    for (size_t i = 0; i < rows; ++i)
+    A norm = 0;
+    for (size_t j = 0; j < cols; ++j)
     {
-      curr += std::abs(data[i][j]);
+      A curr = 0;
+      for (size_t i = 0; i < rows; ++i)
+      {
+        curr = add< P >(curr, abs< P, A >(data[i][j]));
+      }
+      norm = std::max(norm, curr);
     }
-    norm = std::max(norm, curr);
-  }
-  return norm;
+    return norm;
+  });
 }
 
-template< abramov::Integral T >
-int abramov::Matrix< T >::infinityNorm() const
+template< abramov::Integral T, class P >
+typename abramov::Matrix< T, P >::result_type abramov::Matrix< T, P >::infinityNorm() const
 {
-  int norm = 0;
-  for (size_t i = 0; i < rows; ++i)
+  ABRAMOV_PROFILE_SCOPE("Matrix::infinityNorm", rows, cols);
+  return escalate< P, T >([this]< class A >()
   {
-    int curr = 0;
-    for (size_t j = 0; j < cols; ++j)
+    A norm = 0;
+    for (size_t i = 0; i < rows; ++i)
     {
-      curr += std::abs(data[i][j]);
+      A curr = 0;
+      for (size_t j = 0; j < cols; ++j)
+      {
+        curr = add< P >(curr, abs< P, A >(data[i][j]));
+      }
+      norm = std::max(norm, curr);
     }
-    norm = std::max(norm, curr);
-  }
-  return norm;
+    return norm;
+  });
 }
 
-template< abramov::Integral T >
-std::pair< double, abramov::Matrix< T > > abramov::Matrix< T >::inverse() const
+template< abramov::Integral T, class P >
+std::pair< double, abramov::Matrix< T, P > > abramov::Matrix< T, P >::inverse() const
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::inverse", rows, cols);
   if (rows != cols)
   {
     throw std::logic_error("Matrix must be square\n");
   }
-  int det = determinant();
-  if (det == 0)
-  {
-    throw std::logic_error("Matrix does not have inverse\n");
-  }
-  Matrix< T > adj(rows, cols, 0);
-  for (size_t i = 0; i < rows; ++i)
+  return remember(&Memo::inverse, [this]() -> std::pair< double, Matrix< T, P > >
   {
-    for (size_t j = 0; j < cols; ++j)
+    result_type det = determinant();
+    if (det == 0)
     {
-      Matrix< T > minor = createMinor(i, j);
-      int minor_det = minor.determinant();
-      if ((i + j) % 2 == 0)
-      {
-        adj.data[j][i] = minor_det;
-      }
-      else
+      throw std::logic_error("Matrix does not have inverse\n");
+    }
+    Matrix< T, P > adj(rows, cols, 0);
+    for (size_t i = 0; i < rows; ++i)
+    {
+      for (size_t j = 0; j < cols; ++j)
       {
-        adj.data[j][i] = -1 * minor_det;
+        Matrix< T, P > minor = createMinor(i, j);
+        __int128 minor_det = minor.determinant();
+        adj.data[j][i] = P::template narrow< T >((i + j) % 2 == 0 ? minor_det : -minor_det);
       }
     }
-  }
-  return { 1.0 / det, adj };
+    return { 1.0 / static_cast< double >(det), adj };
+  });
 }
 
-template< abramov::Integral T >
-std::vector< double > abramov::Matrix< T >::solveCramer() const
+template< abramov::Integral T, class P >
+std::vector< double > abramov::Matrix< T, P >::solveCramer() const
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::solveCramer", rows, cols);
   if (rows != cols - 1)
   {
     throw std::logic_error("For Cramer`s method number of equations must be equal to number of vars\n");
   }
-  Matrix< T > coeffs(rows, rows, 0);
+  Matrix< T, P > coeffs(rows, rows, 0);
   std::vector< T > consts(rows);
   for (size_t i = 0; i < rows; ++i)
   {
@@ -614,7 +731,7 @@ std::vector< double > abramov::Matrix< T >::solveCramer() const
     }
     consts[i] = data[i][cols - 1];
   }
-  int det = coeffs.determinant();
+  result_type det = coeffs.determinant();
   if (det == 0)
   {
     throw std::logic_error("System has no unique solution\n");
@@ -622,19 +739,20 @@ std::vector< double > abramov::Matrix< T >::solveCramer() const
   std::vector< double > solution(rows);
   for (size_t j = 0; j < rows; ++j)
   {
-    Matrix< T > m = coeffs.replaceColumn(j, consts);
+    Matrix< T, P > m = coeffs.replaceColumn(j, consts);
     double det_j = static_cast< double >(m.determinant());
-    solution[j] = det_j / det;
+    solution[j] = det_j / static_cast< double >(det);
   }
   return solution;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::Matrix< T >::horizontalConcat(const Matrix< T > &lhs, const Matrix< T > &rhs, T fill)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::Matrix< T, P >::horizontalConcat(const Matrix< T, P > &lhs, const Matrix< T, P > &rhs, T fill)
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::horizontalConcat", std::max(lhs.rows, rhs.rows), lhs.cols + rhs.cols);
   size_t max_rows = std::max(lhs.rows, rhs.rows);
   size_t total_cols = lhs.cols + rhs.cols;
-  Matrix< T > res;
+  Matrix< T, P > res;
   res.rows = max_rows;
   res.cols = total_cols;
   res.data = initMatrix(max_rows, total_cols);
@@ -666,12 +784,13 @@ abramov::Matrix< T > abramov::Matrix< T >::horizontalConcat(const Matrix< T > &l
   return res;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::Matrix< T >::verticalConcat(const Matrix< T > &top, const Matrix< T > &bottom, T fill)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::Matrix< T, P >::verticalConcat(const Matrix< T, P > &top, const Matrix< T, P > &bottom, T fill)
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::verticalConcat", top.rows + bottom.rows, std::max(top.cols, bottom.cols));
   size_t max_cols = std::max(top.cols, bottom.cols);
   size_t total_rows = top.rows + bottom.rows;
-  Matrix< T > res;
+  Matrix< T, P > res;
   res.rows = total_rows;
   res.cols = max_cols;
   res.data = initMatrix(total_rows, max_cols);
@@ -704,12 +823,13 @@ abramov::Matrix< T > abramov::Matrix< T >::verticalConcat(const Matrix< T > &top
   return res;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::Matrix< T >::diagonalConcat(const Matrix< T > &a, const Matrix< T > &b, T fill)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::Matrix< T, P >::diagonalConcat(const Matrix< T, P > &a, const Matrix< T, P > &b, T fill)
 {
+  ABRAMOV_PROFILE_SCOPE("Matrix::diagonalConcat", a.rows + b.rows, a.cols + b.cols);
   size_t total_rows = a.rows + b.rows;
   size_t total_cols = a.cols + b.cols;
-  Matrix< T > res;
+  Matrix< T, P > res;
   res.rows = total_rows;
   res.cols = total_cols;
   res.data = initMatrix(total_rows, total_cols);
@@ -734,65 +854,103 @@ abramov::Matrix< T > abramov::Matrix< T >::diagonalConcat(const Matrix< T > &a,
   return res;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::Matrix< T >::kroneckerProduct(const Matrix< T > &a, const Matrix< T > &b)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::Matrix< T, P >::kroneckerProduct(const Matrix< T, P > &a, const Matrix< T, P > &b,
+  size_t threads)
 {
-  Matrix< T > res;
+  ABRAMOV_PROFILE_SCOPE("Matrix::kroneckerProduct", a.rows * b.rows, a.cols * b.cols);
+  Matrix< T, P > res;
   res.rows = a.rows * b.rows;
   res.cols = a.cols * b.cols;
   res.data = initMatrix(res.rows, res.cols);
-  for (size_t i = 0; i < a.rows; ++i)
+  constexpr size_t min_rows = 64;
+  threads = std::max< size_t >(1, std::min(threads ? threads : defaultThreads(), res.rows / min_rows));
+  placedParallelFor(res.rows ? res.data[0] : nullptr, 0, res.rows, [&](size_t lo, size_t hi)
   {
-    for (size_t j = 0; j < a.cols; ++j)
+    for (size_t row = lo; row < hi; ++row)
     {
-      int curr = a.data[i][j];
-      size_t block_row_start = i * b.rows;
-      size_t block_col_start = j * b.cols;
-      for (size_t bi = 0; bi < b.rows; ++bi)
+      const T *arow = a.data[row / b.rows];
+      const T *brow = b.data[row % b.rows];
+      T *dst = res.data[row];
+      for (size_t j = 0; j < a.cols; ++j, dst += b.cols)
       {
-        for (size_t bj = 0; bj < b.cols; ++bj)
-        {
-          res.data[block_row_start + bi][block_col_start + bj] = curr * b.data[bi][bj];
-        }
+        std::copy(brow, brow + b.cols, dst);
+        scaleRow< P >(dst, b.cols, arow[j]);
       }
     }
-  }
+  }, threads);
   return res;
 }
 
-template< abramov::Integral T >
-std::ostream &abramov::Matrix< T >::print(std::ostream &out) const
+template< abramov::Integral T, class P >
+size_t abramov::Matrix< T, P >::getRows() const noexcept
 {
+  return rows;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::Matrix< T, P >::getCols() const noexcept
+{
+  return cols;
+}
+
+template< abramov::Integral T, class P >
+T *abramov::Matrix< T, P >::operator[](size_t row) noexcept
+{
+  invalidate();
+  return data[row];
+}
+
+template< abramov::Integral T, class P >
+const T *abramov::Matrix< T, P >::operator[](size_t row) const noexcept
+{
+  return data[row];
+}
+
+template< abramov::Integral T, class P >
+std::ostream &abramov::Matrix< T, P >::print(std::ostream &out) const
+{
+  ABRAMOV_PROFILE_SCOPE("Matrix::print", rows, cols);
   std::ostream::sentry s(out);
   if (!s)
   {
     return out;
   }
-  for (size_t i = 0; i < rows; ++i)
+  if (!isPlainStream(out))
   {
-    for (size_t j = 0; j < cols - 1; ++j)
+    for (size_t i = 0; i < rows; ++i)
     {
-      out << data[i][j] << " ";
+      for (size_t j = 0; j < cols - 1; ++j)
+      {
+        out << data[i][j] << " ";
+      }
+      out << data[i][cols - 1] << "\n";
     }
-    out << data[i][cols - 1] << "\n";
+    return out;
   }
+  thread_local std::string buffer;
+  buffer.clear();
+  format(buffer);
+  out.write(buffer.data(), buffer.size());
   return out;
 }
 
-template< abramov::Integral T >
-std::istream &abramov::Matrix< T >::read(std::istream &in)
+template< abramov::Integral T, class P >
+std::istream &abramov::Matrix< T, P >::read(std::istream &in)
 {
   std::istream::sentry s(in);
   if (!s)
   {
     return in;
   }
+  bool plain = isPlainStream(in);
   size_t m = 0;
   size_t n = 0;
-  if (!(in >> m >> n))
+  if (!readValue(in, m, plain) || !readValue(in, n, plain))
   {
     return in;
   }
+  ABRAMOV_PROFILE_SCOPE("Matrix::read", m, n);
   Matrix tmp;
   tmp.rows = m;
   tmp.cols = n;
@@ -801,7 +959,7 @@ std::istream &abramov::Matrix< T >::read(std::istream &in)
   {
     for (size_t j = 0; j < n; ++j)
     {
-      if (!(in >> tmp.data[i][j]))
+      if (!readValue(in, tmp.data[i][j], plain))
       {
         return in;
       }
@@ -814,38 +972,106 @@ std::istream &abramov::Matrix< T >::read(std::istream &in)
   return in;
 }
 
-template< abramov::Integral T >
-T **abramov::Matrix< T >::initMatrix(size_t m, size_t n)
+template< abramov::Integral T, class P >
+std::string &abramov::Matrix< T, P >::format(std::string &out) const
 {
-  T **data = new int*[m];
-  size_t created = 0;
-  try
+  ABRAMOV_PROFILE_SCOPE("Matrix::format", rows, cols);
+  for (size_t i = 0; i < rows; ++i)
+  {
+    for (size_t j = 0; j < cols; ++j)
+    {
+      formatInteger(out, data[i][j]);
+      out.push_back(j + 1 < cols ? ' ' : '\n');
+    }
+  }
+  return out;
+}
+
+template< abramov::Integral T, class P >
+const char *abramov::Matrix< T, P >::parse(const char *first, const char *last, size_t threads)
+{
+  size_t m = 0;
+  size_t n = 0;
+  first = parseInteger(first, last, m);
+  if (first)
+  {
+    first = parseInteger(first, last, n);
+  }
+  if (!first)
+  {
+    return nullptr;
+  }
+  ABRAMOV_PROFILE_SCOPE("Matrix::parse", m, n);
+  Matrix tmp;
+  tmp.rows = m;
+  tmp.cols = n;
+  tmp.data = initMatrix(m, n);
+  if (m && n && threads > 1)
   {
-    for (; created < m; ++created)
+    std::vector< T > values(m * n);
+    first = parseIntegers(first, last, values.data(), values.size(), threads);
+    if (!first)
     {
-      data[created] = new T[n];
+      return nullptr;
     }
+    for (size_t i = 0; i < m; ++i)
+    {
+      std::copy(values.begin() + i * n, values.begin() + (i + 1) * n, tmp.data[i]);
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < m && first; ++i)
+    {
+      first = parseIntegers(first, last, tmp.data[i], n);
+    }
+    if (!first)
+    {
+      return nullptr;
+    }
+  }
+  swap(tmp);
+  return first;
+}
+
+template< abramov::Integral T, class P >
+T **abramov::Matrix< T, P >::initMatrix(size_t m, size_t n)
+{
+  ABRAMOV_PROFILE_ALLOC(m * sizeof(T *) + m * n * sizeof(T));
+  T **data = new T*[m];
+  if (!m)
+  {
+    return data;
+  }
+  T *block = nullptr;
+  try
+  {
+    block = static_cast< T * >(allocateRows(m, n * sizeof(T)));
   }
   catch (const std::bad_alloc &)
   {
-    destroyMatrix(data, created);
+    delete[] data;
     throw;
   }
+  for (size_t i = 0; i < m; ++i)
+  {
+    data[i] = block + i * n;
+  }
   return data;
 }
 
-template< abramov::Integral T >
-void abramov::Matrix< T >::destroyMatrix(T **data, size_t m) noexcept
+template< abramov::Integral T, class P >
+void abramov::Matrix< T, P >::destroyMatrix(T **data, size_t m) noexcept
 {
-  for (size_t i = 0; i < m; ++i)
+  if (data && m)
   {
-    delete[] data[i];
+    releaseRows(data[0]);
   }
   delete[] data;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::Matrix< T >::createMinor(size_t row, size_t col) const
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::Matrix< T, P >::createMinor(size_t row, size_t col) const
 {
   Matrix minor;
   minor.rows = rows - 1;
@@ -871,10 +1097,10 @@ abramov::Matrix< T > abramov::Matrix< T >::createMinor(size_t row, size_t col) c
   return minor;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::Matrix< T >::replaceColumn(size_t col, const std::vector< T > &newCol) const
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::Matrix< T, P >::replaceColumn(size_t col, const std::vector< T > &newCol) const
 {
-  Matrix< T > res(rows, cols, 0);
+  Matrix< T, P > res(rows, cols, 0);
   for (size_t i = 0; i < rows; ++i)
   {
     for (size_t j = 0; j < cols; ++j)
@@ -892,23 +1118,102 @@ abramov::Matrix< T > abramov::Matrix< T >::replaceColumn(size_t col, const std::
   return res;
 }
 
-template< abramov::Integral T >
-void abramov::Matrix< T >::swap(Matrix< T > &matrix) noexcept
+template< abramov::Integral T, class P >
+void abramov::Matrix< T, P >::swap(Matrix< T, P > &matrix) noexcept
 {
   std::swap(data, matrix.data);
   std::swap(rows, matrix.rows);
   std::swap(cols, matrix.cols);
+  invalidate();
+  matrix.invalidate();
+}
+
+template< abramov::Integral T, class P >
+void abramov::Matrix< T, P >::enableCache(bool enable)
+{
+  if (!enable)
+  {
+    memo.reset();
+  }
+  else if (!memo)
+  {
+    memo = std::make_unique< Memo >();
+  }
+}
+
+template< abramov::Integral T, class P >
+bool abramov::Matrix< T, P >::isCached() const noexcept
+{
+  return memo != nullptr;
+}
+
+template< abramov::Integral T, class P >
+void abramov::Matrix< T, P >::invalidate() noexcept
+{
+  if (memo)
+  {
+    memo->determinant.reset();
+    memo->trace.reset();
+    memo->rank.reset();
+    memo->inverse.reset();
+  }
+}
+
+template< abramov::Integral T, class P >
+template< class V, class F >
+V abramov::Matrix< T, P >::remember(std::optional< V > Memo::*slot, F compute) const
+{
+  if (!memo)
+  {
+    return compute();
+  }
+  {
+    std::lock_guard< std::mutex > lock(memo->mutex);
+    if ((*memo).*slot)
+    {
+      return *((*memo).*slot);
+    }
+  }
+  V value = compute();
+  std::lock_guard< std::mutex > lock(memo->mutex);
+  (*memo).*slot = value;
+  return value;
+}
+
+template< abramov::Integral T, class P >
+bool abramov::Matrix< T, P >::isPlainStream(const std::ios_base &stream)
+{
+  std::ios_base::fmtflags custom = std::ios_base::showpos | std::ios_base::showbase;
+  bool dec = (stream.flags() & std::ios_base::basefield) == std::ios_base::dec;
+  return dec && !(stream.flags() & custom) && !stream.width() && stream.getloc() == std::locale::classic();
+}
+
+template< abramov::Integral T, class P >
+template< class V >
+bool abramov::Matrix< T, P >::readValue(std::istream &in, V &value, bool plain)
+{
+  if (!plain)
+  {
+    return static_cast< bool >(in >> value);
+  }
+  std::ios_base::iostate state = std::ios_base::goodbit;
+  bool ok = scanInteger(*in.rdbuf(), value, state);
+  if (state)
+  {
+    in.setstate(state);
+  }
+  return ok;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::operator*(Matrix< T > lhs, T scalar)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::operator*(Matrix< T, P > lhs, T scalar)
 {
   lhs *= scalar;
   return lhs;
 }
 
-template< abramov::Integral T >
-abramov::Matrix< T > abramov::operator*(T scalar, const Matrix< T > &rhs)
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::operator*(T scalar, const Matrix< T, P > &rhs)
 {
   return rhs * scalar;
 }
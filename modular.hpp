@@ -0,0 +1,528 @@
+#ifndef MODULAR_HPP
+#define MODULAR_HPP
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "bigint.hpp"
+#include "matrix.hpp"
+#include "threadpool.hpp"
+
+namespace abramov
+{
+  struct CrtBasis
+  {
+    explicit CrtBasis(std::vector< uint32_t > primes);
+    size_t size() const noexcept;
+    BigInt reconstruct(const uint32_t *residues, size_t stride = 1) const;
+  private:
+    std::vector< uint32_t > primes;
+    std::vector< uint32_t > inverses;
+    BigInt modulus;
+    BigInt half;
+  };
+
+  uint32_t mulMod(uint32_t a, uint32_t b, uint32_t p) noexcept;
+  uint32_t powMod(uint32_t a, uint64_t e, uint32_t p) noexcept;
+  uint32_t invMod(uint32_t a, uint32_t p) noexcept;
+  bool isPrime(uint32_t n) noexcept;
+  std::vector< uint32_t > modularPrimes(size_t first, size_t count);
+  template< std::integral T >
+  uint32_t reduceMod(T value, uint32_t p) noexcept;
+  uint32_t eliminateMod(std::vector< uint32_t > &a, size_t n, size_t width, uint32_t p);
+
+  template< Integral T, class P >
+  BigInt exactDeterminant(const Matrix< T, P > &matrix, size_t threads = 0);
+  template< Integral T, class P >
+  BigInt exactPermanent(const Matrix< T, P > &matrix, size_t threads = 0);
+  template< Integral T, class P >
+  std::pair< BigInt, std::vector< BigInt > > exactInverse(const Matrix< T, P > &matrix, size_t threads = 0);
+  template< Integral T, class P >
+  std::pair< BigInt, std::vector< BigInt > > exactCramer(const Matrix< T, P > &matrix, size_t threads = 0);
+}
+
+inline abramov::CrtBasis::CrtBasis(std::vector< uint32_t > basis):
+  primes(std::move(basis)),
+  inverses(primes.size(), 1),
+  modulus(1),
+  half()
+{
+  for (size_t i = 1; i < primes.size(); ++i)
+  {
+    uint32_t prod = 1;
+    for (size_t j = 0; j < i; ++j)
+    {
+      prod = mulMod(prod, primes[j] % primes[i], primes[i]);
+    }
+    inverses[i] = invMod(prod, primes[i]);
+  }
+  for (uint32_t p : primes)
+  {
+    modulus.mulAdd(p, 0);
+  }
+  half = modulus;
+  half.divSmall(2);
+}
+
+inline size_t abramov::CrtBasis::size() const noexcept
+{
+  return primes.size();
+}
+
+inline abramov::BigInt abramov::CrtBasis::reconstruct(const uint32_t *residues, size_t stride) const
+{
+  size_t k = primes.size();
+  std::vector< uint32_t > digits(k, 0);
+  for (size_t i = 0; i < k; ++i)
+  {
+    uint32_t p = primes[i];
+    uint32_t acc = 0;
+    for (size_t j = i; j > 0; --j)
+    {
+      acc = static_cast< uint32_t >((static_cast< uint64_t >(acc) * (primes[j - 1] % p) + digits[j - 1]) % p);
+    }
+    uint32_t r = residues[i * stride];
+    digits[i] = mulMod((r + p - acc) % p, inverses[i], p);
+  }
+  if (!k)
+  {
+    return BigInt();
+  }
+  BigInt res(digits[k - 1]);
+  for (size_t i = k - 1; i > 0; --i)
+  {
+    res.mulAdd(primes[i - 1], digits[i - 1]);
+  }
+  if (res > half)
+  {
+    res -= modulus;
+  }
+  return res;
+}
+
+inline uint32_t abramov::mulMod(uint32_t a, uint32_t b, uint32_t p) noexcept
+{
+  return static_cast< uint32_t >(static_cast< uint64_t >(a) * b % p);
+}
+
+inline uint32_t abramov::powMod(uint32_t a, uint64_t e, uint32_t p) noexcept
+{
+  uint32_t res = 1 % p;
+  while (e)
+  {
+    if (e & 1)
+    {
+      res = mulMod(res, a, p);
+    }
+    a = mulMod(a, a, p);
+    e >>= 1;
+  }
+  return res;
+}
+
+inline uint32_t abramov::invMod(uint32_t a, uint32_t p) noexcept
+{
+  return powMod(a, p - 2, p);
+}
+
+inline bool abramov::isPrime(uint32_t n) noexcept
+{
+  if (n < 2)
+  {
+    return false;
+  }
+  for (uint32_t small : { 2u, 3u, 5u, 7u, 11u, 13u })
+  {
+    if (n % small == 0)
+    {
+      return n == small;
+    }
+  }
+  uint32_t d = n - 1;
+  size_t s = 0;
+  while (!(d & 1))
+  {
+    d >>= 1;
+    ++s;
+  }
+  for (uint32_t base : { 2u, 7u, 61u })
+  {
+    uint32_t x = powMod(base % n, d, n);
+    if (x == 0 || x == 1 || x == n - 1)
+    {
+      continue;
+    }
+    bool composite = true;
+    for (size_t r = 1; r < s && composite; ++r)
+    {
+      x = mulMod(x, x, n);
+      composite = x != n - 1;
+    }
+    if (composite)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline std::vector< uint32_t > abramov::modularPrimes(size_t first, size_t count)
+{
+  static std::mutex mutex;
+  static std::vector< uint32_t > cache;
+  std::lock_guard< std::mutex > lock(mutex);
+  uint32_t candidate = cache.empty() ? 0x7fffffffu : cache.back() - 2;
+  while (cache.size() < first + count)
+  {
+    if (isPrime(candidate))
+    {
+      cache.push_back(candidate);
+    }
+    candidate -= 2;
+  }
+  return std::vector< uint32_t >(cache.begin() + first, cache.begin() + first + count);
+}
+
+template< std::integral T >
+uint32_t abramov::reduceMod(T value, uint32_t p) noexcept
+{
+  if constexpr (std::is_signed_v< T >)
+  {
+    long long r = static_cast< long long >(value) % static_cast< long long >(p);
+    return static_cast< uint32_t >(r < 0 ? r + p : r);
+  }
+  else
+  {
+    return static_cast< uint32_t >(static_cast< unsigned long long >(value) % p);
+  }
+}
+
+inline uint32_t abramov::eliminateMod(std::vector< uint32_t > &a, size_t n, size_t width, uint32_t p)
+{
+  uint32_t det = 1;
+  for (size_t col = 0; col < n; ++col)
+  {
+    size_t pivot = col;
+    while (pivot < n && !a[pivot * width + col])
+    {
+      ++pivot;
+    }
+    if (pivot == n)
+    {
+      return 0;
+    }
+    if (pivot != col)
+    {
+      std::swap_ranges(a.begin() + col * width, a.begin() + (col + 1) * width, a.begin() + pivot * width);
+      det = det ? p - det : 0;
+    }
+    uint32_t *prow = a.data() + col * width;
+    det = mulMod(det, prow[col], p);
+    uint32_t inv = invMod(prow[col], p);
+    for (size_t j = col; j < width; ++j)
+    {
+      prow[j] = mulMod(prow[j], inv, p);
+    }
+    for (size_t i = width > n ? 0 : col + 1; i < n; ++i)
+    {
+      uint32_t *row = a.data() + i * width;
+      if (i == col || !row[col])
+      {
+        continue;
+      }
+      uint64_t f = p - row[col];
+      for (size_t j = col; j < width; ++j)
+      {
+        row[j] = static_cast< uint32_t >((row[j] + f * prow[j]) % p);
+      }
+    }
+  }
+  return det;
+}
+
+namespace abramov
+{
+  template< Integral T, class P >
+  double hadamardBits(const Matrix< T, P > &matrix, size_t cols, bool skip_smallest)
+  {
+    double total = 0.0;
+    double smallest = INFINITY;
+    for (size_t i = 0; i < matrix.getRows(); ++i)
+    {
+      long double sum = 0.0L;
+      for (size_t j = 0; j < cols; ++j)
+      {
+        long double v = static_cast< long double >(matrix[i][j]);
+        sum += v * v;
+      }
+      double bits = sum > 0.0L ? 0.5 * std::log2(static_cast< double >(sum)) : 0.0;
+      total += bits;
+      smallest = std::min(smallest, bits);
+    }
+    if (skip_smallest && matrix.getRows())
+    {
+      total -= smallest;
+    }
+    return total;
+  }
+
+  inline size_t primesFor(double bits, size_t first = 0)
+  {
+    double need = bits + 2.0;
+    double have = 0.0;
+    size_t count = 0;
+    while (have < need)
+    {
+      have += std::log2(static_cast< double >(modularPrimes(first + count, 1)[0]));
+      ++count;
+    }
+    return count;
+  }
+
+  template< Integral T, class P >
+  void reduceMatrix(const Matrix< T, P > &matrix, size_t cols, uint32_t p, std::vector< uint32_t > &out, size_t width)
+  {
+    out.assign(matrix.getRows() * width, 0);
+    for (size_t i = 0; i < matrix.getRows(); ++i)
+    {
+      for (size_t j = 0; j < cols; ++j)
+      {
+        out[i * width + j] = reduceMod(matrix[i][j], p);
+      }
+    }
+  }
+
+  template< class F >
+  std::vector< BigInt > reconstructAll(const CrtBasis &basis, size_t outputs, F residue, size_t threads)
+  {
+    std::vector< BigInt > res(outputs);
+    parallelFor(0, outputs, [&](size_t lo, size_t hi)
+    {
+      std::vector< uint32_t > column(basis.size());
+      for (size_t k = lo; k < hi; ++k)
+      {
+        for (size_t i = 0; i < basis.size(); ++i)
+        {
+          column[i] = residue(i, k);
+        }
+        res[k] = basis.reconstruct(column.data());
+      }
+    }, threads);
+    return res;
+  }
+
+  template< Integral T, class P >
+  std::pair< BigInt, std::vector< BigInt > > exactSolve(const Matrix< T, P > &matrix, size_t n, size_t rhs, bool identity,
+    double det_bits, double out_bits, size_t threads)
+  {
+    size_t width = n + rhs;
+    size_t det_count = primesFor(det_bits);
+    size_t out_count = primesFor(out_bits);
+    std::vector< uint32_t > primes = modularPrimes(0, det_count);
+    std::vector< uint32_t > dets(det_count);
+    std::vector< std::vector< uint32_t > > sols(det_count);
+    auto solve = [&](size_t first)
+    {
+      parallelFor(first, primes.size(), [&](size_t lo, size_t hi)
+      {
+        std::vector< uint32_t > a;
+        for (size_t k = lo; k < hi; ++k)
+        {
+          uint32_t p = primes[k];
+          reduceMatrix(matrix, n, p, a, width);
+          for (size_t i = 0; i < n; ++i)
+          {
+            for (size_t j = 0; j < rhs; ++j)
+            {
+              a[i * width + n + j] = identity ? (i == j) : reduceMod(matrix[i][n + j], p);
+            }
+          }
+          dets[k] = eliminateMod(a, n, width, p);
+          if (dets[k])
+          {
+            sols[k].resize(n * rhs);
+            for (size_t i = 0; i < n; ++i)
+            {
+              for (size_t j = 0; j < rhs; ++j)
+              {
+                sols[k][i * rhs + j] = mulMod(a[i * width + n + j], dets[k], p);
+              }
+            }
+          }
+        }
+      }, threads);
+    };
+    solve(0);
+    BigInt det = CrtBasis(primes).reconstruct(dets.data());
+    if (det.isZero())
+    {
+      return { det, {} };
+    }
+    std::vector< size_t > good;
+    for (size_t k = 0; k < primes.size(); ++k)
+    {
+      if (dets[k])
+      {
+        good.push_back(k);
+      }
+    }
+    while (good.size() < out_count)
+    {
+      size_t first = primes.size();
+      size_t more = out_count - good.size();
+      std::vector< uint32_t > extra = modularPrimes(first, more);
+      primes.insert(primes.end(), extra.begin(), extra.end());
+      dets.resize(primes.size());
+      sols.resize(primes.size());
+      solve(first);
+      for (size_t k = first; k < primes.size(); ++k)
+      {
+        if (dets[k])
+        {
+          good.push_back(k);
+        }
+      }
+    }
+    good.resize(out_count);
+    std::vector< uint32_t > basis_primes;
+    for (size_t k : good)
+    {
+      basis_primes.push_back(primes[k]);
+    }
+    CrtBasis basis(basis_primes);
+    std::vector< BigInt > values = reconstructAll(basis, n * rhs, [&](size_t i, size_t k)
+    {
+      return sols[good[i]][k];
+    }, threads);
+    return { det, values };
+  }
+}
+
+template< abramov::Integral T, class P >
+abramov::BigInt abramov::exactDeterminant(const Matrix< T, P > &matrix, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("exactDeterminant", matrix.getRows(), matrix.getCols());
+  size_t n = matrix.getRows();
+  if (n != matrix.getCols())
+  {
+    throw std::logic_error("Matrix must be square to get determinant\n");
+  }
+  if (!n)
+  {
+    return BigInt();
+  }
+  std::vector< uint32_t > primes = modularPrimes(0, primesFor(hadamardBits(matrix, n, false)));
+  std::vector< uint32_t > dets(primes.size());
+  parallelFor(0, primes.size(), [&](size_t lo, size_t hi)
+  {
+    std::vector< uint32_t > a;
+    for (size_t k = lo; k < hi; ++k)
+    {
+      reduceMatrix(matrix, n, primes[k], a, n);
+      dets[k] = eliminateMod(a, n, n, primes[k]);
+    }
+  }, threads);
+  return CrtBasis(primes).reconstruct(dets.data());
+}
+
+template< abramov::Integral T, class P >
+abramov::BigInt abramov::exactPermanent(const Matrix< T, P > &matrix, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("exactPermanent", matrix.getRows(), matrix.getCols());
+  size_t n = matrix.getRows();
+  if (n != matrix.getCols())
+  {
+    throw std::logic_error("Matrix must be square\n");
+  }
+  if (!n)
+  {
+    return BigInt();
+  }
+  if (n >= 64)
+  {
+    throw std::invalid_argument("Matrix is too large for permanent\n");
+  }
+  double bits = 0.0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    long double sum = 0.0L;
+    for (size_t j = 0; j < n; ++j)
+    {
+      sum += std::fabs(static_cast< long double >(matrix[i][j]));
+    }
+    bits += sum > 0.0L ? std::log2(static_cast< double >(sum)) : 0.0;
+  }
+  std::vector< uint32_t > primes = modularPrimes(0, primesFor(bits));
+  std::vector< uint32_t > perms(primes.size());
+  parallelFor(0, primes.size(), [&](size_t lo, size_t hi)
+  {
+    std::vector< uint32_t > a;
+    std::vector< uint32_t > sums(n);
+    for (size_t k = lo; k < hi; ++k)
+    {
+      uint32_t p = primes[k];
+      reduceMatrix(matrix, n, p, a, n);
+      std::fill(sums.begin(), sums.end(), 0);
+      uint64_t subsets = uint64_t(1) << n;
+      uint32_t total = 0;
+      uint64_t gray = 0;
+      for (uint64_t s = 1; s < subsets; ++s)
+      {
+        size_t j = __builtin_ctzll(s);
+        gray ^= uint64_t(1) << j;
+        bool added = gray >> j & 1;
+        uint32_t prod = 1;
+        for (size_t i = 0; i < n; ++i)
+        {
+          uint32_t v = a[i * n + j];
+          sums[i] = added ? (sums[i] + v) % p : (sums[i] + p - v) % p;
+          prod = mulMod(prod, sums[i], p);
+        }
+        bool odd = __builtin_popcountll(gray) & 1;
+        total = odd == (n & 1) ? (total + prod) % p : (total + p - prod) % p;
+      }
+      perms[k] = total;
+    }
+  }, threads);
+  return CrtBasis(primes).reconstruct(perms.data());
+}
+
+template< abramov::Integral T, class P >
+std::pair< abramov::BigInt, std::vector< abramov::BigInt > > abramov::exactInverse(const Matrix< T, P > &matrix, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("exactInverse", matrix.getRows(), matrix.getCols());
+  size_t n = matrix.getRows();
+  if (n != matrix.getCols())
+  {
+    throw std::logic_error("Matrix must be square\n");
+  }
+  auto res = exactSolve(matrix, n, n, true, hadamardBits(matrix, n, false), hadamardBits(matrix, n, true), threads);
+  if (res.first.isZero())
+  {
+    throw std::logic_error("Matrix does not have inverse\n");
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+std::pair< abramov::BigInt, std::vector< abramov::BigInt > > abramov::exactCramer(const Matrix< T, P > &matrix, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("exactCramer", matrix.getRows(), matrix.getCols());
+  size_t n = matrix.getRows();
+  if (n != matrix.getCols() - 1)
+  {
+    throw std::logic_error("For Cramer`s method number of equations must be equal to number of vars\n");
+  }
+  double bits = hadamardBits(matrix, n + 1, false);
+  auto res = exactSolve(matrix, n, 1, false, bits, bits, threads);
+  if (res.first.isZero())
+  {
+    throw std::logic_error("System has no unique solution\n");
+  }
+  return res;
+}
+#endif
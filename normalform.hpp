@@ -0,0 +1,923 @@
+#ifndef NORMALFORM_HPP
+#define NORMALFORM_HPP
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "bigint.hpp"
+#include "matrix.hpp"
+#include "modular.hpp"
+#include "threadpool.hpp"
+
+namespace abramov
+{
+  struct HermiteForm
+  {
+    size_t rows;
+    size_t cols;
+    std::vector< BigInt > h;
+    std::vector< BigInt > u;
+    std::vector< size_t > pivots;
+
+    size_t rank() const noexcept;
+  };
+
+  struct SmithForm
+  {
+    size_t rows;
+    size_t cols;
+    std::vector< BigInt > diagonal;
+    std::vector< BigInt > u;
+    std::vector< BigInt > v;
+
+    size_t rank() const noexcept;
+  };
+
+  struct PairTransform
+  {
+    BigInt u;
+    BigInt v;
+    BigInt s;
+    BigInt t;
+  };
+
+  struct Lines
+  {
+    BigInt *data;
+    size_t line;
+    size_t step;
+    size_t length;
+  };
+
+  template< Integral T, class P >
+  HermiteForm hermiteForm(const Matrix< T, P > &matrix, bool transform = true, size_t threads = 0);
+  template< Integral T, class P >
+  SmithForm smithForm(const Matrix< T, P > &matrix, bool transform = true, size_t threads = 0);
+
+  BigInt floorDiv(const BigInt &a, const BigInt &b);
+  BigInt floorMod(const BigInt &a, const BigInt &b);
+  BigInt extendedGcd(const BigInt &a, const BigInt &b, BigInt &x, BigInt &y);
+  PairTransform pairTransform(const BigInt &a, const BigInt &b);
+  void applyPair(const PairTransform &t, BigInt *x, BigInt *y, size_t count, size_t stride, const BigInt *modulus);
+  void swapLines(const Lines &lines, size_t i, size_t j);
+  void negateLine(const Lines &lines, size_t i);
+  bool eliminateLines(const Lines &lines, const Lines &track, size_t first, size_t last, const BigInt *modulus,
+    size_t threads);
+  template< Integral T, class P >
+  std::vector< size_t > independentRows(const Matrix< T, P > &matrix);
+  template< Integral T, class P >
+  bool hermiteTall(const Matrix< T, P > &matrix, std::vector< BigInt > &h, size_t threads);
+  template< Integral T, class P >
+  bool hermiteSquare(const Matrix< T, P > &matrix, std::vector< BigInt > &h, BigInt &det, size_t threads);
+  void congruenceHermite(const std::vector< BigInt > &w, const BigInt &modulus, std::vector< BigInt > &h);
+  void divideHermite(std::vector< BigInt > &a, const std::vector< BigInt > &h, size_t n, size_t threads);
+  void composeHermite(const std::vector< BigInt > &left, std::vector< BigInt > &h, size_t n, const BigInt &modulus,
+    size_t threads);
+  void hermiteModular(std::vector< BigInt > &a, size_t m, size_t n, BigInt modulus, size_t threads);
+  void hermiteExact(HermiteForm &form, size_t threads);
+  std::vector< BigInt > smithDiagonal(std::vector< BigInt > &a, size_t m, size_t n, std::vector< BigInt > &u,
+    std::vector< BigInt > &v, const BigInt *modulus, size_t threads);
+  std::vector< BigInt > identityBigInts(size_t n);
+  template< Integral T, class P >
+  std::vector< BigInt > toBigInts(const Matrix< T, P > &matrix);
+}
+
+inline size_t abramov::HermiteForm::rank() const noexcept
+{
+  return pivots.size();
+}
+
+inline size_t abramov::SmithForm::rank() const noexcept
+{
+  size_t res = 0;
+  for (const BigInt &d : diagonal)
+  {
+    res += !d.isZero();
+  }
+  return res;
+}
+
+inline abramov::BigInt abramov::floorDiv(const BigInt &a, const BigInt &b)
+{
+  auto [q, r] = BigInt::divMod(a, b);
+  if (!r.isZero() && r.isNegative() != b.isNegative())
+  {
+    q -= BigInt(1);
+  }
+  return q;
+}
+
+inline abramov::BigInt abramov::floorMod(const BigInt &a, const BigInt &b)
+{
+  BigInt r = BigInt::divMod(a, b).second;
+  if (!r.isZero() && r.isNegative() != b.isNegative())
+  {
+    r += b;
+  }
+  return r;
+}
+
+inline abramov::BigInt abramov::extendedGcd(const BigInt &a, const BigInt &b, BigInt &x, BigInt &y)
+{
+  BigInt r0 = a;
+  BigInt r1 = b;
+  BigInt s0(1);
+  BigInt s1;
+  BigInt t0;
+  BigInt t1(1);
+  while (!r1.isZero())
+  {
+    auto [q, r] = BigInt::divMod(r0, r1);
+    r0 = std::move(r1);
+    r1 = std::move(r);
+    BigInt s = s0 - q * s1;
+    s0 = std::move(s1);
+    s1 = std::move(s);
+    BigInt t = t0 - q * t1;
+    t0 = std::move(t1);
+    t1 = std::move(t);
+  }
+  if (r0.isNegative())
+  {
+    r0 = -r0;
+    s0 = -s0;
+    t0 = -t0;
+  }
+  x = std::move(s0);
+  y = std::move(t0);
+  return r0;
+}
+
+inline abramov::PairTransform abramov::pairTransform(const BigInt &a, const BigInt &b)
+{
+  if ((b % a).isZero())
+  {
+    return { BigInt(1), BigInt(), -(b / a), BigInt(1) };
+  }
+  if ((a % b).isZero())
+  {
+    return { BigInt(), BigInt(1), BigInt(1), -(a / b) };
+  }
+  PairTransform res;
+  BigInt d = extendedGcd(a, b, res.u, res.v);
+  res.s = -(b / d);
+  res.t = a / d;
+  return res;
+}
+
+inline void abramov::applyPair(const PairTransform &t, BigInt *x, BigInt *y, size_t count, size_t stride,
+  const BigInt *modulus)
+{
+  auto combine = [](const BigInt &a, const BigInt &p, const BigInt &b, const BigInt &q)
+  {
+    BigInt res;
+    if (!a.isZero() && !p.isZero())
+    {
+      res = a * p;
+    }
+    if (!b.isZero() && !q.isZero())
+    {
+      res += b * q;
+    }
+    return res;
+  };
+  bool keep = t.v.isZero() && t.u == BigInt(1);
+  for (size_t e = 0; e < count; ++e)
+  {
+    BigInt &p = x[e * stride];
+    BigInt &q = y[e * stride];
+    if (p.isZero() && q.isZero())
+    {
+      continue;
+    }
+    BigInt nq = combine(t.s, p, t.t, q);
+    if (!keep)
+    {
+      p = combine(t.u, p, t.v, q);
+      if (modulus)
+      {
+        p = floorMod(p, *modulus);
+      }
+    }
+    q = modulus ? floorMod(nq, *modulus) : std::move(nq);
+  }
+}
+
+inline void abramov::swapLines(const Lines &lines, size_t i, size_t j)
+{
+  for (size_t e = 0; e < lines.length; ++e)
+  {
+    std::swap(lines.data[i * lines.line + e * lines.step], lines.data[j * lines.line + e * lines.step]);
+  }
+}
+
+inline void abramov::negateLine(const Lines &lines, size_t i)
+{
+  for (size_t e = 0; e < lines.length; ++e)
+  {
+    BigInt &x = lines.data[i * lines.line + e * lines.step];
+    x = -x;
+  }
+}
+
+inline bool abramov::eliminateLines(const Lines &lines, const Lines &track, size_t first, size_t last,
+  const BigInt *modulus, size_t threads)
+{
+  std::vector< size_t > live;
+  for (size_t k = first; k < last; ++k)
+  {
+    if (!lines.data[k * lines.line].isZero())
+    {
+      live.push_back(k);
+    }
+  }
+  if (live.empty())
+  {
+    return false;
+  }
+  while (live.size() > 1)
+  {
+    parallelFor(0, live.size() / 2, [&](size_t lo, size_t hi)
+    {
+      for (size_t k = lo; k < hi; ++k)
+      {
+        size_t x = live[2 * k];
+        size_t y = live[2 * k + 1];
+        PairTransform t = pairTransform(lines.data[x * lines.line], lines.data[y * lines.line]);
+        applyPair(t, lines.data + x * lines.line, lines.data + y * lines.line, lines.length, lines.step, modulus);
+        if (track.data)
+        {
+          applyPair(t, track.data + x * track.line, track.data + y * track.line, track.length, track.step, nullptr);
+        }
+      }
+    }, threads);
+    size_t kept = 0;
+    for (size_t k = 0; k < live.size(); k += 2)
+    {
+      live[kept++] = live[k];
+    }
+    live.resize(kept);
+  }
+  if (live[0] != first)
+  {
+    swapLines(lines, first, live[0]);
+    if (track.data)
+    {
+      swapLines(track, first, live[0]);
+    }
+  }
+  return true;
+}
+
+inline void abramov::hermiteModular(std::vector< BigInt > &a, size_t m, size_t n, BigInt modulus, size_t threads)
+{
+  std::vector< BigInt > h(n * n);
+  bool reduce = true;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (reduce)
+    {
+      parallelFor(i, m, [&](size_t lo, size_t hi)
+      {
+        for (size_t k = lo; k < hi; ++k)
+        {
+          for (size_t j = i; j < n; ++j)
+          {
+            a[k * n + j] = floorMod(a[k * n + j], modulus);
+          }
+        }
+      }, threads);
+    }
+    eliminateLines({ a.data() + i, n, 1, n - i }, { nullptr, 0, 0, 0 }, i, m, &modulus, threads);
+    BigInt u;
+    BigInt v;
+    BigInt d = extendedGcd(a[i * n + i], modulus, u, v);
+    BigInt *row = h.data() + i * n;
+    for (size_t j = i; j < n; ++j)
+    {
+      row[j] = floorMod(u * a[i * n + j], modulus);
+    }
+    if (row[i].isZero())
+    {
+      row[i] = modulus;
+    }
+    parallelFor(0, i, [&](size_t lo, size_t hi)
+    {
+      for (size_t k = lo; k < hi; ++k)
+      {
+        BigInt *above = h.data() + k * n;
+        BigInt q = floorDiv(above[i], row[i]);
+        if (q.isZero())
+        {
+          continue;
+        }
+        for (size_t j = i; j < n; ++j)
+        {
+          above[j] = floorMod(above[j] - q * row[j], modulus);
+        }
+      }
+    }, threads);
+    reduce = !(d == BigInt(1));
+    modulus /= d;
+  }
+  a.swap(h);
+}
+
+inline void abramov::hermiteExact(HermiteForm &form, size_t threads)
+{
+  size_t m = form.rows;
+  size_t n = form.cols;
+  std::vector< BigInt > &h = form.h;
+  std::vector< BigInt > &u = form.u;
+  Lines track{ u.empty() ? nullptr : u.data(), m, 1, m };
+  for (size_t c = 0; c < n && form.pivots.size() < m; ++c)
+  {
+    size_t r = form.pivots.size();
+    Lines lines{ h.data() + c, n, 1, n - c };
+    if (!eliminateLines(lines, track, r, m, nullptr, threads))
+    {
+      continue;
+    }
+    if (h[r * n + c].isNegative())
+    {
+      negateLine(lines, r);
+      if (track.data)
+      {
+        negateLine(track, r);
+      }
+    }
+    parallelFor(0, r, [&](size_t lo, size_t hi)
+    {
+      for (size_t k = lo; k < hi; ++k)
+      {
+        BigInt q = floorDiv(h[k * n + c], h[r * n + c]);
+        if (q.isZero())
+        {
+          continue;
+        }
+        for (size_t j = c; j < n; ++j)
+        {
+          h[k * n + j] -= q * h[r * n + j];
+        }
+        for (size_t j = 0; track.data && j < m; ++j)
+        {
+          u[k * m + j] -= q * u[r * m + j];
+        }
+      }
+    }, threads);
+    form.pivots.push_back(c);
+  }
+}
+
+inline std::vector< abramov::BigInt > abramov::smithDiagonal(std::vector< BigInt > &a, size_t m, size_t n,
+  std::vector< BigInt > &u, std::vector< BigInt > &v, const BigInt *modulus, size_t threads)
+{
+  size_t k = std::min(m, n);
+  std::vector< BigInt > res(k);
+  BigInt r = modulus ? *modulus : BigInt();
+  const BigInt *mod = modulus ? &r : nullptr;
+  Lines rowTrack{ u.empty() ? nullptr : u.data(), m, 1, m };
+  Lines colTrack{ v.empty() ? nullptr : v.data(), 1, n, n };
+  bool reduce = false;
+  for (size_t t = 0; t < k; ++t)
+  {
+    if (mod && r == BigInt(1))
+    {
+      std::fill(res.begin() + t, res.end(), BigInt(1));
+      break;
+    }
+    Lines rows{ a.data() + t, n, 1, n - t };
+    Lines cols{ a.data() + t * n, 1, n, m - t };
+    if (reduce)
+    {
+      parallelFor(t, m, [&](size_t lo, size_t hi)
+      {
+        for (size_t i = lo; i < hi; ++i)
+        {
+          for (size_t j = t; j < n; ++j)
+          {
+            a[i * n + j] = floorMod(a[i * n + j], r);
+          }
+        }
+      }, threads);
+    }
+    BigInt d;
+    while (true)
+    {
+      bool column = eliminateLines(rows, rowTrack, t, m, mod, threads);
+      bool row = eliminateLines(cols, colTrack, t, n, mod, threads);
+      if (!column && !row)
+      {
+        size_t pr = m;
+        size_t pc = n;
+        for (size_t i = t; i < m && pr == m; ++i)
+        {
+          for (size_t j = t; j < n; ++j)
+          {
+            if (!a[i * n + j].isZero())
+            {
+              pr = i;
+              pc = j;
+              break;
+            }
+          }
+        }
+        if (pr == m)
+        {
+          break;
+        }
+        swapLines(rows, t, pr);
+        swapLines(cols, t, pc);
+        if (rowTrack.data)
+        {
+          swapLines(rowTrack, t, pr);
+        }
+        if (colTrack.data)
+        {
+          swapLines(colTrack, t, pc);
+        }
+        continue;
+      }
+      bool clear = true;
+      for (size_t i = t + 1; i < m && clear; ++i)
+      {
+        clear = a[i * n + t].isZero();
+      }
+      if (!clear)
+      {
+        continue;
+      }
+      BigInt x;
+      BigInt y;
+      d = mod ? extendedGcd(a[t * n + t], r, x, y) : extendedGcd(a[t * n + t], BigInt(), x, y);
+      size_t bad = m;
+      for (size_t i = d == BigInt(1) ? m : t + 1; i < m && bad == m; ++i)
+      {
+        for (size_t j = t + 1; j < n; ++j)
+        {
+          if (!(a[i * n + j] % d).isZero())
+          {
+            bad = i;
+            break;
+          }
+        }
+      }
+      if (bad == m)
+      {
+        break;
+      }
+      for (size_t j = t; j < n; ++j)
+      {
+        a[t * n + j] += a[bad * n + j];
+        if (mod)
+        {
+          a[t * n + j] = floorMod(a[t * n + j], r);
+        }
+      }
+      for (size_t j = 0; rowTrack.data && j < m; ++j)
+      {
+        u[t * m + j] += u[bad * m + j];
+      }
+    }
+    if (d.isZero())
+    {
+      if (!mod)
+      {
+        break;
+      }
+      d = r;
+    }
+    if (!mod && a[t * n + t].isNegative())
+    {
+      negateLine(rows, t);
+      if (rowTrack.data)
+      {
+        negateLine(rowTrack, t);
+      }
+    }
+    res[t] = d;
+    if (mod)
+    {
+      reduce = !(d == BigInt(1));
+      r /= d;
+    }
+  }
+  return res;
+}
+
+inline std::vector< abramov::BigInt > abramov::identityBigInts(size_t n)
+{
+  std::vector< BigInt > res(n * n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    res[i * n + i] = BigInt(1);
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+std::vector< abramov::BigInt > abramov::toBigInts(const Matrix< T, P > &matrix)
+{
+  size_t m = matrix.getRows();
+  size_t n = matrix.getCols();
+  std::vector< BigInt > res(m * n);
+  for (size_t i = 0; i < m; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      res[i * n + j] = BigInt(matrix[i][j]);
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+bool abramov::hermiteSquare(const Matrix< T, P > &matrix, std::vector< BigInt > &h, BigInt &det, size_t threads)
+{
+  constexpr size_t rhs = 4;
+  size_t n = matrix.getRows();
+  Matrix< T, P > augmented(n, n + rhs, 0);
+  std::mt19937 gen(static_cast< uint32_t >(n));
+  std::uniform_int_distribution< int > digit(0, 9);
+  for (size_t i = 0; i < n; ++i)
+  {
+    std::copy(matrix[i], matrix[i] + n, augmented[i]);
+    for (size_t k = 0; k < rhs; ++k)
+    {
+      augmented[i][n + k] = static_cast< T >(digit(gen));
+    }
+  }
+  double bits = hadamardBits(augmented, n + rhs, false);
+  auto [scale, z] = exactSolve(augmented, n, rhs, false, bits, bits, threads);
+  if (scale.isZero())
+  {
+    return false;
+  }
+  det = scale.isNegative() ? -scale : scale;
+  if (det == BigInt(1))
+  {
+    // A unimodular matrix spans the whole lattice: no candidate has content
+    // below det, so there is nothing to reduce modulo it
+    h = identityBigInts(n);
+    return true;
+  }
+  std::vector< BigInt > w;
+  BigInt content = det;
+  std::vector< BigInt > candidate(n);
+  for (size_t combination = 0; combination < 27 && !(content == BigInt(1)); ++combination)
+  {
+    BigInt g = det;
+    for (size_t i = 0; i < n; ++i)
+    {
+      BigInt sum = z[i * rhs];
+      for (size_t k = 1, digits = combination; k < rhs; ++k, digits /= 3)
+      {
+        sum += BigInt(digits % 3) * z[i * rhs + k];
+      }
+      candidate[i] = floorMod(sum, det);
+      if (!(g == BigInt(1)))
+      {
+        BigInt x;
+        BigInt y;
+        g = extendedGcd(candidate[i], g, x, y);
+      }
+    }
+    if (w.empty() || g < content)
+    {
+      w = candidate;
+      content = g;
+    }
+  }
+  congruenceHermite(w, det, h);
+  if (content == BigInt(1))
+  {
+    return true;
+  }
+  std::vector< BigInt > c = toBigInts(matrix);
+  divideHermite(c, h, n, threads);
+  hermiteModular(c, n, n, content, threads);
+  composeHermite(c, h, n, det, threads);
+  return true;
+}
+
+inline void abramov::congruenceHermite(const std::vector< BigInt > &w, const BigInt &modulus, std::vector< BigInt > &h)
+{
+  size_t n = w.size();
+  h.assign(n * n, BigInt());
+  std::vector< BigInt > coef(n);
+  BigInt g = modulus;
+  for (size_t i = n; i-- > 0;)
+  {
+    BigInt x;
+    BigInt y;
+    BigInt e = extendedGcd(w[i], g, x, y);
+    BigInt *row = h.data() + i * n;
+    row[i] = g / e;
+    BigInt tail = -(w[i] / e);
+    for (size_t j = i + 1; j < n; ++j)
+    {
+      if (!coef[j].isZero())
+      {
+        row[j] = floorMod(tail * coef[j], modulus);
+      }
+    }
+    for (size_t j = i + 1; j < n; ++j)
+    {
+      if (row[j].isZero())
+      {
+        continue;
+      }
+      const BigInt *below = h.data() + j * n;
+      BigInt q = floorDiv(row[j], below[j]);
+      if (q.isZero())
+      {
+        continue;
+      }
+      row[j] -= q * below[j];
+      for (size_t l = j + 1; l < n; ++l)
+      {
+        if (!below[l].isZero())
+        {
+          row[l] = floorMod(row[l] - q * below[l], modulus);
+        }
+      }
+    }
+    if (!(g == BigInt(1)))
+    {
+      for (size_t j = i + 1; j < n; ++j)
+      {
+        coef[j] = floorMod(y * coef[j], modulus);
+      }
+      coef[i] = floorMod(x, modulus);
+      g = e;
+    }
+  }
+}
+
+inline void abramov::divideHermite(std::vector< BigInt > &a, const std::vector< BigInt > &h, size_t n, size_t threads)
+{
+  std::vector< std::vector< size_t > > above(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = i + 1; j < n; ++j)
+    {
+      if (!h[i * n + j].isZero())
+      {
+        above[j].push_back(i);
+      }
+    }
+  }
+  parallelFor(0, n, [&](size_t lo, size_t hi)
+  {
+    for (size_t r = lo; r < hi; ++r)
+    {
+      BigInt *row = a.data() + r * n;
+      for (size_t j = 0; j < n; ++j)
+      {
+        for (size_t i : above[j])
+        {
+          if (!row[i].isZero())
+          {
+            row[j] -= row[i] * h[i * n + j];
+          }
+        }
+        if (!(h[j * n + j] == BigInt(1)))
+        {
+          row[j] /= h[j * n + j];
+        }
+      }
+    }
+  }, threads);
+}
+
+inline void abramov::composeHermite(const std::vector< BigInt > &left, std::vector< BigInt > &h, size_t n,
+  const BigInt &modulus, size_t threads)
+{
+  std::vector< BigInt > res(n * n);
+  parallelFor(0, n, [&](size_t lo, size_t hi)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      for (size_t k = i; k < n; ++k)
+      {
+        const BigInt &x = left[i * n + k];
+        if (x.isZero())
+        {
+          continue;
+        }
+        for (size_t j = k; j < n; ++j)
+        {
+          if (!h[k * n + j].isZero())
+          {
+            res[i * n + j] += x * h[k * n + j];
+          }
+        }
+      }
+      for (size_t j = i + 1; j < n; ++j)
+      {
+        res[i * n + j] = floorMod(res[i * n + j], modulus);
+      }
+    }
+  }, threads);
+  for (size_t j = 1; j < n; ++j)
+  {
+    const BigInt *pivot = res.data() + j * n;
+    parallelFor(0, j, [&](size_t lo, size_t hi)
+    {
+      for (size_t i = lo; i < hi; ++i)
+      {
+        BigInt *row = res.data() + i * n;
+        if (row[j].isZero())
+        {
+          continue;
+        }
+        BigInt q = floorDiv(row[j], pivot[j]);
+        if (q.isZero())
+        {
+          continue;
+        }
+        row[j] -= q * pivot[j];
+        for (size_t l = j + 1; l < n; ++l)
+        {
+          if (!pivot[l].isZero())
+          {
+            row[l] = floorMod(row[l] - q * pivot[l], modulus);
+          }
+        }
+      }
+    }, threads);
+  }
+  h.swap(res);
+}
+
+template< abramov::Integral T, class P >
+std::vector< size_t > abramov::independentRows(const Matrix< T, P > &matrix)
+{
+  size_t m = matrix.getRows();
+  size_t n = matrix.getCols();
+  uint32_t p = modularPrimes(0, 1)[0];
+  std::vector< uint32_t > basis;
+  std::vector< size_t > pivots;
+  std::vector< size_t > res;
+  std::vector< uint32_t > row(n);
+  for (size_t i = 0; i < m && res.size() < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      row[j] = reduceMod(matrix[i][j], p);
+    }
+    for (size_t k = 0; k < res.size(); ++k)
+    {
+      uint32_t f = row[pivots[k]];
+      for (size_t j = pivots[k]; f && j < n; ++j)
+      {
+        row[j] = (row[j] + p - mulMod(f, basis[k * n + j], p)) % p;
+      }
+    }
+    size_t c = std::find_if(row.begin(), row.end(), [](uint32_t x)
+    {
+      return x != 0;
+    }) - row.begin();
+    if (c == n)
+    {
+      continue;
+    }
+    uint32_t inverse = invMod(row[c], p);
+    basis.resize(basis.size() + n, 0);
+    for (size_t j = c; j < n; ++j)
+    {
+      basis[res.size() * n + j] = mulMod(row[j], inverse, p);
+    }
+    pivots.push_back(c);
+    res.push_back(i);
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+bool abramov::hermiteTall(const Matrix< T, P > &matrix, std::vector< BigInt > &h, size_t threads)
+{
+  size_t m = matrix.getRows();
+  size_t n = matrix.getCols();
+  std::vector< size_t > rows = independentRows(matrix);
+  if (rows.size() < n)
+  {
+    return false;
+  }
+  Matrix< T, P > square(n, n, 0);
+  std::vector< bool > used(m, false);
+  for (size_t i = 0; i < n; ++i)
+  {
+    std::copy(matrix[rows[i]], matrix[rows[i]] + n, square[i]);
+    used[rows[i]] = true;
+  }
+  std::vector< BigInt > stacked;
+  BigInt det;
+  if (!hermiteSquare(square, stacked, det, threads))
+  {
+    return false;
+  }
+  if (det == BigInt(1))
+  {
+    stacked.resize(m * n);
+    h.swap(stacked);
+    return true;
+  }
+  for (size_t i = 0; i < m; ++i)
+  {
+    for (size_t j = 0; !used[i] && j < n; ++j)
+    {
+      stacked.push_back(BigInt(matrix[i][j]));
+    }
+  }
+  hermiteModular(stacked, m, n, det, threads);
+  stacked.resize(m * n);
+  h.swap(stacked);
+  return true;
+}
+
+template< abramov::Integral T, class P >
+abramov::HermiteForm abramov::hermiteForm(const Matrix< T, P > &matrix, bool transform, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("hermiteForm", matrix.getRows(), matrix.getCols());
+  size_t m = matrix.getRows();
+  size_t n = matrix.getCols();
+  HermiteForm res{ m, n, {}, {}, {} };
+  BigInt det;
+  bool full = false;
+  if (n && m == n)
+  {
+    full = hermiteSquare(matrix, res.h, det, threads);
+  }
+  else if (n && m > n && !transform)
+  {
+    full = hermiteTall(matrix, res.h, threads);
+  }
+  if (!full)
+  {
+    res.h = toBigInts(matrix);
+    if (transform)
+    {
+      res.u = identityBigInts(m);
+    }
+    hermiteExact(res, threads);
+    return res;
+  }
+  for (size_t i = 0; i < n; ++i)
+  {
+    res.pivots.push_back(i);
+  }
+  if (transform)
+  {
+    auto [scale, adj] = exactInverse(matrix, threads);
+    res.u.resize(n * n);
+    parallelFor(0, n, [&](size_t lo, size_t hi)
+    {
+      for (size_t i = lo; i < hi; ++i)
+      {
+        for (size_t j = 0; j < n; ++j)
+        {
+          BigInt sum;
+          for (size_t k = i; k < n; ++k)
+          {
+            if (!res.h[i * n + k].isZero())
+            {
+              sum += res.h[i * n + k] * adj[k * n + j];
+            }
+          }
+          res.u[i * n + j] = sum / scale;
+        }
+      }
+    }, threads);
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::SmithForm abramov::smithForm(const Matrix< T, P > &matrix, bool transform, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("smithForm", matrix.getRows(), matrix.getCols());
+  size_t m = matrix.getRows();
+  size_t n = matrix.getCols();
+  HermiteForm hermite = hermiteForm(matrix, transform, threads);
+  SmithForm res{ m, n, {}, std::move(hermite.u), {} };
+  if (transform)
+  {
+    res.v = identityBigInts(n);
+  }
+  BigInt modulus;
+  if (!transform && hermite.rank() == n && n)
+  {
+    modulus = BigInt(1);
+    for (size_t i = 0; i < n; ++i)
+    {
+      modulus *= hermite.h[i * n + i];
+    }
+  }
+  res.diagonal = smithDiagonal(hermite.h, m, n, res.u, res.v, modulus.isZero() ? nullptr : &modulus, threads);
+  return res;
+}
+#endif
@@ -0,0 +1,858 @@
+#ifndef NTT_HPP
+#define NTT_HPP
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "matrix.hpp"
+#include "modular.hpp"
+#include "overflow.hpp"
+#include "threadpool.hpp"
+
+namespace abramov
+{
+  struct NttPrime
+  {
+    uint32_t modulus;
+    uint32_t inverse;
+    uint32_t r2;
+    uint32_t root;
+    size_t order;
+
+    explicit NttPrime(uint32_t modulus);
+    uint32_t reduce(uint64_t value) const noexcept;
+    uint32_t multiply(uint32_t a, uint32_t b) const noexcept;
+    uint32_t toMontgomery(uint32_t a) const noexcept;
+    uint32_t add(uint32_t a, uint32_t b) const noexcept;
+    uint32_t sub(uint32_t a, uint32_t b) const noexcept;
+  };
+
+  struct NttPlan
+  {
+    NttPlan(const NttPrime &prime, size_t length);
+    size_t size() const noexcept;
+    void forward(uint32_t *a) const noexcept;
+    void inverse(uint32_t *a) const noexcept;
+  private:
+    const NttPrime *prime;
+    size_t length;
+    std::vector< uint32_t > roots;
+    std::vector< uint32_t > inverseRoots;
+    uint32_t scale;
+  };
+
+  struct NttBasis
+  {
+    NttBasis(size_t primes, size_t bits);
+    size_t size() const noexcept;
+    bool exact() const noexcept;
+    unsigned __int128 reconstruct(const uint32_t *residues, size_t stride) const noexcept;
+    template< class P, class T >
+    T narrow(const uint32_t *residues, size_t stride) const;
+  private:
+    std::vector< uint32_t > primes;
+    std::vector< uint32_t > inverses;
+    std::vector< uint32_t > offsets;
+    std::vector< unsigned __int128 > radix;
+    unsigned __int128 offset;
+    size_t bits;
+  };
+
+  template< Integral T, class P = Wrapping >
+  struct PolynomialMatrix
+  {
+    PolynomialMatrix();
+    PolynomialMatrix(size_t rows, size_t cols, size_t length);
+    explicit PolynomialMatrix(const std::vector< Matrix< T, P > > &coefficients);
+    static PolynomialMatrix< T, P > identity(size_t n);
+    size_t getRows() const noexcept;
+    size_t getCols() const noexcept;
+    size_t getLength() const noexcept;
+    T *entry(size_t i, size_t j) noexcept;
+    const T *entry(size_t i, size_t j) const noexcept;
+    Matrix< T, P > coefficient(size_t k) const;
+    Matrix< T, P > evaluate(T x) const;
+    PolynomialMatrix< T, P > truncate(size_t length) const;
+    bool operator==(const PolynomialMatrix< T, P > &other) const noexcept;
+  private:
+    size_t rows;
+    size_t cols;
+    size_t length;
+    std::vector< T > values;
+  };
+
+  const std::vector< NttPrime > &nttPrimes();
+  size_t nttLength(size_t n) noexcept;
+  size_t nttPrimeCount(size_t bits);
+  bool nttSupports(size_t primes, size_t length) noexcept;
+  template< class T >
+  size_t magnitudeBits(const T *values, size_t n) noexcept;
+  template< class P, class T >
+  void directConvolve(const T *a, size_t na, const T *b, size_t nb, T *dst);
+  template< class P, class T >
+  void convolveInto(const T *kernel, size_t nk, const T *const *rows, size_t count, size_t nr, size_t first,
+    size_t length, size_t fold, T *const *out, size_t threads = 0);
+
+  template< class P = Wrapping, Integral T >
+  std::vector< T > convolve(const std::vector< T > &a, const std::vector< T > &b, size_t threads = 0);
+  template< class P = Wrapping, Integral T >
+  std::vector< T > cyclicConvolve(const std::vector< T > &a, const std::vector< T > &b, size_t threads = 0);
+  template< Integral T, class P >
+  Matrix< T, P > convolveRows(const std::vector< T > &kernel, const Matrix< T, P > &rows, size_t first, size_t length,
+    size_t threads = 0);
+  template< Integral T, class P >
+  PolynomialMatrix< T, P > polynomialMultiply(const PolynomialMatrix< T, P > &lhs, const PolynomialMatrix< T, P > &rhs,
+    size_t threads = 0);
+  template< Integral T, class P >
+  PolynomialMatrix< T, P > operator*(const PolynomialMatrix< T, P > &lhs, const PolynomialMatrix< T, P > &rhs);
+  template< class P = Wrapping, Integral T >
+  T linearRecurrence(const std::vector< T > &coefficients, const std::vector< T > &initial, unsigned long long index,
+    size_t threads = 0);
+}
+
+inline abramov::NttPrime::NttPrime(uint32_t mod):
+  modulus(mod),
+  inverse(1),
+  r2(static_cast< uint32_t >((static_cast< unsigned __int128 >(1) << 64) % mod)),
+  root(2),
+  order(std::countr_zero(mod - 1))
+{
+  for (int i = 0; i < 5; ++i)
+  {
+    inverse *= 2 - mod * inverse;
+  }
+  inverse = 0u - inverse;
+  std::vector< uint32_t > factors{ 2 };
+  uint32_t rest = (mod - 1) >> order;
+  for (uint32_t q = 3; q * q <= rest; q += 2)
+  {
+    if (rest % q == 0)
+    {
+      factors.push_back(q);
+      while (rest % q == 0)
+      {
+        rest /= q;
+      }
+    }
+  }
+  if (rest > 1)
+  {
+    factors.push_back(rest);
+  }
+  auto generates = [&](uint32_t g)
+  {
+    return std::none_of(factors.begin(), factors.end(), [&](uint32_t q)
+    {
+      return powMod(g, (mod - 1) / q, mod) == 1;
+    });
+  };
+  while (!generates(root))
+  {
+    ++root;
+  }
+}
+
+inline uint32_t abramov::NttPrime::reduce(uint64_t value) const noexcept
+{
+  uint32_t m = static_cast< uint32_t >(value) * inverse;
+  uint32_t t = static_cast< uint32_t >((value + static_cast< uint64_t >(m) * modulus) >> 32);
+  return t >= modulus ? t - modulus : t;
+}
+
+inline uint32_t abramov::NttPrime::multiply(uint32_t a, uint32_t b) const noexcept
+{
+  return reduce(static_cast< uint64_t >(a) * b);
+}
+
+inline uint32_t abramov::NttPrime::toMontgomery(uint32_t a) const noexcept
+{
+  return multiply(a, r2);
+}
+
+inline uint32_t abramov::NttPrime::add(uint32_t a, uint32_t b) const noexcept
+{
+  uint32_t s = a + b;
+  return s >= modulus ? s - modulus : s;
+}
+
+inline uint32_t abramov::NttPrime::sub(uint32_t a, uint32_t b) const noexcept
+{
+  return a >= b ? a - b : a + modulus - b;
+}
+
+inline abramov::NttPlan::NttPlan(const NttPrime &p, size_t n):
+  prime(&p),
+  length(n),
+  roots(n, 0),
+  inverseRoots(n, 0),
+  scale(p.toMontgomery(p.toMontgomery(invMod(static_cast< uint32_t >(n % p.modulus), p.modulus))))
+{
+  if (n & (n - 1) || std::countr_zero(n) > static_cast< int >(p.order))
+  {
+    throw std::invalid_argument("Transform length is not supported\n");
+  }
+  uint32_t one = p.toMontgomery(1);
+  for (size_t h = 1; h < n; h *= 2)
+  {
+    uint32_t w = p.toMontgomery(powMod(p.root, (p.modulus - 1) / (2 * h), p.modulus));
+    uint32_t iw = p.toMontgomery(invMod(powMod(p.root, (p.modulus - 1) / (2 * h), p.modulus), p.modulus));
+    roots[h] = one;
+    inverseRoots[h] = one;
+    for (size_t j = 1; j < h; ++j)
+    {
+      roots[h + j] = p.multiply(roots[h + j - 1], w);
+      inverseRoots[h + j] = p.multiply(inverseRoots[h + j - 1], iw);
+    }
+  }
+}
+
+inline size_t abramov::NttPlan::size() const noexcept
+{
+  return length;
+}
+
+inline void abramov::NttPlan::forward(uint32_t *a) const noexcept
+{
+  const NttPrime &p = *prime;
+  for (size_t h = length / 2; h >= 1; h /= 2)
+  {
+    const uint32_t *w = roots.data() + h;
+    for (size_t s = 0; s < length; s += 2 * h)
+    {
+      for (size_t j = 0; j < h; ++j)
+      {
+        uint32_t u = a[s + j];
+        uint32_t v = a[s + j + h];
+        a[s + j] = p.add(u, v);
+        a[s + j + h] = p.multiply(p.sub(u, v), w[j]);
+      }
+    }
+  }
+}
+
+inline void abramov::NttPlan::inverse(uint32_t *a) const noexcept
+{
+  const NttPrime &p = *prime;
+  for (size_t h = 1; h < length; h *= 2)
+  {
+    const uint32_t *w = inverseRoots.data() + h;
+    for (size_t s = 0; s < length; s += 2 * h)
+    {
+      for (size_t j = 0; j < h; ++j)
+      {
+        uint32_t u = a[s + j];
+        uint32_t v = p.multiply(a[s + j + h], w[j]);
+        a[s + j] = p.add(u, v);
+        a[s + j + h] = p.sub(u, v);
+      }
+    }
+  }
+  for (size_t i = 0; i < length; ++i)
+  {
+    a[i] = p.multiply(a[i], scale);
+  }
+}
+
+inline abramov::NttBasis::NttBasis(size_t count, size_t width):
+  primes(),
+  inverses(count, 1),
+  offsets(count, 0),
+  radix(count, 1),
+  offset(width < 128 ? static_cast< unsigned __int128 >(1) << width : 0),
+  bits(width)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    primes.push_back(nttPrimes()[i].modulus);
+  }
+  for (size_t i = 0; i < count; ++i)
+  {
+    uint32_t p = primes[i];
+    uint32_t prod = 1;
+    for (size_t j = 0; j < i; ++j)
+    {
+      prod = mulMod(prod, primes[j] % p, p);
+      radix[i] *= primes[j];
+    }
+    inverses[i] = invMod(prod, p);
+    offsets[i] = powMod(2, width, p);
+  }
+}
+
+inline size_t abramov::NttBasis::size() const noexcept
+{
+  return primes.size();
+}
+
+inline bool abramov::NttBasis::exact() const noexcept
+{
+  return bits < 128;
+}
+
+inline unsigned __int128 abramov::NttBasis::reconstruct(const uint32_t *residues, size_t stride) const noexcept
+{
+  uint32_t digits[8] = {};
+  unsigned __int128 res = 0;
+  for (size_t i = 0; i < primes.size(); ++i)
+  {
+    uint32_t p = primes[i];
+    uint32_t acc = 0;
+    for (size_t j = i; j > 0; --j)
+    {
+      acc = static_cast< uint32_t >((static_cast< uint64_t >(acc) * (primes[j - 1] % p) + digits[j - 1]) % p);
+    }
+    uint32_t r = static_cast< uint32_t >((static_cast< uint64_t >(residues[i * stride]) + offsets[i]) % p);
+    digits[i] = mulMod(r >= acc ? r - acc : r + p - acc, inverses[i], p);
+    res += radix[i] * digits[i];
+  }
+  return res - offset;
+}
+
+template< class P, class T >
+T abramov::NttBasis::narrow(const uint32_t *residues, size_t stride) const
+{
+  unsigned __int128 value = reconstruct(residues, stride);
+  if (exact())
+  {
+    return P::template narrow< T >(static_cast< __int128 >(value));
+  }
+  return static_cast< T >(value);
+}
+
+inline const std::vector< abramov::NttPrime > &abramov::nttPrimes()
+{
+  static const std::vector< NttPrime > primes{ NttPrime(2013265921u), NttPrime(1811939329u), NttPrime(998244353u),
+    NttPrime(754974721u), NttPrime(469762049u), NttPrime(167772161u) };
+  return primes;
+}
+
+inline size_t abramov::nttLength(size_t n) noexcept
+{
+  return std::bit_ceil(std::max< size_t >(n, 1));
+}
+
+inline size_t abramov::nttPrimeCount(size_t bits)
+{
+  double have = 0.0;
+  size_t count = 0;
+  for (const NttPrime &p : nttPrimes())
+  {
+    if (have > static_cast< double >(bits) + 1.5)
+    {
+      break;
+    }
+    have += std::log2(static_cast< double >(p.modulus));
+    ++count;
+  }
+  return have > static_cast< double >(bits) + 1.5 ? count : 0;
+}
+
+inline bool abramov::nttSupports(size_t primes, size_t length) noexcept
+{
+  return std::all_of(nttPrimes().begin(), nttPrimes().begin() + primes, [length](const NttPrime &p)
+  {
+    return static_cast< size_t >(std::countr_zero(length)) <= p.order;
+  });
+}
+
+template< class T >
+size_t abramov::magnitudeBits(const T *values, size_t n) noexcept
+{
+  unsigned long long top = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if constexpr (std::is_signed_v< T >)
+    {
+      unsigned long long v = static_cast< unsigned long long >(values[i]);
+      top |= values[i] < T(0) ? 0ULL - v : v;
+    }
+    else
+    {
+      top |= static_cast< unsigned long long >(values[i]);
+    }
+  }
+  return std::bit_width(top);
+}
+
+template< class P, class T >
+void abramov::directConvolve(const T *a, size_t na, const T *b, size_t nb, T *dst)
+{
+  if (na > nb)
+  {
+    std::swap(a, b);
+    std::swap(na, nb);
+  }
+  if (!na)
+  {
+    return;
+  }
+  std::vector< T > padded(nb + 2 * (na - 1), T(0));
+  std::copy_n(b, nb, padded.begin() + (na - 1));
+  std::vector< const T * > rows(na);
+  for (size_t s = 0; s < na; ++s)
+  {
+    rows[s] = padded.data() + (na - 1) - s;
+  }
+  multiplyRow< P >(dst, a, rows.data(), na, na + nb - 1);
+}
+
+template< class P, class T >
+void abramov::convolveInto(const T *kernel, size_t nk, const T *const *rows, size_t count, size_t nr, size_t first,
+  size_t length, size_t fold, T *const *out, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("convolveInto", count, nk + nr);
+  size_t full = nk && nr ? nk + nr - 1 : 0;
+  size_t bits = magnitudeBits(kernel, nk);
+  size_t rowBits = 0;
+  for (size_t r = 0; r < count; ++r)
+  {
+    rowBits = std::max(rowBits, magnitudeBits(rows[r], nr));
+  }
+  bits += rowBits + std::bit_width(std::min(nk, nr));
+  size_t primes = nttPrimeCount(bits);
+  size_t n = nttLength(full);
+  bool exact = primes && (bits < 128 || P::wraps) && nttSupports(primes, n);
+  if (!exact || std::min(nk, nr) <= 64)
+  {
+    parallelFor(0, count, [&](size_t lo, size_t hi)
+    {
+      std::vector< T > tmp(full);
+      std::vector< T > folded(fold);
+      for (size_t r = lo; r < hi; ++r)
+      {
+        std::fill(tmp.begin(), tmp.end(), T(0));
+        directConvolve< P >(kernel, nk, rows[r], nr, tmp.data());
+        const T *src = tmp.data();
+        size_t size = full;
+        if (fold)
+        {
+          std::fill(folded.begin(), folded.end(), T(0));
+          for (size_t base = 0; base < full; base += fold)
+          {
+            addRow< P >(folded.data(), tmp.data() + base, std::min(fold, full - base));
+          }
+          src = folded.data();
+          size = fold;
+        }
+        for (size_t t = 0; t < length; ++t)
+        {
+          out[r][t] = first + t < size ? src[first + t] : T(0);
+        }
+      }
+    }, threads);
+    return;
+  }
+  NttBasis basis(primes, bits);
+  std::vector< uint32_t > residues(primes * count * length, 0);
+  for (size_t q = 0; q < primes; ++q)
+  {
+    const NttPrime &prime = nttPrimes()[q];
+    NttPlan plan(prime, n);
+    std::vector< uint32_t > spectrum(n, 0);
+    for (size_t i = 0; i < nk; ++i)
+    {
+      spectrum[i] = reduceMod(kernel[i], prime.modulus);
+    }
+    plan.forward(spectrum.data());
+    parallelFor(0, count, [&](size_t lo, size_t hi)
+    {
+      std::vector< uint32_t > work(n);
+      for (size_t r = lo; r < hi; ++r)
+      {
+        std::fill(work.begin(), work.end(), 0);
+        for (size_t i = 0; i < nr; ++i)
+        {
+          work[i] = reduceMod(rows[r][i], prime.modulus);
+        }
+        plan.forward(work.data());
+        for (size_t i = 0; i < n; ++i)
+        {
+          work[i] = prime.multiply(work[i], spectrum[i]);
+        }
+        plan.inverse(work.data());
+        uint32_t *dst = residues.data() + (q * count + r) * length;
+        for (size_t k = 0; k < full; ++k)
+        {
+          size_t t = fold ? k % fold : k;
+          if (t >= first && t < first + length)
+          {
+            dst[t - first] = prime.add(dst[t - first], work[k]);
+          }
+        }
+      }
+    }, threads);
+  }
+  size_t stride = count * length;
+  parallelFor(0, count, [&](size_t lo, size_t hi)
+  {
+    for (size_t r = lo; r < hi; ++r)
+    {
+      for (size_t t = 0; t < length; ++t)
+      {
+        out[r][t] = basis.template narrow< P, T >(residues.data() + r * length + t, stride);
+      }
+    }
+  }, threads);
+}
+
+template< class P, abramov::Integral T >
+std::vector< T > abramov::convolve(const std::vector< T > &a, const std::vector< T > &b, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("convolve", a.size(), b.size());
+  size_t full = a.empty() || b.empty() ? 0 : a.size() + b.size() - 1;
+  std::vector< T > res(full);
+  const T *row = b.data();
+  T *out = res.data();
+  convolveInto< P >(a.data(), a.size(), &row, 1, b.size(), 0, full, 0, &out, threads);
+  return res;
+}
+
+template< class P, abramov::Integral T >
+std::vector< T > abramov::cyclicConvolve(const std::vector< T > &a, const std::vector< T > &b, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("cyclicConvolve", a.size(), b.size());
+  if (a.size() != b.size())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  std::vector< T > res(a.size());
+  const T *row = b.data();
+  T *out = res.data();
+  convolveInto< P >(a.data(), a.size(), &row, 1, b.size(), 0, a.size(), a.size(), &out, threads);
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::convolveRows(const std::vector< T > &kernel, const Matrix< T, P > &rows, size_t first,
+  size_t length, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("convolveRows", rows.getRows(), rows.getCols());
+  Matrix< T, P > res(rows.getRows(), length, 0);
+  std::vector< const T * > in(rows.getRows());
+  std::vector< T * > out(rows.getRows());
+  for (size_t r = 0; r < in.size(); ++r)
+  {
+    in[r] = rows[r];
+    out[r] = res[r];
+  }
+  convolveInto< P >(kernel.data(), kernel.size(), in.data(), in.size(), rows.getCols(), first, length, 0, out.data(),
+    threads);
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::PolynomialMatrix< T, P >::PolynomialMatrix():
+  PolynomialMatrix(0, 0, 0)
+{}
+
+template< abramov::Integral T, class P >
+abramov::PolynomialMatrix< T, P >::PolynomialMatrix(size_t m, size_t n, size_t len):
+  rows(m),
+  cols(n),
+  length(len),
+  values(m * n * len, T(0))
+{}
+
+template< abramov::Integral T, class P >
+abramov::PolynomialMatrix< T, P >::PolynomialMatrix(const std::vector< Matrix< T, P > > &coefficients):
+  PolynomialMatrix(coefficients.empty() ? 0 : coefficients[0].getRows(),
+    coefficients.empty() ? 0 : coefficients[0].getCols(), coefficients.size())
+{
+  for (size_t k = 0; k < length; ++k)
+  {
+    if (coefficients[k].getRows() != rows || coefficients[k].getCols() != cols)
+    {
+      throw std::invalid_argument("Matrix dimensions do not agree\n");
+    }
+    for (size_t i = 0; i < rows; ++i)
+    {
+      for (size_t j = 0; j < cols; ++j)
+      {
+        entry(i, j)[k] = coefficients[k][i][j];
+      }
+    }
+  }
+}
+
+template< abramov::Integral T, class P >
+abramov::PolynomialMatrix< T, P > abramov::PolynomialMatrix< T, P >::identity(size_t n)
+{
+  PolynomialMatrix< T, P > res(n, n, 1);
+  for (size_t i = 0; i < n; ++i)
+  {
+    res.entry(i, i)[0] = T(1);
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::PolynomialMatrix< T, P >::getRows() const noexcept
+{
+  return rows;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::PolynomialMatrix< T, P >::getCols() const noexcept
+{
+  return cols;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::PolynomialMatrix< T, P >::getLength() const noexcept
+{
+  return length;
+}
+
+template< abramov::Integral T, class P >
+T *abramov::PolynomialMatrix< T, P >::entry(size_t i, size_t j) noexcept
+{
+  return values.data() + (i * cols + j) * length;
+}
+
+template< abramov::Integral T, class P >
+const T *abramov::PolynomialMatrix< T, P >::entry(size_t i, size_t j) const noexcept
+{
+  return values.data() + (i * cols + j) * length;
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::PolynomialMatrix< T, P >::coefficient(size_t k) const
+{
+  Matrix< T, P > res(rows, cols, 0);
+  for (size_t i = 0; k < length && i < rows; ++i)
+  {
+    for (size_t j = 0; j < cols; ++j)
+    {
+      res[i][j] = entry(i, j)[k];
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::PolynomialMatrix< T, P >::evaluate(T x) const
+{
+  ABRAMOV_PROFILE_SCOPE("PolynomialMatrix::evaluate", rows, cols);
+  Matrix< T, P > res(rows, cols, 0);
+  for (size_t k = length; k > 0; --k)
+  {
+    Matrix< T, P > c = coefficient(k - 1);
+    for (size_t i = 0; i < rows; ++i)
+    {
+      scaleRow< P >(res[i], cols, x);
+      addRow< P >(res[i], c[i], cols);
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::PolynomialMatrix< T, P > abramov::PolynomialMatrix< T, P >::truncate(size_t len) const
+{
+  PolynomialMatrix< T, P > res(rows, cols, len);
+  for (size_t i = 0; i < rows; ++i)
+  {
+    for (size_t j = 0; j < cols; ++j)
+    {
+      std::copy_n(entry(i, j), std::min(len, length), res.entry(i, j));
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+bool abramov::PolynomialMatrix< T, P >::operator==(const PolynomialMatrix< T, P > &other) const noexcept
+{
+  return rows == other.rows && cols == other.cols && length == other.length && values == other.values;
+}
+
+template< abramov::Integral T, class P >
+abramov::PolynomialMatrix< T, P > abramov::polynomialMultiply(const PolynomialMatrix< T, P > &lhs,
+  const PolynomialMatrix< T, P > &rhs, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("polynomialMultiply", lhs.getRows(), rhs.getCols());
+  if (lhs.getCols() != rhs.getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  size_t m = lhs.getRows();
+  size_t inner = lhs.getCols();
+  size_t n = rhs.getCols();
+  size_t la = lhs.getLength();
+  size_t lb = rhs.getLength();
+  size_t full = la && lb ? la + lb - 1 : 0;
+  PolynomialMatrix< T, P > res(m, n, full);
+  if (!full || !inner)
+  {
+    return res;
+  }
+  size_t bits = magnitudeBits(lhs.entry(0, 0), m * inner * la) + magnitudeBits(rhs.entry(0, 0), inner * n * lb) +
+    std::bit_width(inner * std::min(la, lb));
+  size_t primes = nttPrimeCount(bits);
+  size_t len = nttLength(full);
+  bool exact = primes && (bits < 128 || P::wraps) && nttSupports(primes, len);
+  if (!exact || std::min(la, lb) <= 16)
+  {
+    parallelFor(0, m, [&](size_t lo, size_t hi)
+    {
+      std::vector< T > tmp(full);
+      for (size_t i = lo; i < hi; ++i)
+      {
+        for (size_t j = 0; j < n; ++j)
+        {
+          for (size_t t = 0; t < inner; ++t)
+          {
+            std::fill(tmp.begin(), tmp.end(), T(0));
+            directConvolve< P >(lhs.entry(i, t), la, rhs.entry(t, j), lb, tmp.data());
+            addRow< P >(res.entry(i, j), tmp.data(), full);
+          }
+        }
+      }
+    }, threads);
+    return res;
+  }
+  NttBasis basis(primes, bits);
+  std::vector< uint32_t > residues(primes * m * n * full);
+  for (size_t q = 0; q < primes; ++q)
+  {
+    const NttPrime &prime = nttPrimes()[q];
+    NttPlan plan(prime, len);
+    std::vector< uint32_t > a(m * inner * len, 0);
+    std::vector< uint32_t > b(inner * n * len, 0);
+    auto transform = [&](const T *src, size_t count, size_t width, std::vector< uint32_t > &dst)
+    {
+      parallelFor(0, count, [&](size_t lo, size_t hi)
+      {
+        for (size_t e = lo; e < hi; ++e)
+        {
+          for (size_t s = 0; s < width; ++s)
+          {
+            dst[e * len + s] = reduceMod(src[e * width + s], prime.modulus);
+          }
+          plan.forward(dst.data() + e * len);
+        }
+      }, threads);
+    };
+    transform(lhs.entry(0, 0), m * inner, la, a);
+    transform(rhs.entry(0, 0), inner * n, lb, b);
+    parallelFor(0, m * n, [&](size_t lo, size_t hi)
+    {
+      std::vector< uint64_t > acc(len);
+      std::vector< uint32_t > work(len);
+      for (size_t e = lo; e < hi; ++e)
+      {
+        size_t i = e / n;
+        size_t j = e % n;
+        std::fill(acc.begin(), acc.end(), 0);
+        for (size_t t = 0; t < inner; ++t)
+        {
+          const uint32_t *x = a.data() + (i * inner + t) * len;
+          const uint32_t *y = b.data() + (t * n + j) * len;
+          for (size_t f = 0; f < len; ++f)
+          {
+            acc[f] += prime.multiply(x[f], y[f]);
+          }
+          if ((t & 0xff) == 0xff)
+          {
+            for (size_t f = 0; f < len; ++f)
+            {
+              acc[f] %= prime.modulus;
+            }
+          }
+        }
+        for (size_t f = 0; f < len; ++f)
+        {
+          work[f] = static_cast< uint32_t >(acc[f] % prime.modulus);
+        }
+        plan.inverse(work.data());
+        std::copy_n(work.begin(), full, residues.begin() + (q * m * n + e) * full);
+      }
+    }, threads);
+  }
+  size_t stride = m * n * full;
+  parallelFor(0, m * n, [&](size_t lo, size_t hi)
+  {
+    for (size_t e = lo; e < hi; ++e)
+    {
+      T *dst = res.entry(e / n, e % n);
+      for (size_t s = 0; s < full; ++s)
+      {
+        dst[s] = basis.template narrow< P, T >(residues.data() + e * full + s, stride);
+      }
+    }
+  }, threads);
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::PolynomialMatrix< T, P > abramov::operator*(const PolynomialMatrix< T, P > &lhs,
+  const PolynomialMatrix< T, P > &rhs)
+{
+  return polynomialMultiply(lhs, rhs);
+}
+
+template< class P, abramov::Integral T >
+T abramov::linearRecurrence(const std::vector< T > &coefficients, const std::vector< T > &initial,
+  unsigned long long index, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("linearRecurrence", coefficients.size(), coefficients.size());
+  if (coefficients.size() != initial.size())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  size_t k = coefficients.size();
+  if (!k)
+  {
+    return T(0);
+  }
+  if (index < k)
+  {
+    return initial[index];
+  }
+  using W = std::conditional_t< P::wraps, T, long long >;
+  using Q = std::conditional_t< P::wraps, Wrapping, Checked >;
+  std::vector< W > den(k + 1);
+  std::vector< W > seed(k);
+  std::vector< W > num;
+  den[0] = W(1);
+  try
+  {
+    for (size_t i = 0; i < k; ++i)
+    {
+      den[i + 1] = sub< Q, W >(W(0), Q::template narrow< W >(coefficients[i]));
+      seed[i] = Q::template narrow< W >(initial[i]);
+    }
+    num = convolve< Q >(den, seed, threads);
+    num.resize(k);
+    while (index)
+    {
+      std::vector< W > mirror = den;
+      for (size_t i = 1; i < mirror.size(); i += 2)
+      {
+        mirror[i] = sub< Q, W >(W(0), mirror[i]);
+      }
+      std::vector< W > u = convolve< Q >(num, mirror, threads);
+      std::vector< W > v = convolve< Q >(den, mirror, threads);
+      for (size_t i = 0; i < k; ++i)
+      {
+        num[i] = 2 * i + (index & 1) < u.size() ? u[2 * i + (index & 1)] : W(0);
+      }
+      for (size_t i = 0; i <= k; ++i)
+      {
+        den[i] = v[2 * i];
+      }
+      index >>= 1;
+    }
+  }
+  catch (const OverflowSignal &)
+  {
+    throw std::overflow_error("Integer overflow\n");
+  }
+  return P::template narrow< T >(num[0]);
+}
+#endif
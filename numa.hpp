@@ -0,0 +1,289 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "threadpool.hpp"
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace abramov
+{
+  struct NumaTopology
+  {
+    std::vector< std::vector< size_t > > cpus;
+
+    size_t nodes() const noexcept;
+  };
+
+  const NumaTopology &numaTopology();
+  size_t numaNodes();
+  std::vector< size_t > parseCpuList(const std::string &list);
+  size_t nodeBegin(size_t begin, size_t end, size_t node, size_t nodes) noexcept;
+  bool pinToNode(size_t node);
+  bool preferNode(void *addr, size_t bytes, size_t node) noexcept;
+  bool interleaveNodes(void *addr, size_t bytes) noexcept;
+  long memoryNode(const void *addr) noexcept;
+  ThreadPool &nodePool(size_t node);
+  bool &nodeWorker() noexcept;
+  template< class F >
+  void numaParallelFor(size_t begin, size_t end, F f);
+}
+
+inline size_t abramov::NumaTopology::nodes() const noexcept
+{
+  return cpus.size();
+}
+
+inline std::vector< size_t > abramov::parseCpuList(const std::string &list)
+{
+  std::vector< size_t > res;
+  size_t pos = 0;
+  while (pos < list.size())
+  {
+    size_t comma = list.find(',', pos);
+    std::string item = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+    pos = comma == std::string::npos ? list.size() : comma + 1;
+    while (!item.empty() && (item.back() == '\n' || item.back() == ' '))
+    {
+      item.pop_back();
+    }
+    if (item.empty())
+    {
+      continue;
+    }
+    size_t dash = item.find('-');
+    size_t lo = std::stoul(item.substr(0, dash));
+    size_t hi = dash == std::string::npos ? lo : std::stoul(item.substr(dash + 1));
+    for (size_t cpu = lo; cpu <= hi; ++cpu)
+    {
+      res.push_back(cpu);
+    }
+  }
+  return res;
+}
+
+inline const abramov::NumaTopology &abramov::numaTopology()
+{
+  static const NumaTopology topology = []()
+  {
+    NumaTopology res;
+    for (size_t node = 0;; ++node)
+    {
+      std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+      if (!in)
+      {
+        break;
+      }
+      std::string list;
+      std::getline(in, list);
+      try
+      {
+        res.cpus.push_back(parseCpuList(list));
+      }
+      catch (const std::exception &)
+      {
+        res.cpus.clear();
+        break;
+      }
+    }
+    res.cpus.erase(std::remove_if(res.cpus.begin(), res.cpus.end(), [](const std::vector< size_t > &cpus)
+    {
+      return cpus.empty();
+    }), res.cpus.end());
+    if (res.cpus.empty())
+    {
+      res.cpus.emplace_back();
+      for (size_t cpu = 0; cpu < defaultThreads(); ++cpu)
+      {
+        res.cpus.back().push_back(cpu);
+      }
+    }
+    return res;
+  }();
+  return topology;
+}
+
+inline size_t abramov::numaNodes()
+{
+  return numaTopology().nodes();
+}
+
+inline size_t abramov::nodeBegin(size_t begin, size_t end, size_t node, size_t nodes) noexcept
+{
+  return begin + static_cast< size_t >(static_cast< unsigned long long >(end - begin) * node / nodes);
+}
+
+inline bool abramov::pinToNode(size_t node)
+{
+#ifdef __linux__
+  const NumaTopology &topology = numaTopology();
+  if (node >= topology.nodes())
+  {
+    return false;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (size_t cpu : topology.cpus[node])
+  {
+    if (cpu < CPU_SETSIZE)
+    {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return !sched_setaffinity(0, sizeof(set), &set);
+#else
+  return node == 0;
+#endif
+}
+
+inline bool abramov::preferNode(void *addr, size_t bytes, size_t node) noexcept
+{
+#if defined(__linux__) && defined(SYS_mbind)
+  constexpr int preferred = 1;
+  unsigned long mask[16] = {};
+  if (node >= sizeof(mask) * 8)
+  {
+    return false;
+  }
+  mask[node / (sizeof(unsigned long) * 8)] |= 1ul << (node % (sizeof(unsigned long) * 8));
+  return !syscall(SYS_mbind, addr, bytes, preferred, mask, sizeof(mask) * 8, 0);
+#else
+  (void)addr;
+  (void)bytes;
+  return node == 0;
+#endif
+}
+
+inline bool abramov::interleaveNodes(void *addr, size_t bytes) noexcept
+{
+#if defined(__linux__) && defined(SYS_mbind)
+  constexpr int interleave = 3;
+  unsigned long mask[16] = {};
+  size_t nodes = std::min(numaNodes(), sizeof(mask) * 8);
+  for (size_t node = 0; node < nodes; ++node)
+  {
+    mask[node / (sizeof(unsigned long) * 8)] |= 1ul << (node % (sizeof(unsigned long) * 8));
+  }
+  return !syscall(SYS_mbind, addr, bytes, interleave, mask, sizeof(mask) * 8, 0);
+#else
+  (void)addr;
+  (void)bytes;
+  return false;
+#endif
+}
+
+inline long abramov::memoryNode(const void *addr) noexcept
+{
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+  constexpr unsigned long flags = 1 | 2;
+  int node = -1;
+  if (syscall(SYS_get_mempolicy, &node, nullptr, 0, addr, flags))
+  {
+    return -1;
+  }
+  return node;
+#else
+  (void)addr;
+  return -1;
+#endif
+}
+
+inline bool &abramov::nodeWorker() noexcept
+{
+  thread_local bool worker = false;
+  return worker;
+}
+
+inline abramov::ThreadPool &abramov::nodePool(size_t node)
+{
+  static std::vector< std::unique_ptr< ThreadPool > > pools(numaNodes());
+  static std::vector< std::once_flag > created(numaNodes());
+  if (node >= pools.size())
+  {
+    throw std::out_of_range("Invalid NUMA node\n");
+  }
+  std::call_once(created[node], [node]()
+  {
+    pools[node] = std::make_unique< ThreadPool >(numaTopology().cpus[node].size(), [node](size_t)
+    {
+      nodeWorker() = true;
+      pinToNode(node);
+    });
+  });
+  return *pools[node];
+}
+
+template< class F >
+void abramov::numaParallelFor(size_t begin, size_t end, F f)
+{
+  if (begin >= end)
+  {
+    return;
+  }
+  size_t nodes = numaNodes();
+  if (nodeWorker())
+  {
+    f(begin, end);
+    return;
+  }
+  std::vector< std::future< void > > futures;
+  std::exception_ptr error;
+  try
+  {
+    for (size_t node = 0; node < nodes; ++node)
+    {
+      size_t lo = nodeBegin(begin, end, node, nodes);
+      size_t hi = nodeBegin(begin, end, node + 1, nodes);
+      if (lo == hi)
+      {
+        continue;
+      }
+      ThreadPool &pool = nodePool(node);
+      size_t chunks = std::min(pool.size(), hi - lo);
+      for (size_t c = 0; c < chunks; ++c)
+      {
+        size_t from = nodeBegin(lo, hi, c, chunks);
+        size_t to = nodeBegin(lo, hi, c + 1, chunks);
+        futures.push_back(pool.submit([&f, from, to]()
+        {
+          f(from, to);
+        }));
+      }
+    }
+  }
+  catch (...)
+  {
+    error = std::current_exception();
+  }
+  for (auto &future : futures)
+  {
+    try
+    {
+      future.get();
+    }
+    catch (...)
+    {
+      if (!error)
+      {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+}
+#endif
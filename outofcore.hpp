@@ -0,0 +1,586 @@
+#ifndef OUTOFCORE_HPP
+#define OUTOFCORE_HPP
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "matrix.hpp"
+
+namespace abramov
+{
+  template< Integral T >
+  struct TiledFile
+  {
+    static constexpr size_t default_budget = size_t(256) << 20;
+
+    explicit TiledFile(const std::string &path);
+    TiledFile(const std::string &path, size_t m, size_t n, size_t tile);
+    TiledFile(const TiledFile< T > &) = delete;
+    TiledFile(TiledFile< T > &&other) noexcept;
+    ~TiledFile();
+    TiledFile< T > &operator=(const TiledFile< T > &) = delete;
+    TiledFile< T > &operator=(TiledFile< T > &&other) noexcept;
+
+    size_t getRows() const noexcept;
+    size_t getCols() const noexcept;
+    size_t getTile() const noexcept;
+    size_t tileRows() const noexcept;
+    size_t tileCols() const noexcept;
+    void readTile(size_t ti, size_t tj, T *buf) const;
+    void writeTile(size_t ti, size_t tj, const T *buf);
+
+    static TiledFile< T > fromMatrix(const std::string &path, const Matrix< T > &matrix, size_t tile);
+    Matrix< T > toMatrix() const;
+    TiledFile< T > multiply(const TiledFile< T > &other, const std::string &path, size_t budget = default_budget) const;
+    TiledFile< T > transpose(const std::string &path) const;
+    static TiledFile< T > horizontalConcat(const TiledFile< T > &lhs, const TiledFile< T > &rhs,
+      const std::string &path, T fill = 0, size_t budget = default_budget);
+    static TiledFile< T > verticalConcat(const TiledFile< T > &top, const TiledFile< T > &bottom,
+      const std::string &path, T fill = 0, size_t budget = default_budget);
+    static TiledFile< T > diagonalConcat(const TiledFile< T > &a, const TiledFile< T > &b,
+      const std::string &path, T fill = 0, size_t budget = default_budget);
+    static TiledFile< T > kroneckerProduct(const TiledFile< T > &a, const TiledFile< T > &b,
+      const std::string &path, size_t budget = default_budget);
+  private:
+    struct Header
+    {
+      char magic[4];
+      uint32_t elem_size;
+      uint64_t rows;
+      uint64_t cols;
+      uint64_t tile;
+    };
+    struct TileCache
+    {
+      TileCache(const TiledFile< T > &file, size_t capacity);
+      const T *get(size_t ti, size_t tj);
+      void copyRow(size_t row, size_t first, size_t last, T *dst);
+    private:
+      const TiledFile< T > &file;
+      size_t capacity;
+      std::list< std::pair< size_t, std::vector< T > > > tiles;
+      std::unordered_map< size_t, typename std::list< std::pair< size_t, std::vector< T > > >::iterator > index;
+    };
+
+    int fd;
+    size_t rows;
+    size_t cols;
+    size_t tile;
+
+    size_t tileElems() const noexcept;
+    off_t tileOffset(size_t ti, size_t tj) const noexcept;
+    static size_t budgetTiles(size_t budget, size_t tile);
+    template< class F >
+    static TiledFile< T > assemble(const std::string &path, size_t m, size_t n, size_t tile, F rowSegment);
+  };
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T >::TiledFile(const std::string &path):
+  fd(::open(path.c_str(), O_RDWR)),
+  rows(0),
+  cols(0),
+  tile(0)
+{
+  if (fd < 0)
+  {
+    throw std::runtime_error("Can not open tiled matrix " + path + "\n");
+  }
+  Header header = {};
+  if (::pread(fd, &header, sizeof(header), 0) != sizeof(header) || std::memcmp(header.magic, "ABTM", 4) != 0
+    || header.elem_size != sizeof(T) || !header.tile)
+  {
+    ::close(fd);
+    throw std::runtime_error("Invalid tiled matrix " + path + "\n");
+  }
+  rows = header.rows;
+  cols = header.cols;
+  tile = header.tile;
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T >::TiledFile(const std::string &path, size_t m, size_t n, size_t t):
+  fd(-1),
+  rows(m),
+  cols(n),
+  tile(t)
+{
+  if (!tile)
+  {
+    throw std::invalid_argument("Tile size must be positive\n");
+  }
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+  {
+    throw std::runtime_error("Can not create tiled matrix " + path + "\n");
+  }
+  Header header = { { 'A', 'B', 'T', 'M' }, sizeof(T), m, n, t };
+  off_t size = tileOffset(tileRows(), 0);
+  if (::pwrite(fd, &header, sizeof(header), 0) != sizeof(header) || ::ftruncate(fd, size) != 0)
+  {
+    ::close(fd);
+    throw std::runtime_error("Can not write tiled matrix " + path + "\n");
+  }
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T >::TiledFile(TiledFile< T > &&other) noexcept:
+  fd(other.fd),
+  rows(other.rows),
+  cols(other.cols),
+  tile(other.tile)
+{
+  other.fd = -1;
+  other.rows = 0;
+  other.cols = 0;
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T >::~TiledFile()
+{
+  if (fd >= 0)
+  {
+    ::close(fd);
+  }
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T > &abramov::TiledFile< T >::operator=(TiledFile< T > &&other) noexcept
+{
+  std::swap(fd, other.fd);
+  std::swap(rows, other.rows);
+  std::swap(cols, other.cols);
+  std::swap(tile, other.tile);
+  return *this;
+}
+
+template< abramov::Integral T >
+size_t abramov::TiledFile< T >::getRows() const noexcept
+{
+  return rows;
+}
+
+template< abramov::Integral T >
+size_t abramov::TiledFile< T >::getCols() const noexcept
+{
+  return cols;
+}
+
+template< abramov::Integral T >
+size_t abramov::TiledFile< T >::getTile() const noexcept
+{
+  return tile;
+}
+
+template< abramov::Integral T >
+size_t abramov::TiledFile< T >::tileRows() const noexcept
+{
+  return (rows + tile - 1) / tile;
+}
+
+template< abramov::Integral T >
+size_t abramov::TiledFile< T >::tileCols() const noexcept
+{
+  return (cols + tile - 1) / tile;
+}
+
+template< abramov::Integral T >
+void abramov::TiledFile< T >::readTile(size_t ti, size_t tj, T *buf) const
+{
+  char *p = reinterpret_cast< char * >(buf);
+  size_t left = tileElems() * sizeof(T);
+  off_t offset = tileOffset(ti, tj);
+  while (left)
+  {
+    ssize_t got = ::pread(fd, p, left, offset);
+    if (got <= 0)
+    {
+      throw std::runtime_error("Fail to read tile\n");
+    }
+    p += got;
+    offset += got;
+    left -= got;
+  }
+}
+
+template< abramov::Integral T >
+void abramov::TiledFile< T >::writeTile(size_t ti, size_t tj, const T *buf)
+{
+  const char *p = reinterpret_cast< const char * >(buf);
+  size_t left = tileElems() * sizeof(T);
+  off_t offset = tileOffset(ti, tj);
+  while (left)
+  {
+    ssize_t put = ::pwrite(fd, p, left, offset);
+    if (put <= 0)
+    {
+      throw std::runtime_error("Fail to write tile\n");
+    }
+    p += put;
+    offset += put;
+    left -= put;
+  }
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T > abramov::TiledFile< T >::fromMatrix(const std::string &path, const Matrix< T > &matrix, size_t tile)
+{
+  return assemble(path, matrix.getRows(), matrix.getCols(), tile, [&matrix](size_t row, size_t first, size_t last, T *dst)
+  {
+    std::copy(matrix[row] + first, matrix[row] + last, dst);
+  });
+}
+
+template< abramov::Integral T >
+abramov::Matrix< T > abramov::TiledFile< T >::toMatrix() const
+{
+  Matrix< T > res(rows, cols, 0);
+  std::vector< T > buf(tileElems());
+  for (size_t ti = 0; ti < tileRows(); ++ti)
+  {
+    for (size_t tj = 0; tj < tileCols(); ++tj)
+    {
+      readTile(ti, tj, buf.data());
+      size_t h = std::min(tile, rows - ti * tile);
+      size_t w = std::min(tile, cols - tj * tile);
+      for (size_t i = 0; i < h; ++i)
+      {
+        std::copy(buf.data() + i * tile, buf.data() + i * tile + w, res[ti * tile + i] + tj * tile);
+      }
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T > abramov::TiledFile< T >::multiply(const TiledFile< T > &other, const std::string &path, size_t budget) const
+{
+  if (cols != other.rows)
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  if (tile != other.tile)
+  {
+    throw std::invalid_argument("Tile sizes do not agree\n");
+  }
+  TiledFile< T > res(path, rows, other.cols, tile);
+  size_t group = std::min(std::max< size_t >((budgetTiles(budget, tile) - 2) / 3, 1), other.tileCols());
+  size_t elems = tileElems();
+  size_t steps = tileCols();
+  std::vector< T > acc(group * elems);
+  std::vector< T > panels[2] = { std::vector< T >((group + 1) * elems), std::vector< T >((group + 1) * elems) };
+  for (size_t ti = 0; ti < tileRows(); ++ti)
+  {
+    for (size_t tj = 0; tj < other.tileCols(); tj += group)
+    {
+      size_t g = std::min(group, other.tileCols() - tj);
+      std::fill(acc.begin(), acc.end(), T(0));
+      auto load = [this, &other, ti, tj, g, elems](size_t tk, T *panel)
+      {
+        readTile(ti, tk, panel);
+        for (size_t q = 0; q < g; ++q)
+        {
+          other.readTile(tk, tj + q, panel + (q + 1) * elems);
+        }
+      };
+      std::future< void > pending;
+      if (steps)
+      {
+        pending = std::async(std::launch::async, load, 0, panels[0].data());
+      }
+      for (size_t tk = 0; tk < steps; ++tk)
+      {
+        pending.get();
+        T *panel = panels[tk % 2].data();
+        if (tk + 1 < steps)
+        {
+          pending = std::async(std::launch::async, load, tk + 1, panels[(tk + 1) % 2].data());
+        }
+        for (size_t q = 0; q < g; ++q)
+        {
+          T *c = acc.data() + q * elems;
+          const T *b = panel + (q + 1) * elems;
+          for (size_t i = 0; i < tile; ++i)
+          {
+            for (size_t k = 0; k < tile; ++k)
+            {
+              T a = panel[i * tile + k];
+              for (size_t j = 0; j < tile; ++j)
+              {
+                c[i * tile + j] += a * b[k * tile + j];
+              }
+            }
+          }
+        }
+      }
+      for (size_t q = 0; q < g; ++q)
+      {
+        res.writeTile(ti, tj + q, acc.data() + q * elems);
+      }
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T > abramov::TiledFile< T >::transpose(const std::string &path) const
+{
+  TiledFile< T > res(path, cols, rows, tile);
+  size_t elems = tileElems();
+  std::vector< T > in[2] = { std::vector< T >(elems), std::vector< T >(elems) };
+  std::vector< T > out(elems);
+  size_t total = tileRows() * tileCols();
+  auto load = [this](size_t idx, T *buf)
+  {
+    readTile(idx / tileCols(), idx % tileCols(), buf);
+  };
+  std::future< void > pending;
+  if (total)
+  {
+    pending = std::async(std::launch::async, load, 0, in[0].data());
+  }
+  for (size_t idx = 0; idx < total; ++idx)
+  {
+    pending.get();
+    const T *src = in[idx % 2].data();
+    if (idx + 1 < total)
+    {
+      pending = std::async(std::launch::async, load, idx + 1, in[(idx + 1) % 2].data());
+    }
+    for (size_t i = 0; i < tile; ++i)
+    {
+      for (size_t j = 0; j < tile; ++j)
+      {
+        out[j * tile + i] = src[i * tile + j];
+      }
+    }
+    res.writeTile(idx % tileCols(), idx / tileCols(), out.data());
+  }
+  return res;
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T > abramov::TiledFile< T >::horizontalConcat(const TiledFile< T > &lhs, const TiledFile< T > &rhs,
+  const std::string &path, T fill, size_t budget)
+{
+  size_t capacity = std::max< size_t >(budgetTiles(budget, lhs.tile) / 4, 1);
+  TileCache left(lhs, capacity);
+  TileCache right(rhs, capacity);
+  size_t m = std::max(lhs.rows, rhs.rows);
+  return assemble(path, m, lhs.cols + rhs.cols, lhs.tile, [&](size_t row, size_t first, size_t last, T *dst)
+  {
+    for (size_t j = first; j < last;)
+    {
+      bool inLeft = j < lhs.cols;
+      const TiledFile< T > &src = inLeft ? lhs : rhs;
+      size_t base = inLeft ? 0 : lhs.cols;
+      size_t end = inLeft ? std::min(last, lhs.cols) : last;
+      if (row < src.rows)
+      {
+        (inLeft ? left : right).copyRow(row, j - base, end - base, dst + (j - first));
+      }
+      else
+      {
+        std::fill(dst + (j - first), dst + (end - first), fill);
+      }
+      j = end;
+    }
+  });
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T > abramov::TiledFile< T >::verticalConcat(const TiledFile< T > &top, const TiledFile< T > &bottom,
+  const std::string &path, T fill, size_t budget)
+{
+  size_t capacity = std::max< size_t >(budgetTiles(budget, top.tile) / 4, 1);
+  TileCache upper(top, capacity);
+  TileCache lower(bottom, capacity);
+  size_t n = std::max(top.cols, bottom.cols);
+  return assemble(path, top.rows + bottom.rows, n, top.tile, [&](size_t row, size_t first, size_t last, T *dst)
+  {
+    bool inTop = row < top.rows;
+    const TiledFile< T > &src = inTop ? top : bottom;
+    size_t r = inTop ? row : row - top.rows;
+    size_t end = std::min(last, std::max(first, src.cols));
+    if (end > first)
+    {
+      (inTop ? upper : lower).copyRow(r, first, end, dst);
+    }
+    std::fill(dst + (end - first), dst + (last - first), fill);
+  });
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T > abramov::TiledFile< T >::diagonalConcat(const TiledFile< T > &a, const TiledFile< T > &b,
+  const std::string &path, T fill, size_t budget)
+{
+  size_t capacity = std::max< size_t >(budgetTiles(budget, a.tile) / 4, 1);
+  TileCache first_cache(a, capacity);
+  TileCache second_cache(b, capacity);
+  return assemble(path, a.rows + b.rows, a.cols + b.cols, a.tile, [&](size_t row, size_t first, size_t last, T *dst)
+  {
+    std::fill(dst, dst + (last - first), fill);
+    if (row < a.rows)
+    {
+      size_t end = std::min(last, a.cols);
+      if (end > first)
+      {
+        first_cache.copyRow(row, first, end, dst);
+      }
+    }
+    else
+    {
+      size_t begin = std::max(first, a.cols);
+      if (last > begin)
+      {
+        second_cache.copyRow(row - a.rows, begin - a.cols, last - a.cols, dst + (begin - first));
+      }
+    }
+  });
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T > abramov::TiledFile< T >::kroneckerProduct(const TiledFile< T > &a, const TiledFile< T > &b,
+  const std::string &path, size_t budget)
+{
+  size_t capacity = std::max< size_t >(budgetTiles(budget, a.tile) / 4, 1);
+  TileCache left(a, capacity);
+  TileCache right(b, capacity);
+  return assemble(path, a.rows * b.rows, a.cols * b.cols, a.tile, [&](size_t row, size_t first, size_t last, T *dst)
+  {
+    size_t ai = row / b.rows;
+    size_t bi = row % b.rows;
+    for (size_t j = first; j < last;)
+    {
+      size_t aj = j / b.cols;
+      size_t bj = j % b.cols;
+      size_t run = std::min(last - j, b.cols - bj);
+      T curr = left.get(ai / a.tile, aj / a.tile)[(ai % a.tile) * a.tile + aj % a.tile];
+      T *out = dst + (j - first);
+      right.copyRow(bi, bj, bj + run, out);
+      for (size_t k = 0; k < run; ++k)
+      {
+        out[k] *= curr;
+      }
+      j += run;
+    }
+  });
+}
+
+template< abramov::Integral T >
+abramov::TiledFile< T >::TileCache::TileCache(const TiledFile< T > &f, size_t cap):
+  file(f),
+  capacity(cap),
+  tiles(),
+  index()
+{}
+
+template< abramov::Integral T >
+const T *abramov::TiledFile< T >::TileCache::get(size_t ti, size_t tj)
+{
+  size_t key = ti * file.tileCols() + tj;
+  auto it = index.find(key);
+  if (it != index.end())
+  {
+    tiles.splice(tiles.begin(), tiles, it->second);
+    return tiles.front().second.data();
+  }
+  if (tiles.size() >= capacity)
+  {
+    index.erase(tiles.back().first);
+    tiles.splice(tiles.begin(), tiles, std::prev(tiles.end()));
+    tiles.front().first = key;
+  }
+  else
+  {
+    tiles.emplace_front(key, std::vector< T >(file.tileElems()));
+  }
+  file.readTile(ti, tj, tiles.front().second.data());
+  index[key] = tiles.begin();
+  return tiles.front().second.data();
+}
+
+template< abramov::Integral T >
+void abramov::TiledFile< T >::TileCache::copyRow(size_t row, size_t first, size_t last, T *dst)
+{
+  size_t t = file.tile;
+  while (first < last)
+  {
+    size_t end = std::min(last, (first / t + 1) * t);
+    const T *src = get(row / t, first / t) + (row % t) * t;
+    std::copy(src + first % t, src + first % t + (end - first), dst);
+    dst += end - first;
+    first = end;
+  }
+}
+
+template< abramov::Integral T >
+size_t abramov::TiledFile< T >::tileElems() const noexcept
+{
+  return tile * tile;
+}
+
+template< abramov::Integral T >
+off_t abramov::TiledFile< T >::tileOffset(size_t ti, size_t tj) const noexcept
+{
+  return sizeof(Header) + (ti * tileCols() + tj) * tileElems() * sizeof(T);
+}
+
+template< abramov::Integral T >
+size_t abramov::TiledFile< T >::budgetTiles(size_t budget, size_t tile)
+{
+  size_t tiles = budget / (tile * tile * sizeof(T));
+  if (tiles < 5)
+  {
+    throw std::invalid_argument("Memory budget is too small for the tile size\n");
+  }
+  return tiles;
+}
+
+template< abramov::Integral T >
+template< class F >
+abramov::TiledFile< T > abramov::TiledFile< T >::assemble(const std::string &path, size_t m, size_t n, size_t tile, F rowSegment)
+{
+  TiledFile< T > res(path, m, n, tile);
+  size_t elems = res.tileElems();
+  std::vector< T > out[2] = { std::vector< T >(elems), std::vector< T >(elems) };
+  std::future< void > pending;
+  size_t total = res.tileRows() * res.tileCols();
+  for (size_t idx = 0; idx < total; ++idx)
+  {
+    size_t ti = idx / res.tileCols();
+    size_t tj = idx % res.tileCols();
+    T *buf = out[idx % 2].data();
+    std::fill(buf, buf + elems, T(0));
+    size_t h = std::min(tile, m - ti * tile);
+    size_t first = tj * tile;
+    size_t last = std::min(n, first + tile);
+    for (size_t i = 0; i < h; ++i)
+    {
+      rowSegment(ti * tile + i, first, last, buf + i * tile);
+    }
+    if (pending.valid())
+    {
+      pending.get();
+    }
+    pending = std::async(std::launch::async, [&res, ti, tj, buf]()
+    {
+      res.writeTile(ti, tj, buf);
+    });
+  }
+  if (pending.valid())
+  {
+    pending.get();
+  }
+  return res;
+}
+#endif
@@ -0,0 +1,465 @@
+#ifndef OVERFLOW_HPP
+#define OVERFLOW_HPP
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace abramov
+{
+  struct Wrapping
+  {
+    static constexpr bool wraps = true;
+    template< class T >
+    using result_type = T;
+
+    template< class R, class W >
+    static R narrow(W value);
+  };
+
+  struct Checked
+  {
+    static constexpr bool wraps = false;
+    template< class T >
+    using result_type = T;
+
+    template< class R, class W >
+    static R narrow(W value);
+  };
+
+  struct Saturating
+  {
+    static constexpr bool wraps = false;
+    template< class T >
+    using result_type = T;
+
+    template< class R, class W >
+    static R narrow(W value);
+  };
+
+  struct Widening
+  {
+    static constexpr bool wraps = false;
+    template< class T >
+    using result_type = std::conditional_t< sizeof(T) < sizeof(long long), long long, __int128 >;
+
+    template< class R, class W >
+    static R narrow(W value);
+  };
+
+  struct OverflowSignal
+  {};
+
+  // Wrapping arithmetic type for T: unsigned, and at least as wide as int so
+  // that short operands are not promoted to signed int first
+  template< class T >
+  using promoted_unsigned_t = std::common_type_t< std::make_unsigned_t< T >, unsigned >;
+
+  template< class R, class W >
+  bool fits(W value) noexcept;
+  template< class P, class A >
+  A add(A a, A b);
+  template< class P, class A >
+  A sub(A a, A b);
+  template< class P, class A >
+  A mul(A a, A b);
+  template< class P, class A >
+  A abs(A a);
+  template< class P, class T, class R = typename P::template result_type< T >, class F >
+  R escalate(F f);
+
+  template< class P, class T >
+  void addRow(T *dst, const T *src, size_t n);
+  template< class P, class T >
+  void subRow(T *dst, const T *src, size_t n);
+  template< class P, class T >
+  void negateRow(T *dst, size_t n);
+  template< class P, class T >
+  void scaleRow(T *dst, size_t n, T scalar);
+  template< class P, class T >
+  void multiplyRow(T *dst, const T *lhs, const T *const *rhs, size_t inner, size_t n);
+}
+
+template< class R, class W >
+bool abramov::fits(W value) noexcept
+{
+  if constexpr (std::is_same_v< R, W >)
+  {
+    return true;
+  }
+  else if constexpr (sizeof(R) > sizeof(W) && std::is_signed_v< R >)
+  {
+    return true;
+  }
+  else
+  {
+    if (value < W(0))
+    {
+      return std::numeric_limits< R >::is_signed && value >= static_cast< W >(std::numeric_limits< R >::min());
+    }
+    return value <= static_cast< W >(std::numeric_limits< R >::max());
+  }
+}
+
+template< class R, class W >
+R abramov::Wrapping::narrow(W value)
+{
+  return static_cast< R >(value);
+}
+
+template< class R, class W >
+R abramov::Checked::narrow(W value)
+{
+  if (!fits< R >(value))
+  {
+    throw std::overflow_error("Integer overflow\n");
+  }
+  return static_cast< R >(value);
+}
+
+template< class R, class W >
+R abramov::Saturating::narrow(W value)
+{
+  if (fits< R >(value))
+  {
+    return static_cast< R >(value);
+  }
+  return value < W(0) ? std::numeric_limits< R >::min() : std::numeric_limits< R >::max();
+}
+
+template< class R, class W >
+R abramov::Widening::narrow(W value)
+{
+  return Checked::narrow< R >(value);
+}
+
+template< class P, class A >
+A abramov::add(A a, A b)
+{
+  A res;
+  if (__builtin_add_overflow(a, b, &res) && !P::wraps)
+  {
+    throw OverflowSignal();
+  }
+  return res;
+}
+
+template< class P, class A >
+A abramov::sub(A a, A b)
+{
+  A res;
+  if (__builtin_sub_overflow(a, b, &res) && !P::wraps)
+  {
+    throw OverflowSignal();
+  }
+  return res;
+}
+
+template< class P, class A >
+A abramov::mul(A a, A b)
+{
+  A res;
+  if (__builtin_mul_overflow(a, b, &res) && !P::wraps)
+  {
+    throw OverflowSignal();
+  }
+  return res;
+}
+
+template< class P, class A >
+A abramov::abs(A a)
+{
+  return a < A(0) ? sub< P >(A(0), a) : a;
+}
+
+template< class P, class T, class R, class F >
+R abramov::escalate(F f)
+{
+  if constexpr (P::wraps)
+  {
+    return static_cast< R >(f.template operator()< T >());
+  }
+  else
+  {
+    if constexpr (std::is_signed_v< T >)
+    {
+      try
+      {
+        return P::template narrow< R >(f.template operator()< T >());
+      }
+      catch (const OverflowSignal &)
+      {}
+    }
+    if constexpr (sizeof(T) < sizeof(long long))
+    {
+      try
+      {
+        return P::template narrow< R >(f.template operator()< long long >());
+      }
+      catch (const OverflowSignal &)
+      {}
+    }
+    try
+    {
+      return P::template narrow< R >(f.template operator()< __int128 >());
+    }
+    catch (const OverflowSignal &)
+    {
+      throw std::overflow_error("Integer overflow\n");
+    }
+  }
+}
+
+template< class P, class T >
+void abramov::addRow(T *dst, const T *src, size_t n)
+{
+  using U = std::make_unsigned_t< T >;
+  bool bad = false;
+  for (size_t j = 0; j < n; ++j)
+  {
+    T s = static_cast< T >(static_cast< U >(dst[j]) + static_cast< U >(src[j]));
+    if constexpr (std::is_signed_v< T >)
+    {
+      bad |= ((dst[j] ^ s) & (src[j] ^ s)) < 0;
+    }
+    else
+    {
+      bad |= s < dst[j];
+    }
+    dst[j] = s;
+  }
+  if constexpr (!P::wraps)
+  {
+    if (bad)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        dst[j] = static_cast< T >(static_cast< U >(dst[j]) - static_cast< U >(src[j]));
+      }
+      for (size_t j = 0; j < n; ++j)
+      {
+        P::template narrow< T >(static_cast< __int128 >(dst[j]) + src[j]);
+      }
+      for (size_t j = 0; j < n; ++j)
+      {
+        dst[j] = P::template narrow< T >(static_cast< __int128 >(dst[j]) + src[j]);
+      }
+    }
+  }
+}
+
+template< class P, class T >
+void abramov::subRow(T *dst, const T *src, size_t n)
+{
+  using U = std::make_unsigned_t< T >;
+  bool bad = false;
+  for (size_t j = 0; j < n; ++j)
+  {
+    T s = static_cast< T >(static_cast< U >(dst[j]) - static_cast< U >(src[j]));
+    if constexpr (std::is_signed_v< T >)
+    {
+      bad |= ((dst[j] ^ src[j]) & (dst[j] ^ s)) < 0;
+    }
+    else
+    {
+      bad |= dst[j] < src[j];
+    }
+    dst[j] = s;
+  }
+  if constexpr (!P::wraps)
+  {
+    if (bad)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        dst[j] = static_cast< T >(static_cast< U >(dst[j]) + static_cast< U >(src[j]));
+      }
+      for (size_t j = 0; j < n; ++j)
+      {
+        P::template narrow< T >(static_cast< __int128 >(dst[j]) - src[j]);
+      }
+      for (size_t j = 0; j < n; ++j)
+      {
+        dst[j] = P::template narrow< T >(static_cast< __int128 >(dst[j]) - src[j]);
+      }
+    }
+  }
+}
+
+template< class P, class T >
+void abramov::negateRow(T *dst, size_t n)
+{
+  using U = std::make_unsigned_t< T >;
+  if constexpr (!P::wraps)
+  {
+    bool bad = false;
+    for (size_t j = 0; j < n; ++j)
+    {
+      if constexpr (std::is_signed_v< T >)
+      {
+        bad |= dst[j] == std::numeric_limits< T >::min();
+      }
+      else
+      {
+        bad |= dst[j] != 0;
+      }
+    }
+    if (bad)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        P::template narrow< T >(-static_cast< __int128 >(dst[j]));
+      }
+      for (size_t j = 0; j < n; ++j)
+      {
+        dst[j] = P::template narrow< T >(-static_cast< __int128 >(dst[j]));
+      }
+      return;
+    }
+  }
+  for (size_t j = 0; j < n; ++j)
+  {
+    dst[j] = static_cast< T >(U(0) - static_cast< U >(dst[j]));
+  }
+}
+
+template< class P, class T >
+void abramov::scaleRow(T *dst, size_t n, T scalar)
+{
+  if constexpr (!P::wraps && sizeof(T) < sizeof(long long))
+  {
+    bool bad = false;
+    for (size_t j = 0; j < n; ++j)
+    {
+      long long p = static_cast< long long >(dst[j]) * scalar;
+      bad |= p < static_cast< long long >(std::numeric_limits< T >::min());
+      bad |= p > static_cast< long long >(std::numeric_limits< T >::max());
+    }
+    for (size_t j = 0; j < n && bad; ++j)
+    {
+      P::template narrow< T >(static_cast< long long >(dst[j]) * scalar);
+    }
+    for (size_t j = 0; j < n; ++j)
+    {
+      long long p = static_cast< long long >(dst[j]) * scalar;
+      dst[j] = bad ? P::template narrow< T >(p) : static_cast< T >(p);
+    }
+  }
+  else if constexpr (!P::wraps)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      P::template narrow< T >(static_cast< __int128 >(dst[j]) * scalar);
+    }
+    for (size_t j = 0; j < n; ++j)
+    {
+      dst[j] = P::template narrow< T >(static_cast< __int128 >(dst[j]) * scalar);
+    }
+  }
+  else
+  {
+    using W = promoted_unsigned_t< T >;
+    for (size_t j = 0; j < n; ++j)
+    {
+      dst[j] = static_cast< T >(static_cast< W >(dst[j]) * static_cast< W >(scalar));
+    }
+  }
+}
+
+template< class P, class T >
+void abramov::multiplyRow(T *dst, const T *lhs, const T *const *rhs, size_t inner, size_t n)
+{
+  if constexpr (P::wraps)
+  {
+    using U = promoted_unsigned_t< T >;
+    for (size_t j = 0; j < n; ++j)
+    {
+      dst[j] = 0;
+    }
+    for (size_t k = 0; k < inner; ++k)
+    {
+      U a = static_cast< U >(lhs[k]);
+      const T *b = rhs[k];
+      for (size_t j = 0; j < n; ++j)
+      {
+        dst[j] = static_cast< T >(static_cast< U >(dst[j]) + a * static_cast< U >(b[j]));
+      }
+    }
+  }
+  else
+  {
+    constexpr bool fast = sizeof(T) < sizeof(long long) && (std::is_signed_v< T > || sizeof(T) < sizeof(int));
+    bool wide = !fast;
+    if constexpr (fast)
+    {
+      thread_local std::vector< long long > acc;
+      acc.assign(n, 0);
+      bool bad = false;
+      for (size_t k = 0; k < inner && !bad; ++k)
+      {
+        long long a = lhs[k];
+        const T *b = rhs[k];
+        for (size_t j = 0; j < n; ++j)
+        {
+          long long p = a * b[j];
+          long long s = static_cast< long long >(static_cast< unsigned long long >(acc[j]) + static_cast< unsigned long long >(p));
+          bad |= ((acc[j] ^ s) & (p ^ s)) < 0;
+          acc[j] = s;
+        }
+      }
+      wide = bad;
+      if (!bad)
+      {
+        bool out = false;
+        for (size_t j = 0; j < n; ++j)
+        {
+          out |= acc[j] < static_cast< long long >(std::numeric_limits< T >::min());
+          out |= acc[j] > static_cast< long long >(std::numeric_limits< T >::max());
+          dst[j] = static_cast< T >(acc[j]);
+        }
+        if (out)
+        {
+          for (size_t j = 0; j < n; ++j)
+          {
+            dst[j] = P::template narrow< T >(acc[j]);
+          }
+        }
+      }
+    }
+    if (wide)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        // The true sum is sum + carry * 2^128; only its sign matters once
+        // carry is nonzero, and narrow then throws or clamps per policy
+        __int128 sum = 0;
+        long long carry = 0;
+        for (size_t k = 0; k < inner; ++k)
+        {
+          __int128 a = lhs[k];
+          __int128 b = rhs[k][j];
+          __int128 p = 0;
+          if (__builtin_mul_overflow(a, b, &p))
+          {
+            carry += (a < 0) == (b < 0) ? 1 : -1;
+          }
+          else if (__builtin_add_overflow(sum, p, &sum))
+          {
+            carry += p < 0 ? -1 : 1;
+          }
+        }
+        if (carry)
+        {
+          __int128 beyond = static_cast< __int128 >(1) << 126;
+          dst[j] = P::template narrow< T >(carry > 0 ? beyond : -beyond);
+        }
+        else
+        {
+          dst[j] = P::template narrow< T >(sum);
+        }
+      }
+    }
+  }
+}
+#endif
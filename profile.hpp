@@ -0,0 +1,283 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef ABRAMOV_PROFILE
+#define ABRAMOV_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ABRAMOV_PROFILE_CONCAT(a, b) ABRAMOV_PROFILE_CONCAT_IMPL(a, b)
+#define ABRAMOV_PROFILE_SCOPE(name, rows, cols) \
+  static const size_t ABRAMOV_PROFILE_CONCAT(abramov_profile_id_, __LINE__) = ::abramov::profileRegister(name); \
+  ::abramov::ProfileScope ABRAMOV_PROFILE_CONCAT(abramov_profile_scope_, __LINE__)( \
+    ABRAMOV_PROFILE_CONCAT(abramov_profile_id_, __LINE__), (rows), (cols))
+#define ABRAMOV_PROFILE_ALLOC(bytes) ::abramov::profileAllocated(bytes)
+#else
+#define ABRAMOV_PROFILE_SCOPE(name, rows, cols) ((void) 0)
+#define ABRAMOV_PROFILE_ALLOC(bytes) ((void) 0)
+#endif
+
+namespace abramov
+{
+  struct ProfileStats
+  {
+    static constexpr size_t buckets = 33;
+
+    std::string name;
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;
+    uint64_t bytes = 0;
+    std::array< uint64_t, buckets > dims{};
+  };
+
+  struct ProfileScope
+  {
+    ProfileScope(size_t id, size_t rows, size_t cols);
+    ProfileScope(const ProfileScope &) = delete;
+    ~ProfileScope();
+    ProfileScope &operator=(const ProfileScope &) = delete;
+  private:
+    size_t id;
+    size_t dims;
+    uint64_t bytes;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  struct ProfileCounters
+  {
+    struct Entry
+    {
+      std::atomic< uint64_t > calls{ 0 };
+      std::atomic< uint64_t > nanoseconds{ 0 };
+      std::atomic< uint64_t > bytes{ 0 };
+      std::array< std::atomic< uint64_t >, ProfileStats::buckets > dims{};
+    };
+    static constexpr size_t capacity = 256;
+
+    std::array< Entry, capacity > entries;
+    uint64_t allocated = 0;
+  };
+
+  struct ProfileRegistry
+  {
+    std::mutex mutex;
+    std::array< std::string, ProfileCounters::capacity > names;
+    size_t count = 0;
+    std::vector< std::shared_ptr< ProfileCounters > > threads;
+    std::atomic< int > marker_fd{ -1 };
+  };
+
+  ProfileRegistry &profileRegistry();
+  ProfileCounters &profileCounters();
+  size_t profileRegister(const char *name);
+  void profileAllocated(size_t bytes) noexcept;
+  std::vector< ProfileStats > profileSnapshot();
+  void profileReset();
+  std::ostream &profileJson(std::ostream &out);
+  bool profileMarkers(const std::string &path = "/sys/kernel/tracing/trace_marker");
+  void profileMarkersOff();
+}
+
+inline abramov::ProfileRegistry &abramov::profileRegistry()
+{
+  static ProfileRegistry registry;
+  return registry;
+}
+
+inline abramov::ProfileCounters &abramov::profileCounters()
+{
+  thread_local std::shared_ptr< ProfileCounters > counters = []()
+  {
+    auto res = std::make_shared< ProfileCounters >();
+    ProfileRegistry &registry = profileRegistry();
+    std::lock_guard< std::mutex > lock(registry.mutex);
+    registry.threads.push_back(res);
+    return res;
+  }();
+  return *counters;
+}
+
+namespace abramov
+{
+  inline void profileMarker(const std::string &text) noexcept
+  {
+    int fd = profileRegistry().marker_fd.load(std::memory_order_relaxed);
+    if (fd >= 0)
+    {
+      ssize_t written = ::write(fd, text.data(), text.size());
+      (void) written;
+    }
+  }
+
+  inline void profileAdd(std::atomic< uint64_t > &counter, uint64_t value) noexcept
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+}
+
+inline abramov::ProfileScope::ProfileScope(size_t op, size_t rows, size_t cols):
+  id(op),
+  dims(std::bit_width(rows > cols ? rows : cols)),
+  bytes(profileCounters().allocated),
+  start(std::chrono::steady_clock::now())
+{
+  if (id < ProfileCounters::capacity && profileRegistry().marker_fd.load(std::memory_order_relaxed) >= 0)
+  {
+    profileMarker("B|" + std::to_string(::getpid()) + "|" + profileRegistry().names[id] + " " + std::to_string(rows)
+      + "x" + std::to_string(cols) + "\n");
+  }
+}
+
+inline abramov::ProfileScope::~ProfileScope()
+{
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  if (id >= ProfileCounters::capacity)
+  {
+    return;
+  }
+  ProfileCounters &counters = profileCounters();
+  ProfileCounters::Entry &entry = counters.entries[id];
+  profileAdd(entry.calls, 1);
+  profileAdd(entry.nanoseconds, std::chrono::duration_cast< std::chrono::nanoseconds >(elapsed).count());
+  profileAdd(entry.bytes, counters.allocated - bytes);
+  profileAdd(entry.dims[dims < ProfileStats::buckets ? dims : ProfileStats::buckets - 1], 1);
+  if (profileRegistry().marker_fd.load(std::memory_order_relaxed) >= 0)
+  {
+    profileMarker("E|" + std::to_string(::getpid()) + "\n");
+  }
+}
+
+inline size_t abramov::profileRegister(const char *name)
+{
+  ProfileRegistry &registry = profileRegistry();
+  std::lock_guard< std::mutex > lock(registry.mutex);
+  for (size_t i = 0; i < registry.count; ++i)
+  {
+    if (registry.names[i] == name)
+    {
+      return i;
+    }
+  }
+  if (registry.count == ProfileCounters::capacity)
+  {
+    return ProfileCounters::capacity;
+  }
+  registry.names[registry.count] = name;
+  return registry.count++;
+}
+
+inline void abramov::profileAllocated(size_t bytes) noexcept
+{
+  profileCounters().allocated += bytes;
+}
+
+inline std::vector< abramov::ProfileStats > abramov::profileSnapshot()
+{
+  ProfileRegistry &registry = profileRegistry();
+  std::lock_guard< std::mutex > lock(registry.mutex);
+  size_t ops = registry.count;
+  std::vector< ProfileStats > res(ops);
+  for (size_t i = 0; i < ops; ++i)
+  {
+    res[i].name = registry.names[i];
+  }
+  for (const auto &thread : registry.threads)
+  {
+    for (size_t i = 0; i < ops; ++i)
+    {
+      const ProfileCounters::Entry &entry = thread->entries[i];
+      res[i].calls += entry.calls.load(std::memory_order_relaxed);
+      res[i].nanoseconds += entry.nanoseconds.load(std::memory_order_relaxed);
+      res[i].bytes += entry.bytes.load(std::memory_order_relaxed);
+      for (size_t b = 0; b < ProfileStats::buckets; ++b)
+      {
+        res[i].dims[b] += entry.dims[b].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  return res;
+}
+
+inline void abramov::profileReset()
+{
+  ProfileRegistry &registry = profileRegistry();
+  std::lock_guard< std::mutex > lock(registry.mutex);
+  for (const auto &thread : registry.threads)
+  {
+    for (auto &entry : thread->entries)
+    {
+      entry.calls = 0;
+      entry.nanoseconds = 0;
+      entry.bytes = 0;
+      for (auto &bucket : entry.dims)
+      {
+        bucket = 0;
+      }
+    }
+  }
+}
+
+inline std::ostream &abramov::profileJson(std::ostream &out)
+{
+  std::vector< ProfileStats > stats = profileSnapshot();
+  out << "[";
+  bool first = true;
+  for (const ProfileStats &s : stats)
+  {
+    if (!s.calls)
+    {
+      continue;
+    }
+    out << (first ? "\n" : ",\n") << "  { \"op\": \"" << s.name << "\", \"calls\": " << s.calls
+      << ", \"nanoseconds\": " << s.nanoseconds << ", \"bytes_allocated\": " << s.bytes << ", \"dims\": {";
+    bool first_bucket = true;
+    for (size_t b = 0; b < ProfileStats::buckets; ++b)
+    {
+      if (s.dims[b])
+      {
+        uint64_t upper = b ? (uint64_t(1) << b) - 1 : 0;
+        out << (first_bucket ? " " : ", ") << "\"<=" << upper << "\": " << s.dims[b];
+        first_bucket = false;
+      }
+    }
+    out << (first_bucket ? "} }" : " } }");
+    first = false;
+  }
+  out << (first ? "]\n" : "\n]\n");
+  return out;
+}
+
+inline bool abramov::profileMarkers(const std::string &path)
+{
+  int fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+  if (fd < 0)
+  {
+    return false;
+  }
+  int old = profileRegistry().marker_fd.exchange(fd);
+  if (old >= 0)
+  {
+    ::close(old);
+  }
+  return true;
+}
+
+inline void abramov::profileMarkersOff()
+{
+  int old = profileRegistry().marker_fd.exchange(-1);
+  if (old >= 0)
+  {
+    ::close(old);
+  }
+}
+#endif
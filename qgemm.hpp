@@ -0,0 +1,433 @@
+#ifndef QGEMM_HPP
+#define QGEMM_HPP
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "matrix.hpp"
+#include "threadpool.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ABRAMOV_QGEMM_X86 1
+#endif
+
+namespace abramov
+{
+  template< class T >
+  concept Narrow = std::same_as< T, int8_t > || std::same_as< T, uint8_t > || std::same_as< T, int16_t >;
+  template< class T >
+  concept Accumulator = std::same_as< T, int32_t > || std::same_as< T, int64_t >;
+
+  enum class GemmKernel
+  {
+    Auto,
+    Portable,
+    Avx2,
+    AvxVnni
+  };
+
+  struct PackedLhs
+  {
+    template< Narrow T, class P >
+    explicit PackedLhs(const Matrix< T, P > &lhs);
+    size_t getRows() const noexcept;
+    size_t getInner() const noexcept;
+    int32_t bound() const noexcept;
+    const int16_t *row(size_t i) const noexcept;
+  private:
+    size_t rows;
+    size_t inner;
+    size_t stride;
+    int32_t maxAbs;
+    std::vector< int16_t > data;
+  };
+
+  struct PackedRhs
+  {
+    static constexpr size_t width = 16;
+
+    template< Narrow T, class P >
+    explicit PackedRhs(const Matrix< T, P > &rhs);
+    size_t getInner() const noexcept;
+    size_t getCols() const noexcept;
+    size_t pairs() const noexcept;
+    size_t blocks() const noexcept;
+    int32_t bound() const noexcept;
+    const int16_t *panel(size_t block) const noexcept;
+  private:
+    size_t inner;
+    size_t cols;
+    int32_t maxAbs;
+    std::vector< int16_t > data;
+  };
+
+  bool gemmSupported(GemmKernel kernel) noexcept;
+  template< Accumulator Acc = int32_t >
+  Matrix< Acc > qgemm(const PackedLhs &lhs, const PackedRhs &rhs, GemmKernel kernel = GemmKernel::Auto,
+    size_t threads = 1);
+  template< Accumulator Acc = int32_t, Narrow A, class PA, Narrow B, class PB >
+  Matrix< Acc > qgemm(const Matrix< A, PA > &lhs, const Matrix< B, PB > &rhs, GemmKernel kernel = GemmKernel::Auto,
+    size_t threads = 1);
+
+  using GemmTile = void (*)(const int16_t *const *a, const int16_t *panel, size_t p0, size_t p1, int32_t *out);
+  template< size_t R >
+  void gemmTilePortable(const int16_t *const *a, const int16_t *panel, size_t p0, size_t p1, int32_t *out);
+#ifdef ABRAMOV_QGEMM_X86
+  template< size_t R >
+  __attribute__((target("avx2"))) void gemmTileAvx2(const int16_t *const *a, const int16_t *panel, size_t p0,
+    size_t p1, int32_t *out);
+  template< size_t R >
+  __attribute__((target("avx2,avxvnni"))) void gemmTileVnni(const int16_t *const *a, const int16_t *panel, size_t p0,
+    size_t p1, int32_t *out);
+#endif
+  template< Accumulator Acc >
+  void gemmRows(const PackedLhs &lhs, const PackedRhs &rhs, Matrix< Acc > &res, size_t lo, size_t hi, size_t span,
+    GemmTile tile4, GemmTile tile1);
+  template< Accumulator Acc >
+  void gemmRowsWide(const PackedLhs &lhs, const PackedRhs &rhs, Matrix< Acc > &res, size_t lo, size_t hi);
+}
+
+template< abramov::Narrow T, class P >
+abramov::PackedLhs::PackedLhs(const Matrix< T, P > &lhs):
+  rows(lhs.getRows()),
+  inner(lhs.getCols()),
+  stride(inner + inner % 2),
+  maxAbs(0),
+  data(rows * stride, 0)
+{
+  for (size_t i = 0; i < rows; ++i)
+  {
+    for (size_t k = 0; k < inner; ++k)
+    {
+      int32_t v = lhs[i][k];
+      maxAbs = std::max(maxAbs, v < 0 ? -v : v);
+      data[i * stride + k] = static_cast< int16_t >(v);
+    }
+  }
+}
+
+inline size_t abramov::PackedLhs::getRows() const noexcept
+{
+  return rows;
+}
+
+inline size_t abramov::PackedLhs::getInner() const noexcept
+{
+  return inner;
+}
+
+inline int32_t abramov::PackedLhs::bound() const noexcept
+{
+  return maxAbs;
+}
+
+inline const int16_t *abramov::PackedLhs::row(size_t i) const noexcept
+{
+  return data.data() + i * stride;
+}
+
+template< abramov::Narrow T, class P >
+abramov::PackedRhs::PackedRhs(const Matrix< T, P > &rhs):
+  inner(rhs.getRows()),
+  cols(rhs.getCols()),
+  maxAbs(0),
+  data(blocks() * pairs() * 2 * width, 0)
+{
+  for (size_t k = 0; k < inner; ++k)
+  {
+    for (size_t j = 0; j < cols; ++j)
+    {
+      int32_t v = rhs[k][j];
+      maxAbs = std::max(maxAbs, v < 0 ? -v : v);
+      data[((j / width) * pairs() + k / 2) * 2 * width + (j % width) * 2 + k % 2] = static_cast< int16_t >(v);
+    }
+  }
+}
+
+inline size_t abramov::PackedRhs::getInner() const noexcept
+{
+  return inner;
+}
+
+inline size_t abramov::PackedRhs::getCols() const noexcept
+{
+  return cols;
+}
+
+inline size_t abramov::PackedRhs::pairs() const noexcept
+{
+  return (inner + 1) / 2;
+}
+
+inline size_t abramov::PackedRhs::blocks() const noexcept
+{
+  return (cols + width - 1) / width;
+}
+
+inline int32_t abramov::PackedRhs::bound() const noexcept
+{
+  return maxAbs;
+}
+
+inline const int16_t *abramov::PackedRhs::panel(size_t block) const noexcept
+{
+  return data.data() + block * pairs() * 2 * width;
+}
+
+inline bool abramov::gemmSupported(GemmKernel kernel) noexcept
+{
+#ifdef ABRAMOV_QGEMM_X86
+  if (kernel == GemmKernel::Avx2)
+  {
+    return __builtin_cpu_supports("avx2");
+  }
+  if (kernel == GemmKernel::AvxVnni)
+  {
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("avxvnni");
+  }
+  return true;
+#else
+  return kernel == GemmKernel::Auto || kernel == GemmKernel::Portable;
+#endif
+}
+
+template< abramov::Accumulator Acc >
+abramov::Matrix< Acc > abramov::qgemm(const PackedLhs &lhs, const PackedRhs &rhs, GemmKernel kernel, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("qgemm", lhs.getRows(), rhs.getCols());
+  if (lhs.getInner() != rhs.getInner())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  if (!gemmSupported(kernel))
+  {
+    throw std::runtime_error("GEMM kernel is not supported by this processor\n");
+  }
+  if (kernel == GemmKernel::Auto)
+  {
+    kernel = gemmSupported(GemmKernel::AvxVnni) ? GemmKernel::AvxVnni :
+      gemmSupported(GemmKernel::Avx2) ? GemmKernel::Avx2 : GemmKernel::Portable;
+  }
+  GemmTile tile4 = gemmTilePortable< 4 >;
+  GemmTile tile1 = gemmTilePortable< 1 >;
+#ifdef ABRAMOV_QGEMM_X86
+  if (kernel == GemmKernel::Avx2)
+  {
+    tile4 = gemmTileAvx2< 4 >;
+    tile1 = gemmTileAvx2< 1 >;
+  }
+  else if (kernel == GemmKernel::AvxVnni)
+  {
+    tile4 = gemmTileVnni< 4 >;
+    tile1 = gemmTileVnni< 1 >;
+  }
+#endif
+  size_t span = rhs.pairs();
+  int64_t pair = 2 * static_cast< int64_t >(lhs.bound()) * rhs.bound();
+  if constexpr (std::is_same_v< Acc, int64_t >)
+  {
+    if (pair)
+    {
+      span = static_cast< size_t >(std::numeric_limits< int32_t >::max() / pair);
+    }
+  }
+  Matrix< Acc > res(lhs.getRows(), rhs.getCols(), 0);
+  size_t tiles = (lhs.getRows() + 3) / 4;
+  parallelFor(0, tiles, [&](size_t lo, size_t hi)
+  {
+    hi = std::min(hi * 4, lhs.getRows());
+    if (span)
+    {
+      gemmRows(lhs, rhs, res, lo * 4, hi, span, tile4, tile1);
+    }
+    else
+    {
+      gemmRowsWide(lhs, rhs, res, lo * 4, hi);
+    }
+  }, threads);
+  return res;
+}
+
+template< abramov::Accumulator Acc, abramov::Narrow A, class PA, abramov::Narrow B, class PB >
+abramov::Matrix< Acc > abramov::qgemm(const Matrix< A, PA > &lhs, const Matrix< B, PB > &rhs, GemmKernel kernel,
+  size_t threads)
+{
+  if (lhs.getCols() != rhs.getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  return qgemm< Acc >(PackedLhs(lhs), PackedRhs(rhs), kernel, threads);
+}
+
+template< size_t R >
+void abramov::gemmTilePortable(const int16_t *const *a, const int16_t *panel, size_t p0, size_t p1, int32_t *out)
+{
+  constexpr size_t width = PackedRhs::width;
+  uint32_t acc[R][width] = {};
+  for (size_t p = p0; p < p1; ++p)
+  {
+    const int16_t *b = panel + p * 2 * width;
+    for (size_t r = 0; r < R; ++r)
+    {
+      int32_t a0 = a[r][2 * p];
+      int32_t a1 = a[r][2 * p + 1];
+      for (size_t c = 0; c < width; ++c)
+      {
+        acc[r][c] += static_cast< uint32_t >(a0 * b[2 * c]) + static_cast< uint32_t >(a1 * b[2 * c + 1]);
+      }
+    }
+  }
+  for (size_t r = 0; r < R; ++r)
+  {
+    for (size_t c = 0; c < width; ++c)
+    {
+      out[r * width + c] = static_cast< int32_t >(acc[r][c]);
+    }
+  }
+}
+
+#ifdef ABRAMOV_QGEMM_X86
+template< size_t R >
+void abramov::gemmTileAvx2(const int16_t *const *a, const int16_t *panel, size_t p0, size_t p1, int32_t *out)
+{
+  constexpr size_t width = PackedRhs::width;
+  __m256i lo[R];
+  __m256i hi[R];
+  for (size_t r = 0; r < R; ++r)
+  {
+    lo[r] = _mm256_setzero_si256();
+    hi[r] = _mm256_setzero_si256();
+  }
+  for (size_t p = p0; p < p1; ++p)
+  {
+    const int16_t *b = panel + p * 2 * width;
+    __m256i b0 = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(b));
+    __m256i b1 = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(b + width));
+    for (size_t r = 0; r < R; ++r)
+    {
+      int32_t pair = 0;
+      std::memcpy(&pair, a[r] + 2 * p, sizeof(pair));
+      __m256i v = _mm256_set1_epi32(pair);
+      lo[r] = _mm256_add_epi32(lo[r], _mm256_madd_epi16(v, b0));
+      hi[r] = _mm256_add_epi32(hi[r], _mm256_madd_epi16(v, b1));
+    }
+  }
+  for (size_t r = 0; r < R; ++r)
+  {
+    _mm256_storeu_si256(reinterpret_cast< __m256i * >(out + r * width), lo[r]);
+    _mm256_storeu_si256(reinterpret_cast< __m256i * >(out + r * width + width / 2), hi[r]);
+  }
+}
+
+template< size_t R >
+void abramov::gemmTileVnni(const int16_t *const *a, const int16_t *panel, size_t p0, size_t p1, int32_t *out)
+{
+  constexpr size_t width = PackedRhs::width;
+  __m256i lo[R];
+  __m256i hi[R];
+  for (size_t r = 0; r < R; ++r)
+  {
+    lo[r] = _mm256_setzero_si256();
+    hi[r] = _mm256_setzero_si256();
+  }
+  for (size_t p = p0; p < p1; ++p)
+  {
+    const int16_t *b = panel + p * 2 * width;
+    __m256i b0 = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(b));
+    __m256i b1 = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(b + width));
+    for (size_t r = 0; r < R; ++r)
+    {
+      int32_t pair = 0;
+      std::memcpy(&pair, a[r] + 2 * p, sizeof(pair));
+      __m256i v = _mm256_set1_epi32(pair);
+      lo[r] = _mm256_dpwssd_avx_epi32(lo[r], v, b0);
+      hi[r] = _mm256_dpwssd_avx_epi32(hi[r], v, b1);
+    }
+  }
+  for (size_t r = 0; r < R; ++r)
+  {
+    _mm256_storeu_si256(reinterpret_cast< __m256i * >(out + r * width), lo[r]);
+    _mm256_storeu_si256(reinterpret_cast< __m256i * >(out + r * width + width / 2), hi[r]);
+  }
+}
+#endif
+
+template< abramov::Accumulator Acc >
+void abramov::gemmRows(const PackedLhs &lhs, const PackedRhs &rhs, Matrix< Acc > &res, size_t lo, size_t hi,
+  size_t span, GemmTile tile4, GemmTile tile1)
+{
+  constexpr size_t width = PackedRhs::width;
+  constexpr size_t band = 64;
+  int32_t out[4 * width];
+  const int16_t *a[4];
+  for (size_t top = lo; top < hi; top += band)
+  {
+    size_t bottom = std::min(top + band, hi);
+    for (size_t block = 0; block < rhs.blocks(); ++block)
+    {
+      const int16_t *panel = rhs.panel(block);
+      size_t first = block * width;
+      size_t count = std::min(width, rhs.getCols() - first);
+      for (size_t i = top; i < bottom;)
+      {
+        size_t r = bottom - i >= 4 ? 4 : 1;
+        for (size_t t = 0; t < r; ++t)
+        {
+          a[t] = lhs.row(i + t);
+        }
+        for (size_t p0 = 0; p0 < rhs.pairs(); p0 += span)
+        {
+          (r == 4 ? tile4 : tile1)(a, panel, p0, std::min(p0 + span, rhs.pairs()), out);
+          for (size_t t = 0; t < r; ++t)
+          {
+            Acc *dst = res[i + t] + first;
+            for (size_t c = 0; c < count; ++c)
+            {
+              using U = std::make_unsigned_t< Acc >;
+              U part = static_cast< U >(static_cast< Acc >(out[t * width + c]));
+              dst[c] = static_cast< Acc >(static_cast< U >(dst[c]) + part);
+            }
+          }
+        }
+        i += r;
+      }
+    }
+  }
+}
+
+template< abramov::Accumulator Acc >
+void abramov::gemmRowsWide(const PackedLhs &lhs, const PackedRhs &rhs, Matrix< Acc > &res, size_t lo, size_t hi)
+{
+  constexpr size_t width = PackedRhs::width;
+  for (size_t block = 0; block < rhs.blocks(); ++block)
+  {
+    const int16_t *panel = rhs.panel(block);
+    size_t first = block * width;
+    size_t count = std::min(width, rhs.getCols() - first);
+    for (size_t i = lo; i < hi; ++i)
+    {
+      const int16_t *a = lhs.row(i);
+      Acc acc[width] = {};
+      for (size_t p = 0; p < rhs.pairs(); ++p)
+      {
+        const int16_t *b = panel + p * 2 * width;
+        Acc a0 = a[2 * p];
+        Acc a1 = a[2 * p + 1];
+        for (size_t c = 0; c < width; ++c)
+        {
+          acc[c] += a0 * b[2 * c] + a1 * b[2 * c + 1];
+        }
+      }
+      for (size_t c = 0; c < count; ++c)
+      {
+        res[i][first + c] = acc[c];
+      }
+    }
+  }
+}
+#endif
@@ -0,0 +1,327 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "matrix.hpp"
+#include "threadpool.hpp"
+
+namespace abramov
+{
+  struct RandomStream
+  {
+    explicit RandomStream(uint64_t seed, uint64_t stream = 0) noexcept;
+
+    uint64_t next() noexcept;
+    uint64_t below(uint64_t bound) noexcept;
+    bool chance(double probability) noexcept;
+    template< Integral T >
+    T uniform(T low, T high) noexcept;
+  private:
+    uint64_t state;
+  };
+
+  struct PropertyReport
+  {
+    std::string name;
+    size_t cases = 0;
+    size_t failures = 0;
+    size_t first = 0;
+    uint64_t seed = 0;
+    std::string message;
+
+    bool passed() const noexcept;
+    std::string toString() const;
+  };
+
+  uint64_t mixSeed(uint64_t seed, uint64_t stream) noexcept;
+  template< Integral T, class P = Wrapping >
+  Matrix< T, P > randomMatrix(size_t m, size_t n, uint64_t seed, T low, T high, size_t threads = 0);
+  template< Integral T, class P = Wrapping >
+  Matrix< T, P > randomSparse(size_t m, size_t n, double density, uint64_t seed, T low, T high, size_t threads = 0);
+  template< Integral T, class P = Wrapping >
+  Matrix< T, P > randomBanded(size_t n, size_t lower, size_t upper, uint64_t seed, T low, T high, size_t threads = 0);
+  template< Integral T, class P = Wrapping >
+  Matrix< T, P > randomLowRank(size_t m, size_t n, size_t rank, uint64_t seed, T low, T high, size_t threads = 0);
+  template< Integral T, class P = Wrapping >
+  Matrix< T, P > randomWithDeterminant(const std::vector< T > &pivots, uint64_t seed, T low, T high,
+    size_t threads = 0);
+  template< class F >
+  PropertyReport checkProperty(const std::string &name, size_t cases, uint64_t seed, F property, size_t threads = 0);
+
+  template< Integral T, class P, class F >
+  Matrix< T, P > generateRows(size_t m, size_t n, uint64_t seed, T low, T high, size_t threads, F fill);
+  template< Integral T, class P >
+  Matrix< T, P > triangularFactor(size_t m, size_t n, bool upper, uint64_t seed, T low, T high, size_t threads);
+  template< Integral T, class P >
+  Matrix< T, P > multiplyFactors(const Matrix< T, P > &lhs, const Matrix< T, P > &rhs, size_t threads);
+}
+
+inline uint64_t abramov::mixSeed(uint64_t seed, uint64_t stream) noexcept
+{
+  uint64_t z = seed ^ (stream * 0x9e3779b97f4a7c15ULL + 0x632be59bd9b4e019ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+inline abramov::RandomStream::RandomStream(uint64_t seed, uint64_t stream) noexcept:
+  state(mixSeed(seed, stream))
+{}
+
+inline uint64_t abramov::RandomStream::next() noexcept
+{
+  uint64_t z = state += 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+inline uint64_t abramov::RandomStream::below(uint64_t bound) noexcept
+{
+  // Multiply-shift without rejection: the bias is at most bound / 2^64 and
+  // keeps every draw a single step, so a row's values never depend on retries
+  if (!bound)
+  {
+    return next();
+  }
+  return static_cast< uint64_t >((static_cast< unsigned __int128 >(next()) * bound) >> 64);
+}
+
+inline bool abramov::RandomStream::chance(double probability) noexcept
+{
+  return static_cast< double >(next() >> 11) * 0x1.0p-53 < probability;
+}
+
+template< abramov::Integral T >
+T abramov::RandomStream::uniform(T low, T high) noexcept
+{
+  uint64_t base = static_cast< uint64_t >(low);
+  return static_cast< T >(base + below(static_cast< uint64_t >(high) - base + 1));
+}
+
+inline bool abramov::PropertyReport::passed() const noexcept
+{
+  return failures == 0;
+}
+
+inline std::string abramov::PropertyReport::toString() const
+{
+  std::string res = name + ": " + std::to_string(cases - failures) + "/" + std::to_string(cases) + " cases passed";
+  if (failures)
+  {
+    res += ", first failure at case " + std::to_string(first) + " (seed " + std::to_string(seed) + ")";
+    if (!message.empty())
+    {
+      res += ": " + message;
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P, class F >
+abramov::Matrix< T, P > abramov::generateRows(size_t m, size_t n, uint64_t seed, T low, T high,
+  size_t threads, F fill)
+{
+  if (low > high)
+  {
+    throw std::invalid_argument("Empty value range\n");
+  }
+  Matrix< T, P > res(m, n, 0);
+  placedParallelFor(m ? res[0] : nullptr, 0, m, [&res, &fill, n, seed, low, high](size_t lo, size_t hi)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      RandomStream stream(seed, i);
+      fill(stream, i, res[i], n, low, high);
+    }
+  }, threads);
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::randomMatrix(size_t m, size_t n, uint64_t seed, T low, T high, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("randomMatrix", m, n);
+  return generateRows< T, P >(m, n, seed, low, high, threads,
+    [](RandomStream &stream, size_t, T *row, size_t count, T lo, T hi)
+  {
+    for (size_t j = 0; j < count; ++j)
+    {
+      row[j] = stream.uniform(lo, hi);
+    }
+  });
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::randomSparse(size_t m, size_t n, double density, uint64_t seed, T low, T high,
+  size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("randomSparse", m, n);
+  if (!(density >= 0.0 && density <= 1.0))
+  {
+    throw std::invalid_argument("Density must lie in [0, 1]\n");
+  }
+  return generateRows< T, P >(m, n, seed, low, high, threads,
+    [density](RandomStream &stream, size_t, T *row, size_t count, T lo, T hi)
+  {
+    for (size_t j = 0; j < count; ++j)
+    {
+      row[j] = stream.chance(density) ? stream.uniform(lo, hi) : T(0);
+    }
+  });
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::randomBanded(size_t n, size_t lower, size_t upper, uint64_t seed, T low, T high,
+  size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("randomBanded", n, n);
+  return generateRows< T, P >(n, n, seed, low, high, threads,
+    [lower, upper](RandomStream &stream, size_t i, T *row, size_t count, T lo, T hi)
+  {
+    size_t first = i > lower ? i - lower : 0;
+    size_t last = std::min(count, i + upper + 1);
+    for (size_t j = first; j < last; ++j)
+    {
+      row[j] = stream.uniform(lo, hi);
+    }
+  });
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::triangularFactor(size_t m, size_t n, bool upper, uint64_t seed, T low,
+  T high, size_t threads)
+{
+  return generateRows< T, P >(m, n, seed, low, high, threads,
+    [upper](RandomStream &stream, size_t i, T *row, size_t count, T lo, T hi)
+  {
+    size_t first = upper ? std::min(i + 1, count) : 0;
+    size_t last = upper ? count : std::min(i, count);
+    for (size_t j = first; j < last; ++j)
+    {
+      row[j] = stream.uniform(lo, hi);
+    }
+    if (i < count)
+    {
+      row[i] = 1;
+    }
+  });
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::multiplyFactors(const Matrix< T, P > &lhs, const Matrix< T, P > &rhs, size_t threads)
+{
+  std::vector< const T * > rows(rhs.getRows());
+  for (size_t k = 0; k < rows.size(); ++k)
+  {
+    rows[k] = rhs[k];
+  }
+  Matrix< T, P > res(lhs.getRows(), rhs.getCols(), 0);
+  placedParallelFor(res.getRows() ? res[0] : nullptr, 0, res.getRows(), [&res, &lhs, &rows](size_t lo, size_t hi)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      multiplyRow< P >(res[i], lhs[i], rows.data(), rows.size(), res.getCols());
+    }
+  }, threads);
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::randomLowRank(size_t m, size_t n, size_t rank, uint64_t seed, T low, T high,
+  size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("randomLowRank", m, n);
+  if (rank > std::min(m, n))
+  {
+    throw std::invalid_argument("Rank exceeds the matrix dimensions\n");
+  }
+  if (!rank)
+  {
+    return Matrix< T, P >(m, n, 0);
+  }
+  // Unit trapezoidal factors keep the rank exactly equal to the requested one:
+  // the leading rank x rank blocks of both are unit triangular
+  Matrix< T, P > left = triangularFactor< T, P >(m, rank, false, mixSeed(seed, 1), low, high, threads);
+  Matrix< T, P > right = triangularFactor< T, P >(rank, n, true, mixSeed(seed, 2), low, high, threads);
+  return multiplyFactors(left, right, threads);
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::randomWithDeterminant(const std::vector< T > &pivots, uint64_t seed, T low, T high,
+  size_t threads)
+{
+  size_t n = pivots.size();
+  ABRAMOV_PROFILE_SCOPE("randomWithDeterminant", n, n);
+  // U * L rather than L * U: the leading minors of the product are not the
+  // pivots, so elimination without row exchanges is not handed the answer
+  Matrix< T, P > upper = triangularFactor< T, P >(n, n, true, mixSeed(seed, 1), low, high, threads);
+  Matrix< T, P > lower = triangularFactor< T, P >(n, n, false, mixSeed(seed, 2), low, high, threads);
+  for (size_t i = 0; i < n; ++i)
+  {
+    upper[i][i] = pivots[i];
+  }
+  return multiplyFactors(upper, lower, threads);
+}
+
+template< class F >
+abramov::PropertyReport abramov::checkProperty(const std::string &name, size_t cases, uint64_t seed, F property,
+  size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("checkProperty", cases, 1);
+  PropertyReport report;
+  report.name = name;
+  report.cases = cases;
+  report.first = cases;
+  std::atomic< size_t > failures{ 0 };
+  std::mutex mutex;
+  parallelFor(0, cases, [&](size_t lo, size_t hi)
+  {
+    for (size_t c = lo; c < hi; ++c)
+    {
+      uint64_t case_seed = mixSeed(seed, c);
+      std::string message;
+      bool ok = false;
+      try
+      {
+        RandomStream stream(case_seed);
+        ok = property(stream);
+      }
+      catch (const std::exception &e)
+      {
+        message = e.what();
+        while (!message.empty() && message.back() == '\n')
+        {
+          message.pop_back();
+        }
+      }
+      catch (...)
+      {
+        message = "unknown exception";
+      }
+      if (ok)
+      {
+        continue;
+      }
+      ++failures;
+      std::lock_guard< std::mutex > lock(mutex);
+      if (c < report.first)
+      {
+        report.first = c;
+        report.seed = case_seed;
+        report.message = std::move(message);
+      }
+    }
+  }, threads);
+  report.failures = failures;
+  return report;
+}
+#endif
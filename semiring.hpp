@@ -0,0 +1,714 @@
+#ifndef SEMIRING_HPP
+#define SEMIRING_HPP
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "matrix.hpp"
+#include "threadpool.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#define ABRAMOV_SEMIRING_X86 1
+#endif
+
+namespace abramov
+{
+  template< Integral T >
+  struct PlusTimes
+  {
+    using value_type = T;
+
+    static constexpr T zero() noexcept;
+    static constexpr T one() noexcept;
+    static T add(T a, T b) noexcept;
+    static T multiply(T a, T b) noexcept;
+    static void accumulate(T *__restrict dst, T a, const T *__restrict b, size_t n) noexcept;
+  };
+
+  template< Integral T >
+  struct OrAnd
+  {
+    using value_type = T;
+
+    static constexpr T zero() noexcept;
+    static constexpr T one() noexcept;
+    static T add(T a, T b) noexcept;
+    static T multiply(T a, T b) noexcept;
+    static void accumulate(T *__restrict dst, T a, const T *__restrict b, size_t n) noexcept;
+  };
+
+  template< Integral T >
+  struct MinPlus
+  {
+    using value_type = T;
+
+    static constexpr T zero() noexcept;
+    static constexpr T one() noexcept;
+    static T add(T a, T b) noexcept;
+    static T multiply(T a, T b) noexcept;
+    static void accumulate(T *__restrict dst, T a, const T *__restrict b, size_t n) noexcept;
+  };
+
+  template< Integral T >
+  struct MaxPlus
+  {
+    using value_type = T;
+
+    static constexpr T zero() noexcept;
+    static constexpr T one() noexcept;
+    static T add(T a, T b) noexcept;
+    static T multiply(T a, T b) noexcept;
+    static void accumulate(T *__restrict dst, T a, const T *__restrict b, size_t n) noexcept;
+  };
+
+  struct BitMatrix
+  {
+    BitMatrix();
+    BitMatrix(size_t m, size_t n);
+    template< Integral T, class P >
+    explicit BitMatrix(const Matrix< T, P > &matrix);
+    size_t getRows() const noexcept;
+    size_t getCols() const noexcept;
+    size_t words() const noexcept;
+    bool get(size_t i, size_t j) const noexcept;
+    void set(size_t i, size_t j, bool value = true) noexcept;
+    uint64_t *row(size_t i) noexcept;
+    const uint64_t *row(size_t i) const noexcept;
+    size_t count() const noexcept;
+    BitMatrix transpose() const;
+    template< Integral T >
+    Matrix< T > toMatrix() const;
+    BitMatrix &operator|=(const BitMatrix &other);
+    bool operator==(const BitMatrix &other) const noexcept;
+  private:
+    size_t rows;
+    size_t cols;
+    size_t stride;
+    std::vector< uint64_t > bits;
+  };
+
+  template< class S, Integral T, class P >
+  Matrix< T, P > semiringMultiply(const Matrix< T, P > &lhs, const Matrix< T, P > &rhs, size_t threads = 0);
+  template< class S, Integral T, class P >
+  Matrix< T, P > semiringPower(const Matrix< T, P > &matrix, size_t k, size_t threads = 0);
+  BitMatrix booleanMultiply(const BitMatrix &lhs, const BitMatrix &rhs, size_t threads = 0);
+  template< Integral T >
+  Matrix< T > countingMultiply(const BitMatrix &lhs, const BitMatrix &rhs, size_t threads = 0);
+  BitMatrix transitiveClosure(const BitMatrix &adjacency, bool reflexive = false, size_t threads = 0);
+  template< Integral T, class P >
+  Matrix< T, P > shortestPaths(const Matrix< T, P > &weights, size_t threads = 0);
+
+  template< class T, class F >
+  void stripes(T *__restrict dst, const T *__restrict b, size_t n, F f);
+  template< class S, class T >
+  void semiringRow(T *dst, const T *lhs, const T *const *rhs, size_t k0, size_t k1, size_t n);
+  template< Integral T >
+  void countRow(const uint64_t *a, const BitMatrix &columns, T *out);
+#ifdef ABRAMOV_SEMIRING_X86
+  template< Integral T >
+  __attribute__((target("popcnt"))) void countRowPopcnt(const uint64_t *a, const BitMatrix &columns, T *out);
+#endif
+}
+
+template< class T, class F >
+void abramov::stripes(T *__restrict dst, const T *__restrict b, size_t n, F f)
+{
+  constexpr size_t width = 16;
+  size_t j = 0;
+  for (; j + width <= n; j += width)
+  {
+    for (size_t l = j; l < j + width; ++l)
+    {
+      dst[l] = f(dst[l], b[l]);
+    }
+  }
+  for (; j < n; ++j)
+  {
+    dst[j] = f(dst[j], b[j]);
+  }
+}
+
+template< abramov::Integral T >
+constexpr T abramov::PlusTimes< T >::zero() noexcept
+{
+  return T(0);
+}
+
+template< abramov::Integral T >
+constexpr T abramov::PlusTimes< T >::one() noexcept
+{
+  return T(1);
+}
+
+template< abramov::Integral T >
+T abramov::PlusTimes< T >::add(T a, T b) noexcept
+{
+  using U = std::make_unsigned_t< T >;
+  return static_cast< T >(static_cast< U >(a) + static_cast< U >(b));
+}
+
+template< abramov::Integral T >
+T abramov::PlusTimes< T >::multiply(T a, T b) noexcept
+{
+  using U = promoted_unsigned_t< T >;
+  return static_cast< T >(static_cast< U >(a) * static_cast< U >(b));
+}
+
+template< abramov::Integral T >
+void abramov::PlusTimes< T >::accumulate(T *__restrict dst, T a, const T *__restrict b, size_t n) noexcept
+{
+  stripes(dst, b, n, [a](T d, T x)
+  {
+    return add(d, multiply(a, x));
+  });
+}
+
+template< abramov::Integral T >
+constexpr T abramov::OrAnd< T >::zero() noexcept
+{
+  return T(0);
+}
+
+template< abramov::Integral T >
+constexpr T abramov::OrAnd< T >::one() noexcept
+{
+  return T(1);
+}
+
+template< abramov::Integral T >
+T abramov::OrAnd< T >::add(T a, T b) noexcept
+{
+  return static_cast< T >(a || b);
+}
+
+template< abramov::Integral T >
+T abramov::OrAnd< T >::multiply(T a, T b) noexcept
+{
+  return static_cast< T >(a && b);
+}
+
+template< abramov::Integral T >
+void abramov::OrAnd< T >::accumulate(T *__restrict dst, T a, const T *__restrict b, size_t n) noexcept
+{
+  if (!a)
+  {
+    return;
+  }
+  stripes(dst, b, n, [](T d, T x)
+  {
+    return static_cast< T >(d | static_cast< T >(x != T(0)));
+  });
+}
+
+template< abramov::Integral T >
+constexpr T abramov::MinPlus< T >::zero() noexcept
+{
+  return std::numeric_limits< T >::max();
+}
+
+template< abramov::Integral T >
+constexpr T abramov::MinPlus< T >::one() noexcept
+{
+  return T(0);
+}
+
+template< abramov::Integral T >
+T abramov::MinPlus< T >::add(T a, T b) noexcept
+{
+  return std::min(a, b);
+}
+
+template< abramov::Integral T >
+T abramov::MinPlus< T >::multiply(T a, T b) noexcept
+{
+  if (a == zero() || b == zero())
+  {
+    return zero();
+  }
+  T res;
+  if (__builtin_add_overflow(a, b, &res))
+  {
+    return a > T(0) ? zero() : std::numeric_limits< T >::lowest();
+  }
+  return res;
+}
+
+template< abramov::Integral T >
+void abramov::MinPlus< T >::accumulate(T *__restrict dst, T a, const T *__restrict b, size_t n) noexcept
+{
+  using U = std::make_unsigned_t< T >;
+  if (a == zero())
+  {
+    return;
+  }
+  if (a > T(0))
+  {
+    stripes(dst, b, n, [a](T d, T x)
+    {
+      T sum = static_cast< T >(static_cast< U >(a) + static_cast< U >(x));
+      return std::min(d, sum < x ? zero() : sum);
+    });
+    return;
+  }
+  stripes(dst, b, n, [a](T d, T x)
+  {
+    T sum = static_cast< T >(static_cast< U >(a) + static_cast< U >(x));
+    T value = sum > x ? std::numeric_limits< T >::lowest() : sum;
+    return std::min(d, x == zero() ? zero() : value);
+  });
+}
+
+template< abramov::Integral T >
+constexpr T abramov::MaxPlus< T >::zero() noexcept
+{
+  return std::numeric_limits< T >::lowest();
+}
+
+template< abramov::Integral T >
+constexpr T abramov::MaxPlus< T >::one() noexcept
+{
+  return T(0);
+}
+
+template< abramov::Integral T >
+T abramov::MaxPlus< T >::add(T a, T b) noexcept
+{
+  return std::max(a, b);
+}
+
+template< abramov::Integral T >
+T abramov::MaxPlus< T >::multiply(T a, T b) noexcept
+{
+  if (a == zero() || b == zero())
+  {
+    return zero();
+  }
+  T res;
+  if (__builtin_add_overflow(a, b, &res))
+  {
+    return a > T(0) ? std::numeric_limits< T >::max() : zero();
+  }
+  return res;
+}
+
+template< abramov::Integral T >
+void abramov::MaxPlus< T >::accumulate(T *__restrict dst, T a, const T *__restrict b, size_t n) noexcept
+{
+  using U = std::make_unsigned_t< T >;
+  if (a == zero())
+  {
+    return;
+  }
+  if (a < T(0))
+  {
+    stripes(dst, b, n, [a](T d, T x)
+    {
+      T sum = static_cast< T >(static_cast< U >(a) + static_cast< U >(x));
+      return std::max(d, sum > x ? zero() : sum);
+    });
+    return;
+  }
+  stripes(dst, b, n, [a](T d, T x)
+  {
+    T sum = static_cast< T >(static_cast< U >(a) + static_cast< U >(x));
+    T value = sum < x ? std::numeric_limits< T >::max() : sum;
+    return std::max(d, x == zero() ? zero() : value);
+  });
+}
+
+inline abramov::BitMatrix::BitMatrix():
+  BitMatrix(0, 0)
+{}
+
+inline abramov::BitMatrix::BitMatrix(size_t m, size_t n):
+  rows(m),
+  cols(n),
+  stride((n + 63) / 64),
+  bits(m * stride, 0)
+{}
+
+template< abramov::Integral T, class P >
+abramov::BitMatrix::BitMatrix(const Matrix< T, P > &matrix):
+  BitMatrix(matrix.getRows(), matrix.getCols())
+{
+  for (size_t i = 0; i < rows; ++i)
+  {
+    uint64_t *dst = row(i);
+    for (size_t j = 0; j < cols; ++j)
+    {
+      dst[j / 64] |= static_cast< uint64_t >(matrix[i][j] != T(0)) << (j % 64);
+    }
+  }
+}
+
+inline size_t abramov::BitMatrix::getRows() const noexcept
+{
+  return rows;
+}
+
+inline size_t abramov::BitMatrix::getCols() const noexcept
+{
+  return cols;
+}
+
+inline size_t abramov::BitMatrix::words() const noexcept
+{
+  return stride;
+}
+
+inline bool abramov::BitMatrix::get(size_t i, size_t j) const noexcept
+{
+  return (row(i)[j / 64] >> (j % 64)) & 1;
+}
+
+inline void abramov::BitMatrix::set(size_t i, size_t j, bool value) noexcept
+{
+  uint64_t mask = uint64_t(1) << (j % 64);
+  uint64_t &word = row(i)[j / 64];
+  word = value ? word | mask : word & ~mask;
+}
+
+inline uint64_t *abramov::BitMatrix::row(size_t i) noexcept
+{
+  return bits.data() + i * stride;
+}
+
+inline const uint64_t *abramov::BitMatrix::row(size_t i) const noexcept
+{
+  return bits.data() + i * stride;
+}
+
+inline size_t abramov::BitMatrix::count() const noexcept
+{
+  size_t res = 0;
+  for (uint64_t word : bits)
+  {
+    res += std::popcount(word);
+  }
+  return res;
+}
+
+inline abramov::BitMatrix abramov::BitMatrix::transpose() const
+{
+  BitMatrix res(cols, rows);
+  for (size_t i = 0; i < rows; ++i)
+  {
+    const uint64_t *src = row(i);
+    for (size_t w = 0; w < stride; ++w)
+    {
+      for (uint64_t word = src[w]; word; word &= word - 1)
+      {
+        res.set(w * 64 + std::countr_zero(word), i);
+      }
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T >
+abramov::Matrix< T > abramov::BitMatrix::toMatrix() const
+{
+  Matrix< T > res(rows, cols, 0);
+  for (size_t i = 0; i < rows; ++i)
+  {
+    for (size_t j = 0; j < cols; ++j)
+    {
+      res[i][j] = static_cast< T >(get(i, j));
+    }
+  }
+  return res;
+}
+
+inline abramov::BitMatrix &abramov::BitMatrix::operator|=(const BitMatrix &other)
+{
+  if (rows != other.rows || cols != other.cols)
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  for (size_t w = 0; w < bits.size(); ++w)
+  {
+    bits[w] |= other.bits[w];
+  }
+  return *this;
+}
+
+inline bool abramov::BitMatrix::operator==(const BitMatrix &other) const noexcept
+{
+  return rows == other.rows && cols == other.cols && bits == other.bits;
+}
+
+template< class S, class T >
+void abramov::semiringRow(T *dst, const T *lhs, const T *const *rhs, size_t k0, size_t k1, size_t n)
+{
+  for (size_t k = k0; k < k1; ++k)
+  {
+    S::accumulate(dst, lhs[k], rhs[k], n);
+  }
+}
+
+template< class S, abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::semiringMultiply(const Matrix< T, P > &lhs, const Matrix< T, P > &rhs,
+  size_t threads)
+{
+  static_assert(std::is_same_v< typename S::value_type, T >, "Semiring must match the matrix element type");
+  ABRAMOV_PROFILE_SCOPE("semiringMultiply", lhs.getRows(), rhs.getCols());
+  if (lhs.getCols() != rhs.getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  if constexpr (std::is_same_v< S, PlusTimes< T > >)
+  {
+    return lhs * rhs;
+  }
+  else
+  {
+    constexpr size_t block = 128;
+    size_t m = lhs.getRows();
+    size_t inner = lhs.getCols();
+    size_t n = rhs.getCols();
+    Matrix< T, P > res(m, n, 0);
+    std::vector< const T * > rows(inner);
+    for (size_t k = 0; k < inner; ++k)
+    {
+      rows[k] = rhs[k];
+    }
+    parallelFor(0, m, [&](size_t lo, size_t hi)
+    {
+      for (size_t i = lo; i < hi; ++i)
+      {
+        std::fill(res[i], res[i] + n, S::zero());
+      }
+      for (size_t k0 = 0; k0 < inner; k0 += block)
+      {
+        size_t k1 = std::min(inner, k0 + block);
+        for (size_t i = lo; i < hi; ++i)
+        {
+          semiringRow< S >(res[i], lhs[i], rows.data(), k0, k1, n);
+        }
+      }
+    }, threads);
+    return res;
+  }
+}
+
+template< class S, abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::semiringPower(const Matrix< T, P > &matrix, size_t k, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("semiringPower", matrix.getRows(), matrix.getCols());
+  size_t n = matrix.getRows();
+  if (n != matrix.getCols())
+  {
+    throw std::logic_error("Matrix must be square\n");
+  }
+  Matrix< T, P > res(n, n, 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      res[i][j] = i == j ? S::one() : S::zero();
+    }
+  }
+  Matrix< T, P > base = matrix;
+  for (; k; k >>= 1)
+  {
+    if (k & 1)
+    {
+      res = semiringMultiply< S >(res, base, threads);
+    }
+    if (k > 1)
+    {
+      base = semiringMultiply< S >(base, base, threads);
+    }
+  }
+  return res;
+}
+
+inline abramov::BitMatrix abramov::booleanMultiply(const BitMatrix &lhs, const BitMatrix &rhs, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("booleanMultiply", lhs.getRows(), rhs.getCols());
+  if (lhs.getCols() != rhs.getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  size_t m = lhs.getRows();
+  size_t inner = lhs.getCols();
+  size_t w = rhs.words();
+  BitMatrix res(m, rhs.getCols());
+  if (!m || !inner || !w)
+  {
+    return res;
+  }
+  std::vector< uint64_t > tables(8 * 256 * w, 0);
+  for (size_t word = 0; word < lhs.words(); ++word)
+  {
+    size_t groups = std::min< size_t >(8, (inner - word * 64 + 7) / 8);
+    parallelFor(0, groups, [&](size_t lo, size_t hi)
+    {
+      for (size_t g = lo; g < hi; ++g)
+      {
+        size_t k0 = word * 64 + g * 8;
+        size_t span = std::min< size_t >(8, inner - k0);
+        uint64_t *table = tables.data() + g * 256 * w;
+        for (size_t mask = 1; mask < (size_t(1) << span); ++mask)
+        {
+          const uint64_t *prev = table + (mask & (mask - 1)) * w;
+          const uint64_t *add = rhs.row(k0 + std::countr_zero(mask));
+          uint64_t *dst = table + mask * w;
+          for (size_t c = 0; c < w; ++c)
+          {
+            dst[c] = prev[c] | add[c];
+          }
+        }
+      }
+    }, threads);
+    parallelFor(0, m, [&](size_t lo, size_t hi)
+    {
+      for (size_t i = lo; i < hi; ++i)
+      {
+        uint64_t bitsRow = lhs.row(i)[word];
+        uint64_t *dst = res.row(i);
+        for (size_t g = 0; bitsRow; ++g, bitsRow >>= 8)
+        {
+          size_t mask = bitsRow & 0xff;
+          if (!mask)
+          {
+            continue;
+          }
+          const uint64_t *src = tables.data() + (g * 256 + mask) * w;
+          for (size_t c = 0; c < w; ++c)
+          {
+            dst[c] |= src[c];
+          }
+        }
+      }
+    }, threads);
+  }
+  return res;
+}
+
+template< abramov::Integral T >
+void abramov::countRow(const uint64_t *a, const BitMatrix &columns, T *out)
+{
+  size_t w = columns.words();
+  for (size_t j = 0; j < columns.getRows(); ++j)
+  {
+    const uint64_t *b = columns.row(j);
+    size_t sum = 0;
+    for (size_t c = 0; c < w; ++c)
+    {
+      sum += std::popcount(a[c] & b[c]);
+    }
+    out[j] = static_cast< T >(sum);
+  }
+}
+
+#ifdef ABRAMOV_SEMIRING_X86
+template< abramov::Integral T >
+__attribute__((target("popcnt"))) void abramov::countRowPopcnt(const uint64_t *a, const BitMatrix &columns, T *out)
+{
+  size_t w = columns.words();
+  for (size_t j = 0; j < columns.getRows(); ++j)
+  {
+    const uint64_t *b = columns.row(j);
+    size_t sum = 0;
+    for (size_t c = 0; c < w; ++c)
+    {
+      sum += __builtin_popcountll(a[c] & b[c]);
+    }
+    out[j] = static_cast< T >(sum);
+  }
+}
+#endif
+
+template< abramov::Integral T >
+abramov::Matrix< T > abramov::countingMultiply(const BitMatrix &lhs, const BitMatrix &rhs, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("countingMultiply", lhs.getRows(), rhs.getCols());
+  if (lhs.getCols() != rhs.getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  BitMatrix columns = rhs.transpose();
+  Matrix< T > res(lhs.getRows(), rhs.getCols(), 0);
+  auto row = countRow< T >;
+#ifdef ABRAMOV_SEMIRING_X86
+  if (__builtin_cpu_supports("popcnt"))
+  {
+    row = countRowPopcnt< T >;
+  }
+#endif
+  placedParallelFor(res.getRows() ? res[0] : nullptr, 0, res.getRows(), [&](size_t lo, size_t hi)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      row(lhs.row(i), columns, res[i]);
+    }
+  }, threads);
+  return res;
+}
+
+inline abramov::BitMatrix abramov::transitiveClosure(const BitMatrix &adjacency, bool reflexive, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("transitiveClosure", adjacency.getRows(), adjacency.getCols());
+  size_t n = adjacency.getRows();
+  if (n != adjacency.getCols())
+  {
+    throw std::logic_error("Matrix must be square\n");
+  }
+  BitMatrix reach = adjacency;
+  if (reflexive)
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      reach.set(i, i);
+    }
+  }
+  for (size_t length = 1; length < n; length *= 2)
+  {
+    BitMatrix next = booleanMultiply(reach, reach, threads);
+    next |= reach;
+    if (next == reach)
+    {
+      break;
+    }
+    reach = std::move(next);
+  }
+  return reach;
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::shortestPaths(const Matrix< T, P > &weights, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("shortestPaths", weights.getRows(), weights.getCols());
+  size_t n = weights.getRows();
+  if (n != weights.getCols())
+  {
+    throw std::logic_error("Matrix must be square\n");
+  }
+  Matrix< T, P > dist = weights;
+  for (size_t i = 0; i < n; ++i)
+  {
+    dist[i][i] = std::min(dist[i][i], T(0));
+  }
+  for (size_t length = 1; length < n; length *= 2)
+  {
+    Matrix< T, P > next = semiringMultiply< MinPlus< T > >(dist, dist, threads);
+    if (next == dist)
+    {
+      break;
+    }
+    dist = std::move(next);
+  }
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (dist[i][i] < T(0))
+    {
+      throw std::logic_error("Graph has a negative cycle\n");
+    }
+  }
+  return dist;
+}
+#endif
@@ -0,0 +1,498 @@
+#ifndef STORAGE_HPP
+#define STORAGE_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+#include "numa.hpp"
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace abramov
+{
+  enum class Placement
+  {
+    Local,
+    Interleave,
+    RowBlocks
+  };
+
+  enum class HugePages
+  {
+    Off,
+    Transparent,
+    Explicit
+  };
+
+  struct StorageHeader
+  {
+    size_t mapped;
+    Placement placement;
+    HugePages huge;
+  };
+
+  struct HugePageStats
+  {
+    size_t explicitBytes;
+    size_t transparentBytes;
+    size_t fallbackBytes;
+    size_t mappings;
+    size_t reusedBytes;
+  };
+
+  struct HugePageCache
+  {
+    std::mutex lock;
+    std::vector< std::pair< char *, size_t > > mappings;
+  };
+
+  void setPlacement(Placement placement, size_t threshold = size_t(1) << 20);
+  Placement placement() noexcept;
+  size_t placementThreshold() noexcept;
+  Placement placementOf(const void *block) noexcept;
+  void setHugePages(HugePages mode, size_t threshold = size_t(2) << 20);
+  HugePages hugePages() noexcept;
+  size_t hugePageThreshold() noexcept;
+  HugePages hugePagesOf(const void *block) noexcept;
+  size_t hugePageSize();
+  bool transparentHugePagesAvailable();
+  HugePageStats hugePageStats() noexcept;
+  void resetHugePageStats() noexcept;
+  size_t hugePageBytes(const void *addr);
+  void trimHugePages() noexcept;
+  void *allocateRows(size_t rows, size_t rowBytes);
+  void releaseRows(void *block) noexcept;
+  std::atomic< Placement > &placementSetting() noexcept;
+  std::atomic< size_t > &thresholdSetting() noexcept;
+  std::atomic< HugePages > &hugePageSetting() noexcept;
+  std::atomic< size_t > &hugePageThresholdSetting() noexcept;
+  std::atomic< size_t > *hugePageCounters() noexcept;
+  HugePageCache &hugePageCache() noexcept;
+  char *mapRows(size_t bytes, HugePages &mode, size_t &mapped) noexcept;
+  void placeRows(char *base, size_t mapped, size_t rows, size_t rowBytes, Placement placement) noexcept;
+  template< class F >
+  void placedParallelFor(const void *block, size_t begin, size_t end, F f, size_t threads = 0);
+}
+
+inline std::atomic< abramov::Placement > &abramov::placementSetting() noexcept
+{
+  static std::atomic< Placement > setting{ Placement::Local };
+  return setting;
+}
+
+inline std::atomic< size_t > &abramov::thresholdSetting() noexcept
+{
+  static std::atomic< size_t > setting{ size_t(1) << 20 };
+  return setting;
+}
+
+inline void abramov::setPlacement(Placement placement, size_t threshold)
+{
+  placementSetting() = placement;
+  thresholdSetting() = threshold;
+}
+
+inline abramov::Placement abramov::placement() noexcept
+{
+  return placementSetting();
+}
+
+inline size_t abramov::placementThreshold() noexcept
+{
+  return thresholdSetting();
+}
+
+inline abramov::Placement abramov::placementOf(const void *block) noexcept
+{
+  if (!block)
+  {
+    return Placement::Local;
+  }
+  const StorageHeader *header = reinterpret_cast< const StorageHeader * >(static_cast< const char * >(block) - 64);
+  return header->placement;
+}
+
+template< class F >
+void abramov::placedParallelFor(const void *block, size_t begin, size_t end, F f, size_t threads)
+{
+  // Rows placed across nodes are written by the pool pinned to each node:
+  // numaParallelFor splits [begin, end) with the same nodeBegin as placeRows
+  if (threads != 1 && numaNodes() > 1 && placementOf(block) != Placement::Local)
+  {
+    numaParallelFor(begin, end, f);
+    return;
+  }
+  parallelFor(begin, end, f, threads);
+}
+
+inline std::atomic< abramov::HugePages > &abramov::hugePageSetting() noexcept
+{
+  static std::atomic< HugePages > setting{ HugePages::Off };
+  return setting;
+}
+
+inline std::atomic< size_t > &abramov::hugePageThresholdSetting() noexcept
+{
+  static std::atomic< size_t > setting{ size_t(2) << 20 };
+  return setting;
+}
+
+inline std::atomic< size_t > *abramov::hugePageCounters() noexcept
+{
+  static std::atomic< size_t > counters[5] = {};
+  return counters;
+}
+
+inline abramov::HugePageCache &abramov::hugePageCache() noexcept
+{
+  static HugePageCache cache;
+  return cache;
+}
+
+inline void abramov::trimHugePages() noexcept
+{
+  HugePageCache &cache = hugePageCache();
+  std::lock_guard< std::mutex > guard(cache.lock);
+#ifdef __linux__
+  for (const auto &[base, mapped] : cache.mappings)
+  {
+    munmap(base, mapped);
+  }
+#endif
+  cache.mappings.clear();
+}
+
+inline void abramov::setHugePages(HugePages mode, size_t threshold)
+{
+  hugePageSetting() = mode;
+  hugePageThresholdSetting() = threshold;
+}
+
+inline abramov::HugePages abramov::hugePages() noexcept
+{
+  return hugePageSetting();
+}
+
+inline size_t abramov::hugePageThreshold() noexcept
+{
+  return hugePageThresholdSetting();
+}
+
+inline abramov::HugePages abramov::hugePagesOf(const void *block) noexcept
+{
+  if (!block)
+  {
+    return HugePages::Off;
+  }
+  const StorageHeader *header = reinterpret_cast< const StorageHeader * >(static_cast< const char * >(block) - 64);
+  return header->huge;
+}
+
+inline size_t abramov::hugePageSize()
+{
+  static const size_t size = []()
+  {
+    std::ifstream in("/proc/meminfo");
+    std::string key;
+    size_t kb = 0;
+    while (in >> key)
+    {
+      if (key == "Hugepagesize:" && in >> kb)
+      {
+        return kb * 1024;
+      }
+      std::getline(in, key);
+    }
+    return size_t(2) << 20;
+  }();
+  return size;
+}
+
+inline bool abramov::transparentHugePagesAvailable()
+{
+  static const bool available = []()
+  {
+    std::ifstream in("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string modes;
+    std::getline(in, modes);
+    return in && modes.find("[never]") == std::string::npos;
+  }();
+  return available;
+}
+
+inline abramov::HugePageStats abramov::hugePageStats() noexcept
+{
+  std::atomic< size_t > *counters = hugePageCounters();
+  return HugePageStats{ counters[0], counters[1], counters[2], counters[3], counters[4] };
+}
+
+inline void abramov::resetHugePageStats() noexcept
+{
+  std::atomic< size_t > *counters = hugePageCounters();
+  for (size_t i = 0; i < 5; ++i)
+  {
+    counters[i] = 0;
+  }
+}
+
+inline size_t abramov::hugePageBytes(const void *addr)
+{
+  std::ifstream in("/proc/self/smaps");
+  uintptr_t target = reinterpret_cast< uintptr_t >(addr);
+  bool inside = false;
+  size_t res = 0;
+  std::string line;
+  while (std::getline(in, line))
+  {
+    size_t dash = line.find('-');
+    size_t space = line.find(' ');
+    if (dash != std::string::npos && space != std::string::npos && dash < space && line.find(':') > space)
+    {
+      if (inside)
+      {
+        break;
+      }
+      uintptr_t lo = std::stoull(line.substr(0, dash), nullptr, 16);
+      uintptr_t hi = std::stoull(line.substr(dash + 1, space - dash - 1), nullptr, 16);
+      inside = lo <= target && target < hi;
+      continue;
+    }
+    if (!inside)
+    {
+      continue;
+    }
+    size_t colon = line.find(':');
+    std::string key = line.substr(0, colon);
+    if (key == "AnonHugePages" || key == "Private_Hugetlb" || key == "Shared_Hugetlb")
+    {
+      res += std::stoull(line.substr(colon + 1)) * 1024;
+    }
+  }
+  return res;
+}
+
+inline void *abramov::allocateRows(size_t rows, size_t rowBytes)
+{
+  static_assert(sizeof(StorageHeader) <= 64);
+  size_t bytes = rows * rowBytes + 64;
+  Placement policy = placement();
+  HugePages huge = hugePages();
+  if (policy != Placement::Local && bytes - 64 < placementThreshold())
+  {
+    policy = Placement::Local;
+  }
+  if (huge != HugePages::Off && bytes - 64 < hugePageThreshold())
+  {
+    huge = HugePages::Off;
+  }
+  char *base = nullptr;
+  size_t mapped = 0;
+  if (policy != Placement::Local || huge != HugePages::Off)
+  {
+    base = mapRows(bytes, huge, mapped);
+    if (base && policy != Placement::Local)
+    {
+      placeRows(base, mapped, rows, rowBytes, policy);
+    }
+  }
+  if (!base)
+  {
+    base = static_cast< char * >(::operator new(bytes));
+    policy = Placement::Local;
+    huge = HugePages::Off;
+  }
+  *reinterpret_cast< StorageHeader * >(base) = StorageHeader{ mapped, policy, huge };
+  return base + 64;
+}
+
+inline void abramov::releaseRows(void *block) noexcept
+{
+  if (!block)
+  {
+    return;
+  }
+  char *base = static_cast< char * >(block) - 64;
+  const StorageHeader header = *reinterpret_cast< StorageHeader * >(base);
+  size_t mapped = header.mapped;
+#ifdef __linux__
+  if (header.huge == HugePages::Transparent && header.placement == Placement::Local)
+  {
+    HugePageCache &cache = hugePageCache();
+    std::lock_guard< std::mutex > guard(cache.lock);
+    if (cache.mappings.size() < 4)
+    {
+      try
+      {
+        cache.mappings.emplace_back(base, mapped);
+        return;
+      }
+      catch (...)
+      {
+      }
+    }
+  }
+  if (mapped)
+  {
+    munmap(base, mapped);
+    return;
+  }
+#endif
+  ::operator delete(base);
+}
+
+inline char *abramov::mapRows(size_t bytes, HugePages &mode, size_t &mapped) noexcept
+{
+#ifdef __linux__
+  std::atomic< size_t > *counters = hugePageCounters();
+  HugePages requested = mode;
+  size_t large = 0;
+  try
+  {
+    large = mode == HugePages::Off ? 0 : hugePageSize();
+  }
+  catch (...)
+  {
+    large = size_t(2) << 20;
+  }
+#ifdef MAP_HUGETLB
+  if (mode == HugePages::Explicit)
+  {
+    size_t length = (bytes + large - 1) / large * large;
+    void *addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED)
+    {
+      counters[0] += length;
+      ++counters[3];
+      mapped = length;
+      return static_cast< char * >(addr);
+    }
+    mode = HugePages::Transparent;
+  }
+#else
+  if (mode == HugePages::Explicit)
+  {
+    mode = HugePages::Transparent;
+  }
+#endif
+  bool transparent = false;
+  if (mode == HugePages::Transparent)
+  {
+    try
+    {
+      transparent = transparentHugePagesAvailable();
+    }
+    catch (...)
+    {
+      transparent = false;
+    }
+  }
+  size_t page = static_cast< size_t >(sysconf(_SC_PAGESIZE));
+  size_t length = (bytes + page - 1) / page * page;
+  if (transparent)
+  {
+    HugePageCache &cache = hugePageCache();
+    std::lock_guard< std::mutex > guard(cache.lock);
+    for (size_t i = 0; i < cache.mappings.size(); ++i)
+    {
+      if (cache.mappings[i].second == length)
+      {
+        char *base = cache.mappings[i].first;
+        cache.mappings[i] = cache.mappings.back();
+        cache.mappings.pop_back();
+        counters[4] += length;
+        mapped = length;
+        return base;
+      }
+    }
+  }
+  size_t slack = transparent ? large : 0;
+  void *addr = mmap(nullptr, length + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED)
+  {
+    mode = HugePages::Off;
+    return nullptr;
+  }
+  char *base = static_cast< char * >(addr);
+  if (slack)
+  {
+    uintptr_t raw = reinterpret_cast< uintptr_t >(base);
+    size_t head = (large - raw % large) % large;
+    if (head)
+    {
+      munmap(base, head);
+    }
+    if (slack - head)
+    {
+      munmap(base + head + length, slack - head);
+    }
+    base += head;
+  }
+#ifdef MADV_HUGEPAGE
+  if (transparent && !madvise(base, length, MADV_HUGEPAGE))
+  {
+    counters[1] += length;
+    ++counters[3];
+  }
+  else
+  {
+    transparent = false;
+  }
+#else
+  transparent = false;
+#endif
+  if (requested != HugePages::Off && !transparent)
+  {
+    counters[2] += length;
+    ++counters[3];
+    mode = HugePages::Off;
+  }
+  mapped = length;
+  return base;
+#else
+  (void)bytes;
+  (void)mapped;
+  mode = HugePages::Off;
+  return nullptr;
+#endif
+}
+
+inline void abramov::placeRows(char *base, size_t mapped, size_t rows, size_t rowBytes, Placement placement) noexcept
+{
+#ifdef __linux__
+  if (placement == Placement::Interleave)
+  {
+    interleaveNodes(base, mapped);
+    return;
+  }
+  size_t nodes = numaNodes();
+  size_t page = static_cast< size_t >(sysconf(_SC_PAGESIZE));
+  size_t from = 0;
+  for (size_t node = 0; node < nodes; ++node)
+  {
+    size_t to = mapped;
+    if (node + 1 < nodes)
+    {
+      to = (64 + nodeBegin(0, rows, node + 1, nodes) * rowBytes) / page * page;
+    }
+    if (to > from)
+    {
+      preferNode(base + from, to - from, node);
+      from = to;
+    }
+  }
+#else
+  (void)base;
+  (void)mapped;
+  (void)rows;
+  (void)rowBytes;
+  (void)placement;
+#endif
+}
+#endif
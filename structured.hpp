@@ -0,0 +1,1646 @@
+#ifndef STRUCTURED_HPP
+#define STRUCTURED_HPP
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "matrix.hpp"
+#include "ntt.hpp"
+#include "overflow.hpp"
+
+namespace abramov
+{
+  enum class Triangle
+  {
+    Lower,
+    Upper
+  };
+
+  template< class T >
+  struct RowSpan
+  {
+    size_t first;
+    size_t count;
+    const T *values;
+  };
+
+  template< Integral T, class P = Wrapping >
+  struct DiagonalMatrix
+  {
+    using result_type = typename P::template result_type< T >;
+
+    DiagonalMatrix() = default;
+    explicit DiagonalMatrix(std::vector< T > values);
+    explicit DiagonalMatrix(const Matrix< T, P > &matrix);
+    size_t getRows() const noexcept;
+    size_t getCols() const noexcept;
+    T get(size_t i, size_t j) const noexcept;
+    const std::vector< T > &diagonal() const noexcept;
+    RowSpan< T > span(size_t i) const noexcept;
+    Matrix< T, P > toMatrix() const;
+    DiagonalMatrix< T, P > transpose() const;
+    result_type trace() const;
+    result_type determinant() const;
+    std::pair< double, DiagonalMatrix< T, P > > inverse() const;
+    std::vector< double > solve(const std::vector< T > &rhs) const;
+    bool operator==(const DiagonalMatrix< T, P > &other) const noexcept;
+  private:
+    std::vector< T > values;
+  };
+
+  template< Integral T, class P = Wrapping >
+  struct TriangularMatrix
+  {
+    using result_type = typename P::template result_type< T >;
+
+    TriangularMatrix();
+    TriangularMatrix(size_t n, Triangle part);
+    TriangularMatrix(const Matrix< T, P > &matrix, Triangle part);
+    size_t getRows() const noexcept;
+    size_t getCols() const noexcept;
+    Triangle getPart() const noexcept;
+    T get(size_t i, size_t j) const noexcept;
+    void set(size_t i, size_t j, T value);
+    RowSpan< T > span(size_t i) const noexcept;
+    Matrix< T, P > toMatrix() const;
+    TriangularMatrix< T, P > transpose() const;
+    result_type trace() const;
+    result_type determinant() const;
+    std::pair< double, TriangularMatrix< T, P > > inverse() const;
+    std::vector< double > solve(const std::vector< T > &rhs) const;
+    bool operator==(const TriangularMatrix< T, P > &other) const noexcept;
+  private:
+    size_t n;
+    Triangle part;
+    std::vector< T > values;
+
+    size_t offset(size_t i) const noexcept;
+    bool inside(size_t i, size_t j) const noexcept;
+  };
+
+  template< Integral T, class P = Wrapping >
+  struct BandedMatrix
+  {
+    using result_type = typename P::template result_type< T >;
+
+    BandedMatrix();
+    BandedMatrix(size_t n, size_t lower, size_t upper);
+    BandedMatrix(const Matrix< T, P > &matrix, size_t lower, size_t upper);
+    size_t getRows() const noexcept;
+    size_t getCols() const noexcept;
+    size_t getLower() const noexcept;
+    size_t getUpper() const noexcept;
+    T get(size_t i, size_t j) const noexcept;
+    void set(size_t i, size_t j, T value);
+    const T *band(size_t i) const noexcept;
+    RowSpan< T > span(size_t i) const noexcept;
+    Matrix< T, P > toMatrix() const;
+    BandedMatrix< T, P > transpose() const;
+    result_type trace() const;
+    result_type determinant() const;
+    std::vector< double > solve(const std::vector< T > &rhs) const;
+    bool operator==(const BandedMatrix< T, P > &other) const noexcept;
+  private:
+    size_t n;
+    size_t lower;
+    size_t upper;
+    std::vector< T > values;
+
+    bool inside(size_t i, size_t j) const noexcept;
+  };
+
+  template< Integral T, class P = Wrapping >
+  struct BlockDiagonalMatrix
+  {
+    using result_type = typename P::template result_type< T >;
+
+    BlockDiagonalMatrix() = default;
+    explicit BlockDiagonalMatrix(std::vector< Matrix< T, P > > blocks);
+    void append(Matrix< T, P > block);
+    size_t getRows() const noexcept;
+    size_t getCols() const noexcept;
+    const std::vector< Matrix< T, P > > &blocks() const noexcept;
+    T get(size_t i, size_t j) const noexcept;
+    RowSpan< T > span(size_t i) const noexcept;
+    Matrix< T, P > toMatrix() const;
+    BlockDiagonalMatrix< T, P > transpose() const;
+    result_type trace() const;
+    result_type determinant() const;
+    std::pair< double, BlockDiagonalMatrix< T, P > > inverse() const;
+    std::vector< double > solve(const std::vector< T > &rhs) const;
+  private:
+    std::vector< Matrix< T, P > > parts;
+    std::vector< size_t > rowStart;
+    std::vector< size_t > colStart;
+    std::vector< size_t > owner;
+
+    void requireSquare() const;
+  };
+
+  template< Integral T, class P = Wrapping >
+  struct ToeplitzMatrix
+  {
+    using result_type = typename P::template result_type< T >;
+
+    ToeplitzMatrix();
+    ToeplitzMatrix(const std::vector< T > &column, const std::vector< T > &row);
+    explicit ToeplitzMatrix(const Matrix< T, P > &matrix);
+    static ToeplitzMatrix< T, P > circulant(const std::vector< T > &row);
+    size_t getRows() const noexcept;
+    size_t getCols() const noexcept;
+    bool isCirculant() const noexcept;
+    T get(size_t i, size_t j) const noexcept;
+    const std::vector< T > &diagonals() const noexcept;
+    RowSpan< T > span(size_t i) const noexcept;
+    Matrix< T, P > toMatrix() const;
+    ToeplitzMatrix< T, P > transpose() const;
+    result_type trace() const;
+    result_type determinant() const;
+    std::vector< double > solve(const std::vector< T > &rhs) const;
+    bool operator==(const ToeplitzMatrix< T, P > &other) const noexcept;
+  private:
+    size_t rows;
+    size_t cols;
+    std::vector< T > values;
+  };
+
+  template< Integral T, class P >
+  DiagonalMatrix< T, P > operator*(const DiagonalMatrix< T, P > &lhs, const DiagonalMatrix< T, P > &rhs);
+  template< Integral T, class P >
+  TriangularMatrix< T, P > operator*(const TriangularMatrix< T, P > &lhs, const TriangularMatrix< T, P > &rhs);
+  template< Integral T, class P >
+  BandedMatrix< T, P > operator*(const BandedMatrix< T, P > &lhs, const BandedMatrix< T, P > &rhs);
+  template< Integral T, class P >
+  BlockDiagonalMatrix< T, P > operator*(const BlockDiagonalMatrix< T, P > &lhs, const BlockDiagonalMatrix< T, P > &rhs);
+  template< class S, Integral T, class P >
+  requires requires(const S &s) { s.span(0); }
+  Matrix< T, P > operator*(const S &lhs, const Matrix< T, P > &rhs);
+  template< class S, Integral T, class P >
+  requires requires(const S &s) { s.span(0); }
+  Matrix< T, P > operator*(const Matrix< T, P > &lhs, const S &rhs);
+
+  template< Integral T, class P >
+  Matrix< T, P > operator*(const ToeplitzMatrix< T, P > &lhs, const Matrix< T, P > &rhs);
+  template< Integral T, class P >
+  Matrix< T, P > operator*(const Matrix< T, P > &lhs, const ToeplitzMatrix< T, P > &rhs);
+  template< Integral T, class P >
+  std::vector< T > operator*(const ToeplitzMatrix< T, P > &lhs, const std::vector< T > &rhs);
+  template< Integral T, class P >
+  ToeplitzMatrix< T, P > circulantMultiply(const ToeplitzMatrix< T, P > &lhs, const ToeplitzMatrix< T, P > &rhs,
+    size_t threads = 0);
+
+  template< class S, Integral T, class P >
+  Matrix< T, P > multiplySpans(const S &lhs, const Matrix< T, P > &rhs);
+  template< class A, class T >
+  A bareissDeterminant(const T *band, size_t n, size_t lower, size_t upper);
+  template< class T >
+  std::vector< double > bandSolve(const T *band, size_t n, size_t lower, size_t upper, const std::vector< T > &rhs);
+  template< Integral T, class P >
+  std::pair< __int128, Matrix< T, P > > exactAdjugate(const Matrix< T, P > &matrix);
+  template< class T >
+  std::vector< double > levinsonSolve(const std::vector< T > &values, size_t n, const std::vector< T > &rhs);
+  template< class P, class T, class F >
+  typename P::template result_type< T > productOf(size_t n, F value);
+}
+
+template< class P, class T, class F >
+typename P::template result_type< T > abramov::productOf(size_t n, F value)
+{
+  return escalate< P, T >([&]< class A >()
+  {
+    A res = 1;
+    for (size_t i = 0; i < n; ++i)
+    {
+      res = mul< P, A >(res, value(i));
+    }
+    return res;
+  });
+}
+
+template< class S, abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::multiplySpans(const S &lhs, const Matrix< T, P > &rhs)
+{
+  ABRAMOV_PROFILE_SCOPE("multiplySpans", lhs.getRows(), rhs.getCols());
+  if (lhs.getCols() != rhs.getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  size_t n = rhs.getCols();
+  Matrix< T, P > res(lhs.getRows(), n, 0);
+  std::vector< const T * > rows(rhs.getRows());
+  for (size_t k = 0; k < rows.size(); ++k)
+  {
+    rows[k] = rhs[k];
+  }
+  for (size_t i = 0; i < lhs.getRows(); ++i)
+  {
+    RowSpan< T > row = lhs.span(i);
+    multiplyRow< P >(res[i], row.values, rows.data() + row.first, row.count, n);
+  }
+  return res;
+}
+
+template< class S, abramov::Integral T, class P >
+requires requires(const S &s) { s.span(0); }
+abramov::Matrix< T, P > abramov::operator*(const S &lhs, const Matrix< T, P > &rhs)
+{
+  return multiplySpans(lhs, rhs);
+}
+
+template< class S, abramov::Integral T, class P >
+requires requires(const S &s) { s.span(0); }
+abramov::Matrix< T, P > abramov::operator*(const Matrix< T, P > &lhs, const S &rhs)
+{
+  return multiplySpans(rhs.transpose(), lhs.transpose()).transpose();
+}
+
+template< class A, class T >
+A abramov::bareissDeterminant(const T *band, size_t n, size_t lower, size_t upper)
+{
+  size_t width = lower + upper + 1;
+  size_t wide = width + lower;
+  std::vector< A > a(n * wide, 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    std::copy_n(band + i * width, width, a.begin() + i * wide);
+  }
+  auto at = [&](size_t i, size_t j) -> A &
+  {
+    return a[i * wide + j + lower - i];
+  };
+  A prev = 1;
+  bool negative = false;
+  for (size_t k = 0; k < n; ++k)
+  {
+    size_t last = std::min(n - 1, k + lower);
+    size_t end = std::min(n - 1, k + lower + upper);
+    if (k && k + lower < n)
+    {
+      for (size_t j = k; j <= end; ++j)
+      {
+        at(last, j) = mul< Checked >(at(last, j), prev);
+      }
+    }
+    size_t pivot = k;
+    while (pivot <= last && at(pivot, k) == A(0))
+    {
+      ++pivot;
+    }
+    if (pivot > last)
+    {
+      return A(0);
+    }
+    if (pivot != k)
+    {
+      for (size_t j = k; j <= end; ++j)
+      {
+        std::swap(at(k, j), at(pivot, j));
+      }
+      negative = !negative;
+    }
+    for (size_t i = k + 1; i <= last; ++i)
+    {
+      A factor = at(i, k);
+      for (size_t j = k + 1; j <= end; ++j)
+      {
+        at(i, j) = sub< Checked >(mul< Checked >(at(k, k), at(i, j)), mul< Checked >(factor, at(k, j))) / prev;
+      }
+      at(i, k) = 0;
+    }
+    prev = at(k, k);
+  }
+  return negative ? sub< Checked >(A(0), prev) : prev;
+}
+
+template< class T >
+std::vector< double > abramov::bandSolve(const T *band, size_t n, size_t lower, size_t upper,
+  const std::vector< T > &rhs)
+{
+  if (rhs.size() != n)
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  size_t width = lower + upper + 1;
+  size_t wide = width + lower;
+  std::vector< double > a(n * wide, 0.0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    std::copy_n(band + i * width, width, a.begin() + i * wide);
+  }
+  auto at = [&](size_t i, size_t j) -> double &
+  {
+    return a[i * wide + j + lower - i];
+  };
+  std::vector< double > x(rhs.begin(), rhs.end());
+  for (size_t k = 0; k < n; ++k)
+  {
+    size_t last = std::min(n - 1, k + lower);
+    size_t end = std::min(n - 1, k + lower + upper);
+    size_t pivot = k;
+    for (size_t i = k + 1; i <= last; ++i)
+    {
+      pivot = std::abs(at(i, k)) > std::abs(at(pivot, k)) ? i : pivot;
+    }
+    if (at(pivot, k) == 0.0)
+    {
+      throw std::logic_error("System has no unique solution\n");
+    }
+    if (pivot != k)
+    {
+      for (size_t j = k; j <= end; ++j)
+      {
+        std::swap(at(k, j), at(pivot, j));
+      }
+      std::swap(x[k], x[pivot]);
+    }
+    for (size_t i = k + 1; i <= last; ++i)
+    {
+      double factor = at(i, k) / at(k, k);
+      for (size_t j = k + 1; j <= end; ++j)
+      {
+        at(i, j) -= factor * at(k, j);
+      }
+      x[i] -= factor * x[k];
+    }
+  }
+  for (size_t i = n; i > 0; --i)
+  {
+    size_t r = i - 1;
+    size_t end = std::min(n - 1, r + lower + upper);
+    double sum = x[r];
+    for (size_t j = r + 1; j <= end; ++j)
+    {
+      sum -= at(r, j) * x[j];
+    }
+    x[r] = sum / at(r, r);
+  }
+  return x;
+}
+
+template< abramov::Integral T, class P >
+std::pair< __int128, abramov::Matrix< T, P > > abramov::exactAdjugate(const Matrix< T, P > &matrix)
+{
+  size_t n = matrix.getRows();
+  size_t w = 2 * n;
+  std::vector< __int128 > a(n * w, 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      a[i * w + j] = matrix[i][j];
+    }
+    a[i * w + n + i] = 1;
+  }
+  __int128 prev = 1;
+  bool negative = false;
+  try
+  {
+    for (size_t k = 0; k < n; ++k)
+    {
+      size_t pivot = k;
+      while (pivot < n && a[pivot * w + k] == 0)
+      {
+        ++pivot;
+      }
+      if (pivot == n)
+      {
+        return { 0, Matrix< T, P >(n, n, 0) };
+      }
+      if (pivot != k)
+      {
+        std::swap_ranges(a.begin() + pivot * w, a.begin() + (pivot + 1) * w, a.begin() + k * w);
+        negative = !negative;
+      }
+      __int128 p = a[k * w + k];
+      for (size_t i = 0; i < n; ++i)
+      {
+        if (i == k)
+        {
+          continue;
+        }
+        __int128 factor = a[i * w + k];
+        for (size_t j = 0; j < w; ++j)
+        {
+          a[i * w + j] = sub< Checked >(mul< Checked >(p, a[i * w + j]), mul< Checked >(factor, a[k * w + j])) / prev;
+        }
+      }
+      prev = p;
+    }
+  }
+  catch (const OverflowSignal &)
+  {
+    throw std::overflow_error("Integer overflow\n");
+  }
+  Matrix< T, P > adj(n, n, 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      __int128 value = a[i * w + n + j];
+      adj[i][j] = P::template narrow< T >(negative ? -value : value);
+    }
+  }
+  return { negative ? -prev : prev, adj };
+}
+
+template< class T >
+std::vector< double > abramov::levinsonSolve(const std::vector< T > &values, size_t n, const std::vector< T > &rhs)
+{
+  // Element (i, j) lies on diagonal j - i, stored at values[n - 1 + j - i]
+  auto diagonal = [&values, n](size_t i, size_t j)
+  {
+    return static_cast< double >(values[n - 1 + j - i]);
+  };
+  constexpr double tolerance = 1e-9;
+  double lead = diagonal(0, 0);
+  double scale = 0.0;
+  for (const T &value : values)
+  {
+    scale = std::max(scale, std::abs(static_cast< double >(value)));
+  }
+  if (std::abs(lead) <= tolerance * scale)
+  {
+    return {};
+  }
+  // Forward and backward solve the leading k x k system for the first and the
+  // last unit vector; each step borders both and corrects the solution along
+  // the new backward vector
+  std::vector< double > forward{ 1.0 / lead };
+  std::vector< double > backward{ 1.0 / lead };
+  std::vector< double > res{ static_cast< double >(rhs[0]) / lead };
+  std::vector< double > nextForward;
+  std::vector< double > nextBackward;
+  for (size_t k = 1; k < n; ++k)
+  {
+    double forwardError = 0.0;
+    double backwardError = 0.0;
+    double solutionError = 0.0;
+    for (size_t j = 0; j < k; ++j)
+    {
+      forwardError += diagonal(k, j) * forward[j];
+      backwardError += diagonal(0, j + 1) * backward[j];
+      solutionError += diagonal(k, j) * res[j];
+    }
+    // The denominator vanishes exactly when the next leading minor does, and
+    // cancellation leaves rounding noise rather than zero: compare relatively
+    double coupling = forwardError * backwardError;
+    double denominator = 1.0 - coupling;
+    if (std::abs(denominator) <= tolerance * std::max(1.0, std::abs(coupling)))
+    {
+      return {};
+    }
+    nextForward.assign(k + 1, 0.0);
+    nextBackward.assign(k + 1, 0.0);
+    for (size_t j = 0; j <= k; ++j)
+    {
+      double extended = j < k ? forward[j] : 0.0;
+      double shifted = j ? backward[j - 1] : 0.0;
+      nextForward[j] = (extended - forwardError * shifted) / denominator;
+      nextBackward[j] = (shifted - backwardError * extended) / denominator;
+    }
+    forward.swap(nextForward);
+    backward.swap(nextBackward);
+    double correction = static_cast< double >(rhs[k]) - solutionError;
+    res.push_back(0.0);
+    for (size_t j = 0; j <= k; ++j)
+    {
+      res[j] += correction * backward[j];
+    }
+  }
+  // Levinson is not backward stable for nonsymmetric matrices: a residual well
+  // above rounding sends the caller to pivoted elimination
+  for (size_t i = 0; i < n; ++i)
+  {
+    double sum = 0.0;
+    double magnitude = std::abs(static_cast< double >(rhs[i]));
+    for (size_t j = 0; j < n; ++j)
+    {
+      sum += diagonal(i, j) * res[j];
+      magnitude += std::abs(diagonal(i, j) * res[j]);
+    }
+    if (std::abs(sum - static_cast< double >(rhs[i])) > 1e-9 * magnitude)
+    {
+      return {};
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::DiagonalMatrix< T, P >::DiagonalMatrix(std::vector< T > values):
+  values(std::move(values))
+{}
+
+template< abramov::Integral T, class P >
+abramov::DiagonalMatrix< T, P >::DiagonalMatrix(const Matrix< T, P > &matrix):
+  values(matrix.getRows())
+{
+  if (matrix.getRows() != matrix.getCols())
+  {
+    throw std::invalid_argument("Matrix is not diagonal\n");
+  }
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    for (size_t j = 0; j < values.size(); ++j)
+    {
+      if (i != j && matrix[i][j] != T(0))
+      {
+        throw std::invalid_argument("Matrix is not diagonal\n");
+      }
+    }
+    values[i] = matrix[i][i];
+  }
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::DiagonalMatrix< T, P >::getRows() const noexcept
+{
+  return values.size();
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::DiagonalMatrix< T, P >::getCols() const noexcept
+{
+  return values.size();
+}
+
+template< abramov::Integral T, class P >
+T abramov::DiagonalMatrix< T, P >::get(size_t i, size_t j) const noexcept
+{
+  return i == j ? values[i] : T(0);
+}
+
+template< abramov::Integral T, class P >
+const std::vector< T > &abramov::DiagonalMatrix< T, P >::diagonal() const noexcept
+{
+  return values;
+}
+
+template< abramov::Integral T, class P >
+abramov::RowSpan< T > abramov::DiagonalMatrix< T, P >::span(size_t i) const noexcept
+{
+  return { i, 1, values.data() + i };
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::DiagonalMatrix< T, P >::toMatrix() const
+{
+  Matrix< T, P > res(values.size(), values.size(), 0);
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    res[i][i] = values[i];
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::DiagonalMatrix< T, P > abramov::DiagonalMatrix< T, P >::transpose() const
+{
+  return *this;
+}
+
+template< abramov::Integral T, class P >
+typename abramov::DiagonalMatrix< T, P >::result_type abramov::DiagonalMatrix< T, P >::trace() const
+{
+  ABRAMOV_PROFILE_SCOPE("DiagonalMatrix::trace", values.size(), values.size());
+  return escalate< P, T >([this]< class A >()
+  {
+    A tr = 0;
+    for (T v : values)
+    {
+      tr = add< P, A >(tr, v);
+    }
+    return tr;
+  });
+}
+
+template< abramov::Integral T, class P >
+typename abramov::DiagonalMatrix< T, P >::result_type abramov::DiagonalMatrix< T, P >::determinant() const
+{
+  ABRAMOV_PROFILE_SCOPE("DiagonalMatrix::determinant", values.size(), values.size());
+  return productOf< P, T >(values.size(), [this](size_t i)
+  {
+    return values[i];
+  });
+}
+
+template< abramov::Integral T, class P >
+std::pair< double, abramov::DiagonalMatrix< T, P > > abramov::DiagonalMatrix< T, P >::inverse() const
+{
+  ABRAMOV_PROFILE_SCOPE("DiagonalMatrix::inverse", values.size(), values.size());
+  result_type det = determinant();
+  if (det == 0)
+  {
+    throw std::logic_error("Matrix does not have inverse\n");
+  }
+  using A = std::conditional_t< P::wraps, T, __int128 >;
+  size_t n = values.size();
+  std::vector< A > suffix(n + 1, A(1));
+  std::vector< T > adj(n);
+  try
+  {
+    for (size_t i = n; i > 0; --i)
+    {
+      suffix[i - 1] = mul< P, A >(suffix[i], values[i - 1]);
+    }
+    A prefix = 1;
+    for (size_t i = 0; i < n; ++i)
+    {
+      adj[i] = P::template narrow< T >(mul< P, A >(prefix, suffix[i + 1]));
+      prefix = mul< P, A >(prefix, values[i]);
+    }
+  }
+  catch (const OverflowSignal &)
+  {
+    throw std::overflow_error("Integer overflow\n");
+  }
+  return { 1.0 / static_cast< double >(det), DiagonalMatrix< T, P >(std::move(adj)) };
+}
+
+template< abramov::Integral T, class P >
+std::vector< double > abramov::DiagonalMatrix< T, P >::solve(const std::vector< T > &rhs) const
+{
+  ABRAMOV_PROFILE_SCOPE("DiagonalMatrix::solve", values.size(), values.size());
+  if (rhs.size() != values.size())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  std::vector< double > res(values.size());
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    if (values[i] == T(0))
+    {
+      throw std::logic_error("System has no unique solution\n");
+    }
+    res[i] = static_cast< double >(rhs[i]) / static_cast< double >(values[i]);
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+bool abramov::DiagonalMatrix< T, P >::operator==(const DiagonalMatrix< T, P > &other) const noexcept
+{
+  return values == other.values;
+}
+
+template< abramov::Integral T, class P >
+abramov::TriangularMatrix< T, P >::TriangularMatrix():
+  TriangularMatrix(0, Triangle::Upper)
+{}
+
+template< abramov::Integral T, class P >
+abramov::TriangularMatrix< T, P >::TriangularMatrix(size_t n, Triangle part):
+  n(n),
+  part(part),
+  values(n * (n + 1) / 2, T(0))
+{}
+
+template< abramov::Integral T, class P >
+abramov::TriangularMatrix< T, P >::TriangularMatrix(const Matrix< T, P > &matrix, Triangle part):
+  TriangularMatrix(matrix.getRows(), part)
+{
+  if (matrix.getRows() != matrix.getCols())
+  {
+    throw std::invalid_argument("Matrix is not triangular\n");
+  }
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      if (inside(i, j))
+      {
+        values[offset(i) + j - span(i).first] = matrix[i][j];
+      }
+      else if (matrix[i][j] != T(0))
+      {
+        throw std::invalid_argument("Matrix is not triangular\n");
+      }
+    }
+  }
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TriangularMatrix< T, P >::offset(size_t i) const noexcept
+{
+  return part == Triangle::Lower ? i * (i + 1) / 2 : i * n - i * (i - 1) / 2;
+}
+
+template< abramov::Integral T, class P >
+bool abramov::TriangularMatrix< T, P >::inside(size_t i, size_t j) const noexcept
+{
+  return part == Triangle::Lower ? j <= i : j >= i;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TriangularMatrix< T, P >::getRows() const noexcept
+{
+  return n;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::TriangularMatrix< T, P >::getCols() const noexcept
+{
+  return n;
+}
+
+template< abramov::Integral T, class P >
+abramov::Triangle abramov::TriangularMatrix< T, P >::getPart() const noexcept
+{
+  return part;
+}
+
+template< abramov::Integral T, class P >
+T abramov::TriangularMatrix< T, P >::get(size_t i, size_t j) const noexcept
+{
+  return inside(i, j) ? values[offset(i) + j - span(i).first] : T(0);
+}
+
+template< abramov::Integral T, class P >
+void abramov::TriangularMatrix< T, P >::set(size_t i, size_t j, T value)
+{
+  if (!inside(i, j))
+  {
+    throw std::invalid_argument("Entry is outside the structure\n");
+  }
+  values[offset(i) + j - span(i).first] = value;
+}
+
+template< abramov::Integral T, class P >
+abramov::RowSpan< T > abramov::TriangularMatrix< T, P >::span(size_t i) const noexcept
+{
+  if (part == Triangle::Lower)
+  {
+    return { 0, i + 1, values.data() + offset(i) };
+  }
+  return { i, n - i, values.data() + offset(i) };
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::TriangularMatrix< T, P >::toMatrix() const
+{
+  Matrix< T, P > res(n, n, 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    RowSpan< T > row = span(i);
+    std::copy_n(row.values, row.count, res[i] + row.first);
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::TriangularMatrix< T, P > abramov::TriangularMatrix< T, P >::transpose() const
+{
+  TriangularMatrix< T, P > res(n, part == Triangle::Lower ? Triangle::Upper : Triangle::Lower);
+  for (size_t i = 0; i < n; ++i)
+  {
+    RowSpan< T > row = span(i);
+    for (size_t k = 0; k < row.count; ++k)
+    {
+      res.set(row.first + k, i, row.values[k]);
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+typename abramov::TriangularMatrix< T, P >::result_type abramov::TriangularMatrix< T, P >::trace() const
+{
+  ABRAMOV_PROFILE_SCOPE("TriangularMatrix::trace", n, n);
+  return escalate< P, T >([this]< class A >()
+  {
+    A tr = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      tr = add< P, A >(tr, get(i, i));
+    }
+    return tr;
+  });
+}
+
+template< abramov::Integral T, class P >
+typename abramov::TriangularMatrix< T, P >::result_type abramov::TriangularMatrix< T, P >::determinant() const
+{
+  ABRAMOV_PROFILE_SCOPE("TriangularMatrix::determinant", n, n);
+  return productOf< P, T >(n, [this](size_t i)
+  {
+    return get(i, i);
+  });
+}
+
+template< abramov::Integral T, class P >
+std::pair< double, abramov::TriangularMatrix< T, P > > abramov::TriangularMatrix< T, P >::inverse() const
+{
+  ABRAMOV_PROFILE_SCOPE("TriangularMatrix::inverse", n, n);
+  result_type det = determinant();
+  if (det == 0)
+  {
+    throw std::logic_error("Matrix does not have inverse\n");
+  }
+  TriangularMatrix< T, P > adj(n, part);
+  std::vector< __int128 > x(n);
+  try
+  {
+    __int128 full = 1;
+    for (size_t i = 0; i < n; ++i)
+    {
+      full = mul< Checked, __int128 >(full, get(i, i));
+    }
+    for (size_t c = 0; c < n; ++c)
+    {
+      if (part == Triangle::Upper)
+      {
+        x[c] = full / get(c, c);
+        for (size_t i = c; i > 0; --i)
+        {
+          size_t r = i - 1;
+          __int128 sum = 0;
+          for (size_t k = r + 1; k <= c; ++k)
+          {
+            sum = add< Checked >(sum, mul< Checked, __int128 >(get(r, k), x[k]));
+          }
+          x[r] = -sum / get(r, r);
+        }
+        for (size_t r = 0; r <= c; ++r)
+        {
+          adj.set(r, c, P::template narrow< T >(x[r]));
+        }
+      }
+      else
+      {
+        x[c] = full / get(c, c);
+        for (size_t r = c + 1; r < n; ++r)
+        {
+          __int128 sum = 0;
+          for (size_t k = c; k < r; ++k)
+          {
+            sum = add< Checked >(sum, mul< Checked, __int128 >(get(r, k), x[k]));
+          }
+          x[r] = -sum / get(r, r);
+        }
+        for (size_t r = c; r < n; ++r)
+        {
+          adj.set(r, c, P::template narrow< T >(x[r]));
+        }
+      }
+    }
+  }
+  catch (const OverflowSignal &)
+  {
+    throw std::overflow_error("Integer overflow\n");
+  }
+  return { 1.0 / static_cast< double >(det), adj };
+}
+
+template< abramov::Integral T, class P >
+std::vector< double > abramov::TriangularMatrix< T, P >::solve(const std::vector< T > &rhs) const
+{
+  ABRAMOV_PROFILE_SCOPE("TriangularMatrix::solve", n, n);
+  if (rhs.size() != n)
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  std::vector< double > x(n);
+  for (size_t step = 0; step < n; ++step)
+  {
+    size_t i = part == Triangle::Lower ? step : n - 1 - step;
+    if (get(i, i) == T(0))
+    {
+      throw std::logic_error("System has no unique solution\n");
+    }
+    RowSpan< T > row = span(i);
+    double sum = static_cast< double >(rhs[i]);
+    for (size_t k = 0; k < row.count; ++k)
+    {
+      size_t j = row.first + k;
+      sum -= j != i ? static_cast< double >(row.values[k]) * x[j] : 0.0;
+    }
+    x[i] = sum / static_cast< double >(get(i, i));
+  }
+  return x;
+}
+
+template< abramov::Integral T, class P >
+bool abramov::TriangularMatrix< T, P >::operator==(const TriangularMatrix< T, P > &other) const noexcept
+{
+  return n == other.n && part == other.part && values == other.values;
+}
+
+template< abramov::Integral T, class P >
+abramov::BandedMatrix< T, P >::BandedMatrix():
+  BandedMatrix(0, 0, 0)
+{}
+
+template< abramov::Integral T, class P >
+abramov::BandedMatrix< T, P >::BandedMatrix(size_t n, size_t lower, size_t upper):
+  n(n),
+  lower(lower),
+  upper(upper),
+  values(n * (lower + upper + 1), T(0))
+{}
+
+template< abramov::Integral T, class P >
+abramov::BandedMatrix< T, P >::BandedMatrix(const Matrix< T, P > &matrix, size_t lower, size_t upper):
+  BandedMatrix(matrix.getRows(), lower, upper)
+{
+  if (matrix.getRows() != matrix.getCols())
+  {
+    throw std::invalid_argument("Matrix does not fit the band\n");
+  }
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      if (inside(i, j))
+      {
+        set(i, j, matrix[i][j]);
+      }
+      else if (matrix[i][j] != T(0))
+      {
+        throw std::invalid_argument("Matrix does not fit the band\n");
+      }
+    }
+  }
+}
+
+template< abramov::Integral T, class P >
+bool abramov::BandedMatrix< T, P >::inside(size_t i, size_t j) const noexcept
+{
+  return j + lower >= i && j <= i + upper;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::BandedMatrix< T, P >::getRows() const noexcept
+{
+  return n;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::BandedMatrix< T, P >::getCols() const noexcept
+{
+  return n;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::BandedMatrix< T, P >::getLower() const noexcept
+{
+  return lower;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::BandedMatrix< T, P >::getUpper() const noexcept
+{
+  return upper;
+}
+
+template< abramov::Integral T, class P >
+T abramov::BandedMatrix< T, P >::get(size_t i, size_t j) const noexcept
+{
+  return inside(i, j) ? values[i * (lower + upper + 1) + j + lower - i] : T(0);
+}
+
+template< abramov::Integral T, class P >
+void abramov::BandedMatrix< T, P >::set(size_t i, size_t j, T value)
+{
+  if (!inside(i, j) || i >= n || j >= n)
+  {
+    throw std::invalid_argument("Entry is outside the structure\n");
+  }
+  values[i * (lower + upper + 1) + j + lower - i] = value;
+}
+
+template< abramov::Integral T, class P >
+const T *abramov::BandedMatrix< T, P >::band(size_t i) const noexcept
+{
+  return values.data() + i * (lower + upper + 1);
+}
+
+template< abramov::Integral T, class P >
+abramov::RowSpan< T > abramov::BandedMatrix< T, P >::span(size_t i) const noexcept
+{
+  size_t first = i > lower ? i - lower : 0;
+  size_t end = std::min(n, i + upper + 1);
+  return { first, end - first, band(i) + first + lower - i };
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::BandedMatrix< T, P >::toMatrix() const
+{
+  Matrix< T, P > res(n, n, 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    RowSpan< T > row = span(i);
+    std::copy_n(row.values, row.count, res[i] + row.first);
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::BandedMatrix< T, P > abramov::BandedMatrix< T, P >::transpose() const
+{
+  BandedMatrix< T, P > res(n, upper, lower);
+  for (size_t i = 0; i < n; ++i)
+  {
+    RowSpan< T > row = span(i);
+    for (size_t k = 0; k < row.count; ++k)
+    {
+      res.set(row.first + k, i, row.values[k]);
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+typename abramov::BandedMatrix< T, P >::result_type abramov::BandedMatrix< T, P >::trace() const
+{
+  ABRAMOV_PROFILE_SCOPE("BandedMatrix::trace", n, n);
+  return escalate< P, T >([this]< class A >()
+  {
+    A tr = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      tr = add< P, A >(tr, get(i, i));
+    }
+    return tr;
+  });
+}
+
+template< abramov::Integral T, class P >
+typename abramov::BandedMatrix< T, P >::result_type abramov::BandedMatrix< T, P >::determinant() const
+{
+  ABRAMOV_PROFILE_SCOPE("BandedMatrix::determinant", n, n);
+  return P::template narrow< result_type >(escalate< Checked, T, __int128 >([this]< class A >()
+  {
+    return static_cast< __int128 >(bareissDeterminant< A >(values.data(), n, lower, upper));
+  }));
+}
+
+template< abramov::Integral T, class P >
+std::vector< double > abramov::BandedMatrix< T, P >::solve(const std::vector< T > &rhs) const
+{
+  ABRAMOV_PROFILE_SCOPE("BandedMatrix::solve", n, n);
+  return bandSolve(values.data(), n, lower, upper, rhs);
+}
+
+template< abramov::Integral T, class P >
+bool abramov::BandedMatrix< T, P >::operator==(const BandedMatrix< T, P > &other) const noexcept
+{
+  return n == other.n && lower == other.lower && upper == other.upper && values == other.values;
+}
+
+template< abramov::Integral T, class P >
+abramov::BlockDiagonalMatrix< T, P >::BlockDiagonalMatrix(std::vector< Matrix< T, P > > blocks)
+{
+  for (Matrix< T, P > &block : blocks)
+  {
+    append(std::move(block));
+  }
+}
+
+template< abramov::Integral T, class P >
+void abramov::BlockDiagonalMatrix< T, P >::append(Matrix< T, P > block)
+{
+  rowStart.push_back(getRows());
+  colStart.push_back(getCols());
+  owner.insert(owner.end(), block.getRows(), parts.size());
+  parts.push_back(std::move(block));
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::BlockDiagonalMatrix< T, P >::getRows() const noexcept
+{
+  return parts.empty() ? 0 : rowStart.back() + parts.back().getRows();
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::BlockDiagonalMatrix< T, P >::getCols() const noexcept
+{
+  return parts.empty() ? 0 : colStart.back() + parts.back().getCols();
+}
+
+template< abramov::Integral T, class P >
+const std::vector< abramov::Matrix< T, P > > &abramov::BlockDiagonalMatrix< T, P >::blocks() const noexcept
+{
+  return parts;
+}
+
+template< abramov::Integral T, class P >
+T abramov::BlockDiagonalMatrix< T, P >::get(size_t i, size_t j) const noexcept
+{
+  size_t b = owner[i];
+  size_t c = colStart[b];
+  return j >= c && j < c + parts[b].getCols() ? parts[b][i - rowStart[b]][j - c] : T(0);
+}
+
+template< abramov::Integral T, class P >
+abramov::RowSpan< T > abramov::BlockDiagonalMatrix< T, P >::span(size_t i) const noexcept
+{
+  size_t b = owner[i];
+  return { colStart[b], parts[b].getCols(), parts[b][i - rowStart[b]] };
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::BlockDiagonalMatrix< T, P >::toMatrix() const
+{
+  Matrix< T, P > res(getRows(), getCols(), 0);
+  for (size_t i = 0; i < getRows(); ++i)
+  {
+    RowSpan< T > row = span(i);
+    std::copy_n(row.values, row.count, res[i] + row.first);
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::BlockDiagonalMatrix< T, P > abramov::BlockDiagonalMatrix< T, P >::transpose() const
+{
+  BlockDiagonalMatrix< T, P > res;
+  for (const Matrix< T, P > &block : parts)
+  {
+    res.append(block.transpose());
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+void abramov::BlockDiagonalMatrix< T, P >::requireSquare() const
+{
+  for (const Matrix< T, P > &block : parts)
+  {
+    if (block.getRows() != block.getCols())
+    {
+      throw std::logic_error("Matrix must be square\n");
+    }
+  }
+}
+
+template< abramov::Integral T, class P >
+typename abramov::BlockDiagonalMatrix< T, P >::result_type abramov::BlockDiagonalMatrix< T, P >::trace() const
+{
+  ABRAMOV_PROFILE_SCOPE("BlockDiagonalMatrix::trace", getRows(), getCols());
+  requireSquare();
+  return escalate< P, T >([this]< class A >()
+  {
+    A tr = 0;
+    for (const Matrix< T, P > &block : parts)
+    {
+      for (size_t i = 0; i < block.getRows(); ++i)
+      {
+        tr = add< P, A >(tr, block[i][i]);
+      }
+    }
+    return tr;
+  });
+}
+
+template< abramov::Integral T, class P >
+typename abramov::BlockDiagonalMatrix< T, P >::result_type abramov::BlockDiagonalMatrix< T, P >::determinant() const
+{
+  ABRAMOV_PROFILE_SCOPE("BlockDiagonalMatrix::determinant", getRows(), getCols());
+  requireSquare();
+  std::vector< result_type > dets;
+  for (const Matrix< T, P > &block : parts)
+  {
+    size_t w = block.getRows() ? block.getRows() - 1 : 0;
+    dets.push_back(BandedMatrix< T, P >(block, w, w).determinant());
+  }
+  return P::template narrow< result_type >(productOf< P, result_type >(dets.size(), [&dets](size_t b)
+  {
+    return dets[b];
+  }));
+}
+
+template< abramov::Integral T, class P >
+std::pair< double, abramov::BlockDiagonalMatrix< T, P > > abramov::BlockDiagonalMatrix< T, P >::inverse() const
+{
+  ABRAMOV_PROFILE_SCOPE("BlockDiagonalMatrix::inverse", getRows(), getCols());
+  requireSquare();
+  std::vector< std::pair< __int128, Matrix< T, P > > > adjugates;
+  for (const Matrix< T, P > &block : parts)
+  {
+    adjugates.push_back(exactAdjugate(block));
+    if (adjugates.back().first == 0)
+    {
+      throw std::logic_error("Matrix does not have inverse\n");
+    }
+  }
+  std::vector< result_type > dets;
+  for (const std::pair< __int128, Matrix< T, P > > &adj : adjugates)
+  {
+    dets.push_back(P::template narrow< result_type >(adj.first));
+  }
+  result_type det = P::template narrow< result_type >(productOf< P, result_type >(dets.size(), [&dets](size_t b)
+  {
+    return dets[b];
+  }));
+  BlockDiagonalMatrix< T, P > res;
+  for (size_t b = 0; b < parts.size(); ++b)
+  {
+    T others = P::template narrow< T >(productOf< P, result_type >(dets.size(), [&dets, b](size_t c)
+    {
+      return c == b ? result_type(1) : dets[c];
+    }));
+    Matrix< T, P > block = std::move(adjugates[b].second);
+    for (size_t i = 0; i < block.getRows(); ++i)
+    {
+      scaleRow< P >(block[i], block.getCols(), others);
+    }
+    res.append(std::move(block));
+  }
+  return { 1.0 / static_cast< double >(det), res };
+}
+
+template< abramov::Integral T, class P >
+std::vector< double > abramov::BlockDiagonalMatrix< T, P >::solve(const std::vector< T > &rhs) const
+{
+  ABRAMOV_PROFILE_SCOPE("BlockDiagonalMatrix::solve", getRows(), getCols());
+  requireSquare();
+  if (rhs.size() != getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  std::vector< double > res;
+  for (size_t b = 0; b < parts.size(); ++b)
+  {
+    size_t n = parts[b].getRows();
+    size_t w = n ? n - 1 : 0;
+    BandedMatrix< T, P > full(parts[b], w, w);
+    std::vector< T > part(rhs.begin() + rowStart[b], rhs.begin() + rowStart[b] + n);
+    std::vector< double > x = full.solve(part);
+    res.insert(res.end(), x.begin(), x.end());
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::ToeplitzMatrix< T, P >::ToeplitzMatrix():
+  rows(0),
+  cols(0),
+  values()
+{}
+
+template< abramov::Integral T, class P >
+abramov::ToeplitzMatrix< T, P >::ToeplitzMatrix(const std::vector< T > &column, const std::vector< T > &row):
+  rows(column.size()),
+  cols(row.size()),
+  values()
+{
+  if (rows && cols && column[0] != row[0])
+  {
+    throw std::invalid_argument("Matrix is not Toeplitz\n");
+  }
+  if (!rows || !cols)
+  {
+    rows = 0;
+    cols = 0;
+    return;
+  }
+  values.assign(column.rbegin(), column.rend());
+  values.insert(values.end(), row.begin() + 1, row.end());
+}
+
+template< abramov::Integral T, class P >
+abramov::ToeplitzMatrix< T, P >::ToeplitzMatrix(const Matrix< T, P > &matrix):
+  ToeplitzMatrix()
+{
+  size_t m = matrix.getRows();
+  size_t n = matrix.getCols();
+  std::vector< T > column(m);
+  std::vector< T > row(n);
+  for (size_t i = 0; i < m; ++i)
+  {
+    column[i] = matrix[i][0];
+  }
+  for (size_t j = 0; j < n; ++j)
+  {
+    row[j] = matrix[0][j];
+  }
+  *this = ToeplitzMatrix< T, P >(column, row);
+  for (size_t i = 0; i < m; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      if (matrix[i][j] != get(i, j))
+      {
+        throw std::invalid_argument("Matrix is not Toeplitz\n");
+      }
+    }
+  }
+}
+
+template< abramov::Integral T, class P >
+abramov::ToeplitzMatrix< T, P > abramov::ToeplitzMatrix< T, P >::circulant(const std::vector< T > &row)
+{
+  std::vector< T > column(row.size());
+  for (size_t i = 0; i < row.size(); ++i)
+  {
+    column[i] = row[(row.size() - i) % row.size()];
+  }
+  return ToeplitzMatrix< T, P >(column, row);
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::ToeplitzMatrix< T, P >::getRows() const noexcept
+{
+  return rows;
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::ToeplitzMatrix< T, P >::getCols() const noexcept
+{
+  return cols;
+}
+
+template< abramov::Integral T, class P >
+bool abramov::ToeplitzMatrix< T, P >::isCirculant() const noexcept
+{
+  if (rows != cols)
+  {
+    return false;
+  }
+  for (size_t k = 0; k + 1 < rows; ++k)
+  {
+    if (values[k] != values[k + rows])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+template< abramov::Integral T, class P >
+const std::vector< T > &abramov::ToeplitzMatrix< T, P >::diagonals() const noexcept
+{
+  return values;
+}
+
+template< abramov::Integral T, class P >
+T abramov::ToeplitzMatrix< T, P >::get(size_t i, size_t j) const noexcept
+{
+  return values[rows - 1 - i + j];
+}
+
+template< abramov::Integral T, class P >
+abramov::RowSpan< T > abramov::ToeplitzMatrix< T, P >::span(size_t i) const noexcept
+{
+  return { 0, cols, values.data() + rows - 1 - i };
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::ToeplitzMatrix< T, P >::toMatrix() const
+{
+  Matrix< T, P > res(rows, cols, 0);
+  for (size_t i = 0; i < rows; ++i)
+  {
+    std::copy_n(span(i).values, cols, res[i]);
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::ToeplitzMatrix< T, P > abramov::ToeplitzMatrix< T, P >::transpose() const
+{
+  ToeplitzMatrix< T, P > res;
+  res.rows = cols;
+  res.cols = rows;
+  res.values.assign(values.rbegin(), values.rend());
+  return res;
+}
+
+template< abramov::Integral T, class P >
+typename abramov::ToeplitzMatrix< T, P >::result_type abramov::ToeplitzMatrix< T, P >::trace() const
+{
+  ABRAMOV_PROFILE_SCOPE("ToeplitzMatrix::trace", rows, cols);
+  if (rows != cols)
+  {
+    throw std::logic_error("Matrix must be square\n");
+  }
+  return escalate< P, T >([this]< class A >()
+  {
+    return rows ? mul< P, A >(static_cast< A >(rows), values[rows - 1]) : A(0);
+  });
+}
+
+template< abramov::Integral T, class P >
+typename abramov::ToeplitzMatrix< T, P >::result_type abramov::ToeplitzMatrix< T, P >::determinant() const
+{
+  ABRAMOV_PROFILE_SCOPE("ToeplitzMatrix::determinant", rows, cols);
+  if (rows != cols)
+  {
+    throw std::logic_error("Matrix must be square to get determinant\n");
+  }
+  size_t w = rows ? rows - 1 : 0;
+  return BandedMatrix< T, P >(toMatrix(), w, w).determinant();
+}
+
+template< abramov::Integral T, class P >
+std::vector< double > abramov::ToeplitzMatrix< T, P >::solve(const std::vector< T > &rhs) const
+{
+  ABRAMOV_PROFILE_SCOPE("ToeplitzMatrix::solve", rows, cols);
+  if (rows != cols)
+  {
+    throw std::logic_error("Matrix must be square\n");
+  }
+  if (rhs.size() != rows)
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  if (!rows)
+  {
+    return {};
+  }
+  std::vector< double > res = levinsonSolve(values, rows, rhs);
+  if (res.empty())
+  {
+    size_t w = rows - 1;
+    res = BandedMatrix< T, P >(toMatrix(), w, w).solve(rhs);
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+bool abramov::ToeplitzMatrix< T, P >::operator==(const ToeplitzMatrix< T, P > &other) const noexcept
+{
+  return rows == other.rows && cols == other.cols && values == other.values;
+}
+
+template< abramov::Integral T, class P >
+abramov::DiagonalMatrix< T, P > abramov::operator*(const DiagonalMatrix< T, P > &lhs, const DiagonalMatrix< T, P > &rhs)
+{
+  ABRAMOV_PROFILE_SCOPE("DiagonalMatrix::operator*", lhs.getRows(), rhs.getCols());
+  if (lhs.getCols() != rhs.getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  std::vector< T > res(lhs.getRows());
+  for (size_t i = 0; i < res.size(); ++i)
+  {
+    const T *b = rhs.diagonal().data() + i;
+    multiplyRow< P >(res.data() + i, lhs.diagonal().data() + i, &b, 1, 1);
+  }
+  return DiagonalMatrix< T, P >(std::move(res));
+}
+
+template< abramov::Integral T, class P >
+abramov::TriangularMatrix< T, P > abramov::operator*(const TriangularMatrix< T, P > &lhs,
+  const TriangularMatrix< T, P > &rhs)
+{
+  ABRAMOV_PROFILE_SCOPE("TriangularMatrix::operator*", lhs.getRows(), rhs.getCols());
+  if (lhs.getCols() != rhs.getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  if (lhs.getPart() != rhs.getPart())
+  {
+    throw std::invalid_argument("Triangular parts do not agree\n");
+  }
+  size_t n = lhs.getRows();
+  Matrix< T, P > dense = rhs.toMatrix();
+  TriangularMatrix< T, P > res(n, lhs.getPart());
+  std::vector< const T * > rows(n);
+  std::vector< T > out(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    RowSpan< T > row = lhs.span(i);
+    for (size_t k = 0; k < row.count; ++k)
+    {
+      rows[k] = dense[row.first + k] + row.first;
+    }
+    multiplyRow< P >(out.data(), row.values, rows.data(), row.count, row.count);
+    for (size_t k = 0; k < row.count; ++k)
+    {
+      res.set(i, row.first + k, out[k]);
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::BandedMatrix< T, P > abramov::operator*(const BandedMatrix< T, P > &lhs, const BandedMatrix< T, P > &rhs)
+{
+  ABRAMOV_PROFILE_SCOPE("BandedMatrix::operator*", lhs.getRows(), rhs.getCols());
+  if (lhs.getCols() != rhs.getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  size_t n = lhs.getRows();
+  size_t l1 = lhs.getLower();
+  size_t u1 = lhs.getUpper();
+  size_t l2 = rhs.getLower();
+  size_t u2 = rhs.getUpper();
+  size_t pad = l1 + u1;
+  size_t inner = l2 + u2 + 1;
+  size_t padded = inner + 2 * pad;
+  std::vector< T > wide(n * padded, T(0));
+  for (size_t k = 0; k < n; ++k)
+  {
+    std::copy_n(rhs.band(k), inner, wide.begin() + k * padded + pad);
+  }
+  BandedMatrix< T, P > res(n, l1 + l2, u1 + u2);
+  size_t width = res.getLower() + res.getUpper() + 1;
+  std::vector< const T * > rows(l1 + u1 + 1);
+  std::vector< T > out(width);
+  for (size_t i = 0; i < n; ++i)
+  {
+    RowSpan< T > row = lhs.span(i);
+    for (size_t k = 0; k < row.count; ++k)
+    {
+      size_t r = row.first + k;
+      rows[k] = wide.data() + r * padded + i + u1 - r;
+    }
+    multiplyRow< P >(out.data(), row.values, rows.data(), row.count, width);
+    for (size_t s = 0; s < width; ++s)
+    {
+      size_t j = i + s;
+      if (j >= res.getLower() && j - res.getLower() < n)
+      {
+        res.set(i, j - res.getLower(), out[s]);
+      }
+    }
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::BlockDiagonalMatrix< T, P > abramov::operator*(const BlockDiagonalMatrix< T, P > &lhs,
+  const BlockDiagonalMatrix< T, P > &rhs)
+{
+  ABRAMOV_PROFILE_SCOPE("BlockDiagonalMatrix::operator*", lhs.getRows(), rhs.getCols());
+  if (lhs.blocks().size() != rhs.blocks().size())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  BlockDiagonalMatrix< T, P > res;
+  for (size_t b = 0; b < lhs.blocks().size(); ++b)
+  {
+    res.append(lhs.blocks()[b] * rhs.blocks()[b]);
+  }
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::operator*(const Matrix< T, P > &lhs, const ToeplitzMatrix< T, P > &rhs)
+{
+  ABRAMOV_PROFILE_SCOPE("ToeplitzMatrix::operator*(Matrix)", lhs.getRows(), rhs.getCols());
+  if (lhs.getCols() != rhs.getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  if (rhs.getRows() <= 64 || rhs.getCols() <= 64)
+  {
+    return multiplySpans(rhs.transpose(), lhs.transpose()).transpose();
+  }
+  return convolveRows(rhs.diagonals(), lhs, rhs.getRows() - 1, rhs.getCols());
+}
+
+template< abramov::Integral T, class P >
+abramov::Matrix< T, P > abramov::operator*(const ToeplitzMatrix< T, P > &lhs, const Matrix< T, P > &rhs)
+{
+  return (rhs.transpose() * lhs.transpose()).transpose();
+}
+
+template< abramov::Integral T, class P >
+std::vector< T > abramov::operator*(const ToeplitzMatrix< T, P > &lhs, const std::vector< T > &rhs)
+{
+  ABRAMOV_PROFILE_SCOPE("ToeplitzMatrix::operator*(vector)", lhs.getRows(), lhs.getCols());
+  if (lhs.getCols() != rhs.size())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  std::vector< T > res(lhs.getRows());
+  if (res.empty() || rhs.empty())
+  {
+    return std::vector< T >(lhs.getRows(), T(0));
+  }
+  std::vector< T > kernel(lhs.diagonals().rbegin(), lhs.diagonals().rend());
+  const T *row = rhs.data();
+  T *out = res.data();
+  convolveInto< P >(kernel.data(), kernel.size(), &row, 1, rhs.size(), rhs.size() - 1, res.size(), 0, &out);
+  return res;
+}
+
+template< abramov::Integral T, class P >
+abramov::ToeplitzMatrix< T, P > abramov::circulantMultiply(const ToeplitzMatrix< T, P > &lhs,
+  const ToeplitzMatrix< T, P > &rhs, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("circulantMultiply", lhs.getRows(), rhs.getCols());
+  if (!lhs.isCirculant() || !rhs.isCirculant())
+  {
+    throw std::invalid_argument("Matrix is not circulant\n");
+  }
+  if (lhs.getCols() != rhs.getRows())
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  size_t n = lhs.getRows();
+  if (!n)
+  {
+    return ToeplitzMatrix< T, P >();
+  }
+  std::vector< T > a(lhs.diagonals().begin() + (n - 1), lhs.diagonals().end());
+  std::vector< T > b(rhs.diagonals().begin() + (n - 1), rhs.diagonals().end());
+  return ToeplitzMatrix< T, P >::circulant(cyclicConvolve< P >(a, b, threads));
+}
+#endif
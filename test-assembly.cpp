@@ -0,0 +1,61 @@
+#define BOOST_TEST_MODULE assembly
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+#include <vector>
+#include "assembly.hpp"
+#include "test-sample.hpp"
+
+BOOST_AUTO_TEST_CASE(matches_concat)
+{
+  abramov::Matrix< int > a = sample(3, 2, 1);
+  abramov::Matrix< int > b = sample(5, 4, 2);
+  using Assembly = abramov::BlockAssembly< int >;
+  BOOST_TEST((Assembly::horizontal({ a, b }, 7).materialize() == abramov::Matrix< int >::horizontalConcat(a, b, 7)));
+  BOOST_TEST((Assembly::vertical({ a, b }, 7).materialize() == abramov::Matrix< int >::verticalConcat(a, b, 7)));
+  BOOST_TEST((Assembly::diagonal({ a, b }, 7).materialize() == abramov::Matrix< int >::diagonalConcat(a, b, 7)));
+}
+
+BOOST_AUTO_TEST_CASE(many_blocks)
+{
+  std::vector< abramov::Matrix< int > > pieces;
+  for (int k = 0; k < 20; ++k)
+  {
+    pieces.push_back(sample(k % 4 + 1, k % 3 + 2, k));
+  }
+  std::vector< abramov::BlockAssembly< int >::Block > refs(pieces.begin(), pieces.end());
+  abramov::Matrix< int > chained = pieces[0];
+  for (size_t k = 1; k < pieces.size(); ++k)
+  {
+    chained = abramov::Matrix< int >::diagonalConcat(chained, pieces[k]);
+  }
+  abramov::BlockAssembly< int > diag = abramov::BlockAssembly< int >::diagonal(refs);
+  BOOST_TEST((diag.materialize() == chained));
+  BOOST_TEST((diag.materialize(4) == chained));
+  for (size_t i = 0; i < diag.getRows(); ++i)
+  {
+    for (size_t j = 0; j < diag.getCols(); ++j)
+    {
+      BOOST_TEST(diag(i, j) == chained[i][j]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(grid)
+{
+  abramov::Matrix< int > a = sample(2, 3, 1);
+  abramov::Matrix< int > b = sample(4, 1, 2);
+  abramov::Matrix< int > c = sample(1, 5, 3);
+  abramov::BlockAssembly< int > grid(2, 2, -1);
+  grid.set(0, 0, a).set(0, 1, b).set(1, 1, c);
+  BOOST_TEST(grid.getRows() == 5u);
+  BOOST_TEST(grid.getCols() == 8u);
+  abramov::Matrix< int > top = abramov::Matrix< int >::horizontalConcat(a, b, -1);
+  abramov::Matrix< int > bottom = abramov::Matrix< int >::horizontalConcat(abramov::Matrix< int >(1, 3, -1), c, -1);
+  BOOST_TEST((grid.materialize() == abramov::Matrix< int >::verticalConcat(top, bottom, -1)));
+  grid.reset(0, 1);
+  BOOST_TEST(grid.getCols() == 8u);
+  BOOST_TEST(grid.getRows() == 3u);
+  BOOST_TEST(grid(0, 3) == -1);
+  BOOST_CHECK_THROW(grid.set(2, 0, a), std::out_of_range);
+  BOOST_CHECK_THROW(grid(3, 0), std::out_of_range);
+}
@@ -0,0 +1,112 @@
+#define BOOST_TEST_MODULE async
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "async.hpp"
+#include "test-sample.hpp"
+
+BOOST_AUTO_TEST_CASE(independent_chains)
+{
+  abramov::TaskGraph< long long > graph;
+  std::vector< size_t > outputs;
+  std::vector< abramov::Matrix< long long > > expected;
+  for (int s = 0; s < 8; ++s)
+  {
+    abramov::Matrix< long long > a = sample< long long >(4, 4, s, -3, 3, 9);
+    abramov::Matrix< long long > b = sample< long long >(4, 4, s + 3, -3, 3, 9);
+    expected.push_back((a.inverse().second * b).power(3).transpose());
+    size_t adj = graph.adjugate(graph.input(a));
+    size_t prod = graph.multiply(adj, graph.input(b));
+    outputs.push_back(graph.transpose(graph.power(prod, 3)));
+  }
+  graph.run(4);
+  for (size_t i = 0; i < outputs.size(); ++i)
+  {
+    BOOST_TEST((graph.result(outputs[i]) == expected[i]));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(shared_inputs)
+{
+  abramov::Matrix< long long > a = sample< long long >(5, 5, 1, -3, 3, 9);
+  abramov::Matrix< long long > b = sample< long long >(5, 5, 2, -3, 3, 9);
+  abramov::TaskGraph< long long > graph;
+  size_t x = graph.input(a);
+  size_t y = graph.input(b);
+  size_t sum = graph.add(x, y);
+  size_t diff = graph.subtract(x, y);
+  size_t prod = graph.multiply(sum, diff);
+  size_t scaled = graph.scale(x, 3);
+  graph.keep(sum);
+  graph.run();
+  BOOST_TEST((graph.result(sum) == a + b));
+  BOOST_TEST((graph.result(prod) == (a + b) * (a - b)));
+  abramov::Matrix< long long > triple = a;
+  triple *= 3;
+  BOOST_TEST((graph.take(scaled) == triple));
+  BOOST_CHECK_THROW(graph.result(scaled), std::logic_error);
+  BOOST_CHECK_THROW(graph.result(diff), std::logic_error);
+  BOOST_CHECK_THROW(graph.result(x), std::logic_error);
+  BOOST_CHECK_THROW(graph.result(42), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(rerun)
+{
+  abramov::Matrix< long long > a = sample< long long >(4, 4, 3, -3, 3, 9);
+  abramov::Matrix< long long > b = sample< long long >(4, 4, 4, -3, 3, 9);
+  abramov::TaskGraph< long long > graph;
+  size_t sum = graph.add(graph.input(a), graph.input(b));
+  for (size_t k = 0; k < 3; ++k)
+  {
+    graph.run();
+    BOOST_TEST((graph.take(sum) == a + b));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(custom_operation)
+{
+  abramov::TaskGraph< int > graph;
+  size_t x = graph.input(abramov::Matrix< int >{ { 1, 2 }, { 3, 4 } });
+  size_t traced = graph.apply({ x, x }, [](abramov::TaskGraph< int >::Inputs &in)
+  {
+    BOOST_TEST(in.size() == 2u);
+    abramov::Matrix< int > res(1, 1, 0);
+    res[0][0] = in.get(0).trace() + in.get(1).trace();
+    return res;
+  });
+  graph.run(1);
+  BOOST_TEST(graph.result(traced)[0][0] == 10);
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+  abramov::TaskGraph< int > graph;
+  size_t bad = graph.multiply(graph.input(abramov::Matrix< int >(2, 3, 1)), graph.input(abramov::Matrix< int >(2, 3, 1)));
+  size_t after = graph.transpose(bad);
+  size_t good = graph.transpose(graph.input(abramov::Matrix< int >(2, 3, 1)));
+  BOOST_CHECK_THROW(graph.run(), std::invalid_argument);
+  BOOST_CHECK_THROW(graph.result(after), std::logic_error);
+  BOOST_TEST((graph.result(good) == abramov::Matrix< int >(3, 2, 1)));
+  BOOST_CHECK_THROW(graph.apply({ 17 }, nullptr), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(read_nodes)
+{
+  std::string path = "async_test_matrix.txt";
+  {
+    std::ofstream out(path);
+    out << "2 2\n1 2\n3 4\n";
+  }
+  abramov::TaskGraph< int > graph;
+  size_t m = graph.read(path);
+  size_t sq = graph.multiply(m, m);
+  size_t missing = graph.read("async_missing_matrix.txt");
+  BOOST_CHECK_THROW(graph.run(2), std::exception);
+  abramov::Matrix< int > expected{ { 7, 10 }, { 15, 22 } };
+  BOOST_TEST((graph.result(sq) == expected));
+  BOOST_CHECK_THROW(graph.result(missing), std::logic_error);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,140 @@
+#define BOOST_TEST_MODULE batch
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "batch.hpp"
+#include "test-sample.hpp"
+
+namespace
+{
+  void save(const std::string &path, const abramov::Matrix< int > &m)
+  {
+    std::ofstream out(path);
+    out << m.getRows() << ' ' << m.getCols() << '\n';
+    m.print(out);
+  }
+
+  abramov::Matrix< int > load(const std::string &path, size_t m, size_t n)
+  {
+    std::ifstream in(path);
+    std::ostringstream text;
+    text << m << ' ' << n << '\n' << in.rdbuf();
+    std::string s = text.str();
+    abramov::Matrix< int > res;
+    BOOST_TEST_REQUIRE(res.parse(s.data(), s.data() + s.size()) != nullptr);
+    return res;
+  }
+
+  std::string slurp(const std::string &path)
+  {
+    std::ifstream in(path);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+  }
+
+  struct TempFiles
+  {
+    std::vector< std::string > names;
+
+    ~TempFiles()
+    {
+      for (const std::string &name : names)
+      {
+        std::remove(name.c_str());
+      }
+    }
+  };
+}
+
+BOOST_AUTO_TEST_CASE(manifest)
+{
+  std::istringstream in("# comment\n\nmultiply c.txt a.txt b.txt\n  power p.txt a.txt 3 # cube\nreport r.txt a.txt b.txt\n");
+  std::vector< abramov::BatchJob > jobs = abramov::parseManifest(in);
+  BOOST_TEST(jobs.size() == 3u);
+  BOOST_TEST(jobs[0].op == "multiply");
+  BOOST_TEST(jobs[0].output == "c.txt");
+  BOOST_TEST(jobs[0].inputs.size() == 2u);
+  BOOST_TEST(jobs[0].line == 3u);
+  BOOST_TEST(jobs[1].arg == 3);
+  BOOST_TEST(jobs[1].inputs.size() == 1u);
+  BOOST_TEST(jobs[2].inputs.size() == 2u);
+  std::istringstream unknown("invert x.txt a.txt\n");
+  BOOST_CHECK_THROW(abramov::parseManifest(unknown), std::invalid_argument);
+  std::istringstream arity("add x.txt a.txt\n");
+  BOOST_CHECK_THROW(abramov::parseManifest(arity), std::invalid_argument);
+  std::istringstream arg("power x.txt a.txt two\n");
+  BOOST_CHECK_THROW(abramov::parseManifest(arg), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(run_jobs)
+{
+  TempFiles files;
+  files.names = { "batch_a.txt", "batch_b.txt", "batch_c.txt", "batch_mul.txt", "batch_pow.txt", "batch_kron.txt",
+    "batch_det.txt", "batch_bad.txt", "batch_rep.txt", "batch_rep2.txt" };
+  abramov::Matrix< int > a = sample(4, 4, 1, -5, 5, 9);
+  abramov::Matrix< int > b = sample(4, 4, 2, -5, 5, 9);
+  abramov::Matrix< int > c = sample(3, 4, 3, -5, 5, 9);
+  save("batch_a.txt", a);
+  save("batch_b.txt", b);
+  save("batch_c.txt", c);
+  std::istringstream in("multiply batch_mul.txt batch_a.txt batch_b.txt\n"
+    "power batch_pow.txt batch_a.txt 3\n"
+    "kronecker batch_kron.txt batch_c.txt batch_b.txt\n"
+    "determinant batch_det.txt batch_a.txt\n"
+    "multiply batch_bad.txt batch_c.txt batch_c.txt\n"
+    "add batch_bad.txt batch_a.txt batch_missing.txt\n"
+    "report batch_rep.txt batch_a.txt batch_b.txt batch_c.txt\n");
+  std::vector< abramov::BatchJob > jobs = abramov::parseManifest(in);
+  std::ostringstream report;
+  std::vector< abramov::BatchStatus > status = abramov::runBatch< int >(jobs, 3, 0, &report);
+  BOOST_TEST(status.size() == jobs.size());
+  BOOST_TEST(status[0].ok);
+  BOOST_TEST(!status[4].ok);
+  BOOST_TEST(!status[5].ok);
+  BOOST_TEST(status[6].ok);
+  BOOST_TEST((load("batch_mul.txt", 4, 4) == a * b));
+  BOOST_TEST((load("batch_pow.txt", 4, 4) == a.power(3)));
+  BOOST_TEST((load("batch_kron.txt", 12, 16) == abramov::Matrix< int >::kroneckerProduct(c, b)));
+  BOOST_TEST(slurp("batch_det.txt") == std::to_string(a.determinant()) + "\n");
+  std::ostringstream expected;
+  abramov::writeReport(a, b, &c, expected);
+  BOOST_TEST(slurp("batch_rep.txt") == expected.str());
+  BOOST_TEST(report.str().find("jobs 7, failed 2") != std::string::npos);
+  BOOST_TEST(report.str().find("failed: Matrix dimensions do not agree") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(memory_budget)
+{
+  TempFiles files;
+  std::string jobs_text;
+  for (int i = 0; i < 12; ++i)
+  {
+    std::string input = "batch_in" + std::to_string(i) + ".txt";
+    std::string output = "batch_out" + std::to_string(i) + ".txt";
+    files.names.push_back(input);
+    files.names.push_back(output);
+    save(input, sample(6 + i, 6 + i, i, -5, 5, 9));
+    jobs_text += "transpose " + output + " " + input + "\n";
+  }
+  std::istringstream in(jobs_text);
+  std::vector< abramov::BatchJob > jobs = abramov::parseManifest(in);
+  abramov::MemoryBudget budget(1);
+  size_t largest = 0;
+  for (const abramov::BatchJob &job : jobs)
+  {
+    largest = std::max(largest, abramov::runJob< int >(job, budget));
+  }
+  BOOST_TEST(budget.peak() == largest);
+  std::vector< abramov::BatchStatus > status = abramov::runBatch< int >(jobs, 4, 1);
+  for (size_t i = 0; i < status.size(); ++i)
+  {
+    BOOST_TEST(status[i].ok);
+    BOOST_TEST((load("batch_out" + std::to_string(i) + ".txt", 6 + i, 6 + i) == sample(6 + i, 6 + i, i, -5, 5, 9).transpose()));
+  }
+}
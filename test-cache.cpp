@@ -0,0 +1,126 @@
+#define BOOST_TEST_MODULE cache
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "cache.hpp"
+#include "test-sample.hpp"
+
+BOOST_AUTO_TEST_CASE(matrix_memo)
+{
+  abramov::Matrix< int > m = sample(5, 5, 1, -4, 4, 7);
+  abramov::Matrix< int > plain = m;
+  BOOST_TEST(!m.isCached());
+  m.enableCache();
+  BOOST_TEST(m.isCached());
+  BOOST_TEST(m.determinant() == plain.determinant());
+  BOOST_TEST(m.determinant() == plain.determinant());
+  BOOST_TEST(m.rank() == plain.rank());
+  BOOST_TEST(m.trace() == plain.trace());
+  BOOST_TEST((m.inverse().second == plain.inverse().second));
+  abramov::Matrix< int > copy = m;
+  BOOST_TEST(copy.isCached());
+  BOOST_TEST(copy.determinant() == plain.determinant());
+  m += plain;
+  plain += plain;
+  BOOST_TEST(m.determinant() == plain.determinant());
+  BOOST_TEST(m.trace() == plain.trace());
+  m *= 3;
+  plain *= 3;
+  BOOST_TEST(m.trace() == plain.trace());
+  m[0][0] = 100;
+  plain[0][0] = 100;
+  BOOST_TEST(m.determinant() == plain.determinant());
+  std::istringstream in("2 2\n1 2\n3 4\n");
+  m.read(in);
+  BOOST_TEST(m.isCached());
+  BOOST_TEST(m.determinant() == -2);
+  m = sample(3, 3, 4, -4, 4, 7);
+  BOOST_TEST(m.isCached());
+  BOOST_TEST(m.determinant() == sample(3, 3, 4, -4, 4, 7).determinant());
+  m.enableCache(false);
+  BOOST_TEST(!m.isCached());
+  BOOST_TEST(m.determinant() == sample(3, 3, 4, -4, 4, 7).determinant());
+}
+
+BOOST_AUTO_TEST_CASE(memo_sees_writes_through_rows)
+{
+  abramov::Matrix< int > m = { { 1, 2 }, { 3, 4 } };
+  m.enableCache();
+  BOOST_TEST(m.determinant() == -2);
+  BOOST_TEST(m.trace() == 5);
+  m[0][0] = 10;
+  BOOST_TEST(m.determinant() == 34);
+  BOOST_TEST(m.trace() == 14);
+  abramov::Matrix< int > copy = m;
+  m[0][1] = 0;
+  BOOST_TEST(m.determinant() == 40);
+  BOOST_TEST(copy.determinant() == 34);
+  BOOST_TEST(m.rank() == 2);
+  m[0][0] = 0;
+  BOOST_TEST(m.rank() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(keys)
+{
+  abramov::Matrix< int > a = sample(4, 4, 1, -4, 4, 7);
+  abramov::Matrix< int > b = a;
+  BOOST_TEST((abramov::cacheKey(a, abramov::CacheOp::rank) == abramov::cacheKey(b, abramov::CacheOp::rank)));
+  BOOST_TEST(!(abramov::cacheKey(a, abramov::CacheOp::rank) == abramov::cacheKey(a, abramov::CacheOp::trace)));
+  b[3][3] += 1;
+  BOOST_TEST(!(abramov::cacheKey(a, abramov::CacheOp::rank) == abramov::cacheKey(b, abramov::CacheOp::rank)));
+  abramov::Matrix< int, abramov::Checked > checked{ { 1, 2 }, { 3, 4 } };
+  abramov::Matrix< int > wrapping{ { 1, 2 }, { 3, 4 } };
+  BOOST_TEST(!(abramov::cacheKey(checked, abramov::CacheOp::trace) == abramov::cacheKey(wrapping, abramov::CacheOp::trace)));
+  abramov::Matrix< int > wide(1, 2, 0);
+  abramov::Matrix< int > tall(2, 1, 0);
+  BOOST_TEST(!(abramov::cacheKey(wide, abramov::CacheOp::rank) == abramov::cacheKey(tall, abramov::CacheOp::rank)));
+}
+
+BOOST_AUTO_TEST_CASE(lru)
+{
+  abramov::ResultCache cache(1 << 20);
+  abramov::Matrix< int > a = sample(6, 6, 2, -4, 4, 7);
+  BOOST_TEST(abramov::cachedDeterminant(a, cache) == a.determinant());
+  BOOST_TEST(cache.misses() == 1u);
+  BOOST_TEST(abramov::cachedDeterminant(abramov::Matrix< int >(a), cache) == a.determinant());
+  BOOST_TEST(cache.hits() == 1u);
+  BOOST_TEST(abramov::cachedRank(a, cache) == a.rank());
+  BOOST_TEST(abramov::cachedTrace(a, cache) == a.trace());
+  auto inv = abramov::cachedInverse(a, cache);
+  auto again = abramov::cachedInverse(a, cache);
+  BOOST_TEST(again.first == inv.first);
+  BOOST_TEST((again.second == a.inverse().second));
+  BOOST_TEST(cache.size() == 4u);
+  BOOST_TEST(cache.hits() == 2u);
+  cache.setBudget(cache.bytes() - 1);
+  BOOST_TEST(cache.size() == 3u);
+  abramov::cachedDeterminant(a, cache);
+  BOOST_TEST(cache.hits() == 2u);
+  cache.setBudget(0);
+  BOOST_TEST(cache.size() == 0u);
+  BOOST_TEST(cache.bytes() == 0u);
+  abramov::Matrix< int > singular(3, 3, 1);
+  BOOST_CHECK_THROW(abramov::cachedInverse(singular, cache), std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(disk)
+{
+  std::filesystem::path dir = std::filesystem::temp_directory_path() / "abramov_cache_test";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  abramov::Matrix< long long > a{ { 3, 1, 2 }, { 4, 1, 5 }, { 9, 2, 6 } };
+  {
+    abramov::ResultCache cache(1 << 20, dir.string());
+    BOOST_TEST(abramov::cachedDeterminant(a, cache) == a.determinant());
+    BOOST_TEST((abramov::cachedInverse(a, cache).second == a.inverse().second));
+  }
+  abramov::ResultCache cache(1 << 20, dir.string());
+  BOOST_TEST(abramov::cachedDeterminant(a, cache) == a.determinant());
+  BOOST_TEST((abramov::cachedInverse(a, cache).second == a.inverse().second));
+  BOOST_TEST(cache.hits() == 2u);
+  BOOST_TEST(cache.misses() == 0u);
+  std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,174 @@
+#define BOOST_TEST_MODULE distributed
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "distributed.hpp"
+#include "test-sample.hpp"
+
+BOOST_AUTO_TEST_CASE(process_grid)
+{
+  BOOST_TEST(abramov::processGrid(1).rows == 1);
+  BOOST_TEST(abramov::processGrid(4).rows == 2);
+  BOOST_TEST(abramov::processGrid(4).cols == 2);
+  BOOST_TEST(abramov::processGrid(6).rows == 2);
+  BOOST_TEST(abramov::processGrid(6).cols == 3);
+  BOOST_TEST(abramov::processGrid(7).rows == 1);
+  BOOST_TEST(abramov::processGrid(7).cols == 7);
+}
+
+BOOST_AUTO_TEST_CASE(block_cyclic_layout)
+{
+  for (size_t n : { 0, 1, 7, 16, 37 })
+  {
+    for (size_t block : { 1, 3, 8 })
+    {
+      for (size_t count : { 1, 2, 3 })
+      {
+        std::vector< int > seen(n, 0);
+        size_t total = 0;
+        for (size_t index = 0; index < count; ++index)
+        {
+          size_t extent = abramov::cyclicExtent(n, block, index, count);
+          total += extent;
+          for (size_t local = 0; local < extent; ++local)
+          {
+            size_t global = abramov::cyclicGlobal(local, block, index, count);
+            BOOST_TEST(global < n);
+            if (global < n)
+            {
+              ++seen[global];
+            }
+          }
+        }
+        BOOST_TEST(total == n);
+        BOOST_TEST(std::count(seen.begin(), seen.end(), 1) == static_cast< long >(n));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(multiply_matches_local)
+{
+  abramov::Matrix< int > a = sample< int >(37, 23, 1);
+  abramov::Matrix< int > b = sample< int >(23, 41, 2);
+  abramov::Matrix< int > want = a * b;
+  for (size_t processes : { 1, 2, 3, 4, 6 })
+  {
+    for (size_t block : { 1, 8, 64 })
+    {
+      abramov::Matrix< int > got;
+      abramov::runProcesses(processes, [&](abramov::Transport &transport)
+      {
+        abramov::Matrix< int > res = abramov::distributedMultiply(a, b, transport, block);
+        if (!transport.rank())
+        {
+          got = std::move(res);
+        }
+      });
+      BOOST_TEST((got == want));
+    }
+  }
+  abramov::Matrix< short > c = sample< short >(9, 7, 4);
+  abramov::Matrix< short > d = sample< short >(7, 5, 5);
+  c[0][0] = std::numeric_limits< short >::min();
+  d[0][0] = std::numeric_limits< short >::min();
+  abramov::Matrix< short > narrow;
+  abramov::runProcesses(2, [&](abramov::Transport &transport)
+  {
+    abramov::Matrix< short > res = abramov::distributedMultiply(c, d, transport, 2);
+    if (!transport.rank())
+    {
+      narrow = std::move(res);
+    }
+  });
+  BOOST_TEST((narrow == c * d));
+}
+
+BOOST_AUTO_TEST_CASE(multiply_overflow_policies)
+{
+  abramov::Matrix< int > a(5, 5, std::numeric_limits< int >::max());
+  abramov::Matrix< int > want = a * a;
+  abramov::Matrix< int > got;
+  abramov::runProcesses(4, [&](abramov::Transport &transport)
+  {
+    abramov::Matrix< int > res = abramov::distributedMultiply(a, a, transport, 2);
+    if (!transport.rank())
+    {
+      got = std::move(res);
+    }
+  });
+  BOOST_TEST((got == want));
+  using Checked = abramov::Matrix< int, abramov::Checked >;
+  Checked c(5, 5, std::numeric_limits< int >::max());
+  BOOST_CHECK_THROW(abramov::runProcesses(4, [&](abramov::Transport &transport)
+  {
+    abramov::distributedMultiply(c, c, transport, 2);
+  }), std::overflow_error);
+  using Saturating = abramov::Matrix< int, abramov::Saturating >;
+  Saturating s = sample< int, abramov::Saturating >(9, 9, 3);
+  s[0][0] = std::numeric_limits< int >::max();
+  Saturating s2 = s * s;
+  Saturating sg;
+  abramov::runProcesses(3, [&](abramov::Transport &transport)
+  {
+    Saturating res = abramov::distributedMultiply(s, s, transport, 2);
+    if (!transport.rank())
+    {
+      sg = std::move(res);
+    }
+  });
+  BOOST_TEST((sg == s2));
+}
+
+BOOST_AUTO_TEST_CASE(transpose_and_kronecker)
+{
+  abramov::Matrix< long long > a = sample< long long >(19, 11, 4);
+  abramov::Matrix< long long > b = sample< long long >(3, 5, 5);
+  abramov::Matrix< long long > kron = abramov::Matrix< long long >::kroneckerProduct(a, b);
+  for (size_t processes : { 1, 2, 4, 5 })
+  {
+    abramov::Matrix< long long > t;
+    abramov::Matrix< long long > k;
+    abramov::runProcesses(processes, [&](abramov::Transport &transport)
+    {
+      abramov::Matrix< long long > x = abramov::distributedTranspose(a, transport, 4);
+      abramov::Matrix< long long > y = abramov::distributedKronecker(a, b, transport);
+      if (!transport.rank())
+      {
+        t = std::move(x);
+        k = std::move(y);
+      }
+    });
+    BOOST_TEST((t == a.transpose()));
+    BOOST_TEST((k == kron));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+  abramov::Matrix< int > a = sample< int >(3, 4, 6);
+  BOOST_CHECK_THROW(abramov::runProcesses(3, [&](abramov::Transport &transport)
+  {
+    abramov::distributedMultiply(a, a, transport);
+  }), std::invalid_argument);
+  BOOST_CHECK_THROW(abramov::runProcesses(0, [](abramov::Transport &)
+  {}), std::invalid_argument);
+  BOOST_CHECK_THROW(abramov::runProcesses(2, [](abramov::Transport &transport)
+  {
+    if (transport.rank())
+    {
+      throw std::runtime_error("Worker failed\n");
+    }
+  }), std::runtime_error);
+  BOOST_CHECK_THROW(abramov::runProcesses(2, [](abramov::Transport &transport)
+  {
+    int value = 0;
+    if (transport.rank())
+    {
+      throw std::runtime_error("Worker failed\n");
+    }
+    transport.receive(1, &value, sizeof(value));
+  }), std::runtime_error);
+}
@@ -0,0 +1,142 @@
+#define BOOST_TEST_MODULE eigen
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <vector>
+#include "eigen.hpp"
+#include "test-sample.hpp"
+
+namespace
+{
+  template< class T >
+  abramov::Matrix< T > shifted(const abramov::Matrix< T > &a, T x)
+  {
+    abramov::Matrix< T > res(a.getRows(), a.getCols(), 0);
+    for (size_t i = 0; i < a.getRows(); ++i)
+    {
+      for (size_t j = 0; j < a.getCols(); ++j)
+      {
+        res[i][j] = static_cast< T >((i == j ? x : T(0)) - a[i][j]);
+      }
+    }
+    return res;
+  }
+
+  void expectEigenvalues(std::vector< std::complex< double > > got, std::vector< std::complex< double > > want)
+  {
+    BOOST_TEST(got.size() == want.size());
+    for (const auto &w : want)
+    {
+      double best = INFINITY;
+      for (const auto &g : got)
+      {
+        best = std::min(best, std::abs(g - w));
+      }
+      BOOST_TEST(best < 1e-8);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(small_polynomials)
+{
+  abramov::Matrix< int > a{ { 2, 1 }, { 1, 2 } };
+  auto poly = abramov::characteristicPolynomial(a);
+  BOOST_TEST(poly.degree() == 2);
+  BOOST_TEST((poly.coefficients[0] == abramov::BigInt(3)));
+  BOOST_TEST((poly.coefficients[1] == abramov::BigInt(-4)));
+  BOOST_TEST((poly.coefficients[2] == abramov::BigInt(1)));
+  BOOST_TEST((poly.trace() == abramov::BigInt(4)));
+  BOOST_TEST((poly.determinant() == abramov::BigInt(3)));
+  abramov::Matrix< int > empty;
+  auto unit = abramov::characteristicPolynomial(empty);
+  BOOST_TEST(unit.degree() == 0);
+  BOOST_TEST((unit.determinant() == abramov::BigInt(1)));
+  abramov::Matrix< int > zero(4, 4, 0);
+  auto monomial = abramov::characteristicPolynomial(zero, abramov::Charpoly::Berkowitz);
+  for (size_t k = 0; k < 4; ++k)
+  {
+    BOOST_TEST(monomial.coefficients[k].isZero());
+  }
+  abramov::Matrix< int > wide(2, 3, 1);
+  BOOST_CHECK_THROW(abramov::characteristicPolynomial(wide), std::logic_error);
+  BOOST_CHECK_THROW(abramov::eigenvalues(wide), std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(methods_agree_with_determinants)
+{
+  for (size_t n : { 1, 3, 7, 12 })
+  {
+    abramov::Matrix< long long > a = sample< long long >(n, n, n, -9, 9);
+    auto hessenberg = abramov::characteristicPolynomial(a, abramov::Charpoly::Hessenberg, 2);
+    auto berkowitz = abramov::characteristicPolynomial(a, abramov::Charpoly::Berkowitz, 1);
+    BOOST_TEST(hessenberg.coefficients.size() == n + 1);
+    for (size_t k = 0; k <= n; ++k)
+    {
+      BOOST_TEST((hessenberg.coefficients[k] == berkowitz.coefficients[k]));
+    }
+    BOOST_TEST((hessenberg.trace() == abramov::BigInt(a.trace())));
+    BOOST_TEST((hessenberg.determinant() == abramov::exactDeterminant(a)));
+    for (long long x : { -3LL, 2LL, 5LL })
+    {
+      BOOST_TEST((hessenberg(abramov::BigInt(x)) == abramov::exactDeterminant(shifted(a, x))));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(large_coefficients)
+{
+  abramov::Matrix< long long > a = sample< long long >(10, 10, 3, -1000000000, 1000000000);
+  auto poly = abramov::characteristicPolynomial(a);
+  BOOST_TEST((poly.determinant() == abramov::exactDeterminant(a)));
+  BOOST_TEST((poly(abramov::BigInt(7)) == abramov::exactDeterminant(shifted(a, 7LL))));
+}
+
+BOOST_AUTO_TEST_CASE(known_eigenvalues)
+{
+  expectEigenvalues(abramov::eigenvalues(abramov::Matrix< int >{ { 2, 1 }, { 1, 2 } }), { 1.0, 3.0 });
+  using C = std::complex< double >;
+  expectEigenvalues(abramov::eigenvalues(abramov::Matrix< int >{ { 0, -1 }, { 1, 0 } }), { C(0, -1), C(0, 1) });
+  abramov::Matrix< int > companion{ { 0, 0, 0, -24 }, { 1, 0, 0, 50 }, { 0, 1, 0, -35 }, { 0, 0, 1, 10 } };
+  expectEigenvalues(abramov::eigenvalues(companion), { 1.0, 2.0, 3.0, 4.0 });
+  abramov::Matrix< int > triangular{ { 5, 7, -2 }, { 0, -1, 3 }, { 0, 0, 8 } };
+  expectEigenvalues(abramov::eigenvalues(triangular), { -1.0, 5.0, 8.0 });
+  BOOST_TEST(abramov::eigenvalues(abramov::Matrix< int >()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(eigenvalues_match_polynomial)
+{
+  for (size_t n : { 5, 16, 40, 300 })
+  {
+    abramov::Matrix< int > a = sample< int >(n, n, n + 1, -4, 4);
+    auto values = abramov::eigenvalues(a, 2);
+    BOOST_TEST(values.size() == n);
+    std::complex< double > sum = 0.0;
+    for (const auto &v : values)
+    {
+      sum += v;
+    }
+    BOOST_TEST(std::abs(sum - static_cast< double >(a.trace())) < 1e-7 * n);
+    if (n > 16)
+    {
+      continue;
+    }
+    auto poly = abramov::characteristicPolynomial(a);
+    double scale = 0.0;
+    for (const auto &v : values)
+    {
+      scale = std::max(scale, std::abs(v));
+    }
+    for (const auto &v : values)
+    {
+      std::complex< double > value = 0.0;
+      std::complex< double > derivative = 0.0;
+      for (size_t k = poly.coefficients.size(); k > 0; --k)
+      {
+        derivative = derivative * v + value;
+        value = value * v + std::stod(poly.coefficients[k - 1].toString());
+      }
+      BOOST_TEST(std::abs(value / derivative) < 1e-6 * std::max(1.0, scale));
+    }
+  }
+}
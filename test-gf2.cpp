@@ -0,0 +1,196 @@
+#define BOOST_TEST_MODULE gf2
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+#include "gf2.hpp"
+
+namespace
+{
+  abramov::Gf2Matrix randomBits(size_t m, size_t n, std::mt19937 &gen, double density = 0.5)
+  {
+    std::bernoulli_distribution bit(density);
+    abramov::Gf2Matrix res(m, n);
+    for (size_t i = 0; i < m; ++i)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        res.set(i, j, bit(gen));
+      }
+    }
+    return res;
+  }
+
+  abramov::Gf2Matrix naiveProduct(const abramov::Gf2Matrix &a, const abramov::Gf2Matrix &b)
+  {
+    abramov::Gf2Matrix res(a.getRows(), b.getCols());
+    for (size_t i = 0; i < a.getRows(); ++i)
+    {
+      for (size_t j = 0; j < b.getCols(); ++j)
+      {
+        bool sum = false;
+        for (size_t k = 0; k < a.getCols(); ++k)
+        {
+          sum ^= a.get(i, k) && b.get(k, j);
+        }
+        res.set(i, j, sum);
+      }
+    }
+    return res;
+  }
+
+  size_t naiveRank(abramov::Gf2Matrix a)
+  {
+    size_t r = 0;
+    for (size_t c = 0; c < a.getCols() && r < a.getRows(); ++c)
+    {
+      size_t p = r;
+      while (p < a.getRows() && !a.get(p, c))
+      {
+        ++p;
+      }
+      if (p == a.getRows())
+      {
+        continue;
+      }
+      for (size_t j = 0; j < a.getCols(); ++j)
+      {
+        bool t = a.get(p, j);
+        a.set(p, j, a.get(r, j));
+        a.set(r, j, t);
+      }
+      for (size_t i = 0; i < a.getRows(); ++i)
+      {
+        if (i != r && a.get(i, c))
+        {
+          for (size_t j = 0; j < a.getCols(); ++j)
+          {
+            a.set(i, j, a.get(i, j) != a.get(r, j));
+          }
+        }
+      }
+      ++r;
+    }
+    return r;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(conversions)
+{
+  abramov::Matrix< int > a{ { 1, 2, -3 }, { 4, -5, 0 } };
+  abramov::Gf2Matrix g(a);
+  BOOST_TEST(g.getRows() == 2);
+  BOOST_TEST(g.getCols() == 3);
+  BOOST_TEST((g.toMatrix< int >() == abramov::Matrix< int >{ { 1, 0, 1 }, { 0, 1, 0 } }));
+  BOOST_TEST((g.transpose().toMatrix< int >() == abramov::Matrix< int >{ { 1, 0 }, { 0, 1 }, { 1, 0 } }));
+  BOOST_TEST((g + g == abramov::Gf2Matrix(2, 3)));
+  BOOST_TEST((abramov::Gf2Matrix::identity(3).toMatrix< long long >() == abramov::Matrix< long long >{ { 1, 0, 0 },
+    { 0, 1, 0 }, { 0, 0, 1 } }));
+  BOOST_CHECK_THROW(g + abramov::Gf2Matrix(3, 2), std::invalid_argument);
+  BOOST_CHECK_THROW(g * g, std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(kernels_agree)
+{
+  std::mt19937_64 gen(1);
+  std::vector< uint64_t > a(37);
+  std::vector< uint64_t > b(37);
+  for (size_t i = 0; i < a.size(); ++i)
+  {
+    a[i] = gen();
+    b[i] = gen();
+  }
+  std::vector< uint64_t > want = a;
+  abramov::xorRowsPortable(want.data(), b.data(), want.size());
+  std::vector< uint64_t > got = a;
+  abramov::xorKernel()(got.data(), b.data(), got.size());
+  BOOST_TEST((got == want));
+  for (size_t i = 0; i < a.size(); ++i)
+  {
+    BOOST_TEST(want[i] == (a[i] ^ b[i]));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(multiply_matches_naive)
+{
+  std::mt19937 gen(4);
+  for (auto [m, k, n] : { std::tuple< size_t, size_t, size_t >{ 1, 1, 1 }, { 3, 7, 5 }, { 64, 64, 64 },
+    { 65, 129, 70 }, { 200, 90, 301 } })
+  {
+    abramov::Gf2Matrix a = randomBits(m, k, gen);
+    abramov::Gf2Matrix b = randomBits(k, n, gen);
+    abramov::Gf2Matrix want = naiveProduct(a, b);
+    BOOST_TEST((a * b == want));
+    BOOST_TEST((abramov::gf2Multiply(a, b, 3) == want));
+    abramov::Matrix< int > ints = a.toMatrix< int >() * b.toMatrix< int >();
+    BOOST_TEST((abramov::Gf2Matrix(ints) == want));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(rank_and_determinant)
+{
+  std::mt19937 gen(9);
+  for (auto [m, n] : { std::pair< size_t, size_t >{ 1, 1 }, { 5, 5 }, { 9, 30 }, { 70, 20 }, { 100, 100 },
+    { 130, 257 } })
+  {
+    for (double density : { 0.02, 0.5 })
+    {
+      abramov::Gf2Matrix a = randomBits(m, n, gen, density);
+      size_t want = naiveRank(a);
+      BOOST_TEST(a.rank() == want);
+      BOOST_TEST(a.rank(2) == want);
+      abramov::Gf2Matrix reduced = a;
+      BOOST_TEST(reduced.echelonize(true, 3) == want);
+      BOOST_TEST(reduced.rank() == want);
+      for (size_t i = want; i < m; ++i)
+      {
+        for (size_t j = 0; j < n; ++j)
+        {
+          BOOST_TEST(!reduced.get(i, j));
+        }
+      }
+      if (m == n)
+      {
+        BOOST_TEST(a.determinant() == (want == n ? 1 : 0));
+      }
+    }
+  }
+  abramov::Gf2Matrix dependent(abramov::Matrix< int >{ { 1, 1, 0 }, { 0, 1, 1 }, { 1, 0, 1 } });
+  BOOST_TEST(dependent.rank() == 2);
+  BOOST_TEST(dependent.determinant() == 0);
+  BOOST_CHECK_THROW(abramov::Gf2Matrix(2, 3).determinant(), std::logic_error);
+  BOOST_TEST(abramov::Gf2Matrix().rank() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(inverse_and_solve)
+{
+  std::mt19937 gen(21);
+  for (size_t n : { 1, 2, 17, 64, 100, 150 })
+  {
+    abramov::Gf2Matrix a = randomBits(n, n, gen);
+    while (a.rank() != n)
+    {
+      a = randomBits(n, n, gen);
+    }
+    abramov::Gf2Matrix inv = a.inverse(2);
+    BOOST_TEST((a * inv == abramov::Gf2Matrix::identity(n)));
+    BOOST_TEST((inv * a == abramov::Gf2Matrix::identity(n)));
+    abramov::Gf2Matrix b = randomBits(n, 3, gen);
+    abramov::Gf2Matrix x = a.solve(b);
+    BOOST_TEST((a * x == b));
+    BOOST_TEST((x == inv * b));
+  }
+  abramov::Gf2Matrix wide = randomBits(40, 90, gen);
+  abramov::Gf2Matrix x0 = randomBits(90, 2, gen);
+  abramov::Gf2Matrix b = wide * x0;
+  BOOST_TEST((wide * wide.solve(b) == b));
+  abramov::Gf2Matrix singular(abramov::Matrix< int >{ { 1, 1 }, { 1, 1 } });
+  BOOST_CHECK_THROW(singular.inverse(), std::logic_error);
+  BOOST_CHECK_THROW(singular.solve(abramov::Gf2Matrix(abramov::Matrix< int >{ { 1 }, { 0 } })), std::logic_error);
+  abramov::Gf2Matrix consistent = singular.solve(abramov::Gf2Matrix(abramov::Matrix< int >{ { 1 }, { 1 } }));
+  BOOST_TEST((singular * consistent == abramov::Gf2Matrix(abramov::Matrix< int >{ { 1 }, { 1 } })));
+  BOOST_CHECK_THROW(singular.solve(abramov::Gf2Matrix(3, 1)), std::invalid_argument);
+  BOOST_CHECK_THROW(wide.inverse(), std::logic_error);
+}
@@ -0,0 +1,171 @@
+#define BOOST_TEST_MODULE knn
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "knn.hpp"
+
+namespace
+{
+  template< class T, size_t N >
+  std::vector< abramov::Vector< T, N > > cloud(size_t n, int seed)
+  {
+    std::vector< abramov::Vector< T, N > > res;
+    for (size_t k = 0; k < n; ++k)
+    {
+      abramov::Vector< T, N > v;
+      for (size_t i = 0; i < N; ++i)
+      {
+        v[i] = static_cast< T >(static_cast< int >((k * k * 31 + i * 17 + k * i * 7 + seed * 13) % 41) - 20);
+      }
+      v[0] = static_cast< T >(v[0] == 0 ? 1 : v[0]);
+      res.push_back(v);
+    }
+    return res;
+  }
+
+  template< class T, size_t N >
+  std::vector< abramov::Neighbour > reference(const std::vector< abramov::Vector< T, N > > &points,
+    const abramov::Vector< T, N > &q, size_t k, abramov::Metric metric)
+  {
+    std::vector< abramov::Neighbour > all;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      double d = metric == abramov::Metric::Cosine ? 1.0 - std::cos(q.angle(points[i])) : q.distance(points[i]);
+      all.push_back({ i, d });
+    }
+    std::stable_sort(all.begin(), all.end(), [](const abramov::Neighbour &a, const abramov::Neighbour &b)
+    {
+      return a.distance < b.distance;
+    });
+    all.resize(std::min(k, all.size()));
+    return all;
+  }
+
+  void expectSame(const std::vector< abramov::Neighbour > &got, const std::vector< abramov::Neighbour > &want)
+  {
+    BOOST_TEST(got.size() == want.size());
+    for (size_t i = 0; i < std::min(got.size(), want.size()); ++i)
+    {
+      BOOST_TEST(std::abs(got[i].distance - want[i].distance) < 1e-9);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(flat_matches_reference)
+{
+  auto points = cloud< float, 24 >(200, 1);
+  auto queries = cloud< float, 24 >(10, 2);
+  for (auto metric : { abramov::Metric::Euclidean, abramov::Metric::Cosine })
+  {
+    abramov::FlatIndex< float, 24 > index(points, metric);
+    BOOST_TEST(index.size() == points.size());
+    for (const auto &q : queries)
+    {
+      expectSame(index.query(q, 5), reference(points, q, 5, metric));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(kd_tree_matches_reference)
+{
+  auto points = cloud< int, 3 >(500, 3);
+  auto queries = cloud< int, 3 >(20, 4);
+  for (auto metric : { abramov::Metric::Euclidean, abramov::Metric::Cosine })
+  {
+    for (size_t threads : { 1, 4 })
+    {
+      abramov::KdTree< int, 3 > tree(points, metric, threads);
+      for (const auto &q : queries)
+      {
+        expectSame(tree.query(q, 7), reference(points, q, 7, metric));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(kd_tree_indices)
+{
+  auto points = cloud< double, 2 >(100, 5);
+  abramov::KdTree< double, 2 > tree(points);
+  for (size_t i = 0; i < points.size(); i += 9)
+  {
+    auto res = tree.query(points[i], 1);
+    BOOST_TEST(res.size() == 1);
+    BOOST_TEST(res[0].distance == 0.0);
+    BOOST_TEST((tree[res[0].index] == points[i]));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ivf_exhaustive_probes)
+{
+  auto points = cloud< float, 64 >(300, 6);
+  auto queries = cloud< float, 64 >(8, 7);
+  for (auto metric : { abramov::Metric::Euclidean, abramov::Metric::Cosine })
+  {
+    abramov::IvfIndex< float, 64 > index(points, metric, 12, 2);
+    BOOST_TEST(index.lists() == 12);
+    BOOST_TEST(index.probes() >= 1);
+    index.setProbes(100);
+    BOOST_TEST(index.probes() == 12);
+    for (const auto &q : queries)
+    {
+      expectSame(index.query(q, 10), reference(points, q, 10, metric));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ivf_finds_indexed_points)
+{
+  auto points = cloud< double, 32 >(256, 8);
+  abramov::IvfIndex< double, 32 > index(points);
+  BOOST_TEST(index.lists() == 16);
+  for (size_t i = 0; i < points.size(); i += 17)
+  {
+    auto res = index.query(points[i], 1);
+    BOOST_TEST(res.size() == 1);
+    BOOST_TEST(res[0].distance == 0.0);
+  }
+  BOOST_CHECK_THROW(index.setProbes(0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(batch_queries)
+{
+  auto points = cloud< float, 8 >(150, 9);
+  auto queries = cloud< float, 8 >(13, 10);
+  abramov::FlatIndex< float, 8 > flat(points);
+  abramov::KdTree< float, 8 > tree(points);
+  abramov::IvfIndex< float, 8 > ivf(points, abramov::Metric::Euclidean, 4);
+  ivf.setProbes(4);
+  for (size_t threads : { 1, 3 })
+  {
+    auto a = flat.query(queries, 4, threads);
+    auto b = tree.query(queries, 4, threads);
+    auto c = ivf.query(queries, 4, threads);
+    BOOST_TEST(a.size() == queries.size());
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+      expectSame(b[i], a[i]);
+      expectSame(c[i], a[i]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(edge_cases)
+{
+  auto points = cloud< int, 4 >(5, 11);
+  abramov::FlatIndex< int, 4 > flat(points);
+  abramov::KdTree< int, 4 > tree(points);
+  BOOST_TEST(flat.query(points[0], 0).empty());
+  BOOST_TEST(tree.query(points[0], 0).empty());
+  BOOST_TEST(flat.query(points[0], 10).size() == 5);
+  BOOST_TEST(tree.query(points[0], 10).size() == 5);
+  abramov::KdTree< int, 4 > empty({});
+  BOOST_TEST(empty.query(points[0], 3).empty());
+  abramov::Vector< int, 4 > zero;
+  abramov::FlatIndex< int, 4 > cosine(points, abramov::Metric::Cosine);
+  BOOST_CHECK_THROW(cosine.query(zero, 1), std::logic_error);
+  std::vector< abramov::Vector< int, 4 > > zeros{ zero };
+  using Tree = abramov::KdTree< int, 4 >;
+  BOOST_CHECK_THROW(Tree(zeros, abramov::Metric::Cosine), std::logic_error);
+}
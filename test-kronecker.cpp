@@ -0,0 +1,78 @@
+#define BOOST_TEST_MODULE kronecker
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+#include <vector>
+#include "kronecker.hpp"
+#include "test-sample.hpp"
+
+BOOST_AUTO_TEST_CASE(elements)
+{
+  abramov::Matrix< int > a = sample(3, 2, 1);
+  abramov::Matrix< int > b = sample(2, 4, 2);
+  abramov::KroneckerOperator< int > op(a, b);
+  abramov::Matrix< int > full = abramov::Matrix< int >::kroneckerProduct(a, b);
+  BOOST_TEST(op.getRows() == 6u);
+  BOOST_TEST(op.getCols() == 8u);
+  for (size_t i = 0; i < op.getRows(); ++i)
+  {
+    for (size_t j = 0; j < op.getCols(); ++j)
+    {
+      BOOST_TEST(op(i, j) == full[i][j]);
+    }
+  }
+  BOOST_CHECK_THROW(op(6, 0), std::out_of_range);
+  BOOST_TEST((op.transpose().materialize() == full.transpose()));
+}
+
+BOOST_AUTO_TEST_CASE(multiply_vector)
+{
+  abramov::Matrix< int > a = sample(4, 3, 3);
+  abramov::Matrix< int > b = sample(5, 6, 4);
+  abramov::KroneckerOperator< int > op(a, b);
+  abramov::Matrix< int > full = op.materialize();
+  std::vector< int > x(op.getCols());
+  abramov::Matrix< int > column(op.getCols(), 1, 0);
+  for (size_t i = 0; i < x.size(); ++i)
+  {
+    x[i] = static_cast< int >(i % 7) - 3;
+    column[i][0] = x[i];
+  }
+  abramov::Matrix< int > expected = full * column;
+  std::vector< int > y = op.multiply(x);
+  std::vector< int > parallel = op.multiply(x, 4);
+  BOOST_TEST(y.size() == op.getRows());
+  for (size_t i = 0; i < y.size(); ++i)
+  {
+    BOOST_TEST(y[i] == expected[i][0]);
+    BOOST_TEST(parallel[i] == expected[i][0]);
+  }
+  BOOST_CHECK_THROW(op.multiply(std::vector< int >(3)), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(multiply_matrix)
+{
+  abramov::Matrix< int > a = sample(3, 4, 5);
+  abramov::Matrix< int > b = sample(2, 3, 6);
+  abramov::KroneckerOperator< int > op(a, b);
+  abramov::Matrix< int > x = sample(12, 5, 7);
+  abramov::Matrix< int > expected = op.materialize() * x;
+  BOOST_TEST((op.multiply(x) == expected));
+  BOOST_TEST((op.multiply(x, 3) == expected));
+}
+
+BOOST_AUTO_TEST_CASE(parallel_materialize)
+{
+  abramov::Matrix< int > a = sample(17, 9, 8);
+  abramov::Matrix< int > b = sample(13, 11, 9);
+  abramov::KroneckerOperator< int > op(a, b);
+  BOOST_TEST((op.materialize(4) == abramov::Matrix< int >::kroneckerProduct(a, b)));
+}
+
+BOOST_AUTO_TEST_CASE(checked_policy)
+{
+  abramov::Matrix< int, abramov::Checked > a = { { 1 << 20 } };
+  abramov::Matrix< int, abramov::Checked > b = { { 1 << 20 } };
+  abramov::KroneckerOperator< int, abramov::Checked > op(a, b);
+  BOOST_CHECK_THROW(op(0, 0), std::overflow_error);
+  BOOST_CHECK_THROW(op.materialize(), std::overflow_error);
+}
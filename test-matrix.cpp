@@ -1,5 +1,6 @@
 #define BOOST_TEST_MODULE matrix
 #include <boost/test/unit_test.hpp>
+#include <sstream>
 #include "matrix.hpp"
 
 BOOST_AUTO_TEST_CASE(default_constructor)
@@ -276,3 +277,66 @@ BOOST_AUTO_TEST_CASE(kronecker_product)
   abramov::Matrix< int > res = { { 0, 5, 0, 10 }, { 6, 7, 12, 14 }, { 0, 15, 0, 20 }, { 18, 21, 24, 28 } };
   BOOST_TEST((prod == res));
 }
+
+BOOST_AUTO_TEST_CASE(read_print)
+{
+  std::istringstream in("2 3\n1 -2 3\n+4 5 -6\n");
+  abramov::Matrix< int > m;
+  BOOST_TEST(static_cast< bool >(m.read(in)));
+  abramov::Matrix< int > res = { { 1, -2, 3 }, { 4, 5, -6 } };
+  BOOST_TEST((m == res));
+  std::ostringstream out;
+  m.print(out);
+  BOOST_TEST(out.str() == "1 -2 3\n4 5 -6\n");
+  std::istringstream zeros("1 2\n0000000000000000000000000042 -0000000000000000000000000007\n");
+  BOOST_TEST(static_cast< bool >(m.read(zeros)));
+  BOOST_TEST((m == abramov::Matrix< int >({ { 42, -7 } })));
+}
+
+BOOST_AUTO_TEST_CASE(read_failure)
+{
+  abramov::Matrix< int > m = { { 7 } };
+  std::istringstream in1("2 2\n1 2\n3 x\n");
+  BOOST_TEST(!m.read(in1));
+  std::istringstream in2("1 1\n99999999999\n");
+  BOOST_TEST(!m.read(in2));
+  std::istringstream in3("2 2 1 2 3");
+  BOOST_TEST(!m.read(in3));
+  BOOST_TEST(in3.eof());
+  abramov::Matrix< int > res = { { 7 } };
+  BOOST_TEST((m == res));
+}
+
+BOOST_AUTO_TEST_CASE(parse_format)
+{
+  std::string text = "3 2\n1 2\n-3 4\n5 -6\n";
+  abramov::Matrix< int > m;
+  const char *end = m.parse(text.data(), text.data() + text.size());
+  BOOST_TEST((end != nullptr));
+  abramov::Matrix< int > res = { { 1, 2 }, { -3, 4 }, { 5, -6 } };
+  BOOST_TEST((m == res));
+  std::string out;
+  BOOST_TEST(m.format(out) == "1 2\n-3 4\n5 -6\n");
+  std::string bad = "2 2 1 2 3 y";
+  BOOST_TEST((m.parse(bad.data(), bad.data() + bad.size()) == nullptr));
+  BOOST_TEST((m == res));
+}
+
+BOOST_AUTO_TEST_CASE(parallel_parse)
+{
+  constexpr size_t n = 512;
+  std::string text = std::to_string(n) + " " + std::to_string(n) + "\n";
+  abramov::Matrix< int > res(n, n, 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      res[i][j] = static_cast< int >(i * 1000003 + j * 7919) - 500000000;
+    }
+  }
+  res.format(text);
+  abramov::Matrix< int > m;
+  const char *end = m.parse(text.data(), text.data() + text.size(), 4);
+  BOOST_TEST((end == text.data() + text.size() - 1));
+  BOOST_TEST((m == res));
+}
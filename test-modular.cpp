@@ -0,0 +1,182 @@
+#define BOOST_TEST_MODULE modular
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "bigint.hpp"
+#include "modular.hpp"
+
+namespace
+{
+  abramov::Matrix< long long > factored(size_t n, std::mt19937 &gen, abramov::BigInt &det)
+  {
+    std::uniform_int_distribution< long long > small(-3, 3);
+    std::uniform_int_distribution< long long > large(1, 1000000);
+    abramov::Matrix< long long > l(n, n, 0);
+    abramov::Matrix< long long > u(n, n, 0);
+    det = abramov::BigInt(1);
+    for (size_t i = 0; i < n; ++i)
+    {
+      l[i][i] = 1;
+      for (size_t j = 0; j < i; ++j)
+      {
+        l[i][j] = small(gen);
+      }
+      u[i][i] = large(gen) * (i % 2 ? -1 : 1);
+      det *= abramov::BigInt(u[i][i]);
+      for (size_t j = i + 1; j < n; ++j)
+      {
+        u[i][j] = small(gen);
+      }
+    }
+    return l * u;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(bigint_arithmetic)
+{
+  abramov::BigInt a("123456789012345678901234567890");
+  abramov::BigInt b(-987654321LL);
+  BOOST_TEST((a * b).toString() == "-121932631124828532112482853211126352690");
+  BOOST_TEST((a + b).toString() == "123456789012345678900246913569");
+  BOOST_TEST((b - a).toString() == "-123456789012345678902222222211");
+  BOOST_TEST((a - a).isZero());
+  BOOST_TEST((b < a));
+  BOOST_TEST((-a < b));
+  BOOST_TEST(abramov::BigInt(-5).modSmall(7) == 2u);
+  BOOST_TEST(static_cast< double >(abramov::BigInt(1) - abramov::BigInt(1000)) == -999.0);
+  BOOST_CHECK_THROW(abramov::BigInt("12x"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(bigint_division)
+{
+  abramov::BigInt a("121932631124828532112482853211126352697");
+  abramov::BigInt b("-987654321");
+  BOOST_TEST((a / b).toString() == "-123456789012345678901234567890");
+  BOOST_TEST((a % b).toString() == "7");
+  BOOST_TEST(((-a) % b).toString() == "-7");
+  BOOST_TEST((abramov::BigInt(5) / a).isZero());
+  std::mt19937 gen(7);
+  std::uniform_int_distribution< long long > digit(-999999999, 999999999);
+  for (int iter = 0; iter < 200; ++iter)
+  {
+    abramov::BigInt x(digit(gen));
+    abramov::BigInt y(digit(gen) | 1);
+    for (int k = iter % 7; k > 0; --k)
+    {
+      x = x * abramov::BigInt(digit(gen)) + abramov::BigInt(digit(gen));
+    }
+    for (int k = iter % 4; k > 0; --k)
+    {
+      y = y * abramov::BigInt(digit(gen)) + abramov::BigInt(1);
+    }
+    auto [q, r] = abramov::BigInt::divMod(x, y);
+    BOOST_TEST((q * y + r == x));
+    BOOST_TEST((r.isZero() || r.isNegative() == x.isNegative()));
+    BOOST_TEST(((r.isNegative() ? -r : r) < (y.isNegative() ? -y : y)));
+  }
+  BOOST_CHECK_THROW(a / abramov::BigInt(), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(crt_reconstruct)
+{
+  std::vector< uint32_t > primes = abramov::modularPrimes(0, 3);
+  abramov::CrtBasis basis(primes);
+  abramov::BigInt value("-12345678901234567890123");
+  std::vector< uint32_t > residues;
+  for (uint32_t p : primes)
+  {
+    residues.push_back(value.modSmall(p));
+  }
+  BOOST_TEST((basis.reconstruct(residues.data()) == value));
+}
+
+BOOST_AUTO_TEST_CASE(determinant_matches)
+{
+  std::mt19937 gen(7);
+  std::uniform_int_distribution< int > dist(-9, 9);
+  for (size_t n = 1; n <= 6; ++n)
+  {
+    abramov::Matrix< int > m(n, n, 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        m[i][j] = dist(gen);
+      }
+    }
+    BOOST_TEST((abramov::exactDeterminant(m) == abramov::BigInt(m.determinant())));
+    BOOST_TEST((abramov::exactPermanent(m) == abramov::BigInt(m.perm())));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(large_determinant)
+{
+  std::mt19937 gen(11);
+  abramov::BigInt expected;
+  abramov::Matrix< long long > m = factored(24, gen, expected);
+  BOOST_TEST(expected.bits() > 300u);
+  BOOST_TEST((abramov::exactDeterminant(m) == expected));
+  BOOST_TEST((abramov::exactDeterminant(m, 1) == expected));
+}
+
+BOOST_AUTO_TEST_CASE(adjugate)
+{
+  std::mt19937 gen(13);
+  abramov::BigInt expected;
+  size_t n = 10;
+  abramov::Matrix< long long > m = factored(n, gen, expected);
+  auto [det, adj] = abramov::exactInverse(m);
+  BOOST_TEST((det == expected));
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      abramov::BigInt sum;
+      for (size_t k = 0; k < n; ++k)
+      {
+        sum += abramov::BigInt(m[i][k]) * adj[k * n + j];
+      }
+      BOOST_TEST((sum == (i == j ? det : abramov::BigInt())));
+    }
+  }
+  abramov::Matrix< int > singular = { { 1, 2 }, { 2, 4 } };
+  BOOST_CHECK_THROW(abramov::exactInverse(singular), std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(cramer)
+{
+  std::mt19937 gen(17);
+  abramov::BigInt expected;
+  size_t n = 8;
+  abramov::Matrix< long long > a = factored(n, gen, expected);
+  abramov::Matrix< long long > b(n, 1, 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    b[i][0] = static_cast< long long >(i * i) - 20;
+  }
+  abramov::Matrix< long long > system = abramov::Matrix< long long >::horizontalConcat(a, b);
+  auto [det, numerators] = abramov::exactCramer(system);
+  BOOST_TEST((det == expected));
+  for (size_t i = 0; i < n; ++i)
+  {
+    abramov::BigInt sum;
+    for (size_t k = 0; k < n; ++k)
+    {
+      sum += abramov::BigInt(a[i][k]) * numerators[k];
+    }
+    BOOST_TEST((sum == det * abramov::BigInt(b[i][0])));
+  }
+  abramov::Matrix< int > small = { { 2, 1, 3 }, { 1, 3, 5 } };
+  auto [d, x] = abramov::exactCramer(small);
+  BOOST_TEST((d == abramov::BigInt(5)));
+  BOOST_TEST((x[0] == abramov::BigInt(4)));
+  BOOST_TEST((x[1] == abramov::BigInt(7)));
+}
+
+BOOST_AUTO_TEST_CASE(permanent_of_ones)
+{
+  abramov::Matrix< int > ones(12, 12, 1);
+  BOOST_TEST(abramov::exactPermanent(ones).toString() == "479001600");
+}
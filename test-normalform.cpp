@@ -0,0 +1,265 @@
+#define BOOST_TEST_MODULE normalform
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include <vector>
+#include "normalform.hpp"
+#include "test-sample.hpp"
+
+namespace
+{
+  using Ints = std::vector< abramov::BigInt >;
+
+  Ints multiply(const Ints &a, const Ints &b, size_t m, size_t k, size_t n)
+  {
+    Ints res(m * n);
+    for (size_t i = 0; i < m; ++i)
+    {
+      for (size_t l = 0; l < k; ++l)
+      {
+        if (a[i * k + l].isZero())
+        {
+          continue;
+        }
+        for (size_t j = 0; j < n; ++j)
+        {
+          res[i * n + j] += a[i * k + l] * b[l * n + j];
+        }
+      }
+    }
+    return res;
+  }
+
+  template< class T >
+  void checkHermite(const abramov::Matrix< T > &a, const abramov::HermiteForm &form)
+  {
+    size_t m = a.getRows();
+    size_t n = a.getCols();
+    Ints h = form.h;
+    for (size_t r = 0; r < m; ++r)
+    {
+      size_t lead = r < form.rank() ? form.pivots[r] : n;
+      for (size_t j = 0; j < lead; ++j)
+      {
+        BOOST_TEST(h[r * n + j].isZero());
+      }
+      if (lead == n)
+      {
+        continue;
+      }
+      BOOST_TEST(!h[r * n + lead].isNegative());
+      BOOST_TEST(!h[r * n + lead].isZero());
+      BOOST_TEST((r == 0 || form.pivots[r - 1] < lead));
+      for (size_t above = 0; above < r; ++above)
+      {
+        BOOST_TEST(!h[above * n + lead].isNegative());
+        BOOST_TEST((h[above * n + lead] < h[r * n + lead]));
+      }
+    }
+    if (!form.u.empty())
+    {
+      BOOST_TEST((multiply(form.u, abramov::toBigInts(a), m, m, n) == h));
+    }
+  }
+
+  template< class T >
+  void checkSmith(const abramov::Matrix< T > &a, const abramov::SmithForm &form)
+  {
+    size_t m = a.getRows();
+    size_t n = a.getCols();
+    for (size_t k = 0; k < form.diagonal.size(); ++k)
+    {
+      BOOST_TEST(!form.diagonal[k].isNegative());
+      if (k + 1 < form.diagonal.size() && !form.diagonal[k].isZero())
+      {
+        BOOST_TEST((form.diagonal[k + 1] % form.diagonal[k]).isZero());
+      }
+    }
+    if (form.u.empty())
+    {
+      return;
+    }
+    Ints s = multiply(multiply(form.u, abramov::toBigInts(a), m, m, n), form.v, m, n, n);
+    Ints want(m * n);
+    for (size_t k = 0; k < form.diagonal.size(); ++k)
+    {
+      want[k * n + k] = form.diagonal[k];
+    }
+    BOOST_TEST((s == want));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(known_forms)
+{
+  abramov::Matrix< int > a{ { 2, 3 }, { 4, 5 } };
+  auto h = abramov::hermiteForm(a);
+  BOOST_TEST((h.h == Ints{ 2, 0, 0, 1 }));
+  checkHermite(a, h);
+  abramov::Matrix< int > b{ { 2, 4, 4 }, { -6, 6, 12 }, { 10, -4, -16 } };
+  auto s = abramov::smithForm(b);
+  BOOST_TEST((s.diagonal == Ints{ 2, 6, 12 }));
+  checkSmith(b, s);
+  BOOST_TEST((abramov::smithForm(b, false).diagonal == s.diagonal));
+  abramov::Matrix< int > zero(2, 3, 0);
+  BOOST_TEST(abramov::hermiteForm(zero).rank() == 0);
+  BOOST_TEST(abramov::smithForm(zero).rank() == 0);
+  abramov::Matrix< int > empty;
+  BOOST_TEST(abramov::hermiteForm(empty).h.empty());
+  BOOST_TEST(abramov::smithForm(empty).diagonal.empty());
+}
+
+BOOST_AUTO_TEST_CASE(unimodular)
+{
+  abramov::Matrix< int > identity{ { 1, 0 }, { 0, 1 } };
+  abramov::Matrix< int > a{ { 2, 1 }, { 1, 1 } };
+  abramov::Matrix< int > tall{ { -1, 1 }, { 0, -1 }, { -1, -1 } };
+  for (const abramov::Matrix< int > *m : { &identity, &a, &tall })
+  {
+    for (bool transform : { true, false })
+    {
+      auto h = abramov::hermiteForm(*m, transform);
+      Ints want(m->getRows() * 2);
+      want[0] = abramov::BigInt(1);
+      want[3] = abramov::BigInt(1);
+      BOOST_TEST((h.h == want));
+      BOOST_TEST(h.rank() == 2u);
+      checkHermite(*m, h);
+      auto s = abramov::smithForm(*m, transform);
+      BOOST_TEST((s.diagonal == Ints{ 1, 1 }));
+      checkSmith(*m, s);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(modular_matches_exact)
+{
+  std::mt19937 gen(5);
+  for (size_t n : { 1, 2, 5, 9, 16 })
+  {
+    abramov::Matrix< long long > a = sample< long long >(n, n, gen(), -20, 20);
+    if (abramov::exactDeterminant(a).isZero())
+    {
+      continue;
+    }
+    abramov::Matrix< long long > padded(n + 1, n, 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        padded[i][j] = a[i][j];
+      }
+    }
+    auto modular = abramov::hermiteForm(a, true, 2);
+    auto exact = abramov::hermiteForm(padded, true, 2);
+    checkHermite(a, modular);
+    checkHermite(padded, exact);
+    BOOST_TEST(modular.rank() == n);
+    BOOST_TEST(exact.rank() == n);
+    BOOST_TEST((Ints(exact.h.begin(), exact.h.begin() + n * n) == modular.h));
+    BOOST_TEST((abramov::hermiteForm(padded, false).h == exact.h));
+    abramov::BigInt det = abramov::exactDeterminant(a);
+    Ints reduced = abramov::toBigInts(a);
+    abramov::hermiteModular(reduced, n, n, det.isNegative() ? -det : det, 1);
+    BOOST_TEST((reduced == modular.h));
+    abramov::BigInt product(1);
+    for (size_t i = 0; i < n; ++i)
+    {
+      product *= modular.h[i * n + i];
+    }
+    BOOST_TEST((product == (det.isNegative() ? -det : det)));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(nontrivial_lattices)
+{
+  std::mt19937 gen(11);
+  for (int iter = 0; iter < 6; ++iter)
+  {
+    size_t n = 6;
+    abramov::Matrix< long long > d(n, n, 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      d[i][i] = static_cast< long long >(1 + (i + iter) % 3) * (i > 3 ? 6 : 1);
+    }
+    abramov::Matrix< long long > x = sample< long long >(n, n, gen(), -2, 2);
+    abramov::Matrix< long long > y = sample< long long >(n, n, gen(), -2, 2);
+    abramov::Matrix< long long > a = x * d * y;
+    if (abramov::exactDeterminant(a).isZero())
+    {
+      continue;
+    }
+    auto h = abramov::hermiteForm(a, true, 1);
+    checkHermite(a, h);
+    auto s = abramov::smithForm(a, true, 1);
+    checkSmith(a, s);
+    BOOST_TEST((abramov::smithForm(a, false, 2).diagonal == s.diagonal));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(nongeneric_lattice_correction)
+{
+  std::mt19937 gen(23);
+  size_t n = 24;
+  abramov::Matrix< long long > d(n, n, 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    d[i][i] = i % 5 ? 1 : 6;
+  }
+  abramov::Matrix< long long > a = sample< long long >(n, n, gen(), -1, 1) * d * sample< long long >(n, n, gen(), -1, 1);
+  abramov::BigInt det = abramov::exactDeterminant(a);
+  BOOST_REQUIRE(!det.isZero());
+  auto h = abramov::hermiteForm(a, false, 2);
+  checkHermite(a, h);
+  Ints reduced = abramov::toBigInts(a);
+  abramov::hermiteModular(reduced, n, n, det.isNegative() ? -det : det, 2);
+  BOOST_TEST((reduced == h.h));
+  auto s = abramov::smithForm(a, false, 2);
+  checkSmith(a, s);
+  for (size_t i = n - 5; i < n; ++i)
+  {
+    BOOST_TEST((s.diagonal[i] % abramov::BigInt(6)).isZero());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(rectangular_and_singular)
+{
+  std::mt19937 gen(3);
+  for (auto [m, n] : { std::pair< size_t, size_t >{ 4, 7 }, { 7, 4 }, { 6, 6 }, { 1, 5 } })
+  {
+    abramov::Matrix< int > a = sample< int >(m, n, gen(), -9, 9);
+    if (m == n)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        a[m - 1][j] = a[0][j] * 2 - a[1][j] * 3;
+      }
+    }
+    auto h = abramov::hermiteForm(a);
+    checkHermite(a, h);
+    auto s = abramov::smithForm(a);
+    checkSmith(a, s);
+    BOOST_TEST(h.rank() == s.rank());
+    BOOST_TEST(static_cast< int >(h.rank()) == a.rank());
+    BOOST_TEST((abramov::smithForm(a, false).diagonal == s.diagonal));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(larger_without_transforms)
+{
+  std::mt19937 gen(19);
+  size_t n = 40;
+  abramov::Matrix< int > a = sample< int >(n, n, gen(), -50, 50);
+  abramov::BigInt det = abramov::exactDeterminant(a);
+  auto h = abramov::hermiteForm(a, false);
+  checkHermite(a, h);
+  auto s = abramov::smithForm(a, false);
+  checkSmith(a, s);
+  abramov::BigInt hp(1);
+  abramov::BigInt sp(1);
+  for (size_t i = 0; i < n; ++i)
+  {
+    hp *= h.h[i * n + i];
+    sp *= s.diagonal[i];
+  }
+  BOOST_TEST((hp == (det.isNegative() ? -det : det)));
+  BOOST_TEST((sp == hp));
+}
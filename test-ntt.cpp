@@ -0,0 +1,232 @@
+#define BOOST_TEST_MODULE ntt
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "structured.hpp"
+#include "test-sample.hpp"
+
+namespace
+{
+  template< class T >
+  std::vector< T > randomVector(size_t n, std::mt19937_64 &gen, unsigned long long range = 0)
+  {
+    std::vector< T > res(n);
+    for (T &x : res)
+    {
+      x = range ? static_cast< T >(static_cast< long long >(gen() % (2 * range + 1)) - static_cast< long long >(range)) :
+        static_cast< T >(gen());
+    }
+    return res;
+  }
+
+  template< class T >
+  std::vector< T > naiveConvolve(const std::vector< T > &a, const std::vector< T > &b)
+  {
+    using U = std::make_unsigned_t< T >;
+    std::vector< T > res(a.size() + b.size() - 1, T(0));
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+      for (size_t j = 0; j < b.size(); ++j)
+      {
+        res[i + j] = static_cast< T >(static_cast< U >(res[i + j]) + static_cast< U >(a[i]) * static_cast< U >(b[j]));
+      }
+    }
+    return res;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(transforms_are_cyclic_convolutions)
+{
+  std::mt19937_64 gen(2);
+  for (const abramov::NttPrime &prime : abramov::nttPrimes())
+  {
+    BOOST_TEST(abramov::isPrime(prime.modulus));
+    BOOST_TEST(prime.order >= 23);
+    BOOST_TEST(abramov::powMod(prime.root, (prime.modulus - 1) / 2, prime.modulus) == prime.modulus - 1);
+    for (size_t n : { 1, 2, 8, 64 })
+    {
+      abramov::NttPlan plan(prime, n);
+      std::vector< uint32_t > a(n);
+      std::vector< uint32_t > b(n);
+      for (size_t i = 0; i < n; ++i)
+      {
+        a[i] = static_cast< uint32_t >(gen() % prime.modulus);
+        b[i] = static_cast< uint32_t >(gen() % prime.modulus);
+      }
+      std::vector< uint32_t > want(n, 0);
+      for (size_t i = 0; i < n; ++i)
+      {
+        for (size_t j = 0; j < n; ++j)
+        {
+          want[(i + j) % n] = (want[(i + j) % n] + abramov::mulMod(a[i], b[j], prime.modulus)) % prime.modulus;
+        }
+      }
+      plan.forward(a.data());
+      plan.forward(b.data());
+      for (size_t i = 0; i < n; ++i)
+      {
+        a[i] = prime.multiply(a[i], b[i]);
+      }
+      plan.inverse(a.data());
+      BOOST_TEST((a == want));
+    }
+  }
+  BOOST_CHECK_THROW(abramov::NttPlan(abramov::nttPrimes()[0], 12), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(convolutions_match_naive)
+{
+  std::mt19937_64 gen(5);
+  for (size_t n : { 1, 3, 64, 65, 300, 1025 })
+  {
+    std::vector< int > a = randomVector< int >(n, gen, 1000);
+    std::vector< int > b = randomVector< int >(n + 17, gen, 1000);
+    BOOST_TEST((abramov::convolve(a, b) == naiveConvolve(a, b)));
+    BOOST_TEST((abramov::convolve< abramov::Checked >(a, b, 2) == naiveConvolve(a, b)));
+    std::vector< long long > c = randomVector< long long >(n, gen);
+    std::vector< long long > d = randomVector< long long >(n + 3, gen);
+    BOOST_TEST((abramov::convolve(c, d) == naiveConvolve(c, d)));
+    std::vector< unsigned > e = randomVector< unsigned >(n, gen);
+    std::vector< unsigned > f = randomVector< unsigned >(n, gen);
+    std::vector< unsigned > linear = naiveConvolve(e, f);
+    std::vector< unsigned > cyclic = abramov::cyclicConvolve(e, f);
+    for (size_t k = 0; k < n; ++k)
+    {
+      BOOST_TEST(cyclic[k] == linear[k] + (k + n < linear.size() ? linear[k + n] : 0u));
+    }
+    BOOST_CHECK_THROW(abramov::convolve< abramov::Checked >(c, d), std::overflow_error);
+    std::vector< long long > s = randomVector< long long >(n, gen, 10000000);
+    std::vector< long long > t = randomVector< long long >(2 * n, gen, 10000000);
+    BOOST_TEST((abramov::convolve< abramov::Checked >(s, t) == naiveConvolve(s, t)));
+  }
+  std::vector< int > big(200, 1 << 15);
+  std::vector< int > saturated = abramov::convolve< abramov::Saturating >(big, big);
+  BOOST_TEST(saturated[0] == 1 << 30);
+  BOOST_TEST(saturated[1] == std::numeric_limits< int >::max());
+  BOOST_TEST(abramov::convolve(std::vector< int >{}, big).empty());
+  BOOST_CHECK_THROW(abramov::cyclicConvolve(big, std::vector< int >(3, 1)), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(toeplitz_products_match_dense)
+{
+  std::mt19937_64 gen(8);
+  for (auto [m, n] : { std::pair< size_t, size_t >{ 3, 5 }, { 70, 90 }, { 130, 100 }, { 200, 200 } })
+  {
+    std::vector< long long > column = randomVector< long long >(m, gen, 50);
+    std::vector< long long > row = randomVector< long long >(n, gen, 50);
+    row[0] = column[0];
+    abramov::ToeplitzMatrix< long long > t(column, row);
+    abramov::Matrix< long long > dense = t.toMatrix();
+    abramov::Matrix< long long > right = sample< long long >(n, 7, gen(), -100, 100);
+    abramov::Matrix< long long > left = sample< long long >(9, m, gen(), -100, 100);
+    BOOST_TEST((t * right == dense * right));
+    BOOST_TEST((left * t == left * dense));
+    std::vector< long long > x = randomVector< long long >(n, gen, 1000);
+    std::vector< long long > y = t * x;
+    for (size_t i = 0; i < m; ++i)
+    {
+      long long want = 0;
+      for (size_t j = 0; j < n; ++j)
+      {
+        want += dense[i][j] * x[j];
+      }
+      BOOST_TEST(y[i] == want);
+    }
+    BOOST_CHECK_THROW(t * std::vector< long long >(n + 1, 1), std::invalid_argument);
+  }
+  for (size_t n : { 1, 4, 100 })
+  {
+    abramov::ToeplitzMatrix< int > a = abramov::ToeplitzMatrix< int >::circulant(randomVector< int >(n, gen, 9));
+    abramov::ToeplitzMatrix< int > b = abramov::ToeplitzMatrix< int >::circulant(randomVector< int >(n, gen, 9));
+    BOOST_TEST(a.isCirculant());
+    abramov::ToeplitzMatrix< int > c = abramov::circulantMultiply(a, b);
+    BOOST_TEST(c.isCirculant());
+    BOOST_TEST((c.toMatrix() == a.toMatrix() * b.toMatrix()));
+  }
+  abramov::ToeplitzMatrix< int > plain({ 1, 2, 3 }, { 1, 4, 5 });
+  BOOST_TEST(!plain.isCirculant());
+  BOOST_CHECK_THROW(abramov::circulantMultiply(plain, plain), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(polynomial_matrices)
+{
+  std::mt19937_64 gen(13);
+  for (auto [la, lb] : { std::pair< size_t, size_t >{ 1, 1 }, { 5, 9 }, { 40, 33 }, { 100, 70 } })
+  {
+    std::vector< abramov::Matrix< long long > > ca;
+    std::vector< abramov::Matrix< long long > > cb;
+    for (size_t k = 0; k < la; ++k)
+    {
+      ca.push_back(sample< long long >(3, 4, gen(), -100, 100));
+    }
+    for (size_t k = 0; k < lb; ++k)
+    {
+      cb.push_back(sample< long long >(4, 2, gen(), -100, 100));
+    }
+    abramov::PolynomialMatrix< long long > a(ca);
+    abramov::PolynomialMatrix< long long > b(cb);
+    abramov::PolynomialMatrix< long long > c = abramov::polynomialMultiply(a, b, 2);
+    BOOST_TEST(c.getLength() == la + lb - 1);
+    for (size_t k = 0; k < c.getLength(); ++k)
+    {
+      abramov::Matrix< long long > want(3, 2, 0);
+      for (size_t s = 0; s < la; ++s)
+      {
+        if (k >= s && k - s < lb)
+        {
+          want += ca[s] * cb[k - s];
+        }
+      }
+      BOOST_TEST((c.coefficient(k) == want));
+    }
+    BOOST_TEST((c.evaluate(-1) == a.evaluate(-1) * b.evaluate(-1)));
+    BOOST_TEST((a * abramov::PolynomialMatrix< long long >::identity(4) == a));
+    BOOST_TEST((c.truncate(1).coefficient(0) == ca[0] * cb[0]));
+  }
+  BOOST_CHECK_THROW(abramov::PolynomialMatrix< int >(2, 3, 1) * abramov::PolynomialMatrix< int >(2, 3, 1),
+    std::invalid_argument);
+  BOOST_CHECK_THROW(abramov::PolynomialMatrix< int >({ abramov::Matrix< int >(2, 2, 0), abramov::Matrix< int >(2, 3, 0) }),
+    std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(recurrences_match_companion_power)
+{
+  std::vector< long long > fibonacci{ 1, 1 };
+  std::vector< long long > start{ 0, 1 };
+  BOOST_TEST(abramov::linearRecurrence(fibonacci, start, 90) == 2880067194370816120LL);
+  std::vector< int > narrow{ 1, 1 };
+  std::vector< int > first{ 0, 1 };
+  BOOST_TEST(abramov::linearRecurrence< abramov::Checked >(narrow, first, 46) == 1836311903);
+  BOOST_CHECK_THROW(abramov::linearRecurrence< abramov::Checked >(narrow, first, 47), std::overflow_error);
+  BOOST_TEST(abramov::linearRecurrence(narrow, first, 1) == 1);
+  std::mt19937_64 gen(21);
+  for (size_t k : { 1, 5, 90 })
+  {
+    std::vector< long long > c = randomVector< long long >(k, gen, 3);
+    std::vector< long long > init = randomVector< long long >(k, gen, 3);
+    abramov::Matrix< long long > companion(k, k, 0);
+    for (size_t j = 0; j < k; ++j)
+    {
+      companion[0][j] = c[j];
+    }
+    for (size_t i = 1; i < k; ++i)
+    {
+      companion[i][i - 1] = 1;
+    }
+    abramov::Matrix< long long > state(k, 1, 0);
+    for (size_t i = 0; i < k; ++i)
+    {
+      state[i][0] = init[k - 1 - i];
+    }
+    for (unsigned long long index : { 0ULL, static_cast< unsigned long long >(k), 1000ULL, 123456789ULL })
+    {
+      long long want = index < k ? init[index] : (companion.power(index - k + 1) * state)[0][0];
+      BOOST_TEST(abramov::linearRecurrence(c, init, index) == want);
+    }
+  }
+  BOOST_CHECK_THROW(abramov::linearRecurrence(std::vector< int >{ 1 }, std::vector< int >{}, 3), std::invalid_argument);
+}
@@ -0,0 +1,228 @@
+#define BOOST_TEST_MODULE numa
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "matrix.hpp"
+#include "numa.hpp"
+#include "storage.hpp"
+#include "test-sample.hpp"
+
+namespace
+{
+  struct PlacementGuard
+  {
+    PlacementGuard(abramov::Placement placement, size_t threshold)
+    {
+      abramov::setPlacement(placement, threshold);
+    }
+    ~PlacementGuard()
+    {
+      abramov::setPlacement(abramov::Placement::Local);
+    }
+  };
+
+  struct HugePageGuard
+  {
+    HugePageGuard(abramov::HugePages mode, size_t threshold)
+    {
+      abramov::setHugePages(mode, threshold);
+      abramov::resetHugePageStats();
+    }
+    ~HugePageGuard()
+    {
+      abramov::setHugePages(abramov::HugePages::Off);
+    }
+  };
+}
+
+BOOST_AUTO_TEST_CASE(cpu_list)
+{
+  BOOST_TEST((abramov::parseCpuList("0-3,8,10-11\n") == std::vector< size_t >{ 0, 1, 2, 3, 8, 10, 11 }));
+  BOOST_TEST(abramov::parseCpuList("").empty());
+}
+
+BOOST_AUTO_TEST_CASE(topology)
+{
+  const abramov::NumaTopology &topology = abramov::numaTopology();
+  BOOST_TEST(topology.nodes() >= 1);
+  BOOST_TEST(abramov::numaNodes() == topology.nodes());
+  for (const auto &cpus : topology.cpus)
+  {
+    BOOST_TEST(!cpus.empty());
+  }
+  BOOST_CHECK_THROW(abramov::nodePool(topology.nodes()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(node_ranges)
+{
+  for (size_t nodes : { 1, 2, 3, 8 })
+  {
+    BOOST_TEST(abramov::nodeBegin(5, 105, 0, nodes) == 5);
+    BOOST_TEST(abramov::nodeBegin(5, 105, nodes, nodes) == 105);
+    for (size_t k = 0; k < nodes; ++k)
+    {
+      BOOST_TEST(abramov::nodeBegin(5, 105, k, nodes) <= abramov::nodeBegin(5, 105, k + 1, nodes));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_for_covers_range)
+{
+  std::vector< std::atomic< int > > hits(1000);
+  abramov::numaParallelFor(0, hits.size(), [&hits](size_t lo, size_t hi)
+  {
+    BOOST_REQUIRE(abramov::nodeWorker());
+    for (size_t i = lo; i < hi; ++i)
+    {
+      ++hits[i];
+    }
+  });
+  for (auto &h : hits)
+  {
+    BOOST_TEST(h.load() == 1);
+  }
+  BOOST_TEST(!abramov::nodeWorker());
+  BOOST_CHECK_THROW(abramov::numaParallelFor(0, 10, [](size_t, size_t)
+  {
+    throw std::runtime_error("fail\n");
+  }), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(placed_kernels)
+{
+  abramov::Matrix< int > a = sample(40, 30, 1, -6, 6);
+  abramov::Matrix< int > b = sample(7, 5, 2, -6, 6);
+  abramov::Matrix< int > reference = abramov::Matrix< int >::kroneckerProduct(a, b, 1);
+  for (auto policy : { abramov::Placement::Local, abramov::Placement::Interleave, abramov::Placement::RowBlocks })
+  {
+    PlacementGuard guard(policy, 4096);
+    abramov::Matrix< int > m = abramov::Matrix< int >::kroneckerProduct(a, b, 4);
+    BOOST_TEST((abramov::placementOf(m[0]) == policy));
+    BOOST_TEST((m == reference));
+    std::vector< std::atomic< int > > hits(m.getRows());
+    abramov::placedParallelFor(m[0], 0, hits.size(), [&hits](size_t lo, size_t hi)
+    {
+      for (size_t i = lo; i < hi; ++i)
+      {
+        ++hits[i];
+      }
+    }, 4);
+    for (auto &h : hits)
+    {
+      BOOST_TEST(h.load() == 1);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(placement_policies)
+{
+  abramov::Matrix< int > reference = sample(300, 257, 1, -6, 6);
+  for (auto policy : { abramov::Placement::Local, abramov::Placement::Interleave, abramov::Placement::RowBlocks })
+  {
+    PlacementGuard guard(policy, 4096);
+    BOOST_TEST((abramov::placement() == policy));
+    abramov::Matrix< int > m = sample(300, 257, 1, -6, 6);
+    BOOST_TEST((m == reference));
+    BOOST_TEST((abramov::placementOf(m[0]) == policy));
+    for (size_t i = 1; i < m.getRows(); ++i)
+    {
+      BOOST_TEST(m[i] == m[i - 1] + m.getCols());
+    }
+    long node = abramov::memoryNode(m[m.getRows() - 1]);
+    BOOST_TEST(node < static_cast< long >(abramov::numaNodes()));
+    abramov::Matrix< int > small(2, 2, 1);
+    BOOST_TEST((abramov::placementOf(small[0]) == abramov::Placement::Local));
+    abramov::Matrix< int > product = m * abramov::Matrix< int >(257, 3, 1);
+    BOOST_TEST(product.getRows() == 300);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(empty_rows)
+{
+  PlacementGuard guard(abramov::Placement::RowBlocks, 0);
+  abramov::Matrix< int > m(4, 0, 0);
+  abramov::Matrix< int > copy(m);
+  BOOST_TEST(copy.getRows() == 4);
+  abramov::Matrix< int > none(0, 5, 0);
+  BOOST_TEST(none.getRows() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(huge_pages)
+{
+  abramov::Matrix< int > reference = sample(1024, 1024, 1, -6, 6);
+  BOOST_TEST((abramov::hugePagesOf(reference[0]) == abramov::HugePages::Off));
+  BOOST_TEST(abramov::hugePageSize() >= 4096);
+  for (auto mode : { abramov::HugePages::Transparent, abramov::HugePages::Explicit })
+  {
+    HugePageGuard guard(mode, 1 << 20);
+    abramov::Matrix< int > m = sample(1024, 1024, 1, -6, 6);
+    BOOST_TEST((m == reference));
+    BOOST_TEST((m.transpose().transpose() == reference));
+    for (size_t i = 1; i < m.getRows(); ++i)
+    {
+      BOOST_TEST(m[i] == m[i - 1] + m.getCols());
+    }
+    abramov::HugePageStats stats = abramov::hugePageStats();
+    size_t bytes = 1024 * 1024 * sizeof(int);
+    BOOST_TEST(stats.explicitBytes + stats.transparentBytes + stats.fallbackBytes + stats.reusedBytes >= bytes);
+    abramov::HugePages got = abramov::hugePagesOf(m[0]);
+    if (got == abramov::HugePages::Off)
+    {
+      BOOST_TEST(stats.fallbackBytes >= bytes);
+    }
+    if (got == abramov::HugePages::Explicit)
+    {
+      BOOST_TEST(stats.explicitBytes >= bytes);
+      BOOST_TEST(abramov::hugePageBytes(m[0]) >= bytes);
+    }
+    if (got == abramov::HugePages::Transparent)
+    {
+      BOOST_TEST(stats.transparentBytes + stats.reusedBytes >= bytes);
+      BOOST_TEST(reinterpret_cast< uintptr_t >(m[0] - 16) % abramov::hugePageSize() == 0);
+    }
+    BOOST_TEST(abramov::hugePageBytes(m[0]) <= bytes + abramov::hugePageSize());
+    abramov::Matrix< int > small(4, 4, 1);
+    BOOST_TEST((abramov::hugePagesOf(small[0]) == abramov::HugePages::Off));
+  }
+  abramov::HugePageStats stats = abramov::hugePageStats();
+  abramov::Matrix< int > plain = sample(1024, 1024, 1, -6, 6);
+  BOOST_TEST(abramov::hugePageStats().transparentBytes == stats.transparentBytes);
+  BOOST_TEST(abramov::hugePageStats().reusedBytes == stats.reusedBytes);
+  abramov::trimHugePages();
+}
+
+BOOST_AUTO_TEST_CASE(huge_page_reuse)
+{
+  HugePageGuard guard(abramov::HugePages::Transparent, 1 << 20);
+  abramov::Matrix< int > reference = sample(700, 700, 1, -6, 6);
+  for (size_t k = 0; k < 6; ++k)
+  {
+    abramov::Matrix< int > m = sample(700, 700, 1, -6, 6);
+    BOOST_TEST((m == reference));
+    abramov::Matrix< int > t = m.transpose();
+    BOOST_TEST(t[3][5] == m[5][3]);
+  }
+  abramov::HugePageStats stats = abramov::hugePageStats();
+  size_t bytes = 700 * 700 * sizeof(int);
+  BOOST_TEST(stats.explicitBytes + stats.transparentBytes + stats.fallbackBytes + stats.reusedBytes >= 13 * bytes);
+  if (abramov::hugePagesOf(reference[0]) == abramov::HugePages::Transparent)
+  {
+    BOOST_TEST(stats.mappings == 3u);
+    BOOST_TEST(stats.transparentBytes < 4 * bytes);
+    BOOST_TEST(stats.reusedBytes >= 10 * bytes);
+  }
+  abramov::trimHugePages();
+  abramov::Matrix< int > m = sample(700, 700, 1, -6, 6);
+  BOOST_TEST((m == reference));
+}
+
+BOOST_AUTO_TEST_CASE(huge_pages_with_placement)
+{
+  PlacementGuard placement(abramov::Placement::RowBlocks, 4096);
+  HugePageGuard huge(abramov::HugePages::Transparent, 4096);
+  abramov::Matrix< int > m = sample(600, 900, 1, -6, 6);
+  BOOST_TEST((abramov::placementOf(m[0]) == abramov::Placement::RowBlocks));
+  BOOST_TEST((m == sample(600, 900, 1, -6, 6)));
+}
@@ -0,0 +1,82 @@
+#define BOOST_TEST_MODULE outofcore
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <string>
+#include "outofcore.hpp"
+#include "test-sample.hpp"
+
+namespace
+{
+  constexpr size_t tile = 3;
+  constexpr size_t budget = 64 * tile * tile * sizeof(int);
+
+  struct TempFiles
+  {
+    ~TempFiles()
+    {
+      for (const char *name : { "ooc_a.bin", "ooc_b.bin", "ooc_c.bin" })
+      {
+        std::remove(name);
+      }
+    }
+  };
+}
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+  TempFiles files;
+  abramov::Matrix< int > m = sample(7, 5, 1, -9, 9);
+  abramov::TiledFile< int >::fromMatrix("ooc_a.bin", m, tile);
+  abramov::TiledFile< int > file("ooc_a.bin");
+  BOOST_TEST(file.getRows() == 7);
+  BOOST_TEST(file.getCols() == 5);
+  BOOST_TEST((file.toMatrix() == m));
+}
+
+BOOST_AUTO_TEST_CASE(multiply)
+{
+  TempFiles files;
+  abramov::Matrix< int > a = sample(7, 8, 1, -9, 9);
+  abramov::Matrix< int > b = sample(8, 10, 2, -9, 9);
+  auto fa = abramov::TiledFile< int >::fromMatrix("ooc_a.bin", a, tile);
+  auto fb = abramov::TiledFile< int >::fromMatrix("ooc_b.bin", b, tile);
+  auto fc = fa.multiply(fb, "ooc_c.bin", budget);
+  BOOST_TEST((fc.toMatrix() == a * b));
+  auto small = fa.multiply(fb, "ooc_c.bin", 5 * tile * tile * sizeof(int));
+  BOOST_TEST((small.toMatrix() == a * b));
+  BOOST_CHECK_THROW(fa.multiply(fb, "ooc_c.bin", tile), std::invalid_argument);
+  BOOST_CHECK_THROW(fb.multiply(fb, "ooc_c.bin", budget), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(transpose)
+{
+  TempFiles files;
+  abramov::Matrix< int > a = sample(7, 4, 3, -9, 9);
+  auto fa = abramov::TiledFile< int >::fromMatrix("ooc_a.bin", a, tile);
+  BOOST_TEST((fa.transpose("ooc_c.bin").toMatrix() == a.transpose()));
+}
+
+BOOST_AUTO_TEST_CASE(concat)
+{
+  TempFiles files;
+  abramov::Matrix< int > a = sample(4, 5, 4, -9, 9);
+  abramov::Matrix< int > b = sample(7, 2, 5, -9, 9);
+  auto fa = abramov::TiledFile< int >::fromMatrix("ooc_a.bin", a, tile);
+  auto fb = abramov::TiledFile< int >::fromMatrix("ooc_b.bin", b, tile);
+  using File = abramov::TiledFile< int >;
+  using Dense = abramov::Matrix< int >;
+  BOOST_TEST((File::horizontalConcat(fa, fb, "ooc_c.bin", 42, budget).toMatrix() == Dense::horizontalConcat(a, b, 42)));
+  BOOST_TEST((File::verticalConcat(fa, fb, "ooc_c.bin", 42, budget).toMatrix() == Dense::verticalConcat(a, b, 42)));
+  BOOST_TEST((File::diagonalConcat(fa, fb, "ooc_c.bin", 42, budget).toMatrix() == Dense::diagonalConcat(a, b, 42)));
+}
+
+BOOST_AUTO_TEST_CASE(kronecker_product)
+{
+  TempFiles files;
+  abramov::Matrix< int > a = sample(3, 4, 6, -9, 9);
+  abramov::Matrix< int > b = sample(5, 2, 7, -9, 9);
+  auto fa = abramov::TiledFile< int >::fromMatrix("ooc_a.bin", a, tile);
+  auto fb = abramov::TiledFile< int >::fromMatrix("ooc_b.bin", b, tile);
+  auto fc = abramov::TiledFile< int >::kroneckerProduct(fa, fb, "ooc_c.bin", budget);
+  BOOST_TEST((fc.toMatrix() == abramov::Matrix< int >::kroneckerProduct(a, b)));
+}
@@ -0,0 +1,128 @@
+#define BOOST_TEST_MODULE overflow
+#include <boost/test/unit_test.hpp>
+#include <climits>
+#include <stdexcept>
+#include <type_traits>
+#include "matrix.hpp"
+
+using Checked = abramov::Matrix< int, abramov::Checked >;
+using Saturating = abramov::Matrix< int, abramov::Saturating >;
+using Widening = abramov::Matrix< int, abramov::Widening >;
+
+BOOST_AUTO_TEST_CASE(wrapping_default)
+{
+  abramov::Matrix< int > m = { { INT_MAX, 1 }, { 1, 1 } };
+  abramov::Matrix< int > one = { { 1, 0 }, { 0, 0 } };
+  m += one;
+  BOOST_TEST(m[0][0] == INT_MIN);
+  BOOST_TEST((std::is_same_v< decltype(m.determinant()), int >));
+}
+
+BOOST_AUTO_TEST_CASE(checked_elementwise)
+{
+  Checked m = { { INT_MAX, 1 }, { 1, 1 } };
+  Checked one = { { 1, 0 }, { 0, 0 } };
+  BOOST_CHECK_THROW(m += one, std::overflow_error);
+  BOOST_TEST(m[0][0] == INT_MAX);
+  BOOST_CHECK_THROW(m -= -one, std::overflow_error);
+  Checked low = { { INT_MIN } };
+  BOOST_CHECK_THROW(-low, std::overflow_error);
+  BOOST_CHECK_THROW(m *= 2, std::overflow_error);
+  Checked fine = { { 1, 2 }, { 3, 4 } };
+  fine += fine;
+  BOOST_TEST((fine == Checked({ { 2, 4 }, { 6, 8 } })));
+}
+
+BOOST_AUTO_TEST_CASE(checked_multiply)
+{
+  Checked a = { { 65536, 0 }, { 0, 1 } };
+  BOOST_CHECK_THROW(a * a, std::overflow_error);
+  Checked b = { { INT_MAX, INT_MAX }, { 0, 0 } };
+  Checked c = { { 1, 0 }, { -1, 0 } };
+  Checked res = b * c;
+  BOOST_TEST(res[0][0] == 0);
+  Checked d = { { 1, 2 }, { 3, 4 } };
+  BOOST_TEST((d * d == Checked({ { 7, 10 }, { 15, 22 } })));
+  using Wide = abramov::Matrix< long long, abramov::Checked >;
+  Wide row = { { LLONG_MAX, LLONG_MAX, LLONG_MAX, LLONG_MAX } };
+  Wide mixed = { { LLONG_MAX, LLONG_MAX, -LLONG_MAX, -LLONG_MAX } };
+  Wide column = { { LLONG_MAX }, { LLONG_MAX }, { LLONG_MAX }, { LLONG_MAX } };
+  BOOST_CHECK_THROW(row * column, std::overflow_error);
+  BOOST_TEST((mixed * column)[0][0] == 0);
+}
+
+BOOST_AUTO_TEST_CASE(checked_reductions)
+{
+  Checked big = { { INT_MAX, 0 }, { 0, 2 } };
+  BOOST_CHECK_THROW(big.determinant(), std::overflow_error);
+  BOOST_CHECK_THROW(big.trace(), std::overflow_error);
+  Checked column = { { INT_MAX, 0 }, { 1, 0 } };
+  BOOST_CHECK_THROW(column.firstNorm(), std::overflow_error);
+  BOOST_TEST(column.infinityNorm() == INT_MAX);
+  Checked cancel = { { INT_MAX, INT_MAX }, { 2, 2 } };
+  BOOST_TEST(cancel.determinant() == 0);
+  BOOST_TEST(cancel.rank() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(saturating)
+{
+  Saturating m = { { INT_MAX, INT_MIN }, { 5, -5 } };
+  Saturating d = { { 1, -1 }, { 1, 1 } };
+  m += d;
+  BOOST_TEST(m[0][0] == INT_MAX);
+  BOOST_TEST(m[0][1] == INT_MIN);
+  BOOST_TEST(m[1][0] == 6);
+  BOOST_TEST(m[1][1] == -4);
+  Saturating big = { { INT_MAX, 0 }, { 0, 2 } };
+  BOOST_TEST(big.determinant() == INT_MAX);
+  BOOST_TEST(big.trace() == INT_MAX);
+  BOOST_TEST((-Saturating({ { INT_MIN } }))[0][0] == INT_MAX);
+  using Wide = abramov::Matrix< long long, abramov::Saturating >;
+  Wide row = { { LLONG_MAX, LLONG_MAX, LLONG_MAX, LLONG_MAX } };
+  Wide column = { { LLONG_MAX }, { LLONG_MAX }, { LLONG_MAX }, { LLONG_MAX } };
+  Wide negative = { { LLONG_MIN }, { LLONG_MIN }, { LLONG_MIN }, { LLONG_MIN } };
+  Wide mixed = { { LLONG_MAX, LLONG_MAX, -LLONG_MAX, -LLONG_MAX } };
+  BOOST_TEST((row * column)[0][0] == LLONG_MAX);
+  BOOST_TEST((row * negative)[0][0] == LLONG_MIN);
+  BOOST_TEST((mixed * column)[0][0] == 0);
+}
+
+BOOST_AUTO_TEST_CASE(widening)
+{
+  Widening big = { { INT_MAX, 0 }, { 0, 2 } };
+  BOOST_TEST((std::is_same_v< decltype(big.determinant()), long long >));
+  BOOST_TEST(big.determinant() == 2LL * INT_MAX);
+  BOOST_TEST(big.trace() == 2LL + INT_MAX);
+  BOOST_TEST(big.infinityNorm() == INT_MAX);
+  Widening huge = { { INT_MAX, 0, 0 }, { 0, INT_MAX, 0 }, { 0, 0, INT_MAX } };
+  __int128 expected = static_cast< __int128 >(INT_MAX) * INT_MAX * INT_MAX;
+  BOOST_CHECK_THROW(huge.determinant(), std::overflow_error);
+  abramov::Matrix< long long, abramov::Widening > wide = { { INT_MAX, 0, 0 }, { 0, INT_MAX, 0 }, { 0, 0, INT_MAX } };
+  BOOST_TEST((wide.determinant() == expected));
+  BOOST_CHECK_THROW(big + big, std::overflow_error);
+}
+
+BOOST_AUTO_TEST_CASE(unsigned_elements)
+{
+  abramov::Matrix< unsigned, abramov::Checked > m = { { 1, 2 }, { 3, 4 } };
+  BOOST_CHECK_THROW(m.determinant(), std::overflow_error);
+  abramov::Matrix< unsigned, abramov::Widening > w = { { 1, 2 }, { 3, 4 } };
+  BOOST_TEST(w.determinant() == -2);
+  BOOST_TEST(w.rank() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(short_elements)
+{
+  using Short = abramov::Matrix< short >;
+  Short m = { { -1, -2 }, { -3, -4 } };
+  m *= m;
+  BOOST_TEST((m == Short({ { 7, 10 }, { 15, 22 } })));
+  m *= static_cast< short >(-3);
+  BOOST_TEST((m == Short({ { -21, -30 }, { -45, -66 } })));
+  Short big = { { -32768, 2 }, { 3, -32768 } };
+  Short square = big * big;
+  BOOST_TEST(square[0][0] == 6);
+  BOOST_TEST(square[0][1] == 0);
+  abramov::Matrix< unsigned short > u = { { 65535, 1 }, { 1, 65535 } };
+  BOOST_TEST((u * u)[0][0] == 2);
+}
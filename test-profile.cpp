@@ -0,0 +1,93 @@
+#define BOOST_TEST_MODULE profile
+#define ABRAMOV_PROFILE
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "matrix.hpp"
+#include "vector.hpp"
+
+namespace
+{
+  const abramov::ProfileStats *find(const std::vector< abramov::ProfileStats > &stats, const std::string &name)
+  {
+    for (const auto &s : stats)
+    {
+      if (s.name == name)
+      {
+        return &s;
+      }
+    }
+    return nullptr;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(counts_calls)
+{
+  abramov::profileReset();
+  abramov::Matrix< int > m = { { 1, 2 }, { 3, 4 } };
+  m *= m;
+  m *= m;
+  BOOST_TEST(m.determinant() == 16);
+  auto stats = abramov::profileSnapshot();
+  const abramov::ProfileStats *mul = find(stats, "Matrix::operator*=(Matrix)");
+  BOOST_TEST_REQUIRE(mul);
+  BOOST_TEST(mul->calls == 2);
+  BOOST_TEST(mul->dims[2] == 2);
+  BOOST_TEST(mul->bytes == 2 * (2 * sizeof(int *) + 4 * sizeof(int)));
+  const abramov::ProfileStats *det = find(stats, "Matrix::determinant");
+  BOOST_TEST_REQUIRE(det);
+  BOOST_TEST(det->calls == 1);
+}
+
+BOOST_AUTO_TEST_CASE(merges_threads)
+{
+  abramov::profileReset();
+  auto work = []()
+  {
+    abramov::Vector< double, 3 > a = { 1.0, 2.0, 3.0 };
+    for (int i = 0; i < 10; ++i)
+    {
+      a.dot(a);
+    }
+  };
+  std::thread t1(work);
+  std::thread t2(work);
+  t1.join();
+  t2.join();
+  const abramov::ProfileStats *dot = find(abramov::profileSnapshot(), "Vector::dot");
+  BOOST_TEST_REQUIRE(dot);
+  BOOST_TEST(dot->calls == 20);
+}
+
+BOOST_AUTO_TEST_CASE(json_export)
+{
+  abramov::profileReset();
+  std::istringstream in("2 2\n1 2\n3 4\n");
+  abramov::Matrix< int > m;
+  m.read(in);
+  std::ostringstream out;
+  abramov::profileJson(out);
+  BOOST_TEST(out.str().find("\"op\": \"Matrix::read\", \"calls\": 1") != std::string::npos);
+  BOOST_TEST(out.str().find("\"<=3\": 1") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(marker_stream)
+{
+  std::string path = "profile_markers.tmp";
+  std::ofstream(path).close();
+  BOOST_TEST(abramov::profileMarkers(path));
+  abramov::Matrix< int > m = { { 1, 2 }, { 3, 4 } };
+  m.trace();
+  abramov::profileMarkersOff();
+  std::ifstream in(path);
+  std::string begin;
+  std::string end;
+  std::getline(in, begin);
+  std::getline(in, end);
+  BOOST_TEST(begin.find("|Matrix::trace 2x2") != std::string::npos);
+  BOOST_TEST(end.rfind("E|", 0) == 0);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,89 @@
+#define BOOST_TEST_MODULE qgemm
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include "qgemm.hpp"
+#include "test-sample.hpp"
+
+namespace
+{
+  template< class Acc, class A, class B >
+  void check(const abramov::Matrix< A > &a, const abramov::Matrix< B > &b)
+  {
+    for (auto kernel : { abramov::GemmKernel::Auto, abramov::GemmKernel::Portable, abramov::GemmKernel::Avx2,
+      abramov::GemmKernel::AvxVnni })
+    {
+      if (!abramov::gemmSupported(kernel))
+      {
+        continue;
+      }
+      for (size_t threads : { 1, 3 })
+      {
+        abramov::Matrix< Acc > c = abramov::qgemm< Acc >(a, b, kernel, threads);
+        BOOST_TEST(c.getRows() == a.getRows());
+        BOOST_TEST(c.getCols() == b.getCols());
+        for (size_t i = 0; i < a.getRows(); ++i)
+        {
+          for (size_t j = 0; j < b.getCols(); ++j)
+          {
+            int64_t sum = 0;
+            for (size_t k = 0; k < a.getCols(); ++k)
+            {
+              sum += static_cast< int64_t >(a[i][k]) * b[k][j];
+            }
+            BOOST_TEST(c[i][j] == static_cast< Acc >(sum));
+          }
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(int8_int32)
+{
+  check< int32_t >(sample< int8_t >(13, 37, 1, -128, 127), sample< int8_t >(37, 21, 2, -128, 127));
+}
+
+BOOST_AUTO_TEST_CASE(uint8_int8)
+{
+  check< int32_t >(sample< uint8_t >(9, 64, 3, 0, 255), sample< int8_t >(64, 33, 4, -128, 127));
+}
+
+BOOST_AUTO_TEST_CASE(int16_int64)
+{
+  check< int64_t >(sample< int16_t >(7, 300, 5, -32768, 32767), sample< int16_t >(300, 17, 6, -32768, 32767));
+  check< int64_t >(sample< int16_t >(6, 301, 7, -3000, 3000), sample< int16_t >(301, 16, 8, -3000, 3000));
+  check< int64_t >(sample< int8_t >(5, 129, 9, -128, 127), sample< int8_t >(129, 5, 10, -128, 127));
+}
+
+BOOST_AUTO_TEST_CASE(int16_int32_wraps)
+{
+  check< int32_t >(sample< int16_t >(5, 99, 11, -32768, 32767), sample< int16_t >(99, 18, 12, -32768, 32767));
+}
+
+BOOST_AUTO_TEST_CASE(packed_reuse)
+{
+  auto a = sample< int8_t >(8, 40, 13, -10, 10);
+  auto b = sample< int8_t >(40, 16, 14, -10, 10);
+  abramov::PackedLhs lhs(a);
+  abramov::PackedRhs rhs(b);
+  BOOST_TEST(lhs.getRows() == 8);
+  BOOST_TEST(rhs.getCols() == 16);
+  BOOST_TEST(lhs.bound() <= 10);
+  auto c = abramov::qgemm(lhs, rhs);
+  auto d = abramov::qgemm(a, b);
+  BOOST_TEST((c == d));
+}
+
+BOOST_AUTO_TEST_CASE(empty_and_errors)
+{
+  abramov::Matrix< int8_t > a(3, 0, 0);
+  abramov::Matrix< int8_t > b(0, 4, 0);
+  auto c = abramov::qgemm(a, b);
+  BOOST_TEST(c.getRows() == 3);
+  BOOST_TEST(c.getCols() == 4);
+  BOOST_TEST(c[2][3] == 0);
+  abramov::Matrix< int8_t > d(3, 5, 1);
+  BOOST_CHECK_THROW(abramov::qgemm(d, d), std::invalid_argument);
+  BOOST_TEST(abramov::gemmSupported(abramov::GemmKernel::Portable));
+}
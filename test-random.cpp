@@ -0,0 +1,313 @@
+#define BOOST_TEST_MODULE random
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "eigen.hpp"
+#include "gf2.hpp"
+#include "kronecker.hpp"
+#include "qgemm.hpp"
+#include "random.hpp"
+#include "semiring.hpp"
+#include "structured.hpp"
+#include "update.hpp"
+
+namespace
+{
+  template< class T >
+  abramov::Matrix< long long > naiveProduct(const abramov::Matrix< T > &a, const abramov::Matrix< T > &b)
+  {
+    abramov::Matrix< long long > res(a.getRows(), b.getCols(), 0);
+    for (size_t i = 0; i < a.getRows(); ++i)
+    {
+      for (size_t j = 0; j < b.getCols(); ++j)
+      {
+        for (size_t k = 0; k < a.getCols(); ++k)
+        {
+          res[i][j] += static_cast< long long >(a[i][k]) * static_cast< long long >(b[k][j]);
+        }
+      }
+    }
+    return res;
+  }
+
+  template< class T >
+  abramov::Matrix< long long > widen(const abramov::Matrix< T > &a)
+  {
+    abramov::Matrix< long long > res(a.getRows(), a.getCols(), 0);
+    for (size_t i = 0; i < a.getRows(); ++i)
+    {
+      for (size_t j = 0; j < a.getCols(); ++j)
+      {
+        res[i][j] = a[i][j];
+      }
+    }
+    return res;
+  }
+
+  std::vector< long long > randomValues(abramov::RandomStream &stream, size_t n, long long low, long long high)
+  {
+    std::vector< long long > res(n);
+    for (long long &x : res)
+    {
+      x = stream.uniform(low, high);
+    }
+    return res;
+  }
+
+  size_t dimension(abramov::RandomStream &stream, size_t max)
+  {
+    return 1 + stream.below(max);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(generators_are_seedable_and_parallel)
+{
+  abramov::Matrix< int > a = abramov::randomMatrix(37, 53, 7, -5, 5, 1);
+  BOOST_TEST((a == abramov::randomMatrix(37, 53, 7, -5, 5, 4)));
+  BOOST_TEST(!(a == abramov::randomMatrix(37, 53, 8, -5, 5, 4)));
+  int low = 5;
+  int high = -5;
+  for (size_t i = 0; i < a.getRows(); ++i)
+  {
+    for (size_t j = 0; j < a.getCols(); ++j)
+    {
+      low = std::min(low, a[i][j]);
+      high = std::max(high, a[i][j]);
+    }
+  }
+  BOOST_TEST(low == -5);
+  BOOST_TEST(high == 5);
+  long long min = std::numeric_limits< long long >::min();
+  long long max = std::numeric_limits< long long >::max();
+  abramov::Matrix< long long > full = abramov::randomMatrix(4, 4, 1, min, max);
+  BOOST_TEST(full[0][0] != full[0][1]);
+  abramov::Matrix< uint8_t > bytes = abramov::randomMatrix< uint8_t >(3, 3, 2, 0, 255);
+  BOOST_TEST(bytes.getRows() == 3u);
+
+  abramov::Matrix< int > sparse = abramov::randomSparse(200, 200, 0.1, 3, 1, 9);
+  size_t nonzero = 0;
+  for (size_t i = 0; i < 200; ++i)
+  {
+    for (size_t j = 0; j < 200; ++j)
+    {
+      nonzero += sparse[i][j] != 0;
+    }
+  }
+  BOOST_TEST(nonzero > 3200u);
+  BOOST_TEST(nonzero < 4800u);
+  BOOST_TEST((abramov::randomSparse(5, 5, 0.0, 3, 1, 9) == abramov::Matrix< int >(5, 5, 0)));
+  BOOST_TEST(abramov::randomSparse(5, 5, 1.0, 3, 1, 9).rank() == abramov::randomMatrix(5, 5, 3, 1, 9).rank());
+  BOOST_CHECK_THROW(abramov::randomSparse(5, 5, 1.5, 3, 1, 9), std::invalid_argument);
+  BOOST_CHECK_THROW(abramov::randomMatrix(5, 5, 3, 9, 1), std::invalid_argument);
+
+  abramov::Matrix< long long > banded = abramov::randomBanded(30, 2, 3, 4, 1LL, 9LL);
+  BOOST_TEST(banded[10][8] != 0);
+  BOOST_TEST(banded[10][13] != 0);
+  BOOST_TEST(banded[10][7] == 0);
+  BOOST_TEST(banded[10][14] == 0);
+  BOOST_CHECK_NO_THROW(abramov::BandedMatrix< long long >(banded, 2, 3));
+
+  for (size_t r = 0; r <= 7; ++r)
+  {
+    BOOST_TEST(abramov::randomLowRank(7, 9, r, r, -3, 3).rank() == static_cast< int >(r));
+  }
+  BOOST_CHECK_THROW(abramov::randomLowRank(7, 9, 8, 1, -3, 3), std::invalid_argument);
+
+  std::vector< long long > pivots{ 2, -3, 1, 5, 1 };
+  BOOST_TEST(abramov::randomWithDeterminant(pivots, 5, -9LL, 9LL).determinant() == -30);
+  std::vector< int > many(40, 1);
+  abramov::BigInt product(1);
+  abramov::RandomStream stream(6);
+  for (int &p : many)
+  {
+    p = stream.uniform(-3, 3);
+    p = p ? p : 1;
+    product *= abramov::BigInt(p);
+  }
+  abramov::Matrix< int > known = abramov::randomWithDeterminant(many, 6, -2, 2);
+  BOOST_TEST((abramov::exactDeterminant(known) == product));
+}
+
+BOOST_AUTO_TEST_CASE(harness_reports_first_failure)
+{
+  auto property = [](abramov::RandomStream &stream)
+  {
+    return stream.below(10) != 7;
+  };
+  abramov::PropertyReport parallel = abramov::checkProperty("digits", 1000, 3, property, 4);
+  abramov::PropertyReport serial = abramov::checkProperty("digits", 1000, 3, property, 1);
+  BOOST_TEST(!parallel.passed());
+  BOOST_TEST(parallel.cases == 1000u);
+  BOOST_TEST(parallel.failures > 50u);
+  BOOST_TEST(parallel.failures == serial.failures);
+  BOOST_TEST(parallel.first == serial.first);
+  BOOST_TEST(parallel.seed == serial.seed);
+  abramov::RandomStream replay(parallel.seed);
+  BOOST_TEST(replay.below(10) == 7u);
+  BOOST_TEST(parallel.toString().find("first failure at case " + std::to_string(parallel.first)) != std::string::npos);
+
+  abramov::PropertyReport thrown = abramov::checkProperty("throws", 10, 1, [](abramov::RandomStream &) -> bool
+  {
+    throw std::logic_error("Broken kernel\n");
+  });
+  BOOST_TEST(thrown.failures == 10u);
+  BOOST_TEST(thrown.first == 0u);
+  BOOST_TEST(thrown.message == "Broken kernel");
+  abramov::PropertyReport fine = abramov::checkProperty("fine", 100, 1, [](abramov::RandomStream &)
+  {
+    return true;
+  });
+  BOOST_TEST(fine.passed());
+  BOOST_TEST(fine.toString() == "fine: 100/100 cases passed");
+}
+
+BOOST_AUTO_TEST_CASE(products_match_reference)
+{
+  abramov::PropertyReport dense = abramov::checkProperty("dense products", 3000, 11, [](abramov::RandomStream &s)
+  {
+    size_t m = dimension(s, 24);
+    size_t k = dimension(s, 24);
+    size_t n = dimension(s, 24);
+    double density = s.chance(0.5) ? 1.0 : 0.2;
+    abramov::Matrix< long long > a = abramov::randomSparse(m, k, density, s.next(), -1000LL, 1000LL, 1);
+    abramov::Matrix< long long > b = abramov::randomSparse(k, n, density, s.next(), -1000LL, 1000LL, 1);
+    abramov::Matrix< long long > want = naiveProduct(a, b);
+    return a * b == want && abramov::semiringMultiply< abramov::PlusTimes< long long > >(a, b, 1) == want;
+  });
+  BOOST_TEST(dense.passed(), dense.toString());
+
+  abramov::PropertyReport quantized = abramov::checkProperty("qgemm", 2000, 12, [](abramov::RandomStream &s)
+  {
+    size_t m = dimension(s, 40);
+    size_t k = dimension(s, 70);
+    size_t n = dimension(s, 40);
+    abramov::Matrix< int8_t > a = abramov::randomMatrix< int8_t >(m, k, s.next(), -128, 127, 1);
+    abramov::Matrix< int8_t > b = abramov::randomMatrix< int8_t >(k, n, s.next(), -128, 127, 1);
+    abramov::Matrix< long long > want = naiveProduct(a, b);
+    return widen(abramov::qgemm(a, b)) == want &&
+      widen(abramov::qgemm(a, b, abramov::GemmKernel::Portable)) == want;
+  });
+  BOOST_TEST(quantized.passed(), quantized.toString());
+
+  abramov::PropertyReport packed = abramov::checkProperty("bit products", 1000, 13, [](abramov::RandomStream &s)
+  {
+    size_t m = dimension(s, 96);
+    size_t k = dimension(s, 96);
+    size_t n = dimension(s, 96);
+    abramov::Matrix< int > a = abramov::randomSparse(m, k, 0.3, s.next(), 1, 1, 1);
+    abramov::Matrix< int > b = abramov::randomSparse(k, n, 0.3, s.next(), 1, 1, 1);
+    abramov::Matrix< int > want = a * b;
+    abramov::BitMatrix ba(a);
+    abramov::BitMatrix bb(b);
+    return abramov::countingMultiply< int >(ba, bb, 1) == want &&
+      abramov::booleanMultiply(ba, bb, 1) == abramov::BitMatrix(want) &&
+      abramov::gf2Multiply(abramov::Gf2Matrix(a), abramov::Gf2Matrix(b), 1) == abramov::Gf2Matrix(want);
+  });
+  BOOST_TEST(packed.passed(), packed.toString());
+
+  abramov::PropertyReport kronecker = abramov::checkProperty("kronecker", 1000, 14, [](abramov::RandomStream &s)
+  {
+    abramov::Matrix< long long > a = abramov::randomMatrix(dimension(s, 6), dimension(s, 6), s.next(), -9LL, 9LL, 1);
+    abramov::Matrix< long long > b = abramov::randomMatrix(dimension(s, 6), dimension(s, 6), s.next(), -9LL, 9LL, 1);
+    abramov::Matrix< long long > x = abramov::randomMatrix(a.getCols() * b.getCols(), dimension(s, 4), s.next(),
+      -9LL, 9LL, 1);
+    abramov::KroneckerOperator< long long > op(a, b);
+    return op.multiply(x) == naiveProduct(abramov::Matrix< long long >::kroneckerProduct(a, b), x);
+  });
+  BOOST_TEST(kronecker.passed(), kronecker.toString());
+
+  abramov::PropertyReport structured = abramov::checkProperty("structured", 300, 15, [](abramov::RandomStream &s)
+  {
+    size_t m = dimension(s, 150);
+    size_t n = dimension(s, 150);
+    std::vector< long long > column = randomValues(s, m, -50, 50);
+    std::vector< long long > row = randomValues(s, n, -50, 50);
+    row[0] = column[0];
+    abramov::ToeplitzMatrix< long long > t(column, row);
+    abramov::Matrix< long long > x = abramov::randomMatrix(n, dimension(s, 5), s.next(), -99LL, 99LL, 1);
+    size_t order = dimension(s, 60);
+    size_t lower = s.below(4);
+    size_t upper = s.below(4);
+    abramov::Matrix< long long > band = abramov::randomBanded(order, lower, upper, s.next(), -99LL, 99LL, 1);
+    abramov::BandedMatrix< long long > banded(band, lower, upper);
+    std::vector< long long > a = randomValues(s, dimension(s, 400), -1000000, 1000000);
+    std::vector< long long > b = randomValues(s, dimension(s, 400), -1000000, 1000000);
+    std::vector< long long > direct(a.size() + b.size() - 1, 0);
+    abramov::directConvolve< abramov::Wrapping >(a.data(), a.size(), b.data(), b.size(), direct.data());
+    return t * x == naiveProduct(t.toMatrix(), x) && (banded * banded).toMatrix() == naiveProduct(band, band) &&
+      abramov::convolve(a, b, 1) == direct;
+  });
+  BOOST_TEST(structured.passed(), structured.toString());
+}
+
+BOOST_AUTO_TEST_CASE(determinants_match_reference)
+{
+  abramov::PropertyReport small = abramov::checkProperty("small determinants", 1000, 21, [](abramov::RandomStream &s)
+  {
+    size_t n = dimension(s, 6);
+    abramov::Matrix< long long > a = abramov::randomMatrix(n, n, s.next(), -50LL, 50LL, 1);
+    abramov::BigInt want(a.determinant());
+    abramov::InverseUpdater< long long > updater(a, 1);
+    return abramov::exactDeterminant(a, 1) == want &&
+      abramov::characteristicPolynomial(a, abramov::Charpoly::Hessenberg, 1).determinant() == want &&
+      abramov::characteristicPolynomial(a, abramov::Charpoly::Berkowitz, 1).determinant() == want &&
+      abramov::BigInt(abramov::BandedMatrix< long long >(a, n - 1, n - 1).determinant()) == want &&
+      updater.determinant() == want;
+  });
+  BOOST_TEST(small.passed(), small.toString());
+
+  abramov::PropertyReport known = abramov::checkProperty("known determinants", 500, 22, [](abramov::RandomStream &s)
+  {
+    size_t n = dimension(s, 40);
+    std::vector< long long > pivots = randomValues(s, n, -3, 3);
+    abramov::BigInt want(1);
+    for (long long &p : pivots)
+    {
+      p = p ? p : 1;
+      want *= abramov::BigInt(p);
+    }
+    abramov::Matrix< long long > a = abramov::randomWithDeterminant(pivots, s.next(), -3LL, 3LL, 1);
+    return abramov::exactDeterminant(a, 1) == want &&
+      abramov::characteristicPolynomial(a, abramov::Charpoly::Hessenberg, 1).determinant() == want;
+  });
+  BOOST_TEST(known.passed(), known.toString());
+
+  abramov::PropertyReport singular = abramov::checkProperty("singular", 500, 23, [](abramov::RandomStream &s)
+  {
+    size_t n = 1 + dimension(s, 30);
+    size_t rank = s.below(n);
+    abramov::Matrix< long long > a = abramov::randomLowRank(n, n, rank, s.next(), -5LL, 5LL, 1);
+    return abramov::exactDeterminant(a, 1).isZero() && a.rank() == static_cast< int >(rank);
+  });
+  BOOST_TEST(singular.passed(), singular.toString());
+
+  abramov::PropertyReport banded = abramov::checkProperty("banded determinants", 500, 24, [](abramov::RandomStream &s)
+  {
+    size_t n = dimension(s, 16);
+    size_t lower = s.below(4);
+    size_t upper = s.below(4);
+    abramov::Matrix< long long > a = abramov::randomBanded(n, lower, upper, s.next(), -2LL, 2LL, 1);
+    return abramov::BigInt(abramov::BandedMatrix< long long >(a, lower, upper).determinant()) ==
+      abramov::exactDeterminant(a, 1);
+  });
+  BOOST_TEST(banded.passed(), banded.toString());
+
+  abramov::PropertyReport updates = abramov::checkProperty("rank-one updates", 300, 25, [](abramov::RandomStream &s)
+  {
+    size_t n = dimension(s, 12);
+    std::vector< long long > pivots(n, 1);
+    abramov::InverseUpdater< long long > updater(abramov::randomWithDeterminant(pivots, s.next(), -4LL, 4LL, 1), 1);
+    for (size_t step = 0; step < 3; ++step)
+    {
+      updater.rankOneUpdate(randomValues(s, n, -3, 3), randomValues(s, n, -3, 3));
+      if (!(updater.determinant() == abramov::exactDeterminant(updater.matrix(), 1)))
+      {
+        return false;
+      }
+    }
+    return true;
+  });
+  BOOST_TEST(updates.passed(), updates.toString());
+}
@@ -0,0 +1,28 @@
+#ifndef TEST_SAMPLE_HPP
+#define TEST_SAMPLE_HPP
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "matrix.hpp"
+#include "random.hpp"
+
+namespace
+{
+  template< abramov::Integral T = int, class P = abramov::Wrapping >
+  abramov::Matrix< T, P > sample(size_t m, size_t n, uint64_t seed, T low = -4, T high = 4, T diagonal = 0)
+  {
+    abramov::Matrix< T, P > res = abramov::randomMatrix< T, P >(m, n, seed, low, high, 1);
+    for (size_t i = 0; i < std::min(m, n); ++i)
+    {
+      res[i][i] += diagonal;
+    }
+    return res;
+  }
+
+  template< abramov::Integral T = int, class P = abramov::Wrapping >
+  abramov::Matrix< T, P > sparseSample(size_t m, size_t n, uint64_t seed, double density, T low = -4, T high = 4)
+  {
+    return abramov::randomSparse< T, P >(m, n, density, seed, low, high, 1);
+  }
+}
+#endif
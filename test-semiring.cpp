@@ -0,0 +1,248 @@
+#define BOOST_TEST_MODULE semiring
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include "semiring.hpp"
+#include "test-sample.hpp"
+
+namespace
+{
+  template< class S, class T >
+  abramov::Matrix< T > naive(const abramov::Matrix< T > &a, const abramov::Matrix< T > &b)
+  {
+    abramov::Matrix< T > res(a.getRows(), b.getCols(), 0);
+    for (size_t i = 0; i < a.getRows(); ++i)
+    {
+      for (size_t j = 0; j < b.getCols(); ++j)
+      {
+        T sum = S::zero();
+        for (size_t k = 0; k < a.getCols(); ++k)
+        {
+          sum = S::add(sum, S::multiply(a[i][k], b[k][j]));
+        }
+        res[i][j] = sum;
+      }
+    }
+    return res;
+  }
+
+  abramov::BitMatrix warshall(const abramov::BitMatrix &a)
+  {
+    abramov::BitMatrix res = a;
+    size_t n = a.getRows();
+    for (size_t k = 0; k < n; ++k)
+    {
+      for (size_t i = 0; i < n; ++i)
+      {
+        if (res.get(i, k))
+        {
+          for (size_t j = 0; j < n; ++j)
+          {
+            if (res.get(k, j))
+            {
+              res.set(i, j);
+            }
+          }
+        }
+      }
+    }
+    return res;
+  }
+
+  abramov::Matrix< long long > floydWarshall(abramov::Matrix< long long > d)
+  {
+    const long long none = std::numeric_limits< long long >::max();
+    size_t n = d.getRows();
+    for (size_t i = 0; i < n; ++i)
+    {
+      d[i][i] = std::min(d[i][i], 0LL);
+    }
+    for (size_t k = 0; k < n; ++k)
+    {
+      for (size_t i = 0; i < n; ++i)
+      {
+        for (size_t j = 0; j < n; ++j)
+        {
+          if (d[i][k] != none && d[k][j] != none)
+          {
+            d[i][j] = std::min(d[i][j], d[i][k] + d[k][j]);
+          }
+        }
+      }
+    }
+    return d;
+  }
+
+  abramov::Matrix< long long > weighted(size_t n, std::mt19937 &gen, int low, int high, double density)
+  {
+    std::uniform_int_distribution< int > dist(low, high);
+    std::bernoulli_distribution edge(density);
+    abramov::Matrix< long long > res(n, n, 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        res[i][j] = edge(gen) ? dist(gen) : std::numeric_limits< long long >::max();
+      }
+    }
+    return res;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(semirings_match_naive)
+{
+  std::mt19937 gen(7);
+  for (auto [m, k, n] : { std::tuple< size_t, size_t, size_t >{ 1, 1, 1 }, { 5, 9, 3 }, { 33, 140, 21 } })
+  {
+    abramov::Matrix< int > a = sparseSample< int >(m, k, gen(), 0.6, -9, 9);
+    abramov::Matrix< int > b = sparseSample< int >(k, n, gen(), 0.6, -9, 9);
+    BOOST_TEST((abramov::semiringMultiply< abramov::PlusTimes< int > >(a, b) == a * b));
+    BOOST_TEST((abramov::semiringMultiply< abramov::PlusTimes< int > >(a, b) ==
+      naive< abramov::PlusTimes< int > >(a, b)));
+    BOOST_TEST((abramov::semiringMultiply< abramov::OrAnd< int > >(a, b, 2) == naive< abramov::OrAnd< int > >(a, b)));
+    BOOST_TEST((abramov::semiringMultiply< abramov::MinPlus< int > >(a, b, 3) ==
+      naive< abramov::MinPlus< int > >(a, b)));
+    BOOST_TEST((abramov::semiringMultiply< abramov::MaxPlus< int > >(a, b, 1) ==
+      naive< abramov::MaxPlus< int > >(a, b)));
+  }
+  abramov::Matrix< short > c = { { -32768, -2 }, { -3, -4 } };
+  BOOST_TEST((abramov::semiringMultiply< abramov::PlusTimes< short > >(c, c) == c * c));
+  BOOST_TEST(abramov::PlusTimes< unsigned short >::multiply(65535, 65535) == 1);
+  abramov::Matrix< int > wide(2, 3, 1);
+  BOOST_CHECK_THROW(abramov::semiringMultiply< abramov::MinPlus< int > >(wide, wide), std::invalid_argument);
+  BOOST_CHECK_THROW(abramov::semiringPower< abramov::OrAnd< int > >(wide, 2), std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(tropical_saturation)
+{
+  using Min = abramov::MinPlus< int >;
+  using Max = abramov::MaxPlus< int >;
+  const int top = std::numeric_limits< int >::max();
+  const int bottom = std::numeric_limits< int >::lowest();
+  BOOST_TEST(Min::multiply(Min::zero(), -5) == Min::zero());
+  BOOST_TEST(Min::multiply(top - 1, 7) == Min::zero());
+  BOOST_TEST(Min::multiply(bottom + 1, -7) == bottom);
+  BOOST_TEST(Max::multiply(Max::zero(), 5) == Max::zero());
+  BOOST_TEST(Max::multiply(top - 1, 7) == top);
+  BOOST_TEST(abramov::MinPlus< unsigned >::multiply(4000000000u, 400000000u) == abramov::MinPlus< unsigned >::zero());
+}
+
+BOOST_AUTO_TEST_CASE(walk_counts_and_powers)
+{
+  abramov::Matrix< long long > cycle(4, 4, 0);
+  for (size_t i = 0; i < 4; ++i)
+  {
+    cycle[i][(i + 1) % 4] = 1;
+    cycle[i][(i + 3) % 4] = 1;
+  }
+  abramov::Matrix< long long > walks = abramov::semiringPower< abramov::PlusTimes< long long > >(cycle, 4);
+  BOOST_TEST(walks[0][0] == 8);
+  BOOST_TEST(walks[0][2] == 8);
+  BOOST_TEST(walks[0][1] == 0);
+  BOOST_TEST((abramov::semiringPower< abramov::PlusTimes< long long > >(cycle, 5) == cycle.power(5)));
+  abramov::Matrix< long long > unit = abramov::semiringPower< abramov::MinPlus< long long > >(cycle, 0);
+  BOOST_TEST(unit[1][1] == 0);
+  BOOST_TEST(unit[1][2] == std::numeric_limits< long long >::max());
+  abramov::Matrix< int > dag{ { 0, 3, 2, 0 }, { 0, 0, 0, 4 }, { 0, 0, 0, 1 }, { 0, 0, 0, 0 } };
+  for (size_t i = 0; i < 4; ++i)
+  {
+    for (size_t j = 0; j < 4; ++j)
+    {
+      dag[i][j] = dag[i][j] ? dag[i][j] : abramov::MaxPlus< int >::zero();
+    }
+  }
+  abramov::Matrix< int > longest = abramov::semiringPower< abramov::MaxPlus< int > >(dag, 2);
+  BOOST_TEST(longest[0][3] == 7);
+  BOOST_TEST(longest[0][1] == abramov::MaxPlus< int >::zero());
+  std::mt19937 gen(13);
+  abramov::Matrix< int > a = sparseSample< int >(20, 20, gen(), 0.1, -1, 1);
+  abramov::Matrix< int > reach = abramov::semiringPower< abramov::OrAnd< int > >(a, 6, 2);
+  abramov::BitMatrix bits(a);
+  abramov::BitMatrix power = bits;
+  for (int i = 1; i < 6; ++i)
+  {
+    power = abramov::booleanMultiply(power, bits);
+  }
+  BOOST_TEST((abramov::BitMatrix(reach) == power));
+}
+
+BOOST_AUTO_TEST_CASE(bit_matrices)
+{
+  std::mt19937 gen(3);
+  for (auto [m, k, n] : { std::tuple< size_t, size_t, size_t >{ 1, 1, 1 }, { 7, 13, 9 }, { 65, 64, 63 },
+    { 70, 200, 130 } })
+  {
+    abramov::Matrix< int > a = sparseSample< int >(m, k, gen(), 0.05, -1, 1);
+    abramov::Matrix< int > b = sparseSample< int >(k, n, gen(), 0.05, -1, 1);
+    abramov::BitMatrix x(a);
+    abramov::BitMatrix y(b);
+    BOOST_TEST((x.toMatrix< int >() == abramov::BitMatrix(x.toMatrix< int >()).toMatrix< int >()));
+    BOOST_TEST((x.transpose().transpose() == x));
+    BOOST_TEST(x.transpose().get(0, 0) == x.get(0, 0));
+    abramov::Matrix< int > product = naive< abramov::OrAnd< int > >(a, b);
+    BOOST_TEST((abramov::booleanMultiply(x, y, 2) == abramov::BitMatrix(product)));
+    abramov::Matrix< int > counts = naive< abramov::PlusTimes< int > >(x.toMatrix< int >(), y.toMatrix< int >());
+    BOOST_TEST((abramov::countingMultiply< int >(x, y, 3) == counts));
+  }
+  abramov::BitMatrix x(3, 100);
+  x.set(2, 99);
+  x.set(1, 64);
+  x.set(1, 64, false);
+  BOOST_TEST(x.count() == 1);
+  BOOST_TEST(x.get(2, 99));
+  BOOST_CHECK_THROW(abramov::booleanMultiply(x, x), std::invalid_argument);
+  BOOST_CHECK_THROW(abramov::transitiveClosure(x), std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(closure_matches_warshall)
+{
+  std::mt19937 gen(17);
+  for (size_t n : { 0, 1, 2, 9, 64, 100, 257 })
+  {
+    abramov::BitMatrix a(sparseSample< int >(n, n, gen(), std::min(1.0, 1.5 / (n + 1)), -1, 1));
+    abramov::BitMatrix want = warshall(a);
+    BOOST_TEST((abramov::transitiveClosure(a, false, 2) == want));
+    abramov::BitMatrix reflexive = abramov::transitiveClosure(a, true);
+    for (size_t i = 0; i < n; ++i)
+    {
+      want.set(i, i);
+    }
+    BOOST_TEST((reflexive == want));
+  }
+  abramov::BitMatrix chain(200, 200);
+  for (size_t i = 0; i + 1 < 200; ++i)
+  {
+    chain.set(i, i + 1);
+  }
+  abramov::BitMatrix closed = abramov::transitiveClosure(chain);
+  BOOST_TEST(closed.count() == 199 * 200 / 2);
+  BOOST_TEST(closed.get(0, 199));
+  BOOST_TEST(!closed.get(199, 0));
+}
+
+BOOST_AUTO_TEST_CASE(all_pairs_shortest_paths)
+{
+  std::mt19937 gen(29);
+  for (size_t n : { 1, 2, 8, 31, 90 })
+  {
+    abramov::Matrix< long long > w = weighted(n, gen, 1, 100, 0.1);
+    BOOST_TEST((abramov::shortestPaths(w, 2) == floydWarshall(w)));
+  }
+  abramov::Matrix< long long > chain = weighted(40, gen, 0, 0, 0.0);
+  for (size_t i = 0; i + 1 < 40; ++i)
+  {
+    chain[i][i + 1] = -3;
+    chain[i + 1][i] = 5;
+  }
+  abramov::Matrix< long long > d = abramov::shortestPaths(chain);
+  BOOST_TEST((d == floydWarshall(chain)));
+  BOOST_TEST(d[0][39] == -117);
+  BOOST_TEST(d[39][0] == 195);
+  chain[39][0] = 100;
+  BOOST_CHECK_THROW(abramov::shortestPaths(chain), std::logic_error);
+  abramov::Matrix< int > empty;
+  BOOST_TEST(abramov::shortestPaths(empty).getRows() == 0);
+}
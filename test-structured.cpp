@@ -0,0 +1,317 @@
+#define BOOST_TEST_MODULE structured
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "structured.hpp"
+#include "test-sample.hpp"
+
+namespace
+{
+  abramov::BandedMatrix< long long > randomBand(size_t n, size_t lower, size_t upper, std::mt19937 &gen)
+  {
+    std::uniform_int_distribution< int > dist(-4, 4);
+    abramov::BandedMatrix< long long > res(n, lower, upper);
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = i > lower ? i - lower : 0; j < n && j <= i + upper; ++j)
+      {
+        res.set(i, j, dist(gen));
+      }
+    }
+    return res;
+  }
+
+  template< class S >
+  void checkSolve(const S &s, const std::vector< long long > &rhs)
+  {
+    std::vector< double > x = s.solve(rhs);
+    BOOST_TEST(x.size() == rhs.size());
+    for (size_t i = 0; i < rhs.size(); ++i)
+    {
+      double sum = 0.0;
+      for (size_t j = 0; j < rhs.size(); ++j)
+      {
+        sum += static_cast< double >(s.get(i, j)) * x[j];
+      }
+      BOOST_TEST(std::abs(sum - static_cast< double >(rhs[i])) < 1e-6);
+    }
+  }
+
+  template< class S >
+  void checkAdjugate(const S &s)
+  {
+    auto [scale, adj] = s.inverse();
+    long long det = s.determinant();
+    BOOST_TEST(std::abs(scale - 1.0 / static_cast< double >(det)) < 1e-12);
+    abramov::Matrix< long long > product = adj.toMatrix() * s.toMatrix();
+    for (size_t i = 0; i < product.getRows(); ++i)
+    {
+      for (size_t j = 0; j < product.getCols(); ++j)
+      {
+        BOOST_TEST(product[i][j] == (i == j ? det : 0));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(conversions_validate_structure)
+{
+  abramov::Matrix< int > a{ { 1, 2, 0 }, { 0, 3, 4 }, { 0, 0, 5 } };
+  abramov::TriangularMatrix< int > upper(a, abramov::Triangle::Upper);
+  BOOST_TEST((upper.toMatrix() == a));
+  BOOST_TEST((upper.transpose().toMatrix() == a.transpose()));
+  BOOST_TEST((upper.transpose().getPart() == abramov::Triangle::Lower));
+  BOOST_CHECK_THROW(abramov::TriangularMatrix< int >(a, abramov::Triangle::Lower), std::invalid_argument);
+  BOOST_CHECK_THROW(abramov::DiagonalMatrix< int >{ a }, std::invalid_argument);
+  abramov::BandedMatrix< int > band(a, 0, 1);
+  BOOST_TEST((band.toMatrix() == a));
+  BOOST_TEST((band.transpose().toMatrix() == a.transpose()));
+  BOOST_CHECK_THROW(abramov::BandedMatrix< int >(a, 1, 0), std::invalid_argument);
+  BOOST_CHECK_THROW(band.set(2, 0, 1), std::invalid_argument);
+  abramov::Matrix< int > t{ { 1, 2, 3, 4 }, { 5, 1, 2, 3 }, { 6, 5, 1, 2 } };
+  abramov::ToeplitzMatrix< int > toeplitz(t);
+  BOOST_TEST((toeplitz.toMatrix() == t));
+  BOOST_TEST((toeplitz.transpose().toMatrix() == t.transpose()));
+  BOOST_TEST((toeplitz == abramov::ToeplitzMatrix< int >({ 1, 5, 6 }, { 1, 2, 3, 4 })));
+  BOOST_CHECK_THROW(abramov::ToeplitzMatrix< int >{ a }, std::invalid_argument);
+  BOOST_CHECK_THROW(abramov::ToeplitzMatrix< int >({ 1, 2 }, { 3, 4 }), std::invalid_argument);
+  BOOST_TEST((abramov::ToeplitzMatrix< int >::circulant({ 1, 2, 3 }).toMatrix() ==
+    abramov::Matrix< int >{ { 1, 2, 3 }, { 3, 1, 2 }, { 2, 3, 1 } }));
+  abramov::Matrix< int > b{ { 1, 2 } };
+  abramov::Matrix< int > c{ { 7 } };
+  abramov::BlockDiagonalMatrix< int > blocks({ b, c });
+  BOOST_TEST((blocks.toMatrix() == abramov::Matrix< int >::diagonalConcat(b, c)));
+  BOOST_TEST((blocks.transpose().toMatrix() == abramov::Matrix< int >::diagonalConcat(b, c).transpose()));
+  BOOST_CHECK_THROW(blocks.determinant(), std::logic_error);
+  abramov::DiagonalMatrix< int > diagonal(std::vector< int >{ 2, -3, 4 });
+  BOOST_TEST((abramov::DiagonalMatrix< int >(diagonal.toMatrix()) == diagonal));
+  BOOST_TEST(diagonal.trace() == 3);
+  BOOST_TEST(upper.trace() == 9);
+  BOOST_TEST(toeplitz.transpose().getRows() == 4);
+}
+
+BOOST_AUTO_TEST_CASE(products_match_dense)
+{
+  std::mt19937 gen(5);
+  for (size_t n : { 1, 2, 7, 40 })
+  {
+    abramov::Matrix< long long > dense = sample< long long >(n, n, gen(), -5, 5);
+    abramov::Matrix< long long > wide = sample< long long >(n, 3, gen(), -5, 5);
+    abramov::Matrix< long long > tall = sample< long long >(3, n, gen(), -5, 5);
+    for (auto [l, u] : { std::pair< size_t, size_t >{ 0, 0 }, { 1, 2 }, { 3, 0 }, { 9, 9 } })
+    {
+      abramov::BandedMatrix< long long > x = randomBand(n, l, u, gen);
+      abramov::BandedMatrix< long long > y = randomBand(n, u, l + 1, gen);
+      BOOST_TEST(((x * y).toMatrix() == x.toMatrix() * y.toMatrix()));
+      BOOST_TEST((x * wide == x.toMatrix() * wide));
+      BOOST_TEST((tall * x == tall * x.toMatrix()));
+      BOOST_TEST((x * dense == x.toMatrix() * dense));
+    }
+    abramov::TriangularMatrix< long long > lower(n, abramov::Triangle::Lower);
+    abramov::TriangularMatrix< long long > upper(n, abramov::Triangle::Upper);
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = 0; j <= i; ++j)
+      {
+        lower.set(i, j, dense[i][j]);
+        upper.set(j, i, dense[j][i]);
+      }
+    }
+    BOOST_TEST(((lower * lower).toMatrix() == lower.toMatrix() * lower.toMatrix()));
+    BOOST_TEST(((upper * upper).toMatrix() == upper.toMatrix() * upper.toMatrix()));
+    BOOST_TEST((upper * wide == upper.toMatrix() * wide));
+    BOOST_TEST((tall * lower == tall * lower.toMatrix()));
+    BOOST_CHECK_THROW(lower * upper, std::invalid_argument);
+    std::vector< long long > values(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      values[i] = dense[i][0];
+    }
+    abramov::DiagonalMatrix< long long > diagonal(values);
+    BOOST_TEST(((diagonal * diagonal).toMatrix() == diagonal.toMatrix() * diagonal.toMatrix()));
+    BOOST_TEST((diagonal * wide == diagonal.toMatrix() * wide));
+    std::vector< long long > row(dense[n - 1], dense[n - 1] + n);
+    row[0] = values[0];
+    abramov::ToeplitzMatrix< long long > toeplitz(values, row);
+    abramov::ToeplitzMatrix< long long > circulant = abramov::ToeplitzMatrix< long long >::circulant(values);
+    BOOST_TEST((circulant * dense == circulant.toMatrix() * dense));
+    BOOST_TEST((tall * circulant == tall * circulant.toMatrix()));
+    BOOST_TEST((toeplitz * wide == toeplitz.toMatrix() * wide));
+  }
+  abramov::BlockDiagonalMatrix< long long > x({ sample< long long >(2, 3, gen(), -5, 5),
+    sample< long long >(4, 1, gen(), -5, 5) });
+  abramov::BlockDiagonalMatrix< long long > y({ sample< long long >(3, 2, gen(), -5, 5),
+    sample< long long >(1, 5, gen(), -5, 5) });
+  BOOST_TEST(((x * y).toMatrix() == x.toMatrix() * y.toMatrix()));
+  BOOST_TEST((x * y.toMatrix() == x.toMatrix() * y.toMatrix()));
+  BOOST_TEST((x.toMatrix() * y == x.toMatrix() * y.toMatrix()));
+  BOOST_CHECK_THROW(x * x, std::invalid_argument);
+  BOOST_CHECK_THROW(x * abramov::Matrix< long long >(5, 2, 0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(determinants_match_dense)
+{
+  std::mt19937 gen(11);
+  for (size_t n : { 1, 2, 5, 7 })
+  {
+    for (auto [l, u] : { std::pair< size_t, size_t >{ 0, 0 }, { 1, 1 }, { 2, 0 }, { 0, 3 }, { 6, 6 } })
+    {
+      for (int round = 0; round < 4; ++round)
+      {
+        abramov::BandedMatrix< long long > band = randomBand(n, l, u, gen);
+        BOOST_TEST(band.determinant() == band.toMatrix().determinant());
+      }
+    }
+    abramov::BandedMatrix< long long > zeros(n, 1, 1);
+    BOOST_TEST(zeros.determinant() == 0);
+    abramov::Matrix< long long > dense = sample< long long >(n, n, gen(), -6, 6);
+    abramov::ToeplitzMatrix< long long > toeplitz = abramov::ToeplitzMatrix< long long >::circulant(
+      std::vector< long long >(dense[0], dense[0] + n));
+    BOOST_TEST(toeplitz.determinant() == toeplitz.toMatrix().determinant());
+    abramov::TriangularMatrix< long long > lower(n, abramov::Triangle::Lower);
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = 0; j <= i; ++j)
+      {
+        lower.set(i, j, dense[i][j]);
+      }
+    }
+    BOOST_TEST(lower.determinant() == lower.toMatrix().determinant());
+  }
+  abramov::Matrix< long long > a = sample< long long >(3, 3, gen(), -6, 6);
+  abramov::Matrix< long long > b = sample< long long >(4, 4, gen(), -6, 6);
+  abramov::BlockDiagonalMatrix< long long > blocks({ a, b });
+  BOOST_TEST(blocks.determinant() == a.determinant() * b.determinant());
+  BOOST_TEST(blocks.trace() == a.trace() + b.trace());
+  abramov::BandedMatrix< int, abramov::Checked > huge(40, 0, 1);
+  for (size_t i = 0; i < 40; ++i)
+  {
+    huge.set(i, i, 3);
+  }
+  BOOST_CHECK_THROW(huge.determinant(), std::overflow_error);
+  abramov::BandedMatrix< int, abramov::Widening > wide(30, 1, 1);
+  for (size_t i = 0; i < 30; ++i)
+  {
+    wide.set(i, i, 4);
+  }
+  BOOST_TEST(wide.determinant() == 1LL << 60);
+  abramov::DiagonalMatrix< int, abramov::Saturating > saturated(std::vector< int >(40, -3));
+  BOOST_TEST(saturated.determinant() == std::numeric_limits< int >::max());
+}
+
+BOOST_AUTO_TEST_CASE(inverses_are_exact)
+{
+  std::mt19937 gen(17);
+  abramov::DiagonalMatrix< long long > diagonal(std::vector< long long >{ 2, -3, 5, 7 });
+  checkAdjugate(diagonal);
+  for (size_t n : { 1, 3, 8 })
+  {
+    abramov::TriangularMatrix< long long > upper(n, abramov::Triangle::Upper);
+    abramov::TriangularMatrix< long long > lower(n, abramov::Triangle::Lower);
+    std::uniform_int_distribution< int > dist(-4, 4);
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = i; j < n; ++j)
+      {
+        upper.set(i, j, i == j ? 1 + static_cast< int >(i % 3) : dist(gen));
+        lower.set(j, i, i == j ? -1 - static_cast< int >(i % 2) : dist(gen));
+      }
+    }
+    checkAdjugate(upper);
+    checkAdjugate(lower);
+  }
+  abramov::Matrix< long long > a = sample< long long >(3, 3, gen(), -4, 4);
+  abramov::Matrix< long long > b = sample< long long >(2, 2, gen(), -4, 4);
+  while (a.determinant() == 0 || b.determinant() == 0)
+  {
+    a = sample< long long >(3, 3, gen(), -4, 4);
+    b = sample< long long >(2, 2, gen(), -4, 4);
+  }
+  abramov::BlockDiagonalMatrix< long long > blocks({ a, b, abramov::Matrix< long long >{ { -2 } } });
+  checkAdjugate(blocks);
+  BOOST_CHECK_THROW(abramov::DiagonalMatrix< int >(std::vector< int >{ 1, 0 }).inverse(), std::logic_error);
+  BOOST_CHECK_THROW(abramov::TriangularMatrix< int >(2, abramov::Triangle::Upper).inverse(), std::logic_error);
+  BOOST_CHECK_THROW(abramov::BlockDiagonalMatrix< int >({ abramov::Matrix< int >(2, 2, 1) }).inverse(),
+    std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(solvers_have_small_residuals)
+{
+  std::mt19937 gen(23);
+  for (size_t n : { 1, 2, 9, 60 })
+  {
+    std::vector< long long > rhs(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      rhs[i] = static_cast< long long >(gen() % 21) - 10;
+    }
+    abramov::BandedMatrix< long long > band = randomBand(n, 2, 1, gen);
+    for (size_t i = 0; i < n; ++i)
+    {
+      band.set(i, i, 20);
+    }
+    checkSolve(band, rhs);
+    abramov::BandedMatrix< long long > pivoting(n, 1, 1);
+    for (size_t i = 0; i + 1 < n; ++i)
+    {
+      pivoting.set(i, i + 1, 1);
+      pivoting.set(i + 1, i, 1);
+    }
+    if (n % 2 == 0)
+    {
+      checkSolve(pivoting, rhs);
+    }
+    abramov::TriangularMatrix< long long > lower(n, abramov::Triangle::Lower);
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = 0; j <= i; ++j)
+      {
+        lower.set(i, j, i == j ? 3 : static_cast< long long >(gen() % 3) - 1);
+      }
+    }
+    checkSolve(lower, rhs);
+    checkSolve(lower.transpose(), rhs);
+    std::vector< long long > column(n);
+    std::vector< long long > row(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      column[i] = i ? static_cast< long long >(gen() % 5) - 2 : 2 * static_cast< long long >(n) + 1;
+      row[i] = i ? static_cast< long long >(gen() % 5) - 2 : column[0];
+    }
+    checkSolve(abramov::ToeplitzMatrix< long long >(column, row), rhs);
+    if (n > 1)
+    {
+      column[0] = 0;
+      row[0] = 0;
+      column[1] = 1;
+      row[1] = 1;
+      checkSolve(abramov::ToeplitzMatrix< long long >(column, row), rhs);
+    }
+    checkSolve(abramov::DiagonalMatrix< long long >(std::vector< long long >(n, -4)), rhs);
+    abramov::Matrix< long long > a = sample< long long >(n, n, gen(), -3, 3);
+    for (size_t i = 0; i < n; ++i)
+    {
+      a[i][i] = 3 * static_cast< long long >(n);
+    }
+    checkSolve(abramov::BlockDiagonalMatrix< long long >({ a }), rhs);
+  }
+  abramov::ToeplitzMatrix< long long > vanishingMinor = abramov::ToeplitzMatrix< long long >::circulant({ 5, -6, 5, -3, -2, -4 });
+  BOOST_TEST(vanishingMinor.determinant() == -200655);
+  abramov::Matrix< long long > leading(4, 4, 0);
+  for (size_t i = 0; i < 4; ++i)
+  {
+    for (size_t j = 0; j < 4; ++j)
+    {
+      leading[i][j] = vanishingMinor.get(i, j);
+    }
+  }
+  BOOST_TEST(leading.determinant() == 0);
+  checkSolve(vanishingMinor, { -16, -11, 7, 4, 17, 18 });
+  abramov::BandedMatrix< int > singular(3, 1, 1);
+  BOOST_CHECK_THROW(singular.solve({ 1, 2, 3 }), std::logic_error);
+  BOOST_CHECK_THROW(singular.solve({ 1, 2 }), std::invalid_argument);
+  BOOST_CHECK_THROW(abramov::DiagonalMatrix< int >(std::vector< int >{ 1, 0 }).solve({ 1, 1 }), std::logic_error);
+}
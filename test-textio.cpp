@@ -0,0 +1,116 @@
+#define BOOST_TEST_MODULE textio
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "textio.hpp"
+
+BOOST_AUTO_TEST_CASE(parse_integer)
+{
+  std::string text = "  -17 +4 12abc";
+  const char *first = text.data();
+  const char *last = first + text.size();
+  int value = 0;
+  first = abramov::parseInteger(first, last, value);
+  BOOST_TEST(value == -17);
+  first = abramov::parseInteger(first, last, value);
+  BOOST_TEST(value == 4);
+  first = abramov::parseInteger(first, last, value);
+  BOOST_TEST(value == 12);
+  BOOST_TEST((abramov::parseInteger(first, last, value) == nullptr));
+}
+
+BOOST_AUTO_TEST_CASE(parse_integer_limits)
+{
+  std::string min = "-2147483648";
+  std::string over = "2147483648";
+  int value = 0;
+  BOOST_TEST((abramov::parseInteger(min.data(), min.data() + min.size(), value) != nullptr));
+  BOOST_TEST(value == -2147483647 - 1);
+  BOOST_TEST((abramov::parseInteger(over.data(), over.data() + over.size(), value) == nullptr));
+}
+
+BOOST_AUTO_TEST_CASE(scan_integer)
+{
+  std::istringstream in(" 42\n-7");
+  int value = 0;
+  std::ios_base::iostate state = std::ios_base::goodbit;
+  BOOST_TEST(abramov::scanInteger(*in.rdbuf(), value, state));
+  BOOST_TEST(value == 42);
+  BOOST_TEST(abramov::scanInteger(*in.rdbuf(), value, state));
+  BOOST_TEST(value == -7);
+  BOOST_TEST((state == std::ios_base::eofbit));
+  BOOST_TEST(!abramov::scanInteger(*in.rdbuf(), value, state));
+  BOOST_TEST((state & std::ios_base::failbit));
+}
+
+BOOST_AUTO_TEST_CASE(scan_integer_leading_zeros)
+{
+  std::istringstream in("0000000000000000000000000042 -00000000000000000000000000000 +000 99999999999999999999");
+  std::istringstream reference(in.str());
+  for (size_t i = 0; i < 4; ++i)
+  {
+    long long value = 1;
+    long long want = 1;
+    std::ios_base::iostate state = std::ios_base::goodbit;
+    bool ok = abramov::scanInteger(*in.rdbuf(), value, state);
+    reference >> want;
+    BOOST_TEST(ok == !reference.fail());
+    if (ok)
+    {
+      BOOST_TEST(value == want);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_parse_integers)
+{
+  constexpr size_t n = 400000;
+  std::string text;
+  for (size_t i = 0; i < n; ++i)
+  {
+    abramov::formatInteger(text, static_cast< int >(i * 2654435761u));
+    text.push_back(i % 10 == 9 ? '\n' : ' ');
+  }
+  text += "tail";
+  std::vector< int > values(n);
+  const char *end = abramov::parseIntegers(text.data(), text.data() + text.size(), values.data(), n, 4);
+  BOOST_TEST((end == text.data() + text.size() - 5));
+  bool same = true;
+  for (size_t i = 0; i < n; ++i)
+  {
+    same = same && values[i] == static_cast< int >(i * 2654435761u);
+  }
+  BOOST_TEST(same);
+  BOOST_TEST((abramov::parseIntegers(text.data(), text.data() + text.size(), values.data(), n + 1, 4) == nullptr));
+}
+
+BOOST_AUTO_TEST_CASE(parallel_parse_fallback)
+{
+  std::string text(3 << 20, ' ');
+  text[0] = '1';
+  text[1] = '-';
+  text[2] = '2';
+  int values[2] = {};
+  const char *end = abramov::parseIntegers(text.data(), text.data() + text.size(), values, 2, 4);
+  BOOST_TEST((end == text.data() + 3));
+  BOOST_TEST(values[0] == 1);
+  BOOST_TEST(values[1] == -2);
+}
+
+BOOST_AUTO_TEST_CASE(mapped_file)
+{
+  std::string path = "textio_test.tmp";
+  {
+    std::ofstream out(path);
+    out << "1 2 3\n";
+  }
+  {
+    abramov::MappedFile file(path);
+    BOOST_TEST(std::string(file.begin(), file.end()) == "1 2 3\n");
+  }
+  std::remove(path.c_str());
+  BOOST_CHECK_THROW(abramov::MappedFile("missing_textio_test.tmp"), std::runtime_error);
+}
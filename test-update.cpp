@@ -0,0 +1,121 @@
+#define BOOST_TEST_MODULE update
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+#include <vector>
+#include "update.hpp"
+#include "test-sample.hpp"
+
+namespace
+{
+  std::vector< int > vec(size_t n, int seed)
+  {
+    std::vector< int > res(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      res[i] = static_cast< int >((i * i * 7 + i * 13 + seed * seed * 5 + seed) % 9) - 4;
+    }
+    return res;
+  }
+
+  template< class P >
+  void check(const abramov::InverseUpdater< int, P > &upd)
+  {
+    abramov::BigInt det = abramov::exactDeterminant(upd.matrix());
+    BOOST_TEST((upd.determinant() == det));
+    if (det.isZero())
+    {
+      BOOST_CHECK_THROW(upd.adjugate(), std::logic_error);
+    }
+    else
+    {
+      BOOST_TEST((upd.adjugate() == abramov::exactInverse(upd.matrix()).second));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(rank_one)
+{
+  abramov::InverseUpdater< int > upd(sample(7, 7, 1, -11, 11));
+  BOOST_TEST(upd.size() == 7u);
+  check(upd);
+  for (int s = 0; s < 5; ++s)
+  {
+    std::vector< int > u = vec(7, s);
+    std::vector< int > v = vec(7, s + 11);
+    abramov::Matrix< int > expected = upd.matrix();
+    for (size_t i = 0; i < 7; ++i)
+    {
+      for (size_t j = 0; j < 7; ++j)
+      {
+        expected[i][j] += u[i] * v[j];
+      }
+    }
+    upd.rankOneUpdate(u, v);
+    BOOST_TEST((upd.matrix() == expected));
+    check(upd);
+  }
+  BOOST_CHECK_THROW(upd.rankOneUpdate(vec(6, 1), vec(7, 1)), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(rows_and_columns)
+{
+  abramov::Matrix< int > a = sample(9, 9, 2, -11, 11);
+  abramov::InverseUpdater< int > upd(a);
+  for (size_t k = 0; k < 9; ++k)
+  {
+    upd.replaceRow(k, vec(9, static_cast< int >(k)));
+    check(upd);
+    upd.replaceColumn((k * 4) % 9, vec(9, static_cast< int >(k) + 3));
+    check(upd);
+  }
+  BOOST_CHECK_THROW(upd.replaceRow(9, vec(9, 0)), std::out_of_range);
+  BOOST_CHECK_THROW(upd.replaceColumn(0, vec(8, 0)), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(singular_transitions)
+{
+  abramov::Matrix< int > a = sample(5, 5, 3, -11, 11);
+  a[0][0] += 50;
+  abramov::InverseUpdater< int > upd(a);
+  check(upd);
+  std::vector< int > saved(a[1], a[1] + 5);
+  upd.replaceRow(1, std::vector< int >(a[2], a[2] + 5));
+  BOOST_TEST(upd.determinant().isZero());
+  BOOST_CHECK_THROW(upd.adjugate(), std::logic_error);
+  check(upd);
+  upd.rankOneUpdate(vec(5, 1), std::vector< int >(5, 0));
+  BOOST_TEST(upd.determinant().isZero());
+  upd.replaceRow(1, saved);
+  check(upd);
+}
+
+BOOST_AUTO_TEST_CASE(woodbury)
+{
+  abramov::Matrix< int > a = sample(8, 8, 4, -11, 11);
+  abramov::InverseUpdater< int > upd(a);
+  abramov::Matrix< int > u(8, 3, 0);
+  abramov::Matrix< int > v(8, 3, 0);
+  for (size_t i = 0; i < 8; ++i)
+  {
+    for (size_t t = 0; t < 3; ++t)
+    {
+      u[i][t] = static_cast< int >((i + 2 * t) % 5) - 2;
+      v[i][t] = static_cast< int >((3 * i + t) % 7) - 3;
+    }
+  }
+  upd.update(u, v);
+  BOOST_TEST((upd.matrix() == a + u * v.transpose()));
+  check(upd);
+  BOOST_CHECK_THROW(upd.update(u, abramov::Matrix< int >(8, 2, 0)), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(overflow)
+{
+  abramov::Matrix< int, abramov::Checked > a{ { 2147483000, 0 }, { 0, 1 } };
+  abramov::InverseUpdater< int, abramov::Checked > upd(a);
+  BOOST_CHECK_THROW(upd.rankOneUpdate({ 1000, 0 }, { 1, 0 }), std::overflow_error);
+  BOOST_TEST((upd.matrix() == a));
+  check(upd);
+  upd.replaceColumn(1, { 5, 7 });
+  check(upd);
+}
@@ -198,3 +198,105 @@ BOOST_AUTO_TEST_CASE(not_equal_operator)
   abramov::Vector< double, N > vect2 = { 3.0, 2.0, 1.0 };
   BOOST_TEST((vect1 != vect2));
 }
+
+BOOST_AUTO_TEST_CASE(subscript)
+{
+  abramov::Vector< int, N > vect = { 1, 2, 3 };
+  vect[1] = 7;
+  const abramov::Vector< int, N > &ref = vect;
+  BOOST_TEST(ref[0] == 1);
+  BOOST_TEST(ref[1] == 7);
+  BOOST_TEST(ref[2] == 3);
+}
+
+BOOST_AUTO_TEST_CASE(norm_integral_overflow)
+{
+  abramov::Vector< int, N > vect = { 60000, 80000, 0 };
+  BOOST_TEST(std::abs(vect.norm() - 100000.0) < 1e-6);
+  abramov::Vector< int, N > vect2 = { -60000, -80000, 0 };
+  BOOST_TEST(std::abs(vect.distance(vect2) - 200000.0) < 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(summation_modes)
+{
+  constexpr size_t M = 1000;
+  std::array< double, M > a;
+  std::array< double, M > b;
+  for (size_t i = 0; i < M; ++i)
+  {
+    a[i] = (i % 3 == 0 ? 1e8 : 1.0) * (i % 2 ? -1.0 : 1.0);
+    b[i] = 1.0 + (i % 7) * 1e-3;
+  }
+  abramov::Vector< double, M > x(a);
+  abramov::Vector< double, M > y(b);
+  long double exact = 0;
+  for (size_t i = 0; i < M; ++i)
+  {
+    exact += static_cast< long double >(a[i]) * b[i];
+  }
+  for (auto mode : { abramov::Summation::Fast, abramov::Summation::Kahan, abramov::Summation::Pairwise })
+  {
+    BOOST_TEST(std::abs(x.dot(y, mode) - exact) < 1e-4);
+    BOOST_TEST(std::abs(x.norm(mode) - std::sqrt(x.dot(x, abramov::Summation::Kahan))) < 1e-6);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(kahan_cancellation)
+{
+  constexpr size_t M = 4;
+  abramov::Vector< double, M > x = { 1e16, 1.0, -1e16, 1.0 };
+  abramov::Vector< double, M > y = { 1.0, 1.0, 1.0, 1.0 };
+  BOOST_TEST(x.dot(y, abramov::Summation::Kahan) == 2.0);
+}
+
+BOOST_AUTO_TEST_CASE(integral_dot_modes)
+{
+  constexpr size_t M = 37;
+  std::array< int, M > a;
+  for (size_t i = 0; i < M; ++i)
+  {
+    a[i] = static_cast< int >(i) - 18;
+  }
+  abramov::Vector< int, M > x(a);
+  int expected = 0;
+  for (size_t i = 0; i < M; ++i)
+  {
+    expected += a[i] * a[i];
+  }
+  BOOST_TEST(x.dot(x) == expected);
+  BOOST_TEST(x.dot(x, abramov::Summation::Kahan) == expected);
+  BOOST_TEST(x.dot(x, abramov::Summation::Pairwise) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(batch_dots_and_distances)
+{
+  constexpr size_t M = 19;
+  std::vector< abramov::Vector< float, M > > items;
+  for (size_t k = 0; k < 11; ++k)
+  {
+    std::array< float, M > arr;
+    for (size_t i = 0; i < M; ++i)
+    {
+      arr[i] = static_cast< float >((i * 5 + k * 3) % 13) - 6.0f;
+    }
+    items.emplace_back(arr);
+  }
+  abramov::Vector< float, M > query = items[4];
+  query[0] = 2.5f;
+  for (size_t threads : { 1, 3 })
+  {
+    for (auto mode : { abramov::Summation::Fast, abramov::Summation::Kahan, abramov::Summation::Pairwise })
+    {
+      auto d = abramov::dots(query, items, mode, threads);
+      auto e = abramov::distances(query, items, mode, threads);
+      BOOST_TEST(d.size() == items.size());
+      BOOST_TEST(e.size() == items.size());
+      for (size_t k = 0; k < items.size(); ++k)
+      {
+        BOOST_TEST(std::abs(d[k] - query.dot(items[k])) < 1e-3);
+        BOOST_TEST(std::abs(e[k] - query.distance(items[k])) < 1e-6);
+      }
+    }
+  }
+  BOOST_TEST(abramov::dots(query, {}).empty());
+}
@@ -0,0 +1,331 @@
+#ifndef TEXTIO_HPP
+#define TEXTIO_HPP
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <istream>
+#include <limits>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "threadpool.hpp"
+
+namespace abramov
+{
+  struct MappedFile
+  {
+    explicit MappedFile(const std::string &path);
+    MappedFile(const MappedFile &) = delete;
+    ~MappedFile();
+    MappedFile &operator=(const MappedFile &) = delete;
+    const char *begin() const noexcept;
+    const char *end() const noexcept;
+    size_t size() const noexcept;
+  private:
+    const char *data;
+    size_t length;
+    bool mapped;
+    std::string fallback;
+  };
+
+  bool isSpace(char c) noexcept;
+  template< std::integral T >
+  const char *parseInteger(const char *first, const char *last, T &value);
+  template< std::integral T >
+  bool scanInteger(std::streambuf &buf, T &value, std::ios_base::iostate &state);
+  template< std::integral T >
+  const char *parseIntegers(const char *first, const char *last, T *out, size_t count, size_t threads = 1);
+  template< std::integral T >
+  void formatInteger(std::string &out, T value);
+}
+
+inline abramov::MappedFile::MappedFile(const std::string &path):
+  data(nullptr),
+  length(0),
+  mapped(false),
+  fallback()
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw std::runtime_error("Can not open file " + path + "\n");
+  }
+  struct stat st = {};
+  if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+  {
+    void *p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED)
+    {
+      ::madvise(p, st.st_size, MADV_SEQUENTIAL);
+      data = static_cast< const char * >(p);
+      length = st.st_size;
+      mapped = true;
+      ::close(fd);
+      return;
+    }
+  }
+  char chunk[1 << 16];
+  for (;;)
+  {
+    ssize_t got = ::read(fd, chunk, sizeof(chunk));
+    if (got < 0)
+    {
+      ::close(fd);
+      throw std::runtime_error("Can not read file " + path + "\n");
+    }
+    if (got == 0)
+    {
+      break;
+    }
+    fallback.append(chunk, got);
+  }
+  ::close(fd);
+  data = fallback.data();
+  length = fallback.size();
+}
+
+inline abramov::MappedFile::~MappedFile()
+{
+  if (mapped)
+  {
+    ::munmap(const_cast< char * >(data), length);
+  }
+}
+
+inline const char *abramov::MappedFile::begin() const noexcept
+{
+  return data;
+}
+
+inline const char *abramov::MappedFile::end() const noexcept
+{
+  return data + length;
+}
+
+inline size_t abramov::MappedFile::size() const noexcept
+{
+  return length;
+}
+
+inline bool abramov::isSpace(char c) noexcept
+{
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+template< std::integral T >
+const char *abramov::parseInteger(const char *first, const char *last, T &value)
+{
+  using U = std::make_unsigned_t< T >;
+  while (first != last && isSpace(*first))
+  {
+    ++first;
+  }
+  bool negative = false;
+  if (first != last && (*first == '-' || *first == '+'))
+  {
+    negative = *first == '-';
+    ++first;
+  }
+  U magnitude = 0;
+  auto res = std::from_chars(first, last, magnitude);
+  if (res.ec != std::errc{})
+  {
+    return nullptr;
+  }
+  if constexpr (std::is_signed_v< T >)
+  {
+    U limit = static_cast< U >(std::numeric_limits< T >::max()) + (negative ? 1 : 0);
+    if (magnitude > limit)
+    {
+      return nullptr;
+    }
+  }
+  value = static_cast< T >(negative ? U(0) - magnitude : magnitude);
+  return res.ptr;
+}
+
+template< std::integral T >
+bool abramov::scanInteger(std::streambuf &buf, T &value, std::ios_base::iostate &state)
+{
+  using traits = std::char_traits< char >;
+  const traits::int_type eof = traits::eof();
+  traits::int_type c = buf.sgetc();
+  while (c != eof && isSpace(traits::to_char_type(c)))
+  {
+    c = buf.snextc();
+  }
+  char token[std::numeric_limits< unsigned long long >::digits10 + 3];
+  size_t len = 0;
+  bool overflow = false;
+  if (c != eof && (c == '-' || c == '+'))
+  {
+    token[len++] = traits::to_char_type(c);
+    c = buf.snextc();
+  }
+  // Leading zeros carry no value, so they must not count against the
+  // token length: operator>> accepts any number of them
+  bool zeros = false;
+  while (c != eof && c == '0')
+  {
+    zeros = true;
+    c = buf.snextc();
+  }
+  if (zeros && (c == eof || c < '0' || c > '9'))
+  {
+    token[len++] = '0';
+  }
+  while (c != eof && c >= '0' && c <= '9')
+  {
+    if (len < sizeof(token))
+    {
+      token[len++] = traits::to_char_type(c);
+    }
+    else
+    {
+      overflow = true;
+    }
+    c = buf.snextc();
+  }
+  if (c == eof)
+  {
+    state |= std::ios_base::eofbit;
+  }
+  if (overflow || !parseInteger(token, token + len, value))
+  {
+    state |= std::ios_base::failbit;
+    return false;
+  }
+  return true;
+}
+
+template< std::integral T >
+const char *abramov::parseIntegers(const char *first, const char *last, T *out, size_t count, size_t threads)
+{
+  constexpr size_t min_chunk = 1 << 20;
+  size_t chunks = std::min(threads, static_cast< size_t >(last - first) / min_chunk);
+  if (chunks < 2 || count < chunks)
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      first = parseInteger(first, last, out[i]);
+      if (!first)
+      {
+        return nullptr;
+      }
+    }
+    return first;
+  }
+  std::vector< const char * > bounds(chunks + 1, last);
+  bounds[0] = first;
+  for (size_t c = 1; c < chunks; ++c)
+  {
+    const char *p = std::max(bounds[c - 1], first + (last - first) / chunks * c);
+    while (p != last && !isSpace(*p))
+    {
+      ++p;
+    }
+    bounds[c] = p;
+  }
+  constexpr size_t clean = std::numeric_limits< size_t >::max();
+  std::vector< size_t > tokens(chunks, 0);
+  std::vector< size_t > dirty(chunks, clean);
+  parallelFor(0, chunks, [&](size_t lo, size_t hi)
+  {
+    for (size_t c = lo; c < hi; ++c)
+    {
+      const char *p = bounds[c];
+      const char *end = bounds[c + 1];
+      size_t n = 0;
+      while (p != end)
+      {
+        while (p != end && isSpace(*p))
+        {
+          ++p;
+        }
+        if (p == end)
+        {
+          break;
+        }
+        if (*p == '-' || *p == '+')
+        {
+          ++p;
+        }
+        const char *digits = p;
+        while (p != end && *p >= '0' && *p <= '9')
+        {
+          ++p;
+        }
+        bool ok = p != digits && (p == end || isSpace(*p));
+        while (p != end && !isSpace(*p))
+        {
+          ++p;
+        }
+        if (!ok && dirty[c] == clean)
+        {
+          dirty[c] = n;
+        }
+        ++n;
+      }
+      tokens[c] = n;
+    }
+  }, chunks);
+  std::vector< size_t > offsets(chunks + 1, 0);
+  for (size_t c = 0; c < chunks; ++c)
+  {
+    if (dirty[c] != clean && offsets[c] + dirty[c] < count)
+    {
+      return parseIntegers(first, last, out, count, 1);
+    }
+    offsets[c + 1] = offsets[c] + tokens[c];
+  }
+  if (offsets[chunks] < count)
+  {
+    return nullptr;
+  }
+  std::vector< const char * > ends(chunks, nullptr);
+  std::atomic< bool > failed(false);
+  parallelFor(0, chunks, [&](size_t lo, size_t hi)
+  {
+    for (size_t c = lo; c < hi && offsets[c] < count; ++c)
+    {
+      const char *p = bounds[c];
+      size_t n = std::min(tokens[c], count - offsets[c]);
+      for (size_t i = 0; i < n && p; ++i)
+      {
+        p = parseInteger(p, bounds[c + 1], out[offsets[c] + i]);
+      }
+      if (!p)
+      {
+        failed = true;
+      }
+      ends[c] = p;
+    }
+  }, chunks);
+  if (failed)
+  {
+    return nullptr;
+  }
+  size_t c = 0;
+  while (offsets[c + 1] < count)
+  {
+    ++c;
+  }
+  return ends[c];
+}
+
+template< std::integral T >
+void abramov::formatInteger(std::string &out, T value)
+{
+  char buf[std::numeric_limits< T >::digits10 + 3];
+  auto res = std::to_chars(buf, buf + sizeof(buf), value);
+  out.append(buf, res.ptr);
+}
+#endif
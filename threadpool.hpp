@@ -0,0 +1,232 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace abramov
+{
+  struct ThreadPool
+  {
+    explicit ThreadPool(size_t threads = 0);
+    ThreadPool(size_t threads, std::function< void(size_t) > init);
+    ThreadPool(const ThreadPool &) = delete;
+    ~ThreadPool();
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    template< class F >
+    std::future< std::invoke_result_t< F > > submit(F &&f);
+    size_t size() const noexcept;
+  private:
+    std::vector< std::thread > workers;
+    std::queue< std::function< void() > > tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop;
+    std::function< void(size_t) > prepare;
+
+    void work(size_t index);
+  };
+
+  ThreadPool &defaultPool();
+  size_t defaultThreads() noexcept;
+  template< class F >
+  void parallelFor(size_t begin, size_t end, F f, size_t threads = 0);
+}
+
+inline abramov::ThreadPool::ThreadPool(size_t threads):
+  ThreadPool(threads, nullptr)
+{}
+
+inline abramov::ThreadPool::ThreadPool(size_t threads, std::function< void(size_t) > init):
+  workers(),
+  tasks(),
+  mutex(),
+  cv(),
+  stop(false),
+  prepare(std::move(init))
+{
+  if (!threads)
+  {
+    threads = defaultThreads();
+  }
+  workers.reserve(threads);
+  try
+  {
+    for (size_t i = 0; i < threads; ++i)
+    {
+      workers.emplace_back(&ThreadPool::work, this, i);
+    }
+  }
+  catch (...)
+  {
+    {
+      std::lock_guard< std::mutex > lock(mutex);
+      stop = true;
+    }
+    cv.notify_all();
+    for (auto &worker : workers)
+    {
+      worker.join();
+    }
+    throw;
+  }
+}
+
+inline abramov::ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    stop = true;
+  }
+  cv.notify_all();
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+}
+
+template< class F >
+std::future< std::invoke_result_t< F > > abramov::ThreadPool::submit(F &&f)
+{
+  using R = std::invoke_result_t< F >;
+  auto task = std::make_shared< std::packaged_task< R() > >(std::forward< F >(f));
+  std::future< R > res = task->get_future();
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    if (stop)
+    {
+      throw std::logic_error("Thread pool is stopped\n");
+    }
+    tasks.emplace([task]()
+    {
+      (*task)();
+    });
+  }
+  cv.notify_one();
+  return res;
+}
+
+inline size_t abramov::ThreadPool::size() const noexcept
+{
+  return workers.size();
+}
+
+inline void abramov::ThreadPool::work(size_t index)
+{
+  if (prepare)
+  {
+    prepare(index);
+  }
+  for (;;)
+  {
+    std::function< void() > task;
+    {
+      std::unique_lock< std::mutex > lock(mutex);
+      cv.wait(lock, [this]()
+      {
+        return stop || !tasks.empty();
+      });
+      if (tasks.empty())
+      {
+        return;
+      }
+      task = std::move(tasks.front());
+      tasks.pop();
+    }
+    task();
+  }
+}
+
+inline abramov::ThreadPool &abramov::defaultPool()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+inline size_t abramov::defaultThreads() noexcept
+{
+  size_t n = std::thread::hardware_concurrency();
+  return n ? n : 1;
+}
+
+template< class F >
+void abramov::parallelFor(size_t begin, size_t end, F f, size_t threads)
+{
+  if (begin >= end)
+  {
+    return;
+  }
+  if (!threads)
+  {
+    threads = defaultThreads();
+  }
+  size_t chunks = std::min(threads, end - begin);
+  if (chunks == 1)
+  {
+    f(begin, end);
+    return;
+  }
+  struct State
+  {
+    std::atomic< size_t > next{ 0 };
+    std::atomic< size_t > done{ 0 };
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::exception_ptr error;
+  };
+  auto state = std::make_shared< State >();
+  size_t step = (end - begin) / chunks;
+  size_t extra = (end - begin) % chunks;
+  auto run = [state, f, begin, step, extra, chunks]() mutable
+  {
+    for (size_t c = state->next++; c < chunks; c = state->next++)
+    {
+      size_t lo = begin + c * step + std::min(c, extra);
+      size_t hi = lo + step + (c < extra ? 1 : 0);
+      try
+      {
+        f(lo, hi);
+      }
+      catch (...)
+      {
+        std::lock_guard< std::mutex > lock(state->mutex);
+        if (!state->error)
+        {
+          state->error = std::current_exception();
+        }
+      }
+      if (++state->done == chunks)
+      {
+        std::lock_guard< std::mutex > lock(state->mutex);
+        state->cv.notify_all();
+      }
+    }
+  };
+  ThreadPool &pool = defaultPool();
+  for (size_t i = 1; i < std::min(chunks, pool.size() + 1); ++i)
+  {
+    pool.submit(run);
+  }
+  run();
+  std::unique_lock< std::mutex > lock(state->mutex);
+  state->cv.wait(lock, [&state, chunks]()
+  {
+    return state->done == chunks;
+  });
+  if (state->error)
+  {
+    std::rethrow_exception(state->error);
+  }
+}
+#endif
@@ -0,0 +1,399 @@
+#ifndef UPDATE_HPP
+#define UPDATE_HPP
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "bigint.hpp"
+#include "matrix.hpp"
+#include "modular.hpp"
+#include "overflow.hpp"
+#include "threadpool.hpp"
+
+namespace abramov
+{
+  template< Integral T, class P = Wrapping >
+  struct InverseUpdater
+  {
+    explicit InverseUpdater(const Matrix< T, P > &matrix, size_t threads = 0);
+    size_t size() const noexcept;
+    const Matrix< T, P > &matrix() const noexcept;
+    BigInt determinant() const;
+    std::vector< BigInt > adjugate() const;
+    void rankOneUpdate(const std::vector< T > &u, const std::vector< T > &v);
+    void update(const Matrix< T, P > &u, const Matrix< T, P > &v);
+    void replaceRow(size_t row, const std::vector< T > &values);
+    void replaceColumn(size_t col, const std::vector< T > &values);
+  private:
+    struct Residue
+    {
+      uint32_t p;
+      uint32_t det;
+      bool invertible;
+      std::vector< uint32_t > inv;
+    };
+
+    Matrix< T, P > current;
+    std::vector< Residue > residues;
+    size_t next;
+    size_t threads;
+
+    void refresh(Residue &r) const;
+    void cover();
+    template< class U, class V >
+    void apply(size_t k, U u, V v);
+    static void rankOne(Residue &r, const std::vector< uint32_t > &u, const std::vector< uint32_t > &v,
+      std::vector< uint32_t > &w, std::vector< uint32_t > &z);
+  };
+}
+
+template< abramov::Integral T, class P >
+abramov::InverseUpdater< T, P >::InverseUpdater(const Matrix< T, P > &matrix, size_t count):
+  current(matrix),
+  residues(),
+  next(0),
+  threads(count)
+{
+  ABRAMOV_PROFILE_SCOPE("InverseUpdater::InverseUpdater", matrix.getRows(), matrix.getCols());
+  if (matrix.getRows() != matrix.getCols())
+  {
+    throw std::logic_error("Matrix must be square\n");
+  }
+  cover();
+}
+
+template< abramov::Integral T, class P >
+size_t abramov::InverseUpdater< T, P >::size() const noexcept
+{
+  return current.getRows();
+}
+
+template< abramov::Integral T, class P >
+const abramov::Matrix< T, P > &abramov::InverseUpdater< T, P >::matrix() const noexcept
+{
+  return current;
+}
+
+template< abramov::Integral T, class P >
+abramov::BigInt abramov::InverseUpdater< T, P >::determinant() const
+{
+  std::vector< uint32_t > primes;
+  std::vector< uint32_t > dets;
+  for (const Residue &r : residues)
+  {
+    primes.push_back(r.p);
+    dets.push_back(r.det);
+  }
+  return CrtBasis(primes).reconstruct(dets.data());
+}
+
+template< abramov::Integral T, class P >
+std::vector< abramov::BigInt > abramov::InverseUpdater< T, P >::adjugate() const
+{
+  ABRAMOV_PROFILE_SCOPE("InverseUpdater::adjugate", size(), size());
+  size_t n = size();
+  std::vector< const Residue * > good;
+  for (const Residue &r : residues)
+  {
+    if (r.invertible)
+    {
+      good.push_back(&r);
+    }
+  }
+  if (good.empty() || determinant().isZero())
+  {
+    throw std::logic_error("Matrix does not have inverse\n");
+  }
+  std::vector< uint32_t > primes;
+  for (const Residue *r : good)
+  {
+    primes.push_back(r->p);
+  }
+  CrtBasis basis(primes);
+  return reconstructAll(basis, n * n, [&good](size_t i, size_t k)
+  {
+    return mulMod(good[i]->inv[k], good[i]->det, good[i]->p);
+  }, threads);
+}
+
+template< abramov::Integral T, class P >
+void abramov::InverseUpdater< T, P >::rankOneUpdate(const std::vector< T > &u, const std::vector< T > &v)
+{
+  ABRAMOV_PROFILE_SCOPE("InverseUpdater::rankOneUpdate", size(), size());
+  size_t n = size();
+  if (u.size() != n || v.size() != n)
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  Matrix< T, P > next_matrix(current);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      __int128 value = static_cast< __int128 >(current[i][j]) + static_cast< __int128 >(u[i]) * v[j];
+      if (!fits< T >(value))
+      {
+        throw std::overflow_error("Integer overflow\n");
+      }
+      next_matrix[i][j] = static_cast< T >(value);
+    }
+  }
+  apply(1, [&u](size_t, size_t i, uint32_t p)
+  {
+    return reduceMod(u[i], p);
+  }, [&v](size_t, size_t j, uint32_t p)
+  {
+    return reduceMod(v[j], p);
+  });
+  current = std::move(next_matrix);
+  cover();
+}
+
+template< abramov::Integral T, class P >
+void abramov::InverseUpdater< T, P >::update(const Matrix< T, P > &u, const Matrix< T, P > &v)
+{
+  ABRAMOV_PROFILE_SCOPE("InverseUpdater::update", size(), u.getCols());
+  size_t n = size();
+  size_t k = u.getCols();
+  if (u.getRows() != n || v.getRows() != n || v.getCols() != k)
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  Matrix< T, P > next_matrix(current);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      __int128 value = current[i][j];
+      bool overflow = false;
+      for (size_t t = 0; t < k; ++t)
+      {
+        __int128 prod = 0;
+        overflow |= __builtin_mul_overflow(static_cast< __int128 >(u[i][t]), static_cast< __int128 >(v[j][t]), &prod);
+        overflow |= __builtin_add_overflow(value, prod, &value);
+      }
+      if (overflow || !fits< T >(value))
+      {
+        throw std::overflow_error("Integer overflow\n");
+      }
+      next_matrix[i][j] = static_cast< T >(value);
+    }
+  }
+  apply(k, [&u](size_t t, size_t i, uint32_t p)
+  {
+    return reduceMod(u[i][t], p);
+  }, [&v](size_t t, size_t j, uint32_t p)
+  {
+    return reduceMod(v[j][t], p);
+  });
+  current = std::move(next_matrix);
+  cover();
+}
+
+template< abramov::Integral T, class P >
+void abramov::InverseUpdater< T, P >::replaceRow(size_t row, const std::vector< T > &values)
+{
+  ABRAMOV_PROFILE_SCOPE("InverseUpdater::replaceRow", size(), size());
+  size_t n = size();
+  if (row >= n)
+  {
+    throw std::out_of_range("Index out of range\n");
+  }
+  if (values.size() != n)
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  const Matrix< T, P > &a = current;
+  apply(1, [row](size_t, size_t i, uint32_t)
+  {
+    return static_cast< uint32_t >(i == row);
+  }, [&a, &values, row](size_t, size_t j, uint32_t p)
+  {
+    return (reduceMod(values[j], p) + p - reduceMod(a[row][j], p)) % p;
+  });
+  std::copy(values.begin(), values.end(), current[row]);
+  cover();
+}
+
+template< abramov::Integral T, class P >
+void abramov::InverseUpdater< T, P >::replaceColumn(size_t col, const std::vector< T > &values)
+{
+  ABRAMOV_PROFILE_SCOPE("InverseUpdater::replaceColumn", size(), size());
+  size_t n = size();
+  if (col >= n)
+  {
+    throw std::out_of_range("Index out of range\n");
+  }
+  if (values.size() != n)
+  {
+    throw std::invalid_argument("Matrix dimensions do not agree\n");
+  }
+  const Matrix< T, P > &a = current;
+  apply(1, [&a, &values, col](size_t, size_t i, uint32_t p)
+  {
+    return (reduceMod(values[i], p) + p - reduceMod(a[i][col], p)) % p;
+  }, [col](size_t, size_t j, uint32_t)
+  {
+    return static_cast< uint32_t >(j == col);
+  });
+  for (size_t i = 0; i < n; ++i)
+  {
+    current[i][col] = values[i];
+  }
+  cover();
+}
+
+template< abramov::Integral T, class P >
+void abramov::InverseUpdater< T, P >::refresh(Residue &r) const
+{
+  size_t n = size();
+  std::vector< uint32_t > a;
+  reduceMatrix(current, n, r.p, a, 2 * n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    a[i * 2 * n + n + i] = 1;
+  }
+  r.det = eliminateMod(a, n, 2 * n, r.p);
+  r.invertible = r.det != 0;
+  r.inv.clear();
+  if (r.invertible)
+  {
+    r.inv.resize(n * n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      std::copy(a.begin() + i * 2 * n + n, a.begin() + (i + 1) * 2 * n, r.inv.begin() + i * n);
+    }
+  }
+}
+
+template< abramov::Integral T, class P >
+void abramov::InverseUpdater< T, P >::cover()
+{
+  size_t n = size();
+  size_t first = residues.size();
+  size_t need = n ? primesFor(hadamardBits(current, n, false)) : 1;
+  auto grow = [this](size_t count)
+  {
+    for (uint32_t p : modularPrimes(next, count))
+    {
+      residues.push_back({ p, 0, false, {} });
+    }
+    next += count;
+  };
+  if (residues.size() < need)
+  {
+    grow(need - residues.size());
+  }
+  parallelFor(0, residues.size(), [this, first](size_t lo, size_t hi)
+  {
+    for (size_t k = lo; k < hi; ++k)
+    {
+      if (k >= first || !residues[k].invertible)
+      {
+        refresh(residues[k]);
+      }
+    }
+  }, threads);
+  size_t good = 0;
+  for (Residue &r : residues)
+  {
+    good += r.invertible;
+  }
+  size_t out = n ? primesFor(hadamardBits(current, n, true)) : 1;
+  while (good < out && !determinant().isZero())
+  {
+    size_t from = residues.size();
+    grow(out - good);
+    parallelFor(from, residues.size(), [this](size_t lo, size_t hi)
+    {
+      for (size_t k = lo; k < hi; ++k)
+      {
+        refresh(residues[k]);
+      }
+    }, threads);
+    for (size_t k = from; k < residues.size(); ++k)
+    {
+      good += residues[k].invertible;
+    }
+  }
+}
+
+template< abramov::Integral T, class P >
+template< class U, class V >
+void abramov::InverseUpdater< T, P >::apply(size_t k, U u, V v)
+{
+  size_t n = size();
+  parallelFor(0, residues.size(), [&](size_t lo, size_t hi)
+  {
+    std::vector< uint32_t > uu(n);
+    std::vector< uint32_t > vv(n);
+    std::vector< uint32_t > w(n);
+    std::vector< uint32_t > z(n);
+    for (size_t r = lo; r < hi; ++r)
+    {
+      Residue &res = residues[r];
+      for (size_t t = 0; t < k && res.invertible; ++t)
+      {
+        for (size_t i = 0; i < n; ++i)
+        {
+          uu[i] = u(t, i, res.p);
+          vv[i] = v(t, i, res.p);
+        }
+        rankOne(res, uu, vv, w, z);
+      }
+    }
+  }, threads);
+}
+
+template< abramov::Integral T, class P >
+void abramov::InverseUpdater< T, P >::rankOne(Residue &r, const std::vector< uint32_t > &u, const std::vector< uint32_t > &v,
+  std::vector< uint32_t > &w, std::vector< uint32_t > &z)
+{
+  size_t n = u.size();
+  uint32_t p = r.p;
+  const uint32_t *inv = r.inv.data();
+  std::fill(z.begin(), z.end(), 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    uint64_t acc = 0;
+    for (size_t j = 0; j < n; ++j)
+    {
+      acc = (acc + static_cast< uint64_t >(inv[i * n + j]) * u[j]) % p;
+    }
+    w[i] = static_cast< uint32_t >(acc);
+    if (v[i])
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        z[j] = static_cast< uint32_t >((z[j] + static_cast< uint64_t >(v[i]) * inv[i * n + j]) % p);
+      }
+    }
+  }
+  uint64_t s = 1;
+  for (size_t i = 0; i < n; ++i)
+  {
+    s = (s + static_cast< uint64_t >(v[i]) * w[i]) % p;
+  }
+  r.det = mulMod(r.det, static_cast< uint32_t >(s), p);
+  if (!s)
+  {
+    r.invertible = false;
+    r.inv.clear();
+    return;
+  }
+  uint32_t scale = p - invMod(static_cast< uint32_t >(s), p);
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (!w[i])
+    {
+      continue;
+    }
+    uint64_t f = mulMod(w[i], scale, p);
+    uint32_t *row = r.inv.data() + i * n;
+    for (size_t j = 0; j < n; ++j)
+    {
+      row[j] = static_cast< uint32_t >((row[j] + f * z[j]) % p);
+    }
+  }
+}
+#endif
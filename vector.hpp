@@ -4,6 +4,11 @@
 #include <cmath>
 #include <concepts>
 #include <initializer_list>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "profile.hpp"
+#include "threadpool.hpp"
 
 namespace abramov
 {
@@ -12,6 +17,23 @@ namespace abramov
   template< Numeric T, size_t N >
   struct Vector;
 
+  enum class Summation
+  {
+    Fast,
+    Kahan,
+    Pairwise
+  };
+
+  template< class A >
+  A fusedMultiplyAdd(A x, A y, A acc);
+  template< class A, class F >
+  A productSum(size_t n, F factors, Summation mode = Summation::Fast);
+  template< Numeric T, size_t N >
+  std::vector< T > dots(const Vector< T, N > &query, const std::vector< Vector< T, N > > &items,
+    Summation mode = Summation::Fast, size_t threads = 1);
+  template< Numeric T, size_t N >
+  std::vector< double > distances(const Vector< T, N > &query, const std::vector< Vector< T, N > > &items,
+    Summation mode = Summation::Fast, size_t threads = 1);
 
   template< Numeric T, size_t N >
   Vector< T, N > operator+(Vector< T, N > lhs, const Vector< T, N > &rhs);
@@ -43,12 +65,14 @@ namespace abramov
     Vector< T, N > &operator*=(T scalar);
     bool operator==(const Vector< T, N > &other) const;
     bool operator!=(const Vector< T, N > &other) const;
-    T dot(const Vector< T, N > &other) const;
+    T &operator[](size_t i) noexcept;
+    const T &operator[](size_t i) const noexcept;
+    T dot(const Vector< T, N > &other, Summation mode = Summation::Fast) const;
     Vector< T, N > cross(const Vector< T, N > &other) const;
     T triple(const Vector< T, N > &b, const Vector< T, N > &c) const;
-    double norm() const;
+    double norm(Summation mode = Summation::Fast) const;
     Vector< double, N > normalized() const;
-    double distance(const Vector< T, N > &other) const;
+    double distance(const Vector< T, N > &other, Summation mode = Summation::Fast) const;
     double angle(const Vector< T, N > &other) const;
     T cross2D(const Vector< T, N > &other) const;
     std::istream &read(std::istream &in = std::cin);
@@ -58,6 +82,155 @@ namespace abramov
 
     void swap(Vector< T, N > &other) noexcept;
   };
+
+  template< std::floating_point A >
+  A productError(A x, A y, A p);
+  template< class A, class F >
+  A fastSum(size_t lo, size_t hi, F factors);
+  template< class A, class F >
+  A kahanSum(size_t lo, size_t hi, F factors);
+  template< class A, class F >
+  A pairwiseSum(size_t lo, size_t hi, F factors);
+}
+
+template< class A >
+A abramov::fusedMultiplyAdd(A x, A y, A acc)
+{
+#if defined(__FMA__) || defined(FP_FAST_FMA)
+  if constexpr (std::floating_point< A >)
+  {
+    return std::fma(x, y, acc);
+  }
+#endif
+  return x * y + acc;
+}
+
+template< std::floating_point A >
+A abramov::productError(A x, A y, A p)
+{
+#if defined(__FMA__) || defined(FP_FAST_FMA)
+  return std::fma(x, y, -p);
+#else
+  constexpr A split = static_cast< A >((1ull << ((std::numeric_limits< A >::digits + 1) / 2)) + 1);
+  A cx = split * x;
+  A xh = cx - (cx - x);
+  A xl = x - xh;
+  A cy = split * y;
+  A yh = cy - (cy - y);
+  A yl = y - yh;
+  return ((xh * yh - p) + xh * yl + xl * yh) + xl * yl;
+#endif
+}
+
+template< class A, class F >
+A abramov::productSum(size_t n, F factors, Summation mode)
+{
+  if (mode == Summation::Kahan)
+  {
+    return kahanSum< A >(0, n, factors);
+  }
+  if (mode == Summation::Pairwise)
+  {
+    return pairwiseSum< A >(0, n, factors);
+  }
+  return fastSum< A >(0, n, factors);
+}
+
+template< class A, class F >
+A abramov::fastSum(size_t lo, size_t hi, F factors)
+{
+  constexpr size_t lanes = 8;
+  A acc[lanes] = {};
+  size_t i = lo;
+  for (; i + lanes <= hi; i += lanes)
+  {
+    for (size_t j = 0; j < lanes; ++j)
+    {
+      auto [x, y] = factors(i + j);
+      acc[j] = fusedMultiplyAdd< A >(x, y, acc[j]);
+    }
+  }
+  for (size_t j = 0; i < hi; ++i, ++j)
+  {
+    auto [x, y] = factors(i);
+    acc[j] = fusedMultiplyAdd< A >(x, y, acc[j]);
+  }
+  for (size_t w = lanes / 2; w; w /= 2)
+  {
+    for (size_t j = 0; j < w; ++j)
+    {
+      acc[j] += acc[j + w];
+    }
+  }
+  return acc[0];
+}
+
+template< class A, class F >
+A abramov::kahanSum(size_t lo, size_t hi, F factors)
+{
+  if constexpr (!std::floating_point< A >)
+  {
+    return fastSum< A >(lo, hi, factors);
+  }
+  else
+  {
+    A sum = 0;
+    A carry = 0;
+    for (size_t i = lo; i < hi; ++i)
+    {
+      auto [x, y] = factors(i);
+      A p = x * y;
+      carry += productError(x, y, p);
+      A t = sum + p;
+      carry += std::abs(sum) >= std::abs(p) ? (sum - t) + p : (p - t) + sum;
+      sum = t;
+    }
+    return sum + carry;
+  }
+}
+
+template< class A, class F >
+A abramov::pairwiseSum(size_t lo, size_t hi, F factors)
+{
+  constexpr size_t block = 128;
+  if (hi - lo <= block)
+  {
+    return fastSum< A >(lo, hi, factors);
+  }
+  size_t mid = lo + (hi - lo) / 2;
+  return pairwiseSum< A >(lo, mid, factors) + pairwiseSum< A >(mid, hi, factors);
+}
+
+template< abramov::Numeric T, size_t N >
+std::vector< T > abramov::dots(const Vector< T, N > &query, const std::vector< Vector< T, N > > &items,
+  Summation mode, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("dots", items.size(), N);
+  std::vector< T > res(items.size());
+  parallelFor(0, items.size(), [&](size_t lo, size_t hi)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      res[i] = query.dot(items[i], mode);
+    }
+  }, threads);
+  return res;
+}
+
+template< abramov::Numeric T, size_t N >
+std::vector< double > abramov::distances(const Vector< T, N > &query, const std::vector< Vector< T, N > > &items,
+  Summation mode, size_t threads)
+{
+  ABRAMOV_PROFILE_SCOPE("distances", items.size(), N);
+  std::vector< double > res(items.size());
+  parallelFor(0, items.size(), [&](size_t lo, size_t hi)
+  {
+    for (size_t i = lo; i < hi; ++i)
+    {
+      res[i] = query.distance(items[i], mode);
+    }
+  }, threads);
+  return res;
 }
 
 template< abramov::Numeric T, size_t N >
@@ -114,6 +287,7 @@ abramov::Vector< T, N > &abramov::Vector< T, N >::operator=(Vector< T, N > &&oth
 template< abramov::Numeric T, size_t N >
 abramov::Vector< T, N > &abramov::Vector< T, N >::operator+=(const Vector< T, N > &other)
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::operator+=", N, 1);
   for (size_t i = 0; i < N; ++i)
   {
     data[i] += other.data[i];
@@ -131,12 +305,14 @@ abramov::Vector< T, N > abramov::operator+(Vector< T, N > lhs, const Vector< T,
 template< abramov::Numeric T, size_t N >
 abramov::Vector< T, N > abramov::Vector< T, N >::operator+() const
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::operator+()", N, 1);
   return *this;
 }
 
 template< abramov::Numeric T, size_t N >
 abramov::Vector< T, N > &abramov::Vector< T, N >::operator-=(const Vector< T, N > &other)
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::operator-=", N, 1);
   for (size_t i = 0; i < N; ++i)
   {
     data[i] -= other.data[i];
@@ -154,6 +330,7 @@ abramov::Vector< T, N > abramov::operator-(Vector< T, N > lhs, const Vector< T,
 template< abramov::Numeric T, size_t N >
 abramov::Vector< T, N > abramov::Vector< T, N >::operator-() const
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::operator-()", N, 1);
   abramov::Vector< T, N > res(*this);
   for (size_t i = 0; i < N; ++i)
   {
@@ -165,6 +342,7 @@ abramov::Vector< T, N > abramov::Vector< T, N >::operator-() const
 template< abramov::Numeric T, size_t N >
 abramov::Vector< T, N > &abramov::Vector< T, N >::operator*=(T scalar)
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::operator*=", N, 1);
   for (size_t i = 0; i < N; ++i)
   {
     data[i] *= scalar;
@@ -188,6 +366,7 @@ abramov::Vector< T, N > abramov::operator*(T scalar, const Vector< T, N > &rhs)
 template< abramov::Numeric T, size_t N >
 bool abramov::Vector< T, N >::operator==(const Vector< T, N > &other) const
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::operator==", N, 1);
   for (size_t i = 0; i < N; ++i)
   {
     if (std::abs(data[i] - other.data[i]) > 1e-6)
@@ -205,19 +384,31 @@ bool abramov::Vector< T, N >::operator!=(const Vector< T, N > &other) const
 }
 
 template< abramov::Numeric T, size_t N >
-T abramov::Vector< T, N >::dot(const Vector< T, N > &other) const
+T &abramov::Vector< T, N >::operator[](size_t i) noexcept
 {
-  T res = 0;
-  for (size_t i = 0; i < N; ++i)
+  return data[i];
+}
+
+template< abramov::Numeric T, size_t N >
+const T &abramov::Vector< T, N >::operator[](size_t i) const noexcept
+{
+  return data[i];
+}
+
+template< abramov::Numeric T, size_t N >
+T abramov::Vector< T, N >::dot(const Vector< T, N > &other, Summation mode) const
+{
+  ABRAMOV_PROFILE_SCOPE("Vector::dot", N, 1);
+  return productSum< T >(N, [this, &other](size_t i)
   {
-    res += data[i] * other.data[i];
-  }
-  return res;
+    return std::pair< T, T >(data[i], other.data[i]);
+  }, mode);
 }
 
 template< abramov::Numeric T, size_t N >
 abramov::Vector< T, N >abramov::Vector< T, N >::cross(const Vector< T, N > &other) const
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::cross", N, 1);
   if (N != 3)
   {
     throw std::logic_error("Vector must be 3D\n");
@@ -231,6 +422,7 @@ abramov::Vector< T, N >abramov::Vector< T, N >::cross(const Vector< T, N > &othe
 template< abramov::Numeric T, size_t N >
 T abramov::Vector< T, N >::triple(const Vector< T, N > &b, const Vector< T, N > &c) const
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::triple", N, 1);
   if (N != 3)
   {
     throw std::logic_error("Vector must be 3D\n");
@@ -239,19 +431,20 @@ T abramov::Vector< T, N >::triple(const Vector< T, N > &b, const Vector< T, N >
 }
 
 template< abramov::Numeric T, size_t N >
-double abramov::Vector< T, N >::norm() const
+double abramov::Vector< T, N >::norm(Summation mode) const
 {
-  double res = 0;
-  for (size_t i = 0; i < N; ++i)
+  ABRAMOV_PROFILE_SCOPE("Vector::norm", N, 1);
+  return std::sqrt(productSum< double >(N, [this](size_t i)
   {
-    res += data[i] * data[i];
-  }
-  return std::sqrt(res);
+    double x = data[i];
+    return std::pair< double, double >(x, x);
+  }, mode));
 }
 
 template< abramov::Numeric T, size_t N >
 abramov::Vector< double, N > abramov::Vector< T, N >::normalized() const
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::normalized", N, 1);
   double len = norm();
   if (len == 0)
   {
@@ -267,19 +460,20 @@ abramov::Vector< double, N > abramov::Vector< T, N >::normalized() const
 }
 
 template< abramov::Numeric T, size_t N >
-double abramov::Vector< T, N >::distance(const Vector< T, N > &other) const
+double abramov::Vector< T, N >::distance(const Vector< T, N > &other, Summation mode) const
 {
-  double dist = 0;
-  for (size_t i = 0; i < N; ++i)
+  ABRAMOV_PROFILE_SCOPE("Vector::distance", N, 1);
+  return std::sqrt(productSum< double >(N, [this, &other](size_t i)
   {
-    dist += (data[i] - other.data[i]) * (data[i] - other.data[i]);
-  }
-  return std::sqrt(dist);
+    double d = static_cast< double >(data[i]) - static_cast< double >(other.data[i]);
+    return std::pair< double, double >(d, d);
+  }, mode));
 }
 
 template< abramov::Numeric T, size_t N >
 double abramov::Vector< T, N >::angle(const Vector< T, N > &other) const
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::angle", N, 1);
   double dot_product = dot(other);
   double norm1 = norm();
   double norm2 = other.norm();
@@ -293,6 +487,7 @@ double abramov::Vector< T, N >::angle(const Vector< T, N > &other) const
 template< abramov::Numeric T, size_t N >
 T abramov::Vector< T, N >::cross2D(const Vector< T, N > &other) const
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::cross2D", N, 1);
   if (N != 2 )
   {
     throw std::logic_error("Cross2D is only defined for 2D vectors\n");
@@ -304,6 +499,7 @@ T abramov::Vector< T, N >::cross2D(const Vector< T, N > &other) const
 template< abramov::Numeric T, size_t N >
 std::istream &abramov::Vector< T, N >::read(std::istream &in)
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::read", N, 1);
   std::istream::sentry s(in);
   if (!s)
   {
@@ -324,6 +520,7 @@ std::istream &abramov::Vector< T, N >::read(std::istream &in)
 template< abramov::Numeric T, size_t N >
 std::ostream &abramov::Vector< T, N >::print(std::ostream &out) const
 {
+  ABRAMOV_PROFILE_SCOPE("Vector::print", N, 1);
   std::ostream::sentry s(out);
   if (!s)
   {